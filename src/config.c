@@ -12,7 +12,7 @@
  *		on Windows XP, possibly Vista and several UNIX systems.
  *		Use the -DANSI_CFG for use on these systems.
  *
- * Version:	@(#)config.c	1.0.56	2021/03/23
+ * Version:	@(#)config.c	1.0.63	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -287,6 +287,22 @@ load_general(config_t *cfg, const char *cat)
     cfg->vid_grayscale = config_get_int(cat, "video_grayscale", 0);
     cfg->vid_graytype = config_get_int(cat, "video_graytype", 0);
 
+    cfg->png_level = config_get_int(cat, "png_level", 6);
+    if (cfg->png_level < 0)
+	cfg->png_level = 0;
+    if (cfg->png_level > 9)
+	cfg->png_level = 9;
+
+    memset(cfg->capture_file, 0x00, sizeof(cfg->capture_file));
+    w = config_get_wstring(cat, "capture_file", NULL);
+    if (w != NULL)
+	wcsncpy(cfg->capture_file, w, sizeof_w(cfg->capture_file) - 1);
+
+    memset(cfg->vidfb_name, 0x00, sizeof(cfg->vidfb_name));
+    p = config_get_string(cat, "video_shared_fb", NULL);
+    if (p != NULL)
+	strncpy(cfg->vidfb_name, p, sizeof(cfg->vidfb_name) - 1);
+
     cfg->window_remember = config_get_int(cat, "window_remember", 0);
     if (cfg->window_remember) {
 	p = config_get_string(cat, "window_coordinates", "0, 0, 0, 0");
@@ -381,6 +397,21 @@ save_general(const config_t *cfg, const char *cat)
     else
 	config_set_int(cat, "video_graytype", cfg->vid_graytype);
 
+    if (cfg->png_level == 6)
+	config_delete_var(cat, "png_level");
+    else
+	config_set_int(cat, "png_level", cfg->png_level);
+
+    if (cfg->capture_file[0] == L'\0')
+	config_delete_var(cat, "capture_file");
+    else
+	config_set_wstring(cat, "capture_file", cfg->capture_file);
+
+    if (cfg->vidfb_name[0] == '\0')
+	config_delete_var(cat, "video_shared_fb");
+    else
+	config_set_string(cat, "video_shared_fb", cfg->vidfb_name);
+
     if (cfg->window_remember) {
 	config_set_int(cat, "window_remember", cfg->window_remember);
 
@@ -613,6 +644,7 @@ save_input(const config_t *cfg, const char *cat)
 static void
 load_sound(config_t *cfg, const char *cat)
 {
+    wchar_t *w;
     char *p;
 
     p = config_get_string(cat, "sound_type", "float");
@@ -639,6 +671,21 @@ load_sound(config_t *cfg, const char *cat)
     cfg->midi_device = midi_device_get_from_internal_name(p);
 
     cfg->mpu401_standalone_enable = !!config_get_int(cat, "mpu401_standalone", 0);
+
+    p = config_get_string(cat, "sound_output", "openal");
+    cfg->sound_output = sound_sink_get_from_internal_name(p);
+
+    /* Get the name of the WAV output file, if any. */
+    memset(cfg->sound_file, 0x00, sizeof(cfg->sound_file));
+    w = config_get_wstring(cat, "sound_file", NULL);
+    if (w != NULL)
+	wcsncpy(cfg->sound_file, w, sizeof_w(cfg->sound_file) - 1);
+
+    /* Get the name of the shared ring buffer, if any. */
+    memset(cfg->sound_ring_name, 0x00, sizeof(cfg->sound_ring_name));
+    p = config_get_string(cat, "sound_ring", NULL);
+    if (p != NULL)
+	strncpy(cfg->sound_ring_name, p, sizeof(cfg->sound_ring_name) - 1);
 }
 
 
@@ -668,6 +715,22 @@ save_sound(const config_t *cfg, const char *cat)
     else
 	config_set_int(cat, "mpu401_standalone", cfg->mpu401_standalone_enable);
 
+    if (cfg->sound_output == SOUND_SINK_OPENAL)
+	config_delete_var(cat, "sound_output");
+    else
+	config_set_string(cat, "sound_output",
+			  sound_sink_get_internal_name(cfg->sound_output));
+
+    if (cfg->sound_file[0] == L'\0')
+	config_delete_var(cat, "sound_file");
+    else
+	config_set_wstring(cat, "sound_file", cfg->sound_file);
+
+    if (cfg->sound_ring_name[0] == '\0')
+	config_delete_var(cat, "sound_ring");
+    else
+	config_set_string(cat, "sound_ring", cfg->sound_ring_name);
+
     delete_section_if_empty(cat);
 }
 
@@ -676,6 +739,7 @@ save_sound(const config_t *cfg, const char *cat)
 static void
 load_network(config_t *cfg, const char *cat)
 {
+    wchar_t *w;
     char *p;
     int k;
 
@@ -692,6 +756,12 @@ load_network(config_t *cfg, const char *cat)
     strcpy(cfg->network_srv_addr, p);
     cfg->network_srv_port = k;
 
+    /* Get the name of the packet capture file, if any. */
+    memset(cfg->network_capture, 0x00, sizeof(cfg->network_capture));
+    w = config_get_wstring(cat, "net_capture", NULL);
+    if (w != NULL)
+	wcsncpy(cfg->network_capture, w, sizeof_w(cfg->network_capture) - 1);
+
     /* Get any PCap parameters. */
     p = config_get_string(cat, "net_host_device", NULL);
     if (p == NULL) {
@@ -748,6 +818,11 @@ save_network(const config_t *cfg, const char *cat)
 		config_set_int(cat, "net_srv_port", cfg->network_srv_port);
     }
 
+    if (cfg->network_capture[0] == L'\0')
+	config_delete_var(cat, "net_capture");
+    else
+	config_set_wstring(cat, "net_capture", cfg->network_capture);
+
     if ((cfg->network_host[0] == '\0') || (!strcmp(cfg->network_host, "none")))
 	config_delete_var(cat, "net_host_device");
     else
@@ -777,6 +852,13 @@ load_ports(config_t *cfg, const char *cat)
     for (i = 0; i < SERIAL_MAX; i++) {
 	sprintf(temp, "serial%i_enabled", i);
 	cfg->serial_enabled[i] = !!config_get_int(cat, temp, 0);
+
+	sprintf(temp, "serial%i_turbo", i);
+	cfg->serial_turbo[i] = !!config_get_int(cat, temp, 0);
+
+	sprintf(temp, "serial%i_link", i);
+	p = (char *)config_get_string(cat, temp, "");
+	strncpy(cfg->serial_link[i], p, sizeof(cfg->serial_link[i]) - 1);
     }
 
     for (i = 0; i < PARALLEL_MAX; i++) {
@@ -809,6 +891,18 @@ save_ports(const config_t *cfg, const char *cat)
 		config_set_int(cat, temp, 1);
 	} else
 		config_delete_var(cat, temp);
+
+	sprintf(temp, "serial%i_turbo", i);
+	if (cfg->serial_turbo[i]) {
+		config_set_int(cat, temp, 1);
+	} else
+		config_delete_var(cat, temp);
+
+	sprintf(temp, "serial%i_link", i);
+	if (cfg->serial_link[i][0] != '\0') {
+		config_set_string(cat, temp, cfg->serial_link[i]);
+	} else
+		config_delete_var(cat, temp);
     }
 
     for (i = 0; i < PARALLEL_MAX; i++) {
@@ -2123,6 +2217,10 @@ config_init(config_t *cfg)
     cfg->enable_overscan = 0;			// enable overscans
     cfg->force_43 = 0;				// video
 
+    cfg->png_level = 6;				// PNG compression level
+    memset(cfg->capture_file, 0x00, sizeof(cfg->capture_file));
+    memset(cfg->vidfb_name, 0x00, sizeof(cfg->vidfb_name));
+
     cfg->mouse_type = MOUSE_NONE;		// selected mouse type
     cfg->joystick_type = 0;			// joystick type
 
@@ -2131,11 +2229,17 @@ config_init(config_t *cfg)
     cfg->sound_card = SOUND_NONE;		// selected sound card
     cfg->mpu401_standalone_enable = 0;		// sound option
     cfg->midi_device = 0;			// selected midi device
+    cfg->sound_output = SOUND_SINK_OPENAL;	// audio output sink
+    memset(cfg->sound_file, 0x00, sizeof(cfg->sound_file));
+    memset(cfg->sound_ring_name, 0x00, sizeof(cfg->sound_ring_name));
 
     cfg->game_enabled = 0;			// enable game port
 
-    for (i = 0; i < SERIAL_MAX; i++)		// enable serial ports
+    for (i = 0; i < SERIAL_MAX; i++) {		// enable serial ports
 	cfg->serial_enabled[i] = 0;
+	cfg->serial_turbo[i] = 0;		// ignore the line speed
+	memset(cfg->serial_link[i], 0x00, sizeof(cfg->serial_link[i]));
+    }
 
     for (i = 0; i < PARALLEL_MAX; i++) {	// enable LPT ports
 	cfg->parallel_enabled[i] = 0;
@@ -2289,8 +2393,11 @@ config_compare(const config_t *one, const config_t *two)
 
     /* Ports category */
     i = i || (one->game_enabled != two->game_enabled);
-    for (j = 0; j < SERIAL_MAX; j++)
+    for (j = 0; j < SERIAL_MAX; j++) {
 	i = i || (one->serial_enabled[j] != two->serial_enabled[j]);
+	i = i || (one->serial_turbo[j] != two->serial_turbo[j]);
+	i = i || strcmp(one->serial_link[j], two->serial_link[j]);
+    }
     for (j = 0; j < PARALLEL_MAX; j++) {
 	i = i || (one->parallel_enabled[j] != two->parallel_enabled[j]);
 	i = i || (one->parallel_device[j] != two->parallel_device[j]);
@@ -8,7 +8,7 @@
  *
  *		Configuration file handler header.
  *
- * Version:	@(#)config.h	1.0.9	2021/03/20
+ * Version:	@(#)config.h	1.0.16	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -92,6 +92,10 @@ typedef struct {
 		enable_overscan,		/* enable overscans */
 		force_43;			/* video */
 
+    int		png_level;			/* PNG compression level */
+    wchar_t	capture_file[512];		/* A/V capture base name */
+    char	vidfb_name[64];			/* shared frame buffer name */
+
     int		mouse_type;			/* selected mouse type */
     int		joystick_type;			/* joystick type */
 
@@ -100,11 +104,16 @@ typedef struct {
 		sound_card,			/* selected sound card */
 		mpu401_standalone_enable,	/* sound option */
 		midi_device;			/* selected midi device */
+    int		sound_output;			/* audio output sink */
+    wchar_t	sound_file[512];		/* WAV output file */
+    char	sound_ring_name[64];		/* shared ring buffer name */
 
     int		game_enabled,			/* enable game port */
 		serial_enabled[SERIAL_MAX],	/* enable serial ports */
+		serial_turbo[SERIAL_MAX],	/* ignore the line speed */
 		parallel_enabled[PARALLEL_MAX],	/* enable LPT ports */
 		parallel_device[PARALLEL_MAX];	/* set up LPT devices */
+    char	serial_link[SERIAL_MAX][128];	/* host side of serial ports */
 
     struct {
 	int	type;				/* drive type */
@@ -134,6 +143,7 @@ typedef struct {
 
     char	network_srv_addr[512];		/* network server address */
     int		network_srv_port;		/* network server port */
+    wchar_t	network_capture[512];		/* packet capture file */
 
     int		bugger_enabled;			/* enable ISAbugger */
 
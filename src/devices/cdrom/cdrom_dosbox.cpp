@@ -15,7 +15,7 @@
  * **NOTE**	This code will very soon be replaced with a C variant, so
  *		no more changes will be done.
  *
- * Version:	@(#)cdrom_dosbox.cpp	1.0.15	2019/05/17
+ * Version:	@(#)cdrom_dosbox.cpp	1.0.16	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -79,6 +79,10 @@ CDROM_Interface_Image::BinaryFile::BinaryFile(const wchar_t *filename, bool &err
 
     memset(fn, 0x00, sizeof(fn));
     wcscpy(fn, filename);
+    cache = NULL;
+    cache_size = cache_len = 0;
+    cache_pos = next_pos = 0;
+    hits = misses = 0;
     file = plat_fopen64(fn, (const wchar_t *)cwstr.c_str());
     DEBUG("CDROM: binary_open(%ls) = %08lx\n", fn, file);
 
@@ -91,6 +95,12 @@ CDROM_Interface_Image::BinaryFile::BinaryFile(const wchar_t *filename, bool &err
 
 CDROM_Interface_Image::BinaryFile::~BinaryFile(void)
 {
+    if (cache != NULL) {
+	INFO("CDROM: read-ahead for '%ls': %" PRIu32 " hits, %" PRIu32 " misses\n",
+	     fn, hits, misses);
+	free(cache);
+	cache = NULL;
+    }
     if (file != NULL) {
 	fclose(file);
 	file = NULL;
@@ -99,6 +109,28 @@ CDROM_Interface_Image::BinaryFile::~BinaryFile(void)
 }
 
 
+/* Set the size of the read-ahead buffer, 0 to disable it. */
+void
+CDROM_Interface_Image::BinaryFile::setReadAhead(size_t size)
+{
+    if (size == cache_size) return;
+
+    if (cache != NULL)
+	free(cache);
+    cache = (size > 0) ? (uint8_t *)mem_alloc(size) : NULL;
+    cache_size = size;
+    cache_len = 0;
+}
+
+
+/*
+ * Read from the image.
+ *
+ * Reads are served from the read-ahead buffer if possible. If not,
+ * and the read continues where the previous one ended, we refill the
+ * buffer from there, as the next few reads will most likely continue
+ * that run. Random reads go directly to the file.
+ */
 bool
 CDROM_Interface_Image::BinaryFile::read(uint8_t *buffer, uint64_t seek, size_t count)
 {
@@ -106,6 +138,32 @@ CDROM_Interface_Image::BinaryFile::read(uint8_t *buffer, uint64_t seek, size_t c
 						file, seek, count);
     if (file == NULL) return 0;
 
+    if ((cache_len > 0) && (seek >= cache_pos) &&
+	((seek + count) <= (cache_pos + cache_len))) {
+	memcpy(buffer, &cache[seek - cache_pos], count);
+	next_pos = seek + count;
+	hits++;
+	return 1;
+    }
+
+    misses++;
+
+    if ((cache != NULL) && (seek == next_pos) && (count <= cache_size)) {
+	fseeko64(file, seek, SEEK_SET);
+	cache_pos = seek;
+	cache_len = fread(cache, 1, cache_size, file);
+	if (cache_len < count) {
+		cache_len = 0;
+		ERRLOG("CDROM: binary_read failed!\n");
+		return 0;
+	}
+	memcpy(buffer, cache, count);
+	next_pos = seek + count;
+	return 1;
+    }
+
+    next_pos = seek + count;
+
     fseeko64(file, seek, SEEK_SET);
     if (fread(buffer, count, 1, file) != 1) {
 	ERRLOG("CDROM: binary_read failed!\n");
@@ -313,6 +371,19 @@ CDROM_Interface_Image::ReadSectorSub(uint8_t *buffer, uint32_t sector)
 }
 
 
+/* Set up read-ahead for all the files making up the image. */
+void
+CDROM_Interface_Image::SetReadAhead(uint32_t sectors)
+{
+    vector<Track>::iterator i;
+
+    for (i = tracks.begin(); i != tracks.end(); i++) {
+	if (i->file != NULL)
+		i->file->setReadAhead(sectors * 2448);
+    }
+}
+
+
 int
 CDROM_Interface_Image::GetSectorSize(uint32_t sector)
 {
@@ -8,7 +8,7 @@
  *
  *		Definitions for the CD-ROM image file handling module.
  *
- * Version:	@(#)cdrom_dosbox.h	1.0.5	2019/05/17
+ * Version:	@(#)cdrom_dosbox.h	1.0.6	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -107,6 +107,7 @@ private:
 	public:
 		virtual bool read(uint8_t *buffer, uint64_t seek, size_t count) = 0;
 		virtual uint64_t getLength() = 0;
+		virtual void setReadAhead(size_t size) { (void)size; };
 		virtual ~TrackFile() { };
     };
 	
@@ -116,10 +117,17 @@ private:
 		~BinaryFile();
 		bool read(uint8_t *buffer, uint64_t seek, size_t count);
 		uint64_t getLength();
+		void setReadAhead(size_t size);
 	private:
 		BinaryFile();
 		wchar_t fn[260];
 		FILE *file;
+
+		// read-ahead buffer
+		uint8_t *cache;
+		size_t cache_size, cache_len;
+		uint64_t cache_pos, next_pos;
+		uint32_t hits, misses;
     };
 	
     struct Track {
@@ -149,6 +157,7 @@ public:
     bool	LoadUnloadMedia(bool unload);
     bool	ReadSector(uint8_t *buffer, bool raw, uint32_t sector);
     bool	ReadSectorSub(uint8_t *buffer, uint32_t sector);
+    void	SetReadAhead(uint32_t sectors);
     int		GetSectorSize(uint32_t sector);
     bool	IsMode2(uint32_t sector);
     int		GetMode2Form(uint32_t sector);
@@ -8,7 +8,7 @@
  *
  *		CD-ROM image support.
  *
- * Version:	@(#)cdrom_image.cpp	1.0.22	2020/11/30
+ * Version:	@(#)cdrom_image.cpp	1.0.23	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -1082,6 +1082,7 @@ int
 cdrom_image_open(cdrom_t *dev, const wchar_t *fn)
 {
     CDROM_Interface_Image *img;
+    uint32_t sectors;
 
     wcscpy(dev->image_path, fn);
   
@@ -1106,6 +1107,16 @@ cdrom_image_open(cdrom_t *dev, const wchar_t *fn)
 	return 1;
     }
 
+    /*
+     * Read ahead about a tenth of a second worth of sectors at the
+     * drive's top speed. Faster drives get a bigger buffer, as the
+     * software using them will ask for more data at a time.
+     */
+    sectors = (cdrom_speeds[dev->speed_idx].speed * CD_FPS) / 10;
+    if (sectors < 16)
+	sectors = 16;
+    img->SetReadAhead(sectors);
+
     /* Attach this handler to the drive. */
     dev->reset = NULL;
     dev->ops = &cdrom_image_ops;
@@ -52,7 +52,7 @@
  *		however, are auto-configured by the system software as
  *		shown above.
  *
- * Version:	@(#)hdc_esdi_mca.c	1.0.21	2021/03/16
+ * Version:	@(#)hdc_esdi_mca.c	1.0.23	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Sarah Walker, <tommowalker@tommowalker.co.uk>
@@ -154,7 +154,7 @@ typedef struct {
 
     drive_t	drives[2];
 
-    int		data_pos;
+    int		data_pos;			/* in bytes, DMA may move odd counts */
     uint16_t	data[256];
 
     int		status_pos,
@@ -397,15 +397,17 @@ hdc_callback(priv_t priv)
 						hdd_image_read(drive->hdd_num, dev->rba, 1, (uint8_t *)dev->data);
                                 	}
 
-                                	while (dev->data_pos < 256) {
-                                        	val = dma_channel_write(dev->dma, dev->data[dev->data_pos]);
+                                	while (dev->data_pos < 512) {
+                                        	val = dma_channel_write_block(dev->dma,
+							(uint8_t *)dev->data + dev->data_pos,
+							512 - dev->data_pos);
 
                                         	if (val == DMA_NODATA) {
                                                 	dev->callback = ESDI_TIME;
                                                 	return;
                                         	}
 
-                                        	dev->data_pos++;
+                                        	dev->data_pos += (val & ~DMA_OVER);
                                 	}
 
                                 	dev->data_pos = 0;
@@ -465,15 +467,17 @@ hdc_callback(priv_t priv)
 				}
 
 				while (dev->sector_pos < dev->sector_count) {
-                                	while (dev->data_pos < 256) {
-	                                        val = dma_channel_read(dev->dma);
+                                	while (dev->data_pos < 512) {
+	                                        val = dma_channel_read_block(dev->dma,
+							(uint8_t *)dev->data + dev->data_pos,
+							512 - dev->data_pos);
 
                                         	if (val == DMA_NODATA) {
                                                 	dev->callback = ESDI_TIME;
                                                 	return;
                                         	}
 
-						dev->data[dev->data_pos++] = val & 0xffff;
+						dev->data_pos += (val & ~DMA_OVER);
                                 	}
 
                                 	if (dev->rba >= drive->sectors)
@@ -646,15 +650,17 @@ hdc_callback(priv_t priv)
                                 	return;
                         	}
                         	while (dev->sector_pos < dev->sector_count) {
-                                	while (dev->data_pos < 256) {
-                                        	val = dma_channel_read(dev->dma);
+                                	while (dev->data_pos < 512) {
+                                        	val = dma_channel_read_block(dev->dma,
+							(uint8_t *)dev->data + dev->data_pos,
+							512 - dev->data_pos);
 
                                         	if (val == DMA_NODATA) {
                                                 	dev->callback = ESDI_TIME;
                                                 	return;
                                         	}
 
-                                        	dev->data[dev->data_pos++] = val & 0xffff;;
+                                        	dev->data_pos += (val & ~DMA_OVER);
                                 	}
 
                                 	memcpy(dev->sector_buffer[dev->sector_pos++], dev->data, 512);
@@ -703,15 +709,17 @@ hdc_callback(priv_t priv)
                         	while (dev->sector_pos < dev->sector_count) {
                                 	if (! dev->data_pos)
                                         	memcpy(dev->data, dev->sector_buffer[dev->sector_pos++], 512);
-                                	while (dev->data_pos < 256) {
-                                        	val = dma_channel_write(dev->dma, dev->data[dev->data_pos]);
+                                	while (dev->data_pos < 512) {
+                                        	val = dma_channel_write_block(dev->dma,
+							(uint8_t *)dev->data + dev->data_pos,
+							512 - dev->data_pos);
 
                                         	if (val == DMA_NODATA) {
                                                 	dev->callback = ESDI_TIME;
                                                 	return;
                                         	}
 
-						dev->data_pos++;
+						dev->data_pos += (val & ~DMA_OVER);
 					}
 
 					dev->data_pos = 0;
@@ -8,7 +8,7 @@
  *
  *		Definitions for the IDE module.
  *
- * Version:	@(#)hdc_ide.h	1.0.17	2021/03/16
+ * Version:	@(#)hdc_ide.h	1.0.18	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -148,6 +148,9 @@ extern void	ide_set_bus_master(int (*read)(int channel, uint8_t *data, int trans
 				   int (*write)(int channel, uint8_t *data, int transfer_length, priv_t priv),
 				   void (*set_irq)(int channel, priv_t priv),
 				   priv_t priv0, priv_t priv1);
+extern void	ide_set_bus_master_sg(int (*sg)(int channel, int transfer_length,
+						void (*func)(uint32_t addr, int pos, int len, priv_t arg),
+						priv_t arg, priv_t priv));
 
 
 extern void	win_cdrom_eject(uint8_t id);
@@ -169,6 +172,9 @@ extern void	ide_padstr8(uint8_t *buf, int buf_size, const char *src);
 extern int	(*ide_bus_master_read)(int channel, uint8_t *data, int transfer_length, priv_t priv);
 extern int	(*ide_bus_master_write)(int channel, uint8_t *data, int transfer_length, priv_t priv);
 extern void	(*ide_bus_master_set_irq)(int channel, priv_t priv);
+extern int	(*ide_bus_master_sg)(int channel, int transfer_length,
+				     void (*func)(uint32_t addr, int pos, int len, priv_t arg),
+				     priv_t arg, priv_t priv);
 extern priv_t	ide_bus_master_priv[2];
 
 extern void	ide_enable_pio_override(void);
@@ -14,7 +14,7 @@
  *		Devices currently implemented are hard disk, CD-ROM and
  *		ZIP IDE/ATAPI devices.
  *
- * Version:	@(#)hdc_ide_ata.c	1.0.38	2021/03/16
+ * Version:	@(#)hdc_ide_ata.c	1.0.39	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -65,6 +65,7 @@
 #include "../../plat.h"
 #include "../system/pic.h"
 #include "../system/pci.h"
+#include "../system/dma.h"
 #include "../scsi/scsi_device.h"
 #include "../cdrom/cdrom.h"
 #include "hdc.h"
@@ -157,6 +158,9 @@ ide_t	*ide_drives[IDE_NUM+XTIDE_NUM];
 int	(*ide_bus_master_read)(int channel, uint8_t *data, int transfer_length, priv_t priv);
 int	(*ide_bus_master_write)(int channel, uint8_t *data, int transfer_length, priv_t priv);
 void	(*ide_bus_master_set_irq)(int channel, priv_t priv);
+int	(*ide_bus_master_sg)(int channel, int transfer_length,
+			     void (*func)(uint32_t addr, int pos, int len, priv_t arg),
+			     priv_t arg, priv_t priv);
 priv_t	ide_bus_master_priv[2];
 int	ide_inited = 0;
 int	ide_ter_enabled = 0, ide_qua_enabled = 0;
@@ -1767,6 +1771,129 @@ ide_readl(uint16_t addr, priv_t priv)
 }
 
 
+/* State for a scatter/gather DMA transfer. */
+typedef struct {
+    ide_t	*ide;
+    uint32_t	sector;			/* first sector of the transfer */
+    uint8_t	staged[256 / 8];	/* sectors staged in sector_buffer */
+} ide_dma_t;
+
+
+/*
+ * Move one PRD region from the disk image to guest memory.
+ *
+ * A region that covers whole sectors of plain RAM is read into
+ * it directly. Anything else (odd sizes, or memory-mapped I/O)
+ * goes through the sector buffer, like it used to.
+ */
+static void
+ide_dma_region_read(uint32_t addr, int pos, int len, priv_t arg)
+{
+    ide_dma_t *dma = (ide_dma_t *)arg;
+    ide_t *ide = dma->ide;
+    uint8_t *ptr = NULL;
+    int first, last;
+
+    if (len <= 0) return;
+
+    if (! ((pos | len) & 511))
+	ptr = mem_get_ram_ptr(addr, len);
+
+    if (ptr != NULL) {
+	hdd_image_read(ide->hdd_num, dma->sector + (pos >> 9),
+		       len >> 9, ptr);
+	mem_invalidate_range(addr, addr + len - 1);
+	return;
+    }
+
+    first = pos >> 9;
+    last = (pos + len - 1) >> 9;
+    hdd_image_read(ide->hdd_num, dma->sector + first, last - first + 1,
+		   &ide->sector_buffer[first << 9]);
+    DMAPageWrite(addr, &ide->sector_buffer[pos], len);
+}
+
+
+/*
+ * Move one PRD region from guest memory to the disk image.
+ *
+ * Sectors split over more than one region can only be written
+ * once all of their bytes are in, so those are collected in the
+ * sector buffer and written by ide_dma_flush() afterwards.
+ */
+static void
+ide_dma_region_write(uint32_t addr, int pos, int len, priv_t arg)
+{
+    ide_dma_t *dma = (ide_dma_t *)arg;
+    ide_t *ide = dma->ide;
+    uint8_t *ptr = NULL;
+    int i;
+
+    if (len <= 0) return;
+
+    if (! ((pos | len) & 511))
+	ptr = mem_get_ram_ptr(addr, len);
+
+    if (ptr != NULL) {
+	hdd_image_write(ide->hdd_num, dma->sector + (pos >> 9),
+			len >> 9, ptr);
+	return;
+    }
+
+    DMAPageRead(addr, &ide->sector_buffer[pos], len);
+    for (i = (pos >> 9); i <= ((pos + len - 1) >> 9); i++)
+	dma->staged[i >> 3] |= (1 << (i & 7));
+}
+
+
+/* Write out the sectors that were collected in the sector buffer. */
+static void
+ide_dma_flush(ide_dma_t *dma, int count)
+{
+    ide_t *ide = dma->ide;
+    int i, n;
+
+    for (i = 0; i < count; i += n) {
+	for (n = 0; ((i + n) < count) &&
+		    (dma->staged[(i + n) >> 3] & (1 << ((i + n) & 7))); n++)
+		;
+
+	if (n == 0) {
+		n = 1;
+		continue;
+	}
+
+	hdd_image_write(ide->hdd_num, dma->sector + i, n,
+			&ide->sector_buffer[i << 9]);
+    }
+}
+
+
+/*
+ * Run a DMA command through the bus master's scatter/gather hook,
+ * moving each PRD region straight between the image and memory.
+ */
+static int
+ide_dma_sg(ide_t *ide, int rd)
+{
+    ide_dma_t dma;
+    int ret;
+
+    memset(&dma, 0x00, sizeof(dma));
+    dma.ide = ide;
+    dma.sector = (uint32_t)ide_get_sector(ide);
+
+    ret = ide_bus_master_sg(ide->board, ide->sector_pos * 512,
+			    rd ? ide_dma_region_read : ide_dma_region_write,
+			    &dma, ide_bus_master_priv[ide->board]);
+
+    if (!rd && (ret == 0))
+	ide_dma_flush(&dma, ide->sector_pos);
+
+    return(ret);
+}
+
+
 static void
 ide_callback(priv_t priv)
 {
@@ -1925,15 +2052,19 @@ ide_callback(priv_t priv)
 			ide->sector_pos = ide->secount;
 		else
 			ide->sector_pos = 256;
-		hdd_image_read(ide->hdd_num, ide_get_sector(ide), ide->sector_pos, ide->sector_buffer);
 
 		ide->pos = 0;
 
 		if (ide_bus_master_read) {
 			/* We should not abort - we should simply wait for the host to start DMA. */
-			ret = ide_bus_master_read(ide->board,
-						  ide->sector_buffer, ide->sector_pos * 512,
-						  ide_bus_master_priv[ide->board]);
+			if (ide_bus_master_sg)
+				ret = ide_dma_sg(ide, 1);
+			else {
+				hdd_image_read(ide->hdd_num, ide_get_sector(ide), ide->sector_pos, ide->sector_buffer);
+				ret = ide_bus_master_read(ide->board,
+							  ide->sector_buffer, ide->sector_pos * 512,
+							  ide_bus_master_priv[ide->board]);
+			}
 			if (ret == 2) {
 				/* Bus master DMA disabled, simply wait for the host to enable DMA. */
 				ide->atastat = DRQ_STAT | DRDY_STAT | DSC_STAT;
@@ -2029,9 +2160,12 @@ ide_callback(priv_t priv)
 			else
 				ide->sector_pos = 256;
 
-			ret = ide_bus_master_write(ide->board,
-						   ide->sector_buffer, ide->sector_pos * 512,
-						   ide_bus_master_priv[ide->board]);
+			if (ide_bus_master_sg)
+				ret = ide_dma_sg(ide, 0);
+			else
+				ret = ide_bus_master_write(ide->board,
+							   ide->sector_buffer, ide->sector_pos * 512,
+							   ide_bus_master_priv[ide->board]);
 
 			if (ret == 2) {
 				/* Bus master DMA disabled, simply wait for the host to enable DMA. */
@@ -2046,7 +2180,9 @@ ide_callback(priv_t priv)
 				/*DMA successful*/
 				DEBUG("IDE %i: DMA write successful\n", ide->channel);
 
-				hdd_image_write(ide->hdd_num, ide_get_sector(ide), ide->sector_pos, ide->sector_buffer);
+				/* The scatter/gather path has written it already. */
+				if (! ide_bus_master_sg)
+					hdd_image_write(ide->hdd_num, ide_get_sector(ide), ide->sector_pos, ide->sector_buffer);
 
 				ide->atastat = DRDY_STAT | DSC_STAT;
 
@@ -2420,6 +2556,7 @@ ide_clear_bus_master(void)
 {
     ide_bus_master_read = ide_bus_master_write = NULL;
     ide_bus_master_set_irq = NULL;
+    ide_bus_master_sg = NULL;
     ide_bus_master_priv[0] = ide_bus_master_priv[1] = NULL;
 }
 
@@ -2474,6 +2611,16 @@ ide_set_bus_master(int (*read)(int channel, uint8_t *data, int transfer_length,
 }
 
 
+/* Optional, for bus masters that can hand out their PRD regions. */
+void
+ide_set_bus_master_sg(int (*sg)(int channel, int transfer_length,
+				void (*func)(uint32_t addr, int pos, int len, priv_t arg),
+				priv_t arg, priv_t priv))
+{
+    ide_bus_master_sg = sg;
+}
+
+
 static priv_t
 ide_init(const device_t *info, void *parent)
 {
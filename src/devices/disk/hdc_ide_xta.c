@@ -46,7 +46,7 @@
  *
  * NOTE:	The XTA interface is 0-based for sector numbers !!
  *
- * Version:	@(#)hdc_ide_xta.c	1.0.18	2021/03/16
+ * Version:	@(#)hdc_ide_xta.c	1.0.19	2026/10/19
  *
  * Author:	Fred N. van Kempen, <decwiz@yahoo.com>
  *
@@ -577,8 +577,9 @@ do_send:
 				if (! no_data) {
 					/* Perform DMA. */
 					while (dev->buf_idx < dev->buf_len) {
-						val = dma_channel_write(dev->dma,
-							*dev->buf_ptr);
+						val = dma_channel_write_block(dev->dma,
+							dev->buf_ptr,
+							dev->buf_len - dev->buf_idx);
 						if (val == DMA_NODATA) {
 							ERRLOG("%s: CMD_READ_SECTORS out of data (idx=%i, len=%i)!\n",
 								dev->name, dev->buf_idx, dev->buf_len);
@@ -587,8 +588,9 @@ do_send:
 							dev->callback = HDC_TIME;
 							return;
 						}
-						dev->buf_ptr++;
-						dev->buf_idx++;
+						val &= ~DMA_OVER;
+						dev->buf_ptr += val;
+						dev->buf_idx += val;
 					}
 				}
 				dev->callback = HDC_TIME;
@@ -682,7 +684,9 @@ do_recv:
 					/* Perform DMA. */
 					dev->status = STAT_BSY;
 					while (dev->buf_idx < dev->buf_len) {
-						val = dma_channel_read(dev->dma);
+						val = dma_channel_read_block(dev->dma,
+							&dev->buf_ptr[dev->buf_idx],
+							dev->buf_len - dev->buf_idx);
 						if (val == DMA_NODATA) {
 							ERRLOG("%s: CMD_WRITE_SECTORS out of data (idx=%i, len=%i)!\n",
 								dev->name, dev->buf_idx, dev->buf_len);
@@ -692,8 +696,7 @@ do_recv:
 							return;
 						}
 
-						dev->buf_ptr[dev->buf_idx] = (val & 0xff);
-						dev->buf_idx++;
+						dev->buf_idx += (val & ~DMA_OVER);
 					}
 					dev->state = STATE_RDONE;
 					dev->callback = HDC_TIME;
@@ -821,7 +824,9 @@ do_recv:
 				if (dev->intr & DMA_ENA) {
 					/* Perform DMA. */
 					while (dev->buf_idx < dev->buf_len) {
-						val = dma_channel_read(dev->dma);
+						val = dma_channel_read_block(dev->dma,
+							&dev->buf_ptr[dev->buf_idx],
+							dev->buf_len - dev->buf_idx);
 						if (val == DMA_NODATA) {
 							ERRLOG("%s: CMD_WRITE_BUFFER out of data!\n",
 								dev->name);
@@ -830,8 +835,7 @@ do_recv:
 							return;
 						}
 
-						dev->buf_ptr[dev->buf_idx] = (val & 0xff);
-						dev->buf_idx++;
+						dev->buf_idx += (val & ~DMA_OVER);
 					}
 					dev->state = STATE_RDONE;
 					dev->callback = HDC_TIME;
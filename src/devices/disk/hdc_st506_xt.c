@@ -41,7 +41,7 @@
  *		Since all controllers (including the ones made by DTC) use
  *		(mostly) the same API, we keep them all in this module.
  *
- * Version:	@(#)hdc_st506_xt.c	1.0.24	2021/03/12
+ * Version:	@(#)hdc_st506_xt.c	1.0.25	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -653,8 +653,10 @@ call_back(priv_t priv)
 				break;
 
 			case STATE_SEND_DATA:
-				for (; dev->buff_pos < dev->buff_cnt; dev->buff_pos++) {
-					val = dma_channel_write(dev->dma, dev->buff[dev->buff_pos]);
+				while (dev->buff_pos < dev->buff_cnt) {
+					val = dma_channel_write_block(dev->dma,
+						&dev->buff[dev->buff_pos],
+						dev->buff_cnt - dev->buff_pos);
 					if (val == DMA_NODATA) {
 						ERRLOG("ST506: CMD_READ out of data!\n");
 						hdc_error(dev, ERR_NO_RECOVERY);
@@ -662,6 +664,7 @@ call_back(priv_t priv)
 						hdd_active(drive->hdd_num, 0);
 						return;
 					}
+					dev->buff_pos += (val & ~DMA_OVER);
 				}
 				dma_set_drq(dev->dma, 0);
 				dev->callback = ST506_TIME;
@@ -748,8 +751,10 @@ call_back(priv_t priv)
 				break;
 
 			case STATE_RECEIVE_DATA:
-				for (; dev->buff_pos < dev->buff_cnt; dev->buff_pos++) {
-					val = dma_channel_read(dev->dma);
+				while (dev->buff_pos < dev->buff_cnt) {
+					val = dma_channel_read_block(dev->dma,
+						&dev->buff[dev->buff_pos],
+						dev->buff_cnt - dev->buff_pos);
 					if (val == DMA_NODATA) {
 						ERRLOG("ST506: CMD_WRITE out of data!\n");
 						hdc_error(dev, ERR_NO_RECOVERY);
@@ -757,7 +762,7 @@ call_back(priv_t priv)
 						hdd_active(drive->hdd_num, 0);
 						return;
 					}
-					dev->buff[dev->buff_pos] = val & 0xff;
+					dev->buff_pos += (val & ~DMA_OVER);
 				}
 
 				dma_set_drq(dev->dma, 0);
@@ -864,14 +869,17 @@ call_back(priv_t priv)
 				break;
 
 			case STATE_SEND_DATA:
-				for (; dev->buff_pos < dev->buff_cnt; dev->buff_pos++) {
-					val = dma_channel_write(dev->dma, dev->buff[dev->buff_pos]);
+				while (dev->buff_pos < dev->buff_cnt) {
+					val = dma_channel_write_block(dev->dma,
+						&dev->buff[dev->buff_pos],
+						dev->buff_cnt - dev->buff_pos);
 					if (val == DMA_NODATA) {
 						ERRLOG("ST506: CMD_READ_BUFFER out of data!\n");
 						hdc_error(dev, ERR_NO_RECOVERY);
 						hdc_complete(dev);
 						return;
 					}
+					dev->buff_pos += (val & ~DMA_OVER);
 				}
 
 				dma_set_drq(dev->dma, 0);
@@ -902,15 +910,17 @@ call_back(priv_t priv)
 				break;
 
 			case STATE_RECEIVE_DATA:
-				for (; dev->buff_pos < dev->buff_cnt; dev->buff_pos++) {
-					val = dma_channel_read(dev->dma);
+				while (dev->buff_pos < dev->buff_cnt) {
+					val = dma_channel_read_block(dev->dma,
+						&dev->buff[dev->buff_pos],
+						dev->buff_cnt - dev->buff_pos);
 					if (val == DMA_NODATA) {
 						ERRLOG("ST506: CMD_WRITE_BUFFER out of data!\n");
 						hdc_error(dev, ERR_NO_RECOVERY);
 						hdc_complete(dev);
 						return;
 					}
-					dev->buff[dev->buff_pos] = val & 0xff;
+					dev->buff_pos += (val & ~DMA_OVER);
 				}
 
 				dma_set_drq(dev->dma, 0);
@@ -14,7 +14,7 @@
  *		merged with hdd.c, since that is the scope of hdd.c. The
  *		actual format handlers can then be in hdd_format.c etc.
  *
- * Version:	@(#)hdd_image.c	1.0.15	2021/03/18
+ * Version:	@(#)hdd_image.c	1.0.16	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -489,7 +489,7 @@ void
 hdd_image_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 {
     hdd_image_t *img = &hdd_images[id];
-    uint32_t i;
+    size_t i;
  
 #ifdef USE_MINIVHD
     if (img->type == HDD_IMAGE_VHD) {
@@ -502,22 +502,14 @@ hdd_image_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 	/* Move to the desired position in the image. */
 	fseeko64(img->file, ((uint64_t)sector << 9LL) + img->base, SEEK_SET);
 
-	/* Now read all (consecutive) blocks from the image. */
-	for (i = 0; i < count; i++) {
-		/* If past end of image, give up. */
-		if (ferror(img->file) || feof(img->file))
-			break;
-
-		/* Read a block. */
-		fread(buffer + (i << 9), 1, 512, img->file);
-
-		/* If error during read, give up. */
-		if (ferror(img->file))
-			break;
-
-		/* Update position. */
-		img->pos = sector + i;
-	}
+	/*
+	 * Now read all (consecutive) blocks from the image, in one
+	 * go. If we run past the end of the image, or get an error,
+	 * we stop at the last block that was read in full.
+	 */
+	i = fread(buffer, 512, count, img->file);
+	if (i > 0)
+		img->pos = sector + (uint32_t)i - 1;
 #ifdef USE_MINIVHD
     }
 #endif
@@ -572,7 +564,7 @@ hdd_image_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 #ifdef USE_MINIVHD
     int remaining;
 #endif
-    uint32_t i;
+    size_t i;
 
 #ifdef USE_MINIVHD
     if (img->type == HDD_IMAGE_VHD) {
@@ -583,18 +575,10 @@ hdd_image_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 	/* Move to the desired position in the image. */
 	fseeko64(img->file, ((uint64_t)sector << 9LL) + img->base, SEEK_SET);
 
-	/* Now write all (consecutive) blocks to the image. */
-	for (i = 0; i < count; i++) {
-		/* Write a block. */
-		fwrite(buffer + (i << 9), 512, 1, img->file);
-
-		/* If error during write, give up. */
-		if (ferror(img->file))
-			break;
-
-		/* Update position. */
-		img->pos = sector + i;
-	}
+	/* Now write all (consecutive) blocks to the image, in one go. */
+	i = fwrite(buffer, 512, count, img->file);
+	if (i > 0)
+		img->pos = sector + (uint32_t)i - 1;
 #ifdef USE_MINIVHD		
     }
 #endif
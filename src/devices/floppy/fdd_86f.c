@@ -10,7 +10,7 @@
  *		data in the form of FM/MFM-encoded transitions) which also
  *		forms the core of the emulator's floppy disk emulation.
  *
- * Version:	@(#)fdd_86f.c	1.0.20	2021/03/18
+ * Version:	@(#)fdd_86f.c	1.0.23	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -42,6 +42,14 @@
 #include <stdlib.h>
 #include <stdarg.h>
 #include <wchar.h>
+#include <time.h>
+#ifdef _WIN32
+# define WIN32_LEAN_AND_MEAN
+# include <windows.h>
+# include <io.h>
+#else
+# include <sys/mman.h>
+#endif
 #define HAVE_STDARG_H
 #define dbglog d86f_log
 #include "../../emu.h"
@@ -52,9 +60,40 @@
 #include "fdd.h"
 #include "fdc.h"
 #include "fdd_86f.h"
-#ifdef D86F_COMPRESS
-# include "lzf/lzf.h"
-#endif
+#include "../../timer.h"
+#include "../../nvr.h"
+#include "lzf/lzf.h"
+
+
+/*
+ * Compressed images.
+ *
+ * The original compressed format ("86bf") is the entire image, less
+ * its header, compressed as a single LZF stream. Rewriting that on
+ * every writeback is way too slow, so we now store compressed images
+ * in blocks ("86bt"), each compressed on its own:
+ *
+ *   0	86F header (8 bytes, with the new magic)
+ *   8	uncompressed image size (4 bytes)
+ *  12	number of blocks in use (4 bytes)
+ *  16	block index, D86F_BLOCKS entries of d86f_block_t
+ *	block data
+ *
+ * A writeback only recompresses the blocks its track touched. If a
+ * block no longer fits in its old slot, it goes into a slot freed up
+ * earlier, or is appended to the file. Any space left unused is given
+ * back when the image is closed, by writing it out again in one go.
+ * Old-style images are converted on their first writeback.
+ */
+# define D86F_MAGIC		0x46423638	/* "86BF" */
+# define D86F_MAGIC_LZF		0x66623638	/* "86bf" */
+# define D86F_MAGIC_BLOCKS	0x74623638	/* "86bt" */
+# define D86F_BLOCK_SIZE	32768
+# define D86F_BLOCKS		2048		/* 64MB maximum */
+# define D86F_BLOCK_RAW		0x80000000	/* block is not compressed */
+# define D86F_INDEX_OFFSET	16
+# define D86F_DATA_OFFSET	(D86F_INDEX_OFFSET + \
+				 (D86F_BLOCKS * sizeof(d86f_block_t)))
 
 
 /*
@@ -194,6 +233,12 @@ typedef struct _sector_ {
  *		If bits 6, 5 are 0, and bit 7 is 1, the extra bitcell count
  *		specifies the entire bitcell count
  */
+typedef struct {
+    uint32_t	offset,			/* position in the file */
+		len,			/* compressed length */
+		cap;			/* size of the slot */
+} d86f_block_t;
+
 typedef struct {
     FILE	*f;
     uint16_t	version;
@@ -229,8 +274,17 @@ typedef struct {
     uint16_t	current_bit[2];
     int		cur_track;
     uint32_t	error_condition;
-#ifdef D86F_COMPRESS
     int		is_compressed;
+    FILE	*cf;			/* the compressed image */
+    d86f_block_t blocks[D86F_BLOCKS];
+    uint8_t	dirty[D86F_BLOCKS];
+    d86f_block_t slots[D86F_BLOCKS];	/* free slots in the file */
+    int		nslots;
+    uint8_t	*map;			/* mapped (uncompressed) image */
+    uint32_t	map_len,
+		map_pos;
+#ifdef _WIN32
+    HANDLE	map_handle;
 #endif
     int		id_found;
     wchar_t	original_file_name[2048];
@@ -2285,6 +2339,7 @@ void
 d86f_turbo_poll(int drive, int side)
 {
     d86f_t *dev = d86f[drive];
+    int state;
 
     if ((dev->state != STATE_IDLE) && (dev->state != STATE_SECTOR_NOT_FOUND) && ((dev->state & 0xF8) != 0xE8)) {
 	if (! d86f_can_read_address(drive)) {
@@ -2385,12 +2440,30 @@ d86f_turbo_poll(int drive, int side)
 	case STATE_0C_READ_DATA:
 	case STATE_11_SCAN_DATA:
 	case STATE_16_VERIFY_DATA:
-		d86f_turbo_read(drive, side);
+		/*
+		 * With DMA, nobody can see the individual bytes go by,
+		 * so we move the entire sector in a single poll. The FDC
+		 * may start on the next sector when this one is done, so
+		 * we stop as soon as the state changes.
+		 */
+		if (fdc_is_dma(d86f_fdc)) {
+			state = dev->state;
+			do {
+				d86f_turbo_read(drive, side);
+			} while (dev->state == state);
+		} else
+			d86f_turbo_read(drive, side);
 		break;
 
 	case STATE_05_WRITE_DATA:
 	case STATE_09_WRITE_DATA:
-		d86f_turbo_write(drive, side);
+		if (fdc_is_dma(d86f_fdc)) {
+			state = dev->state;
+			do {
+				d86f_turbo_write(drive, side);
+			} while (dev->state == state);
+		} else
+			d86f_turbo_write(drive, side);
 		break;
 
 	case STATE_0D_FORMAT_TRACK:
@@ -2903,6 +2976,76 @@ d86f_track_header_size(int drive)
 }
 
 
+/*
+ * Map the image file, so tracks can be read straight from memory.
+ *
+ * All writes still go through the file, which (once flushed) the
+ * mapping sees as well. If the file cannot be mapped, or something
+ * lies beyond the mapped part, we simply read it from the file.
+ */
+static void
+d86f_map(d86f_t *dev)
+{
+    if ((dev->f == NULL) || (dev->file_size == 0)) return;
+
+#ifdef _WIN32
+    dev->map_handle = CreateFileMappingA((HANDLE)_get_osfhandle(_fileno(dev->f)),
+					 NULL, PAGE_READONLY, 0, 0, NULL);
+    if (dev->map_handle == NULL) return;
+
+    dev->map = (uint8_t *)MapViewOfFile(dev->map_handle, FILE_MAP_READ,
+					0, 0, dev->file_size);
+    if (dev->map == NULL) {
+	CloseHandle(dev->map_handle);
+	dev->map_handle = NULL;
+	return;
+    }
+#else
+    dev->map = (uint8_t *)mmap(NULL, dev->file_size, PROT_READ,
+			       MAP_SHARED, fileno(dev->f), 0);
+    if (dev->map == (uint8_t *)MAP_FAILED) {
+	dev->map = NULL;
+	return;
+    }
+#endif
+
+    dev->map_len = dev->file_size;
+}
+
+
+static void
+d86f_unmap(d86f_t *dev)
+{
+    if (dev->map == NULL) return;
+
+#ifdef _WIN32
+    (void)UnmapViewOfFile(dev->map);
+    CloseHandle(dev->map_handle);
+    dev->map_handle = NULL;
+#else
+    (void)munmap(dev->map, dev->map_len);
+#endif
+
+    dev->map = NULL;
+    dev->map_len = 0;
+}
+
+
+/* Read from the image at map_pos, using the mapping if we can. */
+static void
+d86f_fetch(d86f_t *dev, void *buf, uint32_t len)
+{
+    if ((dev->map != NULL) && ((dev->map_pos + len) <= dev->map_len))
+	memcpy(buf, dev->map + dev->map_pos, len);
+    else {
+	fseek(dev->f, dev->map_pos, SEEK_SET);
+	fread(buf, 1, len, dev->f);
+    }
+
+    dev->map_pos += len;
+}
+
+
 void
 d86f_read_track(int drive, int track, int thin_track, int side, uint16_t *da, uint16_t *sa)
 {
@@ -2917,10 +3060,10 @@ d86f_read_track(int drive, int track, int thin_track, int side, uint16_t *da, ui
 
     if (dev->track_offset[logical_track]) {
 	if (! thin_track) {
-		fseek(dev->f, dev->track_offset[logical_track], SEEK_SET);
-		fread(&(dev->side_flags[side]), 2, 1, dev->f);
+		dev->map_pos = dev->track_offset[logical_track];
+		d86f_fetch(dev, &(dev->side_flags[side]), 2);
 		if (d86f_has_extra_bit_cells(drive)) {
-			fread(&(dev->extra_bit_cells[side]), 4, 1, dev->f);
+			d86f_fetch(dev, &(dev->extra_bit_cells[side]), 4);
 			/* If RPM shift is 0% and direction is 1, do not adjust extra bit cells,
 			   as that is the whole track length. */
 			if (d86f_get_rpm_mode(drive) || !d86f_get_speed_shift_dir(drive)) {
@@ -2931,13 +3074,13 @@ d86f_read_track(int drive, int track, int thin_track, int side, uint16_t *da, ui
 			}
 		} else
 			dev->extra_bit_cells[side] = 0;
-		fread(&(dev->index_hole_pos[side]), 4, 1, dev->f);
+		d86f_fetch(dev, &(dev->index_hole_pos[side]), 4);
 	} else
-		fseek(dev->f, dev->track_offset[logical_track] + d86f_track_header_size(drive), SEEK_SET);
+		dev->map_pos = dev->track_offset[logical_track] + d86f_track_header_size(drive);
 	array_size = d86f_get_array_size(drive, side, 0);
 	if (d86f_has_surface_desc(drive))
-		fread(sa, 1, array_size, dev->f);
-	fread(da, 1, array_size, dev->f);
+		d86f_fetch(dev, sa, array_size);
+	d86f_fetch(dev, da, array_size);
     } else {
 	if (! thin_track) {
 		switch((dev->disk_flags >> 1) & 3) {
@@ -3060,6 +3203,227 @@ d86f_set_cur_track(int drive, int track)
 }
 
 
+/* Mark the blocks holding a range of the uncompressed image as dirty. */
+static void
+d86f_mark_dirty(d86f_t *dev, uint32_t start, uint32_t end)
+{
+    uint32_t i;
+
+    if (! dev->is_compressed) return;
+
+    for (i = (start / D86F_BLOCK_SIZE); i < D86F_BLOCKS; i++) {
+	if ((i * D86F_BLOCK_SIZE) >= end) break;
+	dev->dirty[i] = 1;
+    }
+}
+
+
+/*
+ * Decompress a block-compressed image into the temporary file.
+ *
+ * Returns the size of the uncompressed image, or 0 if it is bad.
+ */
+static uint32_t
+d86f_blocks_load(d86f_t *dev, FILE *cf, FILE *tf)
+{
+    d86f_block_t *b;
+    uint32_t len, ulen, clen, i, n;
+
+    fseek(cf, 8, SEEK_SET);
+    if ((fread(&len, 1, 4, cf) != 4) || (fread(&n, 1, 4, cf) != 4) ||
+	(n > D86F_BLOCKS) || (len > (n * D86F_BLOCK_SIZE))) return(0);
+    if (fread(dev->blocks, sizeof(d86f_block_t), n, cf) != n) return(0);
+
+    for (i = 0; i < n; i++) {
+	b = &dev->blocks[i];
+	clen = b->len & ~D86F_BLOCK_RAW;
+	ulen = len - (i * D86F_BLOCK_SIZE);
+	if (ulen > D86F_BLOCK_SIZE)
+		ulen = D86F_BLOCK_SIZE;
+	if ((clen > D86F_BLOCK_SIZE) || (clen > b->cap)) return(0);
+
+	fseek(cf, b->offset, SEEK_SET);
+	if (fread(dev->filebuf, 1, clen, cf) != clen) return(0);
+
+	if (b->len & D86F_BLOCK_RAW) {
+		if (clen != ulen) return(0);
+		memcpy(dev->outbuf, dev->filebuf, ulen);
+	} else if (lzf_decompress(dev->filebuf, clen,
+				  dev->outbuf, D86F_BLOCK_SIZE) != ulen)
+		return(0);
+
+	fwrite(dev->outbuf, 1, ulen, tf);
+    }
+
+    return(len);
+}
+
+
+/* Start a new block-compressed file, replacing an old-style one. */
+static int
+d86f_blocks_create(d86f_t *dev, const uint8_t *header)
+{
+    uint32_t magic = D86F_MAGIC_BLOCKS;
+    uint32_t zero[2] = { 0, 0 };
+
+    dev->cf = plat_fopen(dev->original_file_name, L"wb+");
+    if (dev->cf == NULL) {
+	ERRLOG("86F: unable to re-create compressed image\n");
+	return(0);
+    }
+
+    fwrite(&magic, 1, 4, dev->cf);
+    fwrite(&header[4], 1, 4, dev->cf);
+    fwrite(zero, 1, 8, dev->cf);
+
+    /* An empty index, so the data starts past it. */
+    memset(dev->blocks, 0x00, sizeof(dev->blocks));
+    fwrite(dev->blocks, 1, sizeof(dev->blocks), dev->cf);
+
+    memset(dev->dirty, 0x01, sizeof(dev->dirty));
+    dev->nslots = 0;
+
+    return(1);
+}
+
+
+/* Remember a slot that is no longer used, so it can be re-used. */
+static void
+d86f_slot_free(d86f_t *dev, uint32_t offset, uint32_t cap)
+{
+    if ((cap == 0) || (dev->nslots >= D86F_BLOCKS)) return;
+
+    dev->slots[dev->nslots].offset = offset;
+    dev->slots[dev->nslots].cap = cap;
+    dev->nslots++;
+}
+
+
+/* Find the smallest free slot that will hold 'len' bytes. */
+static int
+d86f_slot_alloc(d86f_t *dev, uint32_t len, d86f_block_t *b)
+{
+    d86f_block_t *s;
+    int i, best = -1;
+
+    for (i = 0; i < dev->nslots; i++) {
+	if ((dev->slots[i].cap >= len) &&
+	    ((best < 0) || (dev->slots[i].cap < dev->slots[best].cap)))
+		best = i;
+    }
+    if (best < 0)
+	return(0);
+
+    /* Take what we need, and leave the rest free. */
+    s = &dev->slots[best];
+    b->offset = s->offset;
+    b->cap = len;
+    s->offset += len;
+    s->cap -= len;
+    if (s->cap == 0)
+	*s = dev->slots[--dev->nslots];
+
+    return(1);
+}
+
+
+/* Recompress and write out the dirty blocks. */
+static void
+d86f_blocks_flush(d86f_t *dev)
+{
+    d86f_block_t *b;
+    uint32_t len, ulen, clen, i, n;
+
+    fseek(dev->f, 0, SEEK_END);
+    len = ftell(dev->f);
+    n = (len + D86F_BLOCK_SIZE - 1) / D86F_BLOCK_SIZE;
+    if (n > D86F_BLOCKS) {
+	ERRLOG("86F: image too large to compress (%u bytes)\n", len);
+	return;
+    }
+
+    for (i = 0; i < n; i++) {
+	if (! dev->dirty[i]) continue;
+	dev->dirty[i] = 0;
+
+	b = &dev->blocks[i];
+	ulen = len - (i * D86F_BLOCK_SIZE);
+	if (ulen > D86F_BLOCK_SIZE)
+		ulen = D86F_BLOCK_SIZE;
+
+	fseek(dev->f, i * D86F_BLOCK_SIZE, SEEK_SET);
+	fread(dev->filebuf, 1, ulen, dev->f);
+
+	/* If it does not compress, store it as-is. */
+	clen = lzf_compress(dev->filebuf, ulen, dev->outbuf, ulen - 1);
+	if (clen == 0) {
+		memcpy(dev->outbuf, dev->filebuf, ulen);
+		clen = ulen;
+		b->len = clen | D86F_BLOCK_RAW;
+	} else
+		b->len = clen;
+
+	/*
+	 * Re-use the slot if the block still fits. If not, move
+	 * it to a free slot that does, or else append it.
+	 */
+	if (clen > b->cap) {
+		d86f_slot_free(dev, b->offset, b->cap);
+		if (! d86f_slot_alloc(dev, clen, b)) {
+			fseek(dev->cf, 0, SEEK_END);
+			b->offset = ftell(dev->cf);
+			if (b->offset < D86F_DATA_OFFSET)
+				b->offset = D86F_DATA_OFFSET;
+			b->cap = clen;
+		}
+	}
+	fseek(dev->cf, b->offset, SEEK_SET);
+	fwrite(dev->outbuf, 1, clen, dev->cf);
+
+	fseek(dev->cf, D86F_INDEX_OFFSET + (i * sizeof(d86f_block_t)), SEEK_SET);
+	fwrite(b, 1, sizeof(d86f_block_t), dev->cf);
+    }
+
+    fseek(dev->cf, 8, SEEK_SET);
+    fwrite(&len, 1, 4, dev->cf);
+    fwrite(&n, 1, 4, dev->cf);
+
+    fflush(dev->cf);
+}
+
+
+/*
+ * Write the compressed image out again if it has unused space,
+ * so slots freed up during this session do not stay in the file.
+ */
+static void
+d86f_blocks_compact(d86f_t *dev)
+{
+    uint8_t header[8];
+    uint32_t size, used = 0;
+    int i;
+
+    fseek(dev->cf, 0, SEEK_END);
+    size = ftell(dev->cf);
+    for (i = 0; i < D86F_BLOCKS; i++)
+	used += dev->blocks[i].cap;
+    if (size <= (D86F_DATA_OFFSET + used))
+	return;
+
+    DEBUG("86F: compacting image, %u bytes unused\n",
+	  size - (uint32_t)D86F_DATA_OFFSET - used);
+
+    fclose(dev->cf);
+    dev->cf = NULL;
+
+    fseek(dev->f, 0, SEEK_SET);
+    fread(header, 1, sizeof(header), dev->f);
+
+    if (d86f_blocks_create(dev, header))
+	d86f_blocks_flush(dev);
+}
+
+
 void
 d86f_write_tracks(int drive, FILE **f, uint32_t *track_table)
 {
@@ -3096,6 +3460,8 @@ d86f_write_tracks(int drive, FILE **f, uint32_t *track_table)
 			if (tbl[logical_track]) {
 				fseek(*f, tbl[logical_track], SEEK_SET);
 				d86f_write_track(drive, f, side, d86f_handler[drive].encoded_data(drive, side), dev->track_surface_data[side]);
+				if (! track_table)
+					d86f_mark_dirty(dev, tbl[logical_track], ftell(*f));
 			}
 		}
 	}
@@ -3115,6 +3481,8 @@ d86f_write_tracks(int drive, FILE **f, uint32_t *track_table)
 		if (tbl[logical_track]) {
 			fseek(*f, tbl[logical_track], SEEK_SET);
 			d86f_write_track(drive, f, side, dev->track_encoded_data[side], dev->track_surface_data[side]);
+			if (! track_table)
+				d86f_mark_dirty(dev, tbl[logical_track], ftell(*f));
 		}
 	}
     }
@@ -3129,11 +3497,7 @@ d86f_writeback(int drive)
     d86f_t *dev = d86f[drive];
     uint8_t header[32];
     int header_size;
-#ifdef D86F_COMPRESS
-    uint32_t len;
-    int ret = 0;
-    FILE *cf;
-#endif
+
     header_size = d86f_header_size(drive);
 
     if (! dev->f) return;
@@ -3144,40 +3508,21 @@ d86f_writeback(int drive)
 
     fseek(dev->f, 8, SEEK_SET);
     fwrite(dev->track_offset, 1, d86f_get_track_table_size(drive), dev->f);
+    d86f_mark_dirty(dev, 8, 8 + d86f_get_track_table_size(drive));
 
     d86f_write_tracks(drive, &dev->f, NULL);
 
-#ifdef D86F_COMPRESS
-    if (dev->is_compressed) {
-	/* The image is compressed. */
-
-	/* Open the original, compressed file. */
-	cf = plat_fopen(dev->original_file_name, L"wb");
-
-	/* Write the header to the original file. */
-	fwrite(header, 1, header_size, cf);
-
-	fseek(dev->f, 0, SEEK_END);
-	len = ftell(dev->f);
-	len -= header_size;
+    /* Make sure the mapping sees what we wrote. */
+    if (dev->map != NULL)
+	fflush(dev->f);
 
-	fseek(dev->f, header_size, SEEK_SET);
-
-	/* Compress data from the temporary uncompressed file to the original, compressed file. */
-	dev->filebuf = (uint8_t *) mem_alloc(len);
-	dev->outbuf = (uint8_t *) mem_alloc(len - 1);
-	fread(dev->filebuf, 1, len, dev->f);
-	ret = lzf_compress(dev->filebuf, len, dev->outbuf, len - 1);
-
-	if (! ret) {
-		DEBUG("86F: Error compressing file\n");
-	}
+    if (dev->is_compressed && !writeprot[drive]) {
+	/* Old-style images are converted to blocks first. */
+	if ((dev->cf == NULL) && !d86f_blocks_create(dev, header))
+		return;
 
-	fwrite(dev->outbuf, 1, ret, cf);
-	free(dev->outbuf);
-	free(dev->filebuf);
+	d86f_blocks_flush(dev);
     }
-#endif
 }
 
 
@@ -3504,12 +3849,11 @@ d86f_load(int drive, const wchar_t *fn)
     d86f_t *dev = d86f[drive];
     uint32_t magic = 0;
     uint32_t len = 0;
-#ifdef D86F_COMPRESS
     wchar_t temp_file_name[2048];
+    uint32_t ulen = 0;
     uint16_t temp = 0;
     FILE *tf;
     int i;
-#endif
 
     d86f_unregister(drive);
 
@@ -3544,7 +3888,8 @@ d86f_load(int drive, const wchar_t *fn)
 	return(0);
     }
 
-    if ((magic != 0x46423638) && (magic != 0x66623638)) {
+    if ((magic != D86F_MAGIC) && (magic != D86F_MAGIC_LZF) &&
+	(magic != D86F_MAGIC_BLOCKS)) {
 	/* File is not of the valid format, abort. */
 	ERRLOG("86F: Unrecognized magic bytes: %08X\n", magic);
 	fclose(dev->f);
@@ -3571,12 +3916,8 @@ d86f_load(int drive, const wchar_t *fn)
     }
 
     fread(&(dev->disk_flags), 2, 1, dev->f);
-#ifdef D86F_COMPRESS
-    dev->is_compressed = (magic == 0x66623638) ? 1 : 0;
+    dev->is_compressed = (magic != D86F_MAGIC) ? 1 : 0;
     if ((len < 51052) && !dev->is_compressed) {
-#else
-    if (len < 51052) {
-#endif
 	/* File too small, abort. */
 	fclose(dev->f);
 	dev->f = NULL;
@@ -3607,9 +3948,8 @@ d86f_load(int drive, const wchar_t *fn)
     }
 #endif
 
-#ifdef D86F_COMPRESS
     if (dev->is_compressed) {
-	memcpy(temp_file_name, drive ? nvr_path(L"TEMP$$$1.$$$") : nvr_path(L"TEMP$$$0.$$$"), 256);
+	wcscpy(temp_file_name, drive ? nvr_path(L"TEMP$$$1.$$$") : nvr_path(L"TEMP$$$0.$$$"));
 	memcpy(dev->original_file_name, fn, (wcslen(fn) << 1) + 2);
 
 	fclose(dev->f);
@@ -3629,40 +3969,54 @@ d86f_load(int drive, const wchar_t *fn)
 		fwrite(&temp, 1, 2, dev->f);
 	}
 
-	dev->filebuf = (uint8_t *) mem_alloc(len);
-	dev->outbuf = (uint8_t *) mem_alloc(67108864);
-	fread(dev->filebuf, 1, len, tf);
-	temp = lzf_decompress(dev->filebuf, len, dev->outbuf, 67108864);
-	if (temp) {
-		fwrite(dev->outbuf, 1, temp, dev->f);
+	if (magic == D86F_MAGIC_BLOCKS) {
+		dev->filebuf = (uint8_t *)mem_alloc(D86F_BLOCK_SIZE);
+		dev->outbuf = (uint8_t *)mem_alloc(D86F_BLOCK_SIZE);
+		fseek(dev->f, 0, SEEK_SET);
+		ulen = d86f_blocks_load(dev, tf, dev->f);
+	} else {
+		/* Old-style image, one big LZF stream. */
+		dev->filebuf = (uint8_t *) mem_alloc(len);
+		dev->outbuf = (uint8_t *) mem_alloc(67108864);
+		fread(dev->filebuf, 1, len, tf);
+		ulen = lzf_decompress(dev->filebuf, len, dev->outbuf, 67108864);
+		if (ulen) {
+			fwrite(dev->outbuf, 1, ulen, dev->f);
+		}
+		free(dev->outbuf);
+		free(dev->filebuf);
+
+		/* From now on, we only need room for a block. */
+		dev->filebuf = (uint8_t *)mem_alloc(D86F_BLOCK_SIZE);
+		dev->outbuf = (uint8_t *)mem_alloc(D86F_BLOCK_SIZE);
 	}
-	free(dev->outbuf);
-	free(dev->filebuf);
 
 	fclose(tf);
 	fclose(dev->f);
 	dev->f = NULL;
 
-	if (! temp) {
+	if (! ulen) {
 		ERRLOG("86F: Error decompressing file\n");
 		plat_remove(temp_file_name);
+		free(dev->outbuf);
+		free(dev->filebuf);
 		free(dev);
 		return(0);
 	}
 
 	dev->f = plat_fopen(temp_file_name, L"rb+");
     }
-#endif
 
     if (dev->disk_flags & 0x100) {
 	/* Zoned disk. */
 	ERRLOG("86F: Disk is zoned (Apple or Sony)\n");
 	fclose(dev->f);
 	dev->f = NULL;
-#ifdef D86F_COMPRESS
-	if (dev->is_compressed)
+	if (dev->is_compressed) {
 		plat_remove(temp_file_name);
-#endif
+		free(dev->outbuf);
+		free(dev->filebuf);
+	}
 	free(dev);
 	return(0);
     }
@@ -3672,10 +4026,11 @@ d86f_load(int drive, const wchar_t *fn)
 	ERRLOG("86F: Disk is fixed-RPM but zone type is not 0\n");
 	fclose(dev->f);
 	dev->f = NULL;
-#ifdef D86F_COMPRESS
-	if (dev->is_compressed)
+	if (dev->is_compressed) {
 		plat_remove(temp_file_name);
-#endif
+		free(dev->outbuf);
+		free(dev->filebuf);
+	}
 	free(dev);
 	return(0);
     }
@@ -3689,14 +4044,20 @@ d86f_load(int drive, const wchar_t *fn)
 	fclose(dev->f);
 	dev->f = NULL;
 
-#ifdef D86F_COMPRESS
 	if (dev->is_compressed)
 		dev->f = plat_fopen(temp_file_name, L"rb");
 	  else
-#endif
 		dev->f = plat_fopen(fn, L"rb");
     }
 
+    /* Block images are updated in place. */
+    if ((magic == D86F_MAGIC_BLOCKS) && !writeprot[drive]) {
+	dev->cf = plat_fopen(fn, L"rb+");
+	if (dev->cf == NULL) {
+		writeprot[drive] = fwriteprot[drive] = 1;
+	}
+    }
+
     /* OK, set the drive data, other code needs it. */
     d86f[drive] = dev;
 
@@ -3774,19 +4135,18 @@ d86f_load(int drive, const wchar_t *fn)
 
     fseek(dev->f, 0, SEEK_SET);
 
+    /* Tracks are read from a mapping of the (uncompressed) image. */
+    d86f_map(dev);
+
     d86f_register_86f(drive);
 
     drives[drive].seek = d86f_seek;
     d86f_common_handlers(drive);
     drives[drive].format = d86f_format;
 
-#ifdef D86F_COMPRESS
     DEBUG("86F: Disk is %scompressed and does%s have surface description data\n",
 	dev->is_compressed ? "" : "not ",
-#else
-    DEBUG("86F: Disk does%s have surface description data\n",
 	d86f_has_surface_desc(drive) ? "" : " not");
-#endif
 
     /* All good. */
     return(1);
@@ -3815,26 +4175,36 @@ d86f_set_fdc(void *fdc)
 void
 d86f_close(int drive)
 {
-#ifdef D86F_COMPRESS
     wchar_t temp[2048];
-#endif
     d86f_t *dev = d86f[drive];
 
     /* Make sure the drive is alive. */
     if (dev == NULL) return;
 
+    d86f_unmap(dev);
+
+    /* Give back any space freed up in the compressed image. */
+    if (dev->is_compressed && (dev->cf != NULL) && (dev->f != NULL))
+	d86f_blocks_compact(dev);
+
     if (dev->f) {
 	fclose(dev->f);
 	dev->f = NULL;
     }
 
-#ifdef D86F_COMPRESS
     if (dev->is_compressed) {
-	memcpy(temp, drive ? nvr_path(L"TEMP$$$1.$$$")
-			   : nvr_path(L"TEMP$$$0.$$$"), 26);
+	if (dev->cf != NULL) {
+		fclose(dev->cf);
+		dev->cf = NULL;
+	}
+	free(dev->outbuf);
+	free(dev->filebuf);
+	dev->outbuf = dev->filebuf = NULL;
+
+	wcscpy(temp, drive ? nvr_path(L"TEMP$$$1.$$$")
+			   : nvr_path(L"TEMP$$$0.$$$"));
 	plat_remove(temp);
     }
-#endif
 }
 
 
@@ -8,7 +8,7 @@
  *
  *		Handle WinPcap library processing.
  *
- * Version:	@(#)net_pcap.c	1.0.13	2021/03/23
+ * Version:	@(#)net_pcap.c	1.0.14	2026/10/19
  *
  * Author:	Fred N. van Kempen, <decwiz@yahoo.com>
  *
@@ -120,14 +120,6 @@ poll_thread(void *arg)
 
     /* As long as the channel is open.. */
     while (pcap != NULL) {
-	/* Request ownership of the device. */
-	network_wait(1);
-
-	/* Wait for a poll request. */
-	network_poll();
-
-	if (pcap == NULL) break;
-
 	/* Wait for the next packet to arrive. */
 	data = (uint8_t *)PCAP_next((pcap_t *)pcap, &h);
 	if (data != NULL) {
@@ -151,9 +143,6 @@ poll_thread(void *arg)
 	/* If we did not get anything, wait a while. */
 	if (data == NULL)
 		thread_wait_event(evt, 10);
-
-	/* Release ownership of the device. */
-	network_wait(0);
     }
 
     /* No longer needed. */
@@ -245,8 +234,6 @@ do_close(void)
 
     /* Tell the thread to terminate. */
     if (poll_tid != NULL) {
-	network_busy(0);
-
 	/* Wait for the thread to finish. */
 	INFO("PCAP: waiting for thread to end...\n");
 	thread_wait_event(poll_state, -1);
@@ -346,11 +333,7 @@ do_send(const uint8_t *bufp, int len)
 {
     if (pcap == NULL) return;
 
-    network_busy(1);
-
     PCAP_sendpacket((pcap_t *)pcap, (uint8_t *)bufp, len);
-
-    network_busy(0);
 }
 
 
@@ -8,7 +8,7 @@
  *
  *		Handle SLiRP library processing.
  *
- * Version:	@(#)net_slirp.c	1.0.9	2021/03/23
+ * Version:	@(#)net_slirp.c	1.0.10	2026/10/19
  *
  * Author:	Fred N. van Kempen, <decwiz@yahoo.com>
  *
@@ -126,7 +126,7 @@ poll_thread(void *arg)
     uint16_t mac_cmp16[2];
     const uint8_t *mac = (const uint8_t *)arg;
     event_t *evt;
-    int len;
+    int len, n;
 
     INFO("SLiRP: thread started.\n");
     thread_set_event(poll_state);
@@ -135,21 +135,21 @@ poll_thread(void *arg)
     evt = thread_create_event();
 
     while (slirp != NULL) {
-	/* Request ownership of the device. */
+	/* Request ownership of the library. */
 	network_wait(1);
 
-	/* Wait for a poll request. */
-	network_poll();
-
 	/* See if there is any work. */
 	FUNC(poll)(slirp);
 
 	/* Our queue may have been nuked.. */
-	if (slirp == NULL) break;
+	if (slirp == NULL) {
+		network_wait(0);
+		break;
+	}
 
-	/* Wait for the next packet to arrive. */
-	len = FUNC(recv)(slirp, pktbuff);
-	if (len > 0) {
+	/* Queue up all packets that have arrived. */
+	n = 0;
+	while ((len = FUNC(recv)(slirp, pktbuff)) > 0) {
 		/* Received MAC. */
 		mac_cmp32[0] = *(uint32_t *)(pktbuff+6);
 		mac_cmp16[0] = *(uint16_t *)(pktbuff+10);
@@ -162,17 +162,16 @@ poll_thread(void *arg)
 			DBGLOG(1, "SLiRP: got a %ibyte packet\n", len);
 
 			network_rx(pktbuff, len); 
-		} else {
-			/* Mark as invalid packet. */
-			len = 0;
+			n++;
 		}
-	} else {
-		/* If we did not get anything, wait a while. */
-		thread_wait_event(evt, 10);
 	}
 
-	/* Release ownership of the device. */
+	/* Release ownership of the library. */
 	network_wait(0);
+
+	/* If we did not get anything, wait a while. */
+	if (n == 0)
+		thread_wait_event(evt, 10);
     }
 
     /* No longer needed. */
@@ -286,8 +285,6 @@ do_close(void)
 
     /* Tell the thread to terminate. */
     if (poll_tid != NULL) {
-	network_busy(0);
-
 	/* Wait for the thread to finish. */
 	INFO("SLiRP: waiting for thread to end...\n");
 	thread_wait_event(poll_state, -1);
@@ -327,11 +324,11 @@ static void
 do_send(const uint8_t *pkt, int pkt_len)
 {
     if (slirp != NULL) {
-	network_busy(1);
+	network_wait(1);
 
 	FUNC(send)(slirp, pkt, pkt_len);
 
-	network_busy(0);
+	network_wait(0);
     }
 }
 
@@ -8,7 +8,7 @@
  *
  *		Implement an Ethernet-over-UDP link tunnel.
  *
- * Version:	@(#)net_udplink.c	1.0.1	2021/03/23
+ * Version:	@(#)net_udplink.c	1.0.2	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Bryan Biedenkapp, <gatekeep@gmail.com>
@@ -129,26 +129,19 @@ poll_thread(UNUSED(void *arg))
     /* As long as the channel is open.. */
     is_running = 1;
     while (is_running) {
-	/* Request ownership of the device. */
+	/* Request ownership of the library. */
 	network_wait(1);
 
-	/* Wait for a poll request. */
-	network_poll();
-
-	/* Wait for the next packet to arrive. */
-	memset(pkt_buf, 0x00, RX_BUF_SIZE);
-
-	pkt_len = FUNC(recv)(pkt_buf, RX_BUF_SIZE);
-	if (pkt_len > 0) {
+	/* Queue up all packets that have arrived. */
+	while ((pkt_len = FUNC(recv)(pkt_buf, RX_BUF_SIZE)) > 0)
 		network_rx(pkt_buf, pkt_len);
-	} else {
-		/* If we did not get anything, wait a while. */
-		if (pkt_len == 0)
-			thread_wait_event(evt, 10);
-	}
 
-	/* Release ownership of the device. */
+	/* Release ownership of the library. */
 	network_wait(0);
+
+	/* If we did not get anything, wait a while. */
+	if (pkt_len == 0)
+		thread_wait_event(evt, 10);
     }
 
     free(pkt_buf);
@@ -170,8 +163,6 @@ do_close(void)
 
     /* Tell the thread to terminate. */
     if (poll_tid != NULL) {
-	network_busy(0);
-
 	is_running = 0;
 
 	/* Wait for the thread to finish. */
@@ -223,7 +214,7 @@ do_reset(uint8_t *mac)
 
     /* Tell the thread to terminate. */
     if (poll_tid != NULL)
-	network_busy(0);
+	is_running = 0;
 
     /* Wait for the thread to finish. */
     INFO("UDPlink: waiting for thread to end...\n");
@@ -312,16 +303,14 @@ do_send(const uint8_t *bufp, int len)
 {
     char temp[128];
 
-    network_busy(1);
+    network_wait(1);
 
     if (FUNC(send)(bufp, len) <= 0) {
 	FUNC(error)(temp, sizeof(temp));
         ERRLOG("UDPlink: %s\n", temp);
-	network_busy(0);
-	return;
     }
 
-    network_busy(0);
+    network_wait(0);
 }
 
 
@@ -0,0 +1,404 @@
+/*
+ * VARCem	Virtual ARchaeological Computer EMulator.
+ *		An emulator of (mostly) x86-based PC systems and devices,
+ *		using the ISA,EISA,VLB,MCA  and PCI system buses, roughly
+ *		spanning the era between 1981 and 1995.
+ *
+ *		This file is part of the VARCem Project.
+ *
+ *		Implement a provider that connects to a Virtual Switch.
+ *
+ *		This allows several emulator instances on the same host
+ *		(or network) to talk to each other without needing pcap
+ *		or any special privileges. On UNIX systems, the switch
+ *		address can also be the pathname of a local socket.
+ *
+ * Version:	@(#)net_vswitch.c	1.0.3	2026/10/19
+ *
+ * Author:	agent, <agent@local>
+ *
+ *		Copyright 2026 agent.
+ *
+ *		Redistribution and  use  in source  and binary forms, with
+ *		or  without modification, are permitted  provided that the
+ *		following conditions are met:
+ *
+ *		1. Redistributions of  source  code must retain the entire
+ *		   above notice, this list of conditions and the following
+ *		   disclaimer.
+ *
+ *		2. Redistributions in binary form must reproduce the above
+ *		   copyright  notice,  this list  of  conditions  and  the
+ *		   following disclaimer in  the documentation and/or other
+ *		   materials provided with the distribution.
+ *
+ *		3. Neither the  name of the copyright holder nor the names
+ *		   of  its  contributors may be used to endorse or promote
+ *		   products  derived from  this  software without specific
+ *		   prior written permission.
+ *
+ * THIS SOFTWARE  IS  PROVIDED BY THE  COPYRIGHT  HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND  ANY EXPRESS  OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE  ARE  DISCLAIMED. IN  NO  EVENT  SHALL THE COPYRIGHT
+ * HOLDER OR  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL,  EXEMPLARY,  OR  CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE  GOODS OR SERVICES;  LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON  ANY
+ * THEORY OF  LIABILITY, WHETHER IN  CONTRACT, STRICT  LIABILITY, OR  TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING  IN ANY  WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <wchar.h>
+#ifdef _WIN32
+# define WIN32_LEAN_AND_MEAN
+# include <winsock2.h>
+# include <ws2tcpip.h>
+#else
+# include <sys/types.h>
+# include <sys/socket.h>
+# include <sys/select.h>
+# include <sys/un.h>
+# include <netinet/in.h>
+# include <arpa/inet.h>
+# include <netdb.h>
+# include <unistd.h>
+#endif
+#define dbglog network_log
+#include "../../emu.h"
+#include "../../config.h"
+#include "../../device.h"
+#include "../../plat.h"
+#include "../../ui/ui.h"
+#include "network.h"
+#include "net_vswitch.h"
+
+
+#ifdef _WIN32
+# define sock_close	closesocket
+#else
+typedef int		SOCKET;
+# define INVALID_SOCKET	-1
+# define sock_close	close
+#endif
+
+
+static volatile SOCKET	sock = INVALID_SOCKET;
+static volatile thread_t *poll_tid;
+static event_t		*poll_state;
+static volatile int	is_running;
+static uint32_t		last_hello;
+static uint8_t		tx_buf[VSW_DGRAM_MAX];	// outgoing batch
+static int		tx_len,
+			tx_count;
+#ifndef _WIN32
+static char		local_path[108];	// our end of a UNIX socket
+#endif
+
+
+/* Send a control datagram to the switch. */
+static void
+send_ctl(int type)
+{
+    vsw_hdr_t hdr;
+
+    hdr.magic = htonl(VSW_MAGIC);
+    hdr.type = type;
+    hdr.flags = 0;
+    hdr.count = 0;
+
+    (void)send(sock, (const char *)&hdr, sizeof(hdr), 0);
+
+    last_hello = plat_timer_ms();
+}
+
+
+/* Handle the receiving of frames from the switch. */
+static void
+poll_thread(void *arg)
+{
+    const uint8_t *mac = (const uint8_t *)arg;
+    struct timeval tv;
+    vsw_hdr_t *hdr;
+    uint8_t *buf, *p;
+    fd_set fds;
+    int len, cnt, n;
+
+    INFO("VSwitch: thread started.\n");
+    thread_set_event(poll_state);
+
+    buf = (uint8_t *)mem_alloc(VSW_DGRAM_MAX);
+    hdr = (vsw_hdr_t *)buf;
+
+    while (is_running) {
+	/* Keep our port alive on the switch. */
+	if ((plat_timer_ms() - last_hello) >= (VSW_KEEPALIVE * 1000))
+		send_ctl(VSW_HELLO);
+
+	/* Wait for something to arrive. */
+	FD_ZERO(&fds);
+	FD_SET(sock, &fds);
+	tv.tv_sec = 0;
+	tv.tv_usec = 10000;
+	if (select((int)sock + 1, &fds, NULL, NULL, &tv) <= 0)
+		continue;
+
+	len = recv(sock, (char *)buf, VSW_DGRAM_MAX, 0);
+	if (len < (int)sizeof(vsw_hdr_t)) continue;
+	if ((ntohl(hdr->magic) != VSW_MAGIC) || (hdr->type != VSW_DATA))
+		continue;
+
+	/* Unpack the batch of frames. */
+	cnt = ntohs(hdr->count);
+	p = buf + sizeof(vsw_hdr_t);
+	len -= sizeof(vsw_hdr_t);
+	while ((cnt-- > 0) && (len >= 2)) {
+		n = (p[0] << 8) | p[1];
+		p += 2;
+		len -= 2;
+		if (n > len) break;
+
+		/* Ignore our own frames. */
+		if ((n >= 14) && memcmp(p+6, mac, 6))
+			network_rx(p, n);
+
+		p += n;
+		len -= n;
+	}
+    }
+
+    free(buf);
+
+    INFO("VSwitch: thread stopped.\n");
+    thread_set_event(poll_state);
+}
+
+
+/*
+ * Prepare the Virtual Switch module for use.
+ *
+ * This is called only once, during application init,
+ * so the UI can be properly initialized.
+ */
+static int
+do_init(UNUSED(netdev_t *list))
+{
+#ifdef _WIN32
+    WSADATA wsa;
+
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+	ERRLOG("VSwitch: unable to initialize WinSock!\n");
+	return(-1);
+    }
+#endif
+
+    return(1);
+}
+
+
+/* Close up shop. */
+static void
+do_close(void)
+{
+    if (sock == INVALID_SOCKET) return;
+
+    INFO("VSwitch: closing.\n");
+
+    /* Tell the thread to terminate. */
+    if (poll_tid != NULL) {
+	is_running = 0;
+
+	/* Wait for the thread to finish. */
+	INFO("VSwitch: waiting for thread to end...\n");
+	thread_wait_event(poll_state, -1);
+	INFO("VSwitch: thread ended\n");
+	thread_destroy_event(poll_state);
+
+	poll_tid = NULL;
+	poll_state = NULL;
+    }
+
+    /* Tell the switch we are leaving. */
+    send_ctl(VSW_BYE);
+
+    sock_close(sock);
+    sock = INVALID_SOCKET;
+
+#ifndef _WIN32
+    if (local_path[0] != '\0') {
+	(void)unlink(local_path);
+	local_path[0] = '\0';
+    }
+#endif
+
+    INFO("VSwitch: closed.\n");
+}
+
+
+/* Create a socket connected to the configured switch. */
+static SOCKET
+do_connect(void)
+{
+    struct addrinfo hints, *res;
+    char port[16];
+    const char *host;
+    SOCKET s;
+#ifndef _WIN32
+    struct sockaddr_un su;
+
+    /* A pathname means a local (UNIX domain) switch. */
+    if (config.network_srv_addr[0] == '/') {
+	s = socket(AF_UNIX, SOCK_DGRAM, 0);
+	if (s == INVALID_SOCKET) return(s);
+
+	/* We need a name of our own to get replies. */
+	memset(&su, 0x00, sizeof(su));
+	su.sun_family = AF_UNIX;
+	snprintf(local_path, sizeof(local_path), "%s.%i",
+		 config.network_srv_addr, (int)getpid());
+	strncpy(su.sun_path, local_path, sizeof(su.sun_path) - 1);
+	(void)unlink(local_path);
+	if (bind(s, (struct sockaddr *)&su, sizeof(su)) < 0) {
+		local_path[0] = '\0';
+		sock_close(s);
+		return(INVALID_SOCKET);
+	}
+
+	strncpy(su.sun_path, config.network_srv_addr, sizeof(su.sun_path) - 1);
+	if (connect(s, (struct sockaddr *)&su, sizeof(su)) < 0) {
+		(void)unlink(local_path);
+		local_path[0] = '\0';
+		sock_close(s);
+		return(INVALID_SOCKET);
+	}
+
+	return(s);
+    }
+#endif
+
+    /* No address means a switch on the local host. */
+    host = config.network_srv_addr;
+    if ((host[0] == '\0') || !strcmp(host, "none"))
+	host = "127.0.0.1";
+    sprintf(port, "%i", (config.network_srv_port > 0) ?
+			config.network_srv_port : VSW_PORT);
+
+    memset(&hints, 0x00, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    if (getaddrinfo(host, port, &hints, &res) != 0) {
+	ERRLOG("VSwitch: unable to resolve '%s'\n", host);
+	return(INVALID_SOCKET);
+    }
+
+    s = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    if (s != INVALID_SOCKET) {
+	if (connect(s, res->ai_addr, (int)res->ai_addrlen) < 0) {
+		sock_close(s);
+		s = INVALID_SOCKET;
+	}
+    }
+    freeaddrinfo(res);
+
+    return(s);
+}
+
+
+/*
+ * Reset the Virtual Switch link and activate it.
+ *
+ * This is called on every 'cycle' of the emulator,
+ * if and as long the NetworkType is set to VSWITCH,
+ * and also as long as we have a NetCard defined.
+ */
+static int
+do_reset(uint8_t *mac)
+{
+    /* Make sure local variables are cleared. */
+    poll_tid = NULL;
+    poll_state = NULL;
+    tx_count = 0;
+
+    sock = do_connect();
+    if (sock == INVALID_SOCKET) {
+	ERRLOG("VSwitch: unable to connect to switch '%s'\n",
+	       config.network_srv_addr);
+	return(-1);
+    }
+    INFO("VSwitch: connected to switch '%s'\n", config.network_srv_addr);
+
+    /* Register our port with the switch. */
+    send_ctl(VSW_HELLO);
+
+    is_running = 1;
+    poll_state = thread_create_event();
+    poll_tid = thread_create(poll_thread, mac);
+    thread_wait_event(poll_state, -1);
+
+    return(0);
+}
+
+
+/* Are we available or not? */
+static int
+do_available(void)
+{
+    return(1);
+}
+
+
+/* Send the batched frames to the switch. */
+static void
+do_flush(void)
+{
+    vsw_hdr_t *hdr = (vsw_hdr_t *)tx_buf;
+
+    if (tx_count == 0) return;
+
+    hdr->magic = htonl(VSW_MAGIC);
+    hdr->type = VSW_DATA;
+    hdr->flags = 0;
+    hdr->count = htons(tx_count);
+
+    if (send(sock, (const char *)tx_buf, tx_len, 0) < 0)
+	DEBUG("VSwitch: send error\n");
+
+    tx_count = 0;
+}
+
+
+/*
+ * Add a frame to the outgoing batch.
+ *
+ * The transmit thread calls do_flush() once its queue is empty,
+ * so a burst of frames from the card goes out as one datagram.
+ */
+static void
+do_send(const uint8_t *bufp, int len)
+{
+    if ((sock == INVALID_SOCKET) || (len > VSW_FRAME_MAX)) return;
+
+    if ((tx_count > 0) && ((tx_len + 2 + len) > VSW_DGRAM_MAX))
+	do_flush();
+    if (tx_count == 0)
+	tx_len = sizeof(vsw_hdr_t);
+
+    tx_buf[tx_len++] = (len >> 8);
+    tx_buf[tx_len++] = (len & 0xff);
+    memcpy(&tx_buf[tx_len], bufp, len);
+    tx_len += len;
+    tx_count++;
+}
+
+
+const network_t network_vswitch = {
+    "Virtual Switch",
+    do_init, do_close, do_reset,
+    do_available,
+    do_send,
+    do_flush
+};
@@ -0,0 +1,87 @@
+/*
+ * VARCem	Virtual ARchaeological Computer EMulator.
+ *		An emulator of (mostly) x86-based PC systems and devices,
+ *		using the ISA,EISA,VLB,MCA  and PCI system buses, roughly
+ *		spanning the era between 1981 and 1995.
+ *
+ *		This file is part of the VARCem Project.
+ *
+ *		Definitions for the Virtual Switch protocol.
+ *
+ *		Emulator instances (and the standalone switch program)
+ *		exchange Ethernet frames as datagrams, each of which can
+ *		carry a batch of frames. The switch learns which port
+ *		each MAC address lives on, and floods anything else.
+ *
+ * Version:	@(#)net_vswitch.h	1.0.2	2026/10/19
+ *
+ * Author:	agent, <agent@local>
+ *
+ *		Copyright 2026 agent.
+ *
+ *		Redistribution and  use  in source  and binary forms, with
+ *		or  without modification, are permitted  provided that the
+ *		following conditions are met:
+ *
+ *		1. Redistributions of  source  code must retain the entire
+ *		   above notice, this list of conditions and the following
+ *		   disclaimer.
+ *
+ *		2. Redistributions in binary form must reproduce the above
+ *		   copyright  notice,  this list  of  conditions  and  the
+ *		   following disclaimer in  the documentation and/or other
+ *		   materials provided with the distribution.
+ *
+ *		3. Neither the  name of the copyright holder nor the names
+ *		   of  its  contributors may be used to endorse or promote
+ *		   products  derived from  this  software without specific
+ *		   prior written permission.
+ *
+ * THIS SOFTWARE  IS  PROVIDED BY THE  COPYRIGHT  HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND  ANY EXPRESS  OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE  ARE  DISCLAIMED. IN  NO  EVENT  SHALL THE COPYRIGHT
+ * HOLDER OR  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL,  EXEMPLARY,  OR  CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE  GOODS OR SERVICES;  LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON  ANY
+ * THEORY OF  LIABILITY, WHETHER IN  CONTRACT, STRICT  LIABILITY, OR  TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING  IN ANY  WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef NET_VSWITCH_H
+# define NET_VSWITCH_H
+
+
+#define VSW_MAGIC	0x56535731		// "VSW1"
+#define VSW_PORT	8023			// default UDP port
+#define VSW_DGRAM_MAX	32768			// max datagram size
+#define VSW_FRAME_MAX	1536			// max Ethernet frame size
+#define VSW_KEEPALIVE	5			// seconds between HELLOs
+#define VSW_TIMEOUT	30			// seconds before port expires
+
+
+/* Datagram types. */
+enum {
+    VSW_HELLO = 1,				// register/keep port alive
+    VSW_DATA,					// one or more frames
+    VSW_BYE					// port is going away
+};
+
+
+/*
+ * Each datagram starts with this header, followed by 'count'
+ * frames, each of which is preceded by its 16-bit length.
+ * All multi-byte fields are in network byte order.
+ */
+#pragma pack(push,1)
+typedef struct {
+    uint32_t	magic;
+    uint8_t	type;
+    uint8_t	flags;
+    uint16_t	count;
+} vsw_hdr_t;
+#pragma pack(pop)
+
+
+#endif	/*NET_VSWITCH_H*/
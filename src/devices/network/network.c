@@ -8,10 +8,16 @@
  *
  *		Implementation of the network module.
  *
+ *		Frames are passed between the providers and the card
+ *		through a pair of lock-free packet queues. Received
+ *		frames are delivered to the card from a timer on the
+ *		emulation thread, and transmitted frames are handed
+ *		to the provider by a separate transmit thread.
+ *
  * FIXME:	We should move the "receiver thread" out of the providers,
  *		and into here, really.
  *
- * Version:	@(#)network.c	1.0.23	2021/03/23
+ * Version:	@(#)network.c	1.0.27	2026/10/19
  *
  * Author:	Fred N. van Kempen, <decwiz@yahoo.com>
  *
@@ -49,6 +55,7 @@
  */
 #include <stdio.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdarg.h>
@@ -58,6 +65,7 @@
 #include "../../emu.h"
 #include "../../config.h"
 #include "../../device.h"
+#include "../../timer.h"
 #include "../../ui/ui.h"
 #include "../../plat.h"
 #include "network.h"
@@ -66,20 +74,53 @@
 #define ENABLE_NETWORK_DUMP	1
 
 
+#define NET_QUEUE_LEN		64		// must be a power of 2
+#define NET_FRAME_MAX		2048		// max size of a queued frame
+#define NET_RX_BATCH		16		// max frames per RX poll
+#define NET_RX_PERIOD		100		// RX poll period, in usec
+
+
+/* A single frame in one of the packet queues. */
+typedef struct {
+    int		len;
+    uint64_t	stamp;				// time of arrival, in usec
+    uint8_t	data[NET_FRAME_MAX];
+} netpkt_t;
+
+/*
+ * Single-producer, single-consumer packet queue.
+ *
+ * The producer only ever writes 'head', and the consumer only ever
+ * writes 'tail', so the two threads never need to lock each other.
+ */
+typedef struct {
+    volatile uint32_t head,			// next slot to fill
+		tail;				// next slot to drain
+    uint32_t	dropped;			// frames lost (queue full)
+
+    netpkt_t	pkt[NET_QUEUE_LEN];
+} netqueue_t;
+
 typedef struct {
     int		network;			// current provider
     mutex_t	*mutex;
 
     void	*priv;				// card priv data
-    int		(*poll)(void *);		// card poll function
     NETRXCB	rx;				// card RX function
     uint8_t	*mac;				// card MAC address
 
-    volatile int poll_busy,			// polling thread data
-		queue_in_use;
-    event_t	*poll_wake,
-		*poll_complete,
-		*queue_not_in_use;
+    netqueue_t	*rxq,				// provider -> card
+		*txq;				// card -> provider
+
+    tmrval_t	rx_time,			// RX poll timer
+		rx_enable;			// RX frames are queued
+
+    netstats_t	stats;				// statistics
+
+    volatile int tx_running;			// transmit thread data
+    thread_t	*tx_tid;
+    event_t	*tx_wake,
+		*tx_state;
 } netdata_t;
 
 
@@ -91,6 +132,10 @@ int		network_host_ndev;
 netdev_t	network_host_devs[32];
 
 
+/*
+ * The table is indexed by the NET_xxx values, so every provider has
+ * an entry, even if it was not compiled in (its 'net' is NULL then.)
+ */
 static const struct {
     const char		*internal_name;
     const network_t	*net;
@@ -99,15 +144,28 @@ static const struct {
 
 #ifdef USE_SLIRP
     { "slirp",		&network_slirp		},
+#else
+    { "slirp",		NULL			},
 #endif
 #ifdef USE_UDPLINK
     { "udplink",	&network_udplink	},
+#else
+    { "udplink",	NULL			},
 #endif
 #ifdef USE_PCAP
     { "pcap",		&network_pcap		},
+#else
+    { "pcap",		NULL			},
 #endif
 #ifdef USE_VNS
     { "vns",		&network_vns		},
+#else
+    { "vns",		NULL			},
+#endif
+#ifdef USE_VSWITCH
+    { "vswitch",	&network_vswitch	},
+#else
+    { "vswitch",	NULL			},
 #endif
 
     { NULL					}
@@ -123,7 +181,7 @@ network_get_from_internal_name(const char *s)
 	
     for (c = 0; networks[c].internal_name != NULL; c++)
 	if (! strcmp(networks[c].internal_name, s))
-		return(c);
+		return((networks[c].net != NULL) ? c : 0);
 
     /* Not found or not available. */
     return(0);
@@ -153,7 +211,15 @@ network_getname(int net)
 int
 network_available(int net)
 {
-    if (networks[net].net && networks[net].net->available)
+    /* "None" is always available. */
+    if (net == NET_NONE)
+	return(1);
+
+    /* Providers that were not compiled in are not. */
+    if (networks[net].net == NULL)
+	return(0);
+
+    if (networks[net].net->available)
 	return(networks[net].net->available());
 
     return(1);
@@ -177,6 +243,13 @@ network_log(int level, const char *fmt, ...)
 #endif
 
 
+/*
+ * Serialize access to the provider module.
+ *
+ * Providers whose library is not thread-safe use this to keep
+ * their receiver thread and the transmit thread apart. It is
+ * never taken by the emulation thread itself.
+ */
 void
 network_wait(int8_t do_wait)
 {
@@ -187,30 +260,142 @@ network_wait(int8_t do_wait)
 }
 
 
-void
-network_poll(void)
+/* Add a frame to a queue. Called by the producer only. */
+static int
+queue_put(netqueue_t *q, const uint8_t *bufp, int len)
 {
-    while (netdata.poll_busy)
-	thread_wait_event(netdata.poll_wake, -1);
+    netpkt_t *pkt;
+    uint32_t head = q->head;
+
+    if ((len <= 0) || (len > NET_FRAME_MAX) ||
+	((head - q->tail) >= NET_QUEUE_LEN)) {
+	q->dropped++;
+	return(0);
+    }
+
+    pkt = &q->pkt[head & (NET_QUEUE_LEN - 1)];
+    memcpy(pkt->data, bufp, len);
+    pkt->len = len;
+    pkt->stamp = plat_timer_us();
+
+    /* Make sure the frame is stored before we publish it. */
+    thread_barrier();
+    q->head = head + 1;
 
-    thread_reset_event(netdata.poll_wake);
+    return(1);
 }
 
 
-void
-network_busy(int8_t set)
+/* Get the oldest frame from a queue. Called by the consumer only. */
+static netpkt_t *
+queue_peek(netqueue_t *q)
 {
-    netdata.poll_busy = !!set;
+    if (q->tail == q->head)
+	return(NULL);
 
-    if (! set)
-	thread_set_event(netdata.poll_wake);
+    /* Make sure we see the frame the producer stored. */
+    thread_barrier();
+
+    return(&q->pkt[q->tail & (NET_QUEUE_LEN - 1)]);
 }
 
 
-void
-network_end(void)
+/* Release the oldest frame in a queue. Called by the consumer only. */
+static void
+queue_next(netqueue_t *q)
 {
-    thread_set_event(netdata.poll_complete);
+    thread_barrier();
+    q->tail++;
+}
+
+
+/*
+ * Deliver received frames to the card.
+ *
+ * This runs as a timer on the emulation thread, so the card's RX
+ * handler never races with the CPU accessing the same device.
+ */
+static void
+rx_poll(UNUSED(priv_t priv))
+{
+    netpkt_t *pkt;
+    uint64_t now;
+    uint32_t lat;
+    int i, b;
+
+    netdata.rx_time += (tmrval_t)(NET_RX_PERIOD * TIMER_USEC);
+
+    if (netdata.rxq == NULL) return;
+
+    for (i = 0; i < NET_RX_BATCH; i++) {
+	if ((pkt = queue_peek(netdata.rxq)) == NULL) break;
+
+	if (i == 0)
+		ui_sb_icon_update(SB_NETWORK, 1);
+
+	/* Update the statistics, the frame may have come in just now. */
+	netdata.stats.rx.packets++;
+	netdata.stats.rx.bytes += pkt->len;
+	now = plat_timer_us();
+	lat = (now > pkt->stamp) ? (uint32_t)(now - pkt->stamp) : 0;
+	for (b = 0; (b < (NET_LAT_BUCKETS - 1)) && (lat >= (1U << b)); b++)
+		;
+	netdata.stats.rx_latency[b]++;
+
+	netcap_write(pkt->data, pkt->len);
+
+	if (netdata.rx && netdata.priv)
+		netdata.rx(netdata.priv, pkt->data, pkt->len);
+
+	queue_next(netdata.rxq);
+    }
+
+    if (i > 0)
+	ui_sb_icon_update(SB_NETWORK, 0);
+
+    /*
+     * Stop polling once the queue is empty. A frame may have been
+     * queued just before we did that, so look again afterwards; the
+     * receiver re-enables us after storing its frame.
+     */
+    if (queue_peek(netdata.rxq) == NULL) {
+	netdata.rx_enable = 0;
+	thread_barrier();
+	if (queue_peek(netdata.rxq) != NULL)
+		netdata.rx_enable = 1;
+    }
+}
+
+
+/* Hand queued frames to the network provider. */
+static void
+tx_thread(UNUSED(void *arg))
+{
+    netpkt_t *pkt;
+
+    INFO("NETWORK: transmit thread started.\n");
+    thread_set_event(netdata.tx_state);
+
+    while (netdata.tx_running) {
+	/* Wait for work, but re-check the queue every now and then. */
+	if (queue_peek(netdata.txq) == NULL) {
+		thread_wait_event(netdata.tx_wake, 10);
+		continue;
+	}
+
+	while ((pkt = queue_peek(netdata.txq)) != NULL) {
+		networks[netdata.network].net->send(pkt->data, pkt->len);
+
+		queue_next(netdata.txq);
+	}
+
+	/* Queue is empty, so let a batching provider send it off. */
+	if (networks[netdata.network].net->flush != NULL)
+		networks[netdata.network].net->flush();
+    }
+
+    INFO("NETWORK: transmit thread stopped.\n");
+    thread_set_event(netdata.tx_state);
 }
 
 
@@ -284,9 +469,34 @@ network_attach(void *dev, uint8_t *mac, NETRXCB rx)
     netdata.rx = rx;
     netdata.mac = mac;
 
-    /* Create the network events. */
-    netdata.poll_wake = thread_create_event();
-    netdata.poll_complete = thread_create_event();
+    /* Create the packet queues. */
+    netdata.rxq = (netqueue_t *)mem_alloc(sizeof(netqueue_t));
+    memset(netdata.rxq, 0x00, sizeof(netqueue_t));
+    netdata.txq = (netqueue_t *)mem_alloc(sizeof(netqueue_t));
+    memset(netdata.txq, 0x00, sizeof(netqueue_t));
+
+    /* Start the transmit thread. */
+    netdata.tx_wake = thread_create_event();
+    netdata.tx_state = thread_create_event();
+    netdata.tx_running = 1;
+    netdata.tx_tid = thread_create(tx_thread, NULL);
+    thread_wait_event(netdata.tx_state, -1);
+
+    /* Start with fresh statistics. */
+    memset(&netdata.stats, 0x00, sizeof(netstats_t));
+
+    /* If requested, capture all traffic to a file. */
+    if (config.network_capture[0] != L'\0')
+	(void)netcap_open(config.network_capture);
+
+    /*
+     * Received frames are delivered from the emulation thread. The
+     * poll timer only runs while frames are queued; adding it again
+     * on a re-attach is a no-op for timer_add().
+     */
+    netdata.rx_time = 0;
+    netdata.rx_enable = 0;
+    timer_add(rx_poll, NULL, &netdata.rx_time, &netdata.rx_enable);
 
     return(1);
 }
@@ -297,7 +507,18 @@ void
 network_close(void)
 {
     /* If already closed, do nothing. */
-    if (netdata.network == NET_NONE)
+    if (netdata.network == NET_NONE) return;
+
+    /* No more frames for the card. */
+    netdata.rx_enable = 0;
+
+    /* Stop the transmit thread. */
+    if (netdata.tx_tid != NULL) {
+	netdata.tx_running = 0;
+	thread_set_event(netdata.tx_wake);
+	thread_wait_event(netdata.tx_state, -1);
+	netdata.tx_tid = NULL;
+    }
 
     /* Force-close the network provider module. */
     if (networks[netdata.network].net)
@@ -305,15 +526,31 @@ network_close(void)
     netdata.network = NET_NONE;
 
     /* Close the network events. */
-    if (netdata.poll_wake != NULL) {
-	thread_destroy_event(netdata.poll_wake);
-	netdata.poll_wake = NULL;
+    if (netdata.tx_wake != NULL) {
+	thread_destroy_event(netdata.tx_wake);
+	netdata.tx_wake = NULL;
     }
-    if (netdata.poll_complete != NULL) {
-	thread_destroy_event(netdata.poll_complete);
-	netdata.poll_complete = NULL;
+    if (netdata.tx_state != NULL) {
+	thread_destroy_event(netdata.tx_state);
+	netdata.tx_state = NULL;
     }
 
+    /* Show what happened, and stop capturing. */
+    network_dump_stats();
+    netcap_close();
+
+    /* Release the packet queues. */
+    if (netdata.rxq != NULL) {
+	free(netdata.rxq);
+	netdata.rxq = NULL;
+    }
+    if (netdata.txq != NULL) {
+	free(netdata.txq);
+	netdata.txq = NULL;
+    }
+    netdata.priv = NULL;
+    netdata.rx = NULL;
+
     /* Close the network thread mutex. */
     thread_close_mutex(netdata.mutex);
     netdata.mutex = NULL;
@@ -364,7 +601,58 @@ network_reset(void)
 }
 
 
-/* Transmit a packet to one of the network providers. */
+/* Return a snapshot of the statistics. */
+void
+network_get_stats(netstats_t *st)
+{
+    memcpy(st, &netdata.stats, sizeof(netstats_t));
+
+    if (netdata.rxq != NULL)
+	st->rx.drops = netdata.rxq->dropped;
+    if (netdata.txq != NULL)
+	st->tx.drops = netdata.txq->dropped;
+
+    netcap_stats(&st->cap_packets, &st->cap_drops);
+}
+
+
+/* Write the statistics to the logfile. */
+void
+network_dump_stats(void)
+{
+    char temp[512];
+    netstats_t st;
+    int i, n;
+
+    if (netdata.rxq == NULL) return;
+
+    network_get_stats(&st);
+
+    INFO("NETWORK: RX %" PRIu64 " frames, %" PRIu64 " bytes, %u dropped\n",
+	 st.rx.packets, st.rx.bytes, st.rx.drops);
+    INFO("NETWORK: TX %" PRIu64 " frames, %" PRIu64 " bytes, %u dropped\n",
+	 st.tx.packets, st.tx.bytes, st.tx.drops);
+
+    n = 0;
+    for (i = 0; i < NET_LAT_BUCKETS; i++) {
+	if (st.rx_latency[i] == 0) continue;
+
+	if (i < (NET_LAT_BUCKETS - 1))
+		n += sprintf(&temp[n], " <%uus:%u", 1U << i, st.rx_latency[i]);
+	  else
+		n += sprintf(&temp[n], " >=%uus:%u", 1U << (i - 1), st.rx_latency[i]);
+    }
+    if (n > 0)
+	INFO("NETWORK: RX latency%s\n", temp);
+}
+
+
+/*
+ * Transmit a packet to one of the network providers.
+ *
+ * The frame is copied into the transmit queue, and handed to the
+ * provider by the transmit thread, so the card never blocks here.
+ */
 void
 network_tx(uint8_t *bufp, int len)
 {
@@ -380,18 +668,28 @@ network_tx(uint8_t *bufp, int len)
 }
 #endif
 
-    networks[netdata.network].net->send(bufp, len);
+    netcap_write(bufp, len);
+
+    if ((netdata.txq != NULL) && queue_put(netdata.txq, bufp, len)) {
+	netdata.stats.tx.packets++;
+	netdata.stats.tx.bytes += len;
+
+	thread_set_event(netdata.tx_wake);
+    }
 
     ui_sb_icon_update(SB_NETWORK, 0);
 }
 
 
-/* Process a packet received from one of the network providers. */
+/*
+ * Process a packet received from one of the network providers.
+ *
+ * This is called from the provider's receiver thread, and only
+ * queues the frame; rx_poll() delivers it to the card.
+ */
 void
 network_rx(uint8_t *bufp, int len)
 {
-    ui_sb_icon_update(SB_NETWORK, 1);
-
 #if defined(WALTJE) && defined(_DEBUG) && ENABLE_NETWORK_DUMP
 {
     char temp[16384];
@@ -402,10 +700,11 @@ network_rx(uint8_t *bufp, int len)
 }
 #endif
 
-    if (netdata.rx && netdata.priv)
-	netdata.rx(netdata.priv, bufp, len);
-
-    ui_sb_icon_update(SB_NETWORK, 0);
+    if ((netdata.rxq != NULL) && queue_put(netdata.rxq, bufp, len)) {
+	/* Frame is stored, so start the poll timer if needed. */
+	thread_barrier();
+	netdata.rx_enable = 1;
+    }
 }
 
 
@@ -8,7 +8,7 @@
  *
  *		Definitions for the network module.
  *
- * Version:	@(#)network.h	1.0.10	2021/03/22
+ * Version:	@(#)network.h	1.0.12	2026/10/19
  *
  * Author:	Fred N. van Kempen, <decwiz@yahoo.com>
  *
@@ -53,7 +53,8 @@ enum {
     NET_SLIRP,
     NET_UDPLINK,
     NET_PCAP,
-    NET_VNS
+    NET_VNS,
+    NET_VSWITCH
 };
 
 enum {
@@ -62,8 +63,35 @@ enum {
 };
 
 
+#define NET_LAT_BUCKETS	16		// RX latency histogram size
+
+
 typedef void (*NETRXCB)(void *, uint8_t *bufp, int);
 
+/* Traffic counters, per direction. */
+typedef struct {
+    uint64_t	packets,
+		bytes;
+    uint32_t	drops;
+} netcnt_t;
+
+/* Statistics for the network module. */
+typedef struct {
+    netcnt_t	rx,
+		tx;
+
+    /*
+     * Time from a frame arriving at the provider until it was
+     * delivered to the card, in power-of-2 microsecond buckets:
+     * bucket N counts frames that took less than 2^N usec, and
+     * the last bucket counts all slower ones.
+     */
+    uint32_t	rx_latency[NET_LAT_BUCKETS];
+
+    uint32_t	cap_packets,			// capture tap
+		cap_drops;
+} netstats_t;
+
 /* Define a host interface entry for a network provider. */
 typedef struct {
     char	device[128];
@@ -79,6 +107,7 @@ typedef struct {
     int		(*reset)(uint8_t *);
     int		(*available)(void);
     void	(*send)(const uint8_t *, int);
+    void	(*flush)(void);			// optional, ends a batch
 } network_t;
 
 
@@ -94,6 +123,7 @@ extern const network_t	network_slirp;
 extern const network_t	network_pcap;
 extern const network_t	network_udplink;
 extern const network_t	network_vns;
+extern const network_t	network_vswitch;
 
 
 /* Function prototypes. */
@@ -112,9 +142,13 @@ extern void		network_tx(uint8_t *, int);
 extern void		network_rx(uint8_t *, int);
 
 extern void		network_wait(int8_t do_wait);
-extern void		network_poll(void);
-extern void		network_busy(int8_t set);
-extern void		network_end(void);
+extern void		network_get_stats(netstats_t *);
+extern void		network_dump_stats(void);
+
+extern int		netcap_open(const wchar_t *fn);
+extern void		netcap_close(void);
+extern void		netcap_write(const uint8_t *bufp, int len);
+extern void		netcap_stats(uint32_t *packets, uint32_t *drops);
 
 extern void		network_card_log(int level, const char *fmt, ...);
 extern int		network_card_to_id(const char *);
@@ -0,0 +1,281 @@
+/*
+ * VARCem	Virtual ARchaeological Computer EMulator.
+ *		An emulator of (mostly) x86-based PC systems and devices,
+ *		using the ISA,EISA,VLB,MCA  and PCI system buses, roughly
+ *		spanning the era between 1981 and 1995.
+ *
+ *		This file is part of the VARCem Project.
+ *
+ *		Implement a packet capture tap for the network module.
+ *
+ *		Frames passing between the card and the provider can be
+ *		written to a standard (libpcap format) capture file. The
+ *		emulation thread only copies frames into a ring buffer;
+ *		a separate writer thread moves them to the file.
+ *
+ * Version:	@(#)network_cap.c	1.0.3	2026/10/19
+ *
+ * Author:	agent, <agent@local>
+ *
+ *		Copyright 2026 agent.
+ *
+ *		Redistribution and  use  in source  and binary forms, with
+ *		or  without modification, are permitted  provided that the
+ *		following conditions are met:
+ *
+ *		1. Redistributions of  source  code must retain the entire
+ *		   above notice, this list of conditions and the following
+ *		   disclaimer.
+ *
+ *		2. Redistributions in binary form must reproduce the above
+ *		   copyright  notice,  this list  of  conditions  and  the
+ *		   following disclaimer in  the documentation and/or other
+ *		   materials provided with the distribution.
+ *
+ *		3. Neither the  name of the copyright holder nor the names
+ *		   of  its  contributors may be used to endorse or promote
+ *		   products  derived from  this  software without specific
+ *		   prior written permission.
+ *
+ * THIS SOFTWARE  IS  PROVIDED BY THE  COPYRIGHT  HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND  ANY EXPRESS  OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE  ARE  DISCLAIMED. IN  NO  EVENT  SHALL THE COPYRIGHT
+ * HOLDER OR  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL,  EXEMPLARY,  OR  CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE  GOODS OR SERVICES;  LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON  ANY
+ * THEORY OF  LIABILITY, WHETHER IN  CONTRACT, STRICT  LIABILITY, OR  TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING  IN ANY  WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <wchar.h>
+#include <time.h>
+#define dbglog network_log
+#include "../../emu.h"
+#include "../../device.h"
+#include "../../plat.h"
+#include "network.h"
+
+
+#define CAP_BUFSIZE	(1024 * 1024)		// must be a power of 2
+#define CAP_SNAPLEN	65535
+
+
+/* Standard pcap file header. */
+#pragma pack(push,1)
+typedef struct {
+    uint32_t	magic;
+    uint16_t	version_major,
+		version_minor;
+    int32_t	thiszone;
+    uint32_t	sigfigs,
+		snaplen,
+		network;
+} pcap_hdr_t;
+
+typedef struct {
+    uint32_t	ts_sec,
+		ts_usec,
+		incl_len,
+		orig_len;
+} pcap_rec_t;
+#pragma pack(pop)
+
+
+static FILE		*cap_fp;
+static uint8_t		*cap_buf;
+static volatile uint32_t cap_head,		// written by emulation
+			cap_tail;		// written by writer
+static volatile int	cap_running;
+static thread_t		*cap_tid;
+static event_t		*cap_wake,
+			*cap_state;
+static time_t		cap_epoch;		// wall time at open
+static uint64_t		cap_base;		// timer value at open
+static uint32_t		cap_packets,
+			cap_drops;
+
+
+/* Move everything in the ring buffer to the file. */
+static void
+cap_flush(void)
+{
+    uint32_t head = cap_head, tail = cap_tail;
+    uint32_t n, off;
+
+    thread_barrier();
+
+    while (tail != head) {
+	off = tail & (CAP_BUFSIZE - 1);
+	n = head - tail;
+	if (n > (CAP_BUFSIZE - off))
+		n = CAP_BUFSIZE - off;
+
+	(void)fwrite(&cap_buf[off], 1, n, cap_fp);
+	tail += n;
+    }
+
+    thread_barrier();
+    cap_tail = tail;
+}
+
+
+static void
+cap_thread(UNUSED(void *arg))
+{
+    thread_set_event(cap_state);
+
+    while (cap_running) {
+	thread_wait_event(cap_wake, -1);
+	thread_reset_event(cap_wake);
+
+	/* Frames may come in while we write, so keep going until done. */
+	if (cap_tail != cap_head) {
+		while (cap_tail != cap_head)
+			cap_flush();
+		fflush(cap_fp);
+	}
+    }
+
+    cap_flush();
+
+    thread_set_event(cap_state);
+}
+
+
+/* Copy data into the ring buffer; caller checked for room. */
+static void
+cap_copy(uint32_t *head, const void *data, uint32_t len)
+{
+    uint32_t off = *head & (CAP_BUFSIZE - 1);
+    uint32_t n = CAP_BUFSIZE - off;
+
+    if (n > len)
+	n = len;
+    memcpy(&cap_buf[off], data, n);
+    if (n < len)
+	memcpy(cap_buf, (const uint8_t *)data + n, len - n);
+
+    *head += len;
+}
+
+
+/*
+ * Capture a frame.
+ *
+ * Called from the emulation thread only. If the writer can
+ * not keep up, frames are dropped rather than stalling us.
+ */
+void
+netcap_write(const uint8_t *bufp, int len)
+{
+    pcap_rec_t rec;
+    uint64_t now;
+    uint32_t head = cap_head;
+
+    if (cap_fp == NULL) return;
+
+    if ((sizeof(rec) + len) > (CAP_BUFSIZE - (head - cap_tail))) {
+	cap_drops++;
+	return;
+    }
+
+    now = plat_timer_us() - cap_base;
+    rec.ts_sec = (uint32_t)(cap_epoch + (now / 1000000));
+    rec.ts_usec = (uint32_t)(now % 1000000);
+    rec.incl_len = rec.orig_len = len;
+
+    cap_copy(&head, &rec, sizeof(rec));
+    cap_copy(&head, bufp, len);
+
+    /* Make sure the record is stored before we publish it. */
+    thread_barrier();
+    cap_head = head;
+
+    cap_packets++;
+
+    thread_set_event(cap_wake);
+}
+
+
+/* Return the capture counters. */
+void
+netcap_stats(uint32_t *packets, uint32_t *drops)
+{
+    *packets = cap_packets;
+    *drops = cap_drops;
+}
+
+
+/* Start capturing to a file. */
+int
+netcap_open(const wchar_t *fn)
+{
+    pcap_hdr_t hdr;
+
+    if (cap_fp != NULL)
+	netcap_close();
+
+    cap_fp = plat_fopen(fn, L"wb");
+    if (cap_fp == NULL) {
+	ERRLOG("NETWORK: unable to create capture file '%ls'\n", fn);
+	return(0);
+    }
+
+    memset(&hdr, 0x00, sizeof(hdr));
+    hdr.magic = 0xa1b2c3d4;
+    hdr.version_major = 2;
+    hdr.version_minor = 4;
+    hdr.snaplen = CAP_SNAPLEN;
+    hdr.network = 1;				// LINKTYPE_ETHERNET
+    (void)fwrite(&hdr, 1, sizeof(hdr), cap_fp);
+
+    cap_buf = (uint8_t *)mem_alloc(CAP_BUFSIZE);
+    cap_head = cap_tail = 0;
+    cap_packets = cap_drops = 0;
+    cap_epoch = time(NULL);
+    cap_base = plat_timer_us();
+
+    cap_wake = thread_create_event();
+    cap_state = thread_create_event();
+    cap_running = 1;
+    cap_tid = thread_create(cap_thread, NULL);
+    thread_wait_event(cap_state, -1);
+
+    INFO("NETWORK: capturing to '%ls'\n", fn);
+
+    return(1);
+}
+
+
+/* Stop capturing, and close the file. */
+void
+netcap_close(void)
+{
+    FILE *fp = cap_fp;
+
+    if (fp == NULL) return;
+
+    /* Let the writer drain the buffer and exit. */
+    cap_running = 0;
+    thread_set_event(cap_wake);
+    thread_wait_event(cap_state, -1);
+    cap_fp = NULL;
+    cap_tid = NULL;
+
+    thread_destroy_event(cap_wake);
+    thread_destroy_event(cap_state);
+    cap_wake = cap_state = NULL;
+
+    (void)fclose(fp);
+    free(cap_buf);
+    cap_buf = NULL;
+
+    INFO("NETWORK: capture closed, %u frames (%u dropped)\n",
+	 cap_packets, cap_drops);
+}
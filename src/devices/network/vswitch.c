@@ -0,0 +1,495 @@
+/*
+ * VARCem	Virtual ARchaeological Computer EMulator.
+ *		An emulator of (mostly) x86-based PC systems and devices,
+ *		using the ISA,EISA,VLB,MCA  and PCI system buses, roughly
+ *		spanning the era between 1981 and 1995.
+ *
+ *		This file is part of the VARCem Project.
+ *
+ *		Standalone Virtual Switch for connecting emulator instances.
+ *
+ *		This is a simple learning Ethernet switch. Each emulator
+ *		connected to it is a port; frames for a known MAC address
+ *		are sent only to the port it was learned on, all others
+ *		are flooded to all ports. Frames going to the same port
+ *		in one pass are batched into a single datagram.
+ *
+ *		Usage:	vswitch [-v] [-p port] [-s path]
+ *
+ *		It needs no privileges, and can be built on its own on
+ *		UNIX systems with:  cc -o vswitch vswitch.c
+ *
+ * Version:	@(#)vswitch.c	1.0.3	2026/10/19
+ *
+ * Author:	agent, <agent@local>
+ *
+ *		Copyright 2026 agent.
+ *
+ *		Redistribution and  use  in source  and binary forms, with
+ *		or  without modification, are permitted  provided that the
+ *		following conditions are met:
+ *
+ *		1. Redistributions of  source  code must retain the entire
+ *		   above notice, this list of conditions and the following
+ *		   disclaimer.
+ *
+ *		2. Redistributions in binary form must reproduce the above
+ *		   copyright  notice,  this list  of  conditions  and  the
+ *		   following disclaimer in  the documentation and/or other
+ *		   materials provided with the distribution.
+ *
+ *		3. Neither the  name of the copyright holder nor the names
+ *		   of  its  contributors may be used to endorse or promote
+ *		   products  derived from  this  software without specific
+ *		   prior written permission.
+ *
+ * THIS SOFTWARE  IS  PROVIDED BY THE  COPYRIGHT  HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND  ANY EXPRESS  OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE  ARE  DISCLAIMED. IN  NO  EVENT  SHALL THE COPYRIGHT
+ * HOLDER OR  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL,  EXEMPLARY,  OR  CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE  GOODS OR SERVICES;  LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON  ANY
+ * THEORY OF  LIABILITY, WHETHER IN  CONTRACT, STRICT  LIABILITY, OR  TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING  IN ANY  WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#ifdef _WIN32
+# define WIN32_LEAN_AND_MEAN
+# include <winsock2.h>
+# include <ws2tcpip.h>
+typedef int		socklen_t;
+# define sock_close	closesocket
+#else
+# include <sys/types.h>
+# include <sys/socket.h>
+# include <sys/select.h>
+# include <sys/un.h>
+# include <netinet/in.h>
+# include <arpa/inet.h>
+# include <fcntl.h>
+# include <unistd.h>
+typedef int		SOCKET;
+# define INVALID_SOCKET	-1
+# define sock_close	close
+#endif
+#include "net_vswitch.h"
+
+
+#define MAX_PORTS	64
+#define MAC_HASH	1024			// must be a power of 2
+#define RX_BATCH	64			// datagrams per pass
+
+
+typedef struct {
+    int		used;
+    struct sockaddr_storage addr;
+    socklen_t	alen;
+    time_t	seen;
+
+    uint32_t	rx_frames,			// statistics
+		tx_frames;
+
+    int		len,				// outgoing batch
+		count;
+    uint8_t	buf[VSW_DGRAM_MAX];
+} port_t;
+
+typedef struct {
+    uint8_t	mac[6];
+    int16_t	port;				// -1 if unused
+    time_t	seen;
+} macent_t;
+
+
+static SOCKET	sock;
+static int	verbose;
+static port_t	ports[MAX_PORTS];
+static macent_t	macs[MAC_HASH];
+
+
+static int
+mac_hash(const uint8_t *mac)
+{
+    return(((mac[3] << 8) ^ (mac[4] << 4) ^ mac[5]) & (MAC_HASH - 1));
+}
+
+
+/* Find the port a MAC address was learned on. */
+static int
+mac_lookup(const uint8_t *mac, time_t now)
+{
+    int h = mac_hash(mac), i;
+    macent_t *m;
+
+    for (i = 0; i < MAC_HASH; i++) {
+	m = &macs[(h + i) & (MAC_HASH - 1)];
+	if (m->port < 0) break;
+	if (! memcmp(m->mac, mac, 6)) {
+		if ((now - m->seen) > VSW_TIMEOUT)
+			return(-1);
+		return(m->port);
+	}
+    }
+
+    return(-1);
+}
+
+
+/*
+ * Remember which port a MAC address lives on.
+ *
+ * Entries are never emptied (that would break the probe chains of
+ * other addresses), but an entry that was flushed or has expired
+ * is re-used for a new address.
+ */
+static void
+mac_learn(const uint8_t *mac, int port, time_t now)
+{
+    int h = mac_hash(mac), i;
+    macent_t *m, *old = NULL;
+
+    for (i = 0; i < MAC_HASH; i++) {
+	m = &macs[(h + i) & (MAC_HASH - 1)];
+	if (m->port < 0) break;
+	if (! memcmp(m->mac, mac, 6)) break;
+
+	if ((old == NULL) && ((m->seen == 0) || ((now - m->seen) > VSW_TIMEOUT)))
+		old = m;
+    }
+
+    /* Not known yet, so take a stale entry if we passed one. */
+    if ((i == MAC_HASH) || (m->port < 0)) {
+	if (old != NULL)
+		m = old;
+	else if (i == MAC_HASH)
+		return;
+    }
+
+    if (verbose && ((m->port != port) || memcmp(m->mac, mac, 6)))
+	printf("Learned %02x:%02x:%02x:%02x:%02x:%02x on port %i\n",
+	       mac[0], mac[1], mac[2], mac[3], mac[4], mac[5], port);
+
+    memcpy(m->mac, mac, 6);
+    m->port = port;
+    m->seen = now;
+}
+
+
+/* Forget all MAC addresses learned on a port. */
+static void
+mac_flush(int port)
+{
+    int i;
+
+    /* Entries stay in place to keep the probe chains intact. */
+    for (i = 0; i < MAC_HASH; i++) {
+	if (macs[i].port == port)
+		macs[i].seen = 0;
+    }
+}
+
+
+/* Find (or create) the port for a peer address. */
+static int
+port_find(const struct sockaddr_storage *addr, socklen_t alen, int create)
+{
+    int i, free_port = -1;
+
+    for (i = 0; i < MAX_PORTS; i++) {
+	if (! ports[i].used) {
+		if (free_port < 0)
+			free_port = i;
+		continue;
+	}
+	if ((ports[i].alen == alen) && !memcmp(&ports[i].addr, addr, alen))
+		return(i);
+    }
+
+    if (!create || (free_port < 0))
+	return(-1);
+
+    memset(&ports[free_port], 0x00, sizeof(port_t) - VSW_DGRAM_MAX);
+    memcpy(&ports[free_port].addr, addr, alen);
+    ports[free_port].alen = alen;
+    ports[free_port].used = 1;
+    if (verbose)
+	printf("Port %i connected\n", free_port);
+
+    return(free_port);
+}
+
+
+static void
+port_drop(int port)
+{
+    if (verbose)
+	printf("Port %i disconnected (rx=%u tx=%u)\n", port,
+	       ports[port].rx_frames, ports[port].tx_frames);
+
+    mac_flush(port);
+    ports[port].used = 0;
+}
+
+
+/* Send out whatever is batched up for a port. */
+static void
+port_flush(port_t *p)
+{
+    vsw_hdr_t *hdr = (vsw_hdr_t *)p->buf;
+
+    if (p->count == 0) return;
+
+    hdr->magic = htonl(VSW_MAGIC);
+    hdr->type = VSW_DATA;
+    hdr->flags = 0;
+    hdr->count = htons(p->count);
+    (void)sendto(sock, (const char *)p->buf, p->len, 0,
+		 (struct sockaddr *)&p->addr, p->alen);
+
+    p->tx_frames += p->count;
+    p->count = 0;
+}
+
+
+/* Add a frame to a port's outgoing batch. */
+static void
+port_queue(port_t *p, const uint8_t *frame, int len)
+{
+    if (p->count == 0)
+	p->len = sizeof(vsw_hdr_t);
+    else if ((p->len + 2 + len) > VSW_DGRAM_MAX)
+	port_flush(p), p->len = sizeof(vsw_hdr_t);
+
+    p->buf[p->len++] = (len >> 8);
+    p->buf[p->len++] = (len & 0xff);
+    memcpy(&p->buf[p->len], frame, len);
+    p->len += len;
+    p->count++;
+}
+
+
+/* Switch all frames in a datagram received on a port. */
+static void
+do_frames(int src, const uint8_t *bufp, int len, int cnt, time_t now)
+{
+    int n, dst, i;
+
+    while ((cnt-- > 0) && (len >= 2)) {
+	n = (bufp[0] << 8) | bufp[1];
+	bufp += 2;
+	len -= 2;
+	if ((n > len) || (n > VSW_FRAME_MAX)) break;
+
+	if (n >= 14) {
+		ports[src].rx_frames++;
+
+		/* Learn the source, unless it is a group address. */
+		if (! (bufp[6] & 0x01))
+			mac_learn(bufp+6, src, now);
+
+		/* Known unicast destination? */
+		dst = (bufp[0] & 0x01) ? -1 : mac_lookup(bufp, now);
+		if ((dst >= 0) && ports[dst].used) {
+			if (dst != src)
+				port_queue(&ports[dst], bufp, n);
+		} else {
+			/* No, flood it. */
+			for (i = 0; i < MAX_PORTS; i++) {
+				if (ports[i].used && (i != src))
+					port_queue(&ports[i], bufp, n);
+			}
+		}
+	}
+
+	bufp += n;
+	len -= n;
+    }
+}
+
+
+/* Process one datagram. */
+static void
+do_dgram(const struct sockaddr_storage *addr, socklen_t alen,
+	 const uint8_t *bufp, int len, time_t now)
+{
+    const vsw_hdr_t *hdr = (const vsw_hdr_t *)bufp;
+    int port;
+
+    if ((len < (int)sizeof(vsw_hdr_t)) || (ntohl(hdr->magic) != VSW_MAGIC))
+	return;
+
+    port = port_find(addr, alen, (hdr->type != VSW_BYE));
+    if (port < 0) return;
+    ports[port].seen = now;
+
+    switch (hdr->type) {
+	case VSW_HELLO:
+		break;
+
+	case VSW_DATA:
+		do_frames(port, bufp + sizeof(vsw_hdr_t),
+			  len - sizeof(vsw_hdr_t), ntohs(hdr->count), now);
+		break;
+
+	case VSW_BYE:
+		port_drop(port);
+		break;
+    }
+}
+
+
+static SOCKET
+do_bind(int portnr, const char *path)
+{
+    struct sockaddr_in sin;
+    SOCKET s;
+#ifndef _WIN32
+    struct sockaddr_un su;
+
+    if (path != NULL) {
+	s = socket(AF_UNIX, SOCK_DGRAM, 0);
+	if (s == INVALID_SOCKET) return(s);
+
+	memset(&su, 0x00, sizeof(su));
+	su.sun_family = AF_UNIX;
+	strncpy(su.sun_path, path, sizeof(su.sun_path) - 1);
+	(void)unlink(path);
+	if (bind(s, (struct sockaddr *)&su, sizeof(su)) < 0) {
+		sock_close(s);
+		return(INVALID_SOCKET);
+	}
+	printf("Listening on '%s'..\n", path);
+
+	return(s);
+    }
+#else
+    (void)path;
+#endif
+
+    s = socket(AF_INET, SOCK_DGRAM, 0);
+    if (s == INVALID_SOCKET) return(s);
+
+    memset(&sin, 0x00, sizeof(sin));
+    sin.sin_family = AF_INET;
+    sin.sin_addr.s_addr = htonl(INADDR_ANY);
+    sin.sin_port = htons(portnr);
+    if (bind(s, (struct sockaddr *)&sin, sizeof(sin)) < 0) {
+	sock_close(s);
+	return(INVALID_SOCKET);
+    }
+    printf("Listening on UDP port %i..\n", portnr);
+
+    return(s);
+}
+
+
+static void
+usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [-v] [-p port]", prog);
+#ifndef _WIN32
+    fprintf(stderr, " [-s path]");
+#endif
+    fprintf(stderr, "\n");
+
+    exit(1);
+}
+
+
+int
+main(int argc, char **argv)
+{
+    static uint8_t buf[VSW_DGRAM_MAX];
+    struct sockaddr_storage addr;
+    const char *path = NULL;
+    struct timeval tv;
+    socklen_t alen;
+    fd_set fds;
+    time_t now, last;
+    int portnr = VSW_PORT;
+    int i, len;
+#ifdef _WIN32
+    WSADATA wsa;
+    u_long on = 1;
+
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+	fprintf(stderr, "Unable to initialize WinSock!\n");
+	return(1);
+    }
+#endif
+
+    for (i = 1; i < argc; i++) {
+	if (! strcmp(argv[i], "-v"))
+		verbose++;
+	else if (!strcmp(argv[i], "-p") && (i + 1 < argc))
+		portnr = atoi(argv[++i]);
+#ifndef _WIN32
+	else if (!strcmp(argv[i], "-s") && (i + 1 < argc))
+		path = argv[++i];
+#endif
+	else
+		usage(argv[0]);
+    }
+
+    for (i = 0; i < MAC_HASH; i++)
+	macs[i].port = -1;
+
+    sock = do_bind(portnr, path);
+    if (sock == INVALID_SOCKET) {
+	fprintf(stderr, "Unable to create switch socket!\n");
+	return(2);
+    }
+
+    /* We drain the socket in batches, so make it non-blocking. */
+#ifdef _WIN32
+    ioctlsocket(sock, FIONBIO, &on);
+#else
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) | O_NONBLOCK);
+#endif
+
+    last = time(NULL);
+    for (;;) {
+	FD_ZERO(&fds);
+	FD_SET(sock, &fds);
+	tv.tv_sec = 1;
+	tv.tv_usec = 0;
+	(void)select((int)sock + 1, &fds, NULL, NULL, &tv);
+	now = time(NULL);
+
+	/* Switch everything that arrived, then send out the batches. */
+	for (i = 0; i < RX_BATCH; i++) {
+		alen = sizeof(addr);
+		len = recvfrom(sock, (char *)buf, sizeof(buf), 0,
+			       (struct sockaddr *)&addr, &alen);
+		if (len <= 0) break;
+
+		do_dgram(&addr, alen, buf, len, now);
+	}
+	for (i = 0; i < MAX_PORTS; i++) {
+		if (ports[i].used)
+			port_flush(&ports[i]);
+	}
+
+	/* Expire ports we have not heard from in a while. */
+	if (now != last) {
+		for (i = 0; i < MAX_PORTS; i++) {
+			if (ports[i].used &&
+			    ((now - ports[i].seen) > VSW_TIMEOUT))
+				port_drop(i);
+		}
+		last = now;
+	}
+    }
+
+    /*NOTREACHED*/
+    sock_close(sock);
+
+    return(0);
+}
@@ -30,9 +30,13 @@
  *		like FIFO buffers, higher line speeds and DMA transfers.
  *
  *		The lower half of the driver can interface to the host system
- *		serial ports, or other channels, for real-world access.
+ *		serial ports, or other channels, for real-world access. These
+ *		are polled from a timer, which moves as much data into the RX
+ *		FIFO as the line speed allows. In turbo mode, the line speed
+ *		is ignored, and the FIFO is kept full, so the transfer rate
+ *		is limited only by how fast the guest can empty it.
  *
- * Version:	@(#)serial.c	1.0.20	2021/03/16
+ * Version:	@(#)serial.c	1.0.22	2026/10/19
  *
  * Author:	Fred N. van Kempen, <decwiz@yahoo.com>
  *
@@ -177,6 +181,9 @@
 #define MSR_DCD		0x80
 #define MSR_MASK	(MSR_DDCD|MSR_TERI|MSR_DDSR|MSR_DCTS)
 
+#define POLL_TIME	1000		// poll linked ports every 1ms
+#define TX_BUFLEN	256
+
 
 typedef struct serial {
     int8_t	port;			// port number (0,1,..)
@@ -202,6 +209,12 @@ typedef struct serial {
     int64_t	delay;
 
     priv_t	bh;			// BottomHalf handler
+    const serial_bh_t *bh_ops;
+    int8_t	turbo;			// ignore the line speed
+    int64_t	poll_delay,
+		rx_credit;		// line time not used yet
+    int		tx_len;
+    uint8_t	tx_buf[TX_BUFLEN];
 
     int		fifo_read,
 		fifo_write;
@@ -295,6 +308,33 @@ clear_fifo(serial_t *dev)
 }
 
 
+/* Number of bytes that can still go into the RX FIFO. */
+static int
+fifo_room(serial_t *dev)
+{
+    return((int)sizeof(dev->fifo) - 1 -
+	   ((dev->fifo_write - dev->fifo_read) & (sizeof(dev->fifo) - 1)));
+}
+
+
+/* Time it takes to send one character at the programmed line speed. */
+static int64_t
+char_time(serial_t *dev)
+{
+    int bits;
+
+    if (dev->dlab == 0)
+	return(POLL_TIME * TIMER_USEC);
+
+    bits = 1 + (dev->lcr & LCR_WLS) + 5;
+    if (dev->lcr & LCR_PE)
+	bits++;
+    bits += (dev->lcr & LCR_SBS) ? 2 : 1;
+
+    return(((int64_t)bits * dev->dlab * 1000000LL * TIMER_USEC) / 115200LL);
+}
+
+
 static void
 write_fifo(serial_t *dev, uint8_t *ptr, uint8_t len)
 {
@@ -314,6 +354,41 @@ write_fifo(serial_t *dev, uint8_t *ptr, uint8_t len)
 }
 
 
+/* The host side went away for good, so unlink the port. */
+static void
+link_lost(serial_t *dev)
+{
+    ERRLOG("Serial%i: link lost, unlinking\n", dev->port);
+
+    (void)serial_link(dev->port, NULL);
+}
+
+
+/* Take in what the host side has for us, up to 'max' bytes. */
+static int
+fill_rx(serial_t *dev, int max)
+{
+    uint8_t buf[SERIAL_FIFO_MAX];
+    int n;
+
+    if (max > fifo_room(dev))
+	max = fifo_room(dev);
+    if (max <= 0) return(0);
+
+    n = dev->bh_ops->read(dev->bh, buf, max);
+    if (n < 0) {
+	link_lost(dev);
+	return(0);
+    }
+
+    /* Stuff it all into the FIFO and set intr. */
+    if (n > 0)
+	write_fifo(dev, buf, (uint8_t)n);
+
+    return(n);
+}
+
+
 static uint8_t
 read_fifo(serial_t *dev)
 {
@@ -323,22 +398,26 @@ read_fifo(serial_t *dev)
 		dev->fifo_read = 0;
     }
 
+    /* In turbo mode, do not wait for the next poll to refill. */
+    if ((dev->fifo_read == dev->fifo_write) &&
+	dev->turbo && (dev->bh != NULL))
+	(void)fill_rx(dev, SERIAL_FIFO_MAX);
+
 #if 1
     /* If we have more, generate (new) int. */
     if (dev->fifo_read != dev->fifo_write) {
-#if 1
-	dev->delay = 1000*TIMER_USEC;
-#else
-	if (dev->bh != NULL) {
-		dev->int_status |= SERINT_RECEIVE;
+	if (dev->turbo || (dev->fcr & FCR_FCRFE)) {
+		/* The next byte is available right away. */
+		dev->int_status |= SER_INT_RX;
 		dev->lsr |= LSR_DR;
 
 		/* Update interrupt state. */
 		update_ints(dev);
+	} else if (dev->bh != NULL) {
+		dev->delay = char_time(dev);
 	} else {
 		dev->delay = 1000*TIMER_USEC;
 	}
-#endif
     }
 #endif
 
@@ -372,51 +451,82 @@ reset_port(serial_t *dev)
 }
 
 
+/*
+ * Send whatever the guest has written to the host side.
+ *
+ * If the host side is busy, we keep the data, and once the
+ * buffer is full, the guest is held off (THRE stays clear)
+ * until we have room again.
+ */
 static void
-read_timer(priv_t priv)
+flush_tx(serial_t *dev)
 {
-    serial_t *dev = (serial_t *)priv;
+    int n;
 
-    dev->delay = 0;
+    if (dev->tx_len == 0) return;
 
-    if (dev->fifo_read != dev->fifo_write) {
-	dev->lsr |= LSR_DR;
-	dev->int_status |= SER_INT_RX;
+    n = dev->bh_ops->write(dev->bh, dev->tx_buf, dev->tx_len);
+    if (n <= 0) return;
+
+    dev->tx_len -= n;
+    if (dev->tx_len > 0)
+	memmove(dev->tx_buf, &dev->tx_buf[n], dev->tx_len);
+
+    /* If we were holding off the guest, let it go on. */
+    if (! (dev->lsr & LSR_THRE)) {
+	dev->lsr |= (LSR_THRE | LSR_TEMT);
+	dev->int_status |= SER_INT_TX;
 	update_ints(dev);
     }
 }
 
 
-#ifdef USE_HOST_SERIAL
-/* Platform module has data, so read it! */
+/*
+ * Poll the host side of a linked port.
+ *
+ * Normally, we only take in as many bytes as the line could
+ * have carried since the last poll. In turbo mode, we fill up
+ * the FIFO, and let the guest take them as fast as it can.
+ */
 static void
-read_done(priv_t arg, int num)
+poll_timer(priv_t priv)
 {
-    serial_t *dev = (serial_t *)arg;
+    serial_t *dev = (serial_t *)priv;
+    int64_t ct = 0;
+    int max, n;
 
-    /* We can do at least 'num' bytes.. */
-    while (num-- > 0) {
-	/* Get a byte from them. */
-	if (plat_serial_read(dev->bh, &dev->hold, 1) < 0) break;
+    /* Not linked (anymore), so stop polling. */
+    if (dev->bh == NULL) {
+	dev->poll_delay = 0;
+	return;
+    }
 
-	/* Stuff it into the FIFO and set intr. */
-	write_fifo(dev, &dev->hold, 1);
+    dev->poll_delay += POLL_TIME * TIMER_USEC;
+
+    flush_tx(dev);
+
+    max = SERIAL_FIFO_MAX;
+    if (! dev->turbo) {
+	ct = char_time(dev);
+	dev->rx_credit += POLL_TIME * TIMER_USEC;
+	if (dev->rx_credit > (ct * SERIAL_FIFO_MAX))
+		dev->rx_credit = ct * SERIAL_FIFO_MAX;
+	max = (int)(dev->rx_credit / ct);
     }
 
-    /* We have data waiting for us.. delay a little, and then read it. */
-//    timer_add(ser_timer, dev, &dev->delay, &dev->delay);
+    n = fill_rx(dev, max);
+
+    if (! dev->turbo)
+	dev->rx_credit -= n * ct;
 }
-#endif
 
 
 static void
 ser_write(uint16_t addr, uint8_t val, priv_t priv)
 {
     serial_t *dev = (serial_t *)priv;
-#if defined(_LOGGING) || defined(USE_HOST_SERIAL)
     uint32_t speed;
     uint8_t wl, sb, pa;
-#endif
     uint32_t baud;
     uint8_t msr;
 
@@ -435,18 +545,26 @@ ser_write(uint16_t addr, uint8_t val, priv_t priv)
 
 		if (dev->ops && dev->ops->write) {
 			dev->ops->write(dev, dev->ops_arg, dev->thr);
-#ifdef USE_HOST_SERIAL
 		} else if (dev->bh != NULL) {
-			/* We are linked, so send to BH layer. */
-			plat_serial_write(dev->bh, dev->thr);
-#endif
+			/* We are linked, so queue it for the BH layer. */
+			if (dev->tx_len < TX_BUFLEN)
+				dev->tx_buf[dev->tx_len++] = dev->thr;
+			if (dev->tx_len == TX_BUFLEN)
+				flush_tx(dev);
 		}
 
-		/* WRITE completed, we are ready for more. */
-		//FIXME: add a callback delay here.
-		dev->lsr |= LSR_THRE;
-                dev->int_status |= SER_INT_TX;
-                update_ints(dev);
+		if ((dev->bh != NULL) && (dev->tx_len == TX_BUFLEN)) {
+			/* Host side is busy, hold off until we have room. */
+			dev->lsr &= ~(LSR_THRE | LSR_TEMT);
+			dev->int_status &= ~SER_INT_TX;
+			update_ints(dev);
+		} else {
+			/* WRITE completed, we are ready for more. */
+			//FIXME: add a callback delay here.
+			dev->lsr |= LSR_THRE;
+			dev->int_status |= SER_INT_TX;
+			update_ints(dev);
+		}
 
 		/* Loopback echo data to RX needed? */
                 if (dev->mcr & MCR_LMS) {
@@ -485,31 +603,23 @@ INFO("Serial%i: enable FIFO (%02x), type %i!\n", dev->port, val, dev->type);
 			/* We dropped DLAB, so handle baudrate. */
 			baud = dev->dlab;
 			if (baud > 0) {
-#if defined(_LOGGING) || defined(USE_HOST_SERIAL)
 				speed = 115200UL / baud;
-#endif
 				DEBUG("Serial%i: divisor %u, baudrate %i\n",
 						dev->port, baud, speed);
-#ifdef USE_HOST_SERIAL
-				if (dev->bh != NULL)
-					plat_serial_speed(dev->bh, speed);
-#endif
+				if ((dev->bh != NULL) && dev->bh_ops->speed)
+					dev->bh_ops->speed(dev->bh, speed);
 			} else {
 				DEBUG("Serial%i: divisor %u invalid!\n",
 							dev->port, baud);
 			}
 		}
 
-#if defined(_LOGGING) || defined(USE_HOST_SERIAL)
 		wl = (val & LCR_WLS) + 5;		/* databits */
 		sb = (val & LCR_SBS) ? 2 : 1;		/* stopbits */
 		pa = (val & (LCR_PE|LCR_EP|LCR_PS)) >> 3;
-#endif
 		DEBUG("Serial%i: WL=%i SB=%i PA=%i\n", dev->port, wl, sb, pa);
-#ifdef USE_HOST_SERIAL
-		if (dev->bh != NULL)
-			plat_serial_params(dev->bh, wl, pa, sb);
-#endif
+		if ((dev->bh != NULL) && dev->bh_ops->params)
+			dev->bh_ops->params(dev->bh, wl, pa, sb);
 
 		dev->lcr = val;
 		break;
@@ -536,25 +646,16 @@ INFO("Serial%i: enable FIFO (%02x), type %i!\n", dev->port, val, dev->type);
 		}
 
 		if ((val & MCR_OUT2) && !(dev->mcr & MCR_OUT2)) {
-#ifdef USE_HOST_SERIAL
-			if (dev->bh != NULL) {
-				/* Linked, start host port. */
-				(void)plat_serial_active(dev->bh, 1);
-			} else {
-#endif
-				/* Not linked, start RX timer. */
-				timer_add(read_timer, dev,
-					  &dev->delay, &dev->delay);
-
-				/* Fake CTS, DSR and DCD (for now.) */
-				dev->msr = (MSR_CTS | MSR_DCTS |
-					    MSR_DSR | MSR_DDSR |
-					    MSR_DCD | MSR_DDCD);
-				dev->int_status |= SER_INT_MSR;
-				update_ints(dev);
-#ifdef USE_HOST_SERIAL
-			}
-#endif
+			/*
+			 * The RX timer was set up in ser_init, and linked
+			 * ports are polled already, so all we need to do
+			 * is fake CTS, DSR and DCD (for now.)
+			 */
+			dev->msr = (MSR_CTS | MSR_DCTS |
+				    MSR_DSR | MSR_DDSR |
+				    MSR_DCD | MSR_DDCD);
+			dev->int_status |= SER_INT_MSR;
+			update_ints(dev);
 		}
 
 		dev->mcr = val;
@@ -630,10 +731,6 @@ ser_read(uint16_t addr, priv_t priv)
 
 		/* If there is data in the RX FIFO, grab it. */
                 ret = read_fifo(dev);
-
-                if (dev->fifo_read != dev->fifo_write) {
-                        dev->delay = 1000LL * TIMER_USEC;
-		}
                 break;
 
 	case 1:		/* LCR / DLAB2 */
@@ -673,7 +770,8 @@ ser_read(uint16_t addr, priv_t priv)
 	case 5:		/* LSR */
                 if (dev->lsr & LSR_THRE)
                         dev->lsr |= LSR_TEMT;
-                dev->lsr |= LSR_THRE;
+		if ((dev->bh == NULL) || (dev->tx_len < TX_BUFLEN))
+			dev->lsr |= LSR_THRE;
                 ret = dev->lsr;
                 if (dev->lsr & 0x1f)
                         dev->lsr &= ~0x1e;
@@ -710,11 +808,9 @@ ser_close(priv_t priv)
 {
     serial_t *dev = (serial_t *)priv;
 
-#ifdef USE_HOST_SERIAL
     /* Close the host device. */
     if (dev->bh != NULL)
 	(void)serial_link(dev->port, NULL);
-#endif
 
     /* Remove the I/O handler. */
     io_removehandler(dev->base, 8,
@@ -748,6 +844,13 @@ ser_init(const device_t *info, UNUSED(void *parent))
     INFO("SERIAL: COM%i (I/O=%04X, IRQ=%i)\n",
 	 info->local & 127, dev->base, dev->irq);
 
+    /* Link it to the host side, if so configured. */
+    dev->turbo = config.serial_turbo[dev->port];
+    if (config.serial_link[dev->port][0] != '\0') {
+	timer_add(poll_timer, dev, &dev->poll_delay, &dev->poll_delay);
+	(void)serial_link(dev->port, config.serial_link[dev->port]);
+    }
+
     return((priv_t)dev);
 }
 
@@ -868,11 +971,12 @@ serial_attach(int port, serial_ops_t *ops, priv_t arg)
 }
 
 
-#ifdef USE_HOST_SERIAL
-/* Link a serial port to a host (serial) port. */
+/* Link a serial port to a host (serial) port, socket or pty. */
 int
 serial_link(int port, const char *arg)
 {
+    const serial_bh_t *bh;
+    const char *sp;
     serial_t *dev;
 
     /* No can do if port not enabled. */
@@ -888,30 +992,39 @@ serial_link(int port, const char *arg)
 		return(-1);
 	}
 
+	/* Find the backend for it. */
+	bh = serial_bh_find(arg, &sp);
+	if (bh == NULL) {
+		ERRLOG("Serial%i: no backend for '%s' !\n", port, arg);
+		return(-1);
+	}
+
 	/* Request a port from the host system. */
-	dev->bh = plat_serial_open(arg, 0);
+	dev->bh = bh->open(sp);
 	if (dev->bh == NULL) {
 		ERRLOG("Serial%i unable to link to '%s' !\n", port, arg);
 		return(-1);
 	}
+	dev->bh_ops = bh;
+	dev->tx_len = 0;
+	dev->rx_credit = 0;
+	dev->poll_delay = POLL_TIME * TIMER_USEC;
 
-	/* Set up bottom-half I/O callback info. */
-#if 0
-	bh->rd_done = read_done;
-	bh->rd_arg = dev;
-#endif
+	INFO("Serial%i linked to '%s'%s\n",
+	     port, arg, dev->turbo ? " (turbo)" : "");
     } else {
 	/* If we are linked, unlink it. */
 	if (dev->bh != NULL) {
-		plat_serial_close(dev->bh);
+		flush_tx(dev);
+		dev->bh_ops->close(dev->bh);
 		dev->bh = NULL;
+		dev->bh_ops = NULL;
 	}
-
+	dev->poll_delay = 0;
     }
 
     return(0);
 }
-#endif
 
 
 /* API: clear the FIFO buffers of a serial port. */
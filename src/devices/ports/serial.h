@@ -8,7 +8,7 @@
  *
  *		Definitions for the SERIAL card.
  *
- * Version:	@(#)serial.h	1.0.11	2019/05/13
+ * Version:	@(#)serial.h	1.0.13	2026/10/19
  *
  * Author:	Fred N. van Kempen, <decwiz@yahoo.com>
  *
@@ -71,6 +71,23 @@ typedef struct {
     void	(*write)(void *dev, void *arg, uint8_t val);
 } serial_ops_t;
 
+/*
+ * Host side ("bottom half") of a linked serial port.
+ *
+ * The read and write calls never block; they return the number
+ * of bytes moved, which can be 0 if the host side is busy. A read
+ * returns -1 once the link is gone for good.
+ */
+typedef struct {
+    const char	*prefix;
+    priv_t	(*open)(const char *arg);
+    void	(*close)(priv_t);
+    int		(*read)(priv_t, uint8_t *bufp, int max);
+    int		(*write)(priv_t, const uint8_t *bufp, int len);
+    int		(*speed)(priv_t, long speed);
+    int		(*params)(priv_t, char dbit, char par, char sbit);
+} serial_bh_t;
+
 
 /* Global variables. */
 #ifdef EMU_DEVICE_H
@@ -91,6 +108,8 @@ extern int	serial_link(int port, const char *name);
 extern void	serial_clear(priv_t arg);
 extern void	serial_write(priv_t arg, uint8_t *ptr, uint8_t len);
 
+extern const serial_bh_t *serial_bh_find(const char *name, const char **arg);
+
 /* Platform serial driver support. */
 extern priv_t	plat_serial_open(const char *port, int tmo);
 extern void	plat_serial_close(priv_t);
@@ -0,0 +1,525 @@
+/*
+ * VARCem	Virtual ARchaeological Computer EMulator.
+ *		An emulator of (mostly) x86-based PC systems and devices,
+ *		using the ISA,EISA,VLB,MCA  and PCI system buses, roughly
+ *		spanning the era between 1981 and 1995.
+ *
+ *		This file is part of the VARCem Project.
+ *
+ *		Host side ("bottom halves") of linked serial ports.
+ *
+ *		A serial port can be linked to a host serial port, to a
+ *		TCP socket, or (on UNIX systems) to a pseudo-terminal.
+ *		The link name selects the backend:
+ *
+ *		  tcp:host:port		connect to a TCP server
+ *		  tcp:port		listen for a TCP client
+ *		  pty			create a pseudo-terminal
+ *		  anything else		host serial port (COM1 etc)
+ *
+ *		All backends are non-blocking, and are polled from the
+ *		emulator thread, so data can be moved in batches.
+ *
+ * Version:	@(#)serial_bh.c	1.0.3	2026/10/19
+ *
+ * Author:	agent, <agent@local>
+ *
+ *		Copyright 2026 agent.
+ *
+ *		Redistribution and  use  in source  and binary forms, with
+ *		or  without modification, are permitted  provided that the
+ *		following conditions are met:
+ *
+ *		1. Redistributions of  source  code must retain the entire
+ *		   above notice, this list of conditions and the following
+ *		   disclaimer.
+ *
+ *		2. Redistributions in binary form must reproduce the above
+ *		   copyright  notice,  this list  of  conditions  and  the
+ *		   following disclaimer in  the documentation and/or other
+ *		   materials provided with the distribution.
+ *
+ *		3. Neither the  name of the copyright holder nor the names
+ *		   of  its  contributors may be used to endorse or promote
+ *		   products  derived from  this  software without specific
+ *		   prior written permission.
+ *
+ * THIS SOFTWARE  IS  PROVIDED BY THE  COPYRIGHT  HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND  ANY EXPRESS  OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE  ARE  DISCLAIMED. IN  NO  EVENT  SHALL THE COPYRIGHT
+ * HOLDER OR  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL,  EXEMPLARY,  OR  CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE  GOODS OR SERVICES;  LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON  ANY
+ * THEORY OF  LIABILITY, WHETHER IN  CONTRACT, STRICT  LIABILITY, OR  TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING  IN ANY  WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _WIN32
+# define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <wchar.h>
+#ifdef _WIN32
+# define WIN32_LEAN_AND_MEAN
+# include <winsock2.h>
+# include <ws2tcpip.h>
+#else
+# include <sys/types.h>
+# include <sys/select.h>
+# include <sys/socket.h>
+# include <netinet/in.h>
+# include <netinet/tcp.h>
+# include <netdb.h>
+# include <errno.h>
+# include <fcntl.h>
+# include <termios.h>
+# include <unistd.h>
+#endif
+#include "../../emu.h"
+#include "../../plat.h"
+#include "serial.h"
+
+
+#ifdef _WIN32
+# define sock_close	closesocket
+# define sock_again()	(WSAGetLastError() == WSAEWOULDBLOCK)
+# define sock_pending()	(WSAGetLastError() == WSAEWOULDBLOCK)
+#else
+typedef int		SOCKET;
+# define INVALID_SOCKET	-1
+# define sock_close	close
+# define sock_again()	((errno == EAGAIN) || (errno == EWOULDBLOCK))
+# define sock_pending()	(errno == EINPROGRESS)
+#endif
+
+
+typedef struct {
+    SOCKET	listener,			// INVALID_SOCKET if client
+		pending,			// connect in progress
+		sock;				// INVALID_SOCKET if none
+    char	name[128];
+} tcp_t;
+
+#ifndef _WIN32
+typedef struct {
+    int		master,
+		slave;				// kept open to avoid EIO
+    char	name[128];
+} pty_t;
+#endif
+
+
+static int
+sock_nonblock(SOCKET s)
+{
+#ifdef _WIN32
+    u_long on = 1;
+
+    return(ioctlsocket(s, FIONBIO, &on));
+#else
+    return(fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK));
+#endif
+}
+
+
+/* Set up a new connection, we want small writes to go out right away. */
+static void
+tcp_setup(tcp_t *dev, SOCKET s)
+{
+    int on = 1;
+
+    (void)setsockopt(s, IPPROTO_TCP, TCP_NODELAY,
+		     (const char *)&on, sizeof(on));
+    (void)sock_nonblock(s);
+
+    dev->sock = s;
+}
+
+
+/* Accept a new client, if we are listening and have none. */
+static void
+tcp_accept(tcp_t *dev)
+{
+    SOCKET s;
+
+    if ((dev->listener == INVALID_SOCKET) || (dev->sock != INVALID_SOCKET))
+	return;
+
+    s = accept(dev->listener, NULL, NULL);
+    if (s == INVALID_SOCKET)
+	return;
+
+    INFO("%s: client connected\n", dev->name);
+
+    tcp_setup(dev, s);
+}
+
+
+/* See if our connect to the server has completed. */
+static void
+tcp_connect(tcp_t *dev)
+{
+    struct timeval tv;
+    fd_set wfds, efds;
+    socklen_t len;
+    SOCKET s;
+    int err;
+
+    if (dev->pending == INVALID_SOCKET)
+	return;
+    s = dev->pending;
+
+    FD_ZERO(&wfds);
+    FD_SET(s, &wfds);
+    FD_ZERO(&efds);
+    FD_SET(s, &efds);
+    tv.tv_sec = tv.tv_usec = 0;
+    if (select((int)s + 1, NULL, &wfds, &efds, &tv) <= 0)
+	return;
+
+    dev->pending = INVALID_SOCKET;
+
+    err = 0;
+    len = sizeof(err);
+    if ((getsockopt(s, SOL_SOCKET, SO_ERROR, (char *)&err, &len) != 0) ||
+	(err != 0)) {
+	ERRLOG("%s: unable to connect\n", dev->name);
+	sock_close(s);
+	return;
+    }
+
+    INFO("%s: connected\n", dev->name);
+
+    tcp_setup(dev, s);
+}
+
+
+/* The other end went away. */
+static void
+tcp_drop(tcp_t *dev)
+{
+    INFO("%s: connection closed\n", dev->name);
+
+    sock_close(dev->sock);
+    dev->sock = INVALID_SOCKET;
+}
+
+
+static priv_t
+tcp_open(const char *arg)
+{
+    struct addrinfo hints, *res;
+    char host[128], *sp;
+    const char *port;
+    tcp_t *dev;
+    SOCKET s;
+    int on = 1;
+#ifdef _WIN32
+    WSADATA wsa;
+
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+	ERRLOG("SERIAL: unable to initialize WinSock!\n");
+	return(NULL);
+    }
+#endif
+
+    /* Split the argument into host and port. */
+    strncpy(host, arg, sizeof(host) - 1);
+    host[sizeof(host) - 1] = '\0';
+    if ((sp = strrchr(host, ':')) != NULL) {
+	*sp++ = '\0';
+	port = sp;
+    } else {
+	port = host;
+	sp = NULL;
+    }
+
+    memset(&hints, 0x00, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (sp == NULL)
+	hints.ai_flags = AI_PASSIVE;
+    if (getaddrinfo((sp != NULL) ? host : NULL, port, &hints, &res) != 0) {
+	ERRLOG("SERIAL: unable to resolve '%s'\n", arg);
+	goto failed;
+    }
+
+    s = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    if (s == INVALID_SOCKET) {
+	ERRLOG("SERIAL: unable to create socket for '%s'\n", arg);
+	freeaddrinfo(res);
+	goto failed;
+    }
+
+    dev = (tcp_t *)mem_alloc(sizeof(tcp_t));
+    memset(dev, 0x00, sizeof(tcp_t));
+    dev->listener = dev->pending = dev->sock = INVALID_SOCKET;
+    snprintf(dev->name, sizeof(dev->name), "tcp:%s", arg);
+
+    if (sp == NULL) {
+	/* No host given, so wait for a client to connect to us. */
+	(void)setsockopt(s, SOL_SOCKET, SO_REUSEADDR,
+			 (const char *)&on, sizeof(on));
+	if ((bind(s, res->ai_addr, (int)res->ai_addrlen) != 0) ||
+	    (listen(s, 1) != 0)) {
+		ERRLOG("%s: unable to listen\n", dev->name);
+		goto failed_sock;
+	}
+	(void)sock_nonblock(s);
+	dev->listener = s;
+
+	INFO("%s: waiting for a client\n", dev->name);
+    } else {
+	/* Do not hold up the emulator, the poll finishes the connect. */
+	(void)sock_nonblock(s);
+	if ((connect(s, res->ai_addr, (int)res->ai_addrlen) != 0) &&
+	    !sock_pending()) {
+		ERRLOG("%s: unable to connect\n", dev->name);
+		goto failed_sock;
+	}
+	dev->pending = s;
+
+	INFO("%s: connecting\n", dev->name);
+    }
+    freeaddrinfo(res);
+
+    return((priv_t)dev);
+
+failed_sock:
+    sock_close(s);
+    freeaddrinfo(res);
+    free(dev);
+
+failed:
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    return(NULL);
+}
+
+
+static void
+tcp_close(priv_t arg)
+{
+    tcp_t *dev = (tcp_t *)arg;
+
+    if (dev->sock != INVALID_SOCKET)
+	sock_close(dev->sock);
+    if (dev->pending != INVALID_SOCKET)
+	sock_close(dev->pending);
+    if (dev->listener != INVALID_SOCKET)
+	sock_close(dev->listener);
+
+    free(dev);
+
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+
+static int
+tcp_read(priv_t arg, uint8_t *bufp, int max)
+{
+    tcp_t *dev = (tcp_t *)arg;
+    int n;
+
+    tcp_accept(dev);
+    tcp_connect(dev);
+    if (dev->sock == INVALID_SOCKET) {
+	/* A client that lost (or never got) its connection is done. */
+	if ((dev->listener == INVALID_SOCKET) &&
+	    (dev->pending == INVALID_SOCKET))
+		return(-1);
+	return(0);
+    }
+
+    n = recv(dev->sock, (char *)bufp, max, 0);
+    if (n > 0)
+	return(n);
+
+    if ((n < 0) && sock_again())
+	return(0);
+
+    tcp_drop(dev);
+
+    return(0);
+}
+
+
+static int
+tcp_write(priv_t arg, const uint8_t *bufp, int len)
+{
+    tcp_t *dev = (tcp_t *)arg;
+    int n;
+
+    if (dev->pending != INVALID_SOCKET)
+	return(0);			// not connected yet, hold it
+    if (dev->sock == INVALID_SOCKET)
+	return(len);			// nobody listening, discard
+
+    n = send(dev->sock, (const char *)bufp, len, 0);
+    if ((n < 0) && !sock_again()) {
+	tcp_drop(dev);
+	return(len);
+    }
+
+    return((n < 0) ? 0 : n);
+}
+
+
+#ifndef _WIN32
+static priv_t
+pty_open(UNUSED(const char *arg))
+{
+    struct termios tio;
+    pty_t *dev;
+    char *sp;
+
+    dev = (pty_t *)mem_alloc(sizeof(pty_t));
+    memset(dev, 0x00, sizeof(pty_t));
+    dev->slave = -1;
+
+    dev->master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (dev->master < 0) {
+	ERRLOG("SERIAL: unable to create pty\n");
+	free(dev);
+	return(NULL);
+    }
+
+    if ((grantpt(dev->master) != 0) || (unlockpt(dev->master) != 0) ||
+	((sp = ptsname(dev->master)) == NULL)) {
+	ERRLOG("SERIAL: unable to set up pty\n");
+	close(dev->master);
+	free(dev);
+	return(NULL);
+    }
+    strncpy(dev->name, sp, sizeof(dev->name) - 1);
+
+    /* Keep the slave side open, and make it transparent. */
+    dev->slave = open(dev->name, O_RDWR | O_NOCTTY);
+    if ((dev->slave >= 0) && (tcgetattr(dev->slave, &tio) == 0)) {
+	cfmakeraw(&tio);
+	(void)tcsetattr(dev->slave, TCSANOW, &tio);
+    }
+
+    INFO("SERIAL: linked to pty '%s'\n", dev->name);
+
+    return((priv_t)dev);
+}
+
+
+static void
+pty_close(priv_t arg)
+{
+    pty_t *dev = (pty_t *)arg;
+
+    if (dev->slave >= 0)
+	close(dev->slave);
+    close(dev->master);
+
+    free(dev);
+}
+
+
+static int
+pty_read(priv_t arg, uint8_t *bufp, int max)
+{
+    pty_t *dev = (pty_t *)arg;
+    ssize_t n;
+
+    n = read(dev->master, bufp, max);
+
+    return((n < 0) ? 0 : (int)n);
+}
+
+
+static int
+pty_write(priv_t arg, const uint8_t *bufp, int len)
+{
+    pty_t *dev = (pty_t *)arg;
+    ssize_t n;
+
+    n = write(dev->master, bufp, len);
+    if ((n < 0) && !sock_again())
+	return(len);			// nobody there, discard
+
+    return((n < 0) ? 0 : (int)n);
+}
+#endif
+
+
+#ifdef USE_HOST_SERIAL
+static priv_t
+host_open(const char *arg)
+{
+    priv_t dev;
+
+    /* Short timeout, so the reader can return partial blocks. */
+    dev = plat_serial_open(arg, 10);
+    if (dev != NULL)
+	(void)plat_serial_active(dev, 1);
+
+    return(dev);
+}
+
+
+static int
+host_write(priv_t arg, const uint8_t *bufp, int len)
+{
+    int i;
+
+    for (i = 0; i < len; i++) {
+	if (plat_serial_write(arg, bufp[i]) < 0) break;
+    }
+
+    return(i);
+}
+
+
+static int
+host_read(priv_t arg, uint8_t *bufp, int max)
+{
+    return(plat_serial_read(arg, bufp, max));
+}
+#endif
+
+
+static const serial_bh_t backends[] = {
+  { "tcp:",
+    tcp_open, tcp_close, tcp_read, tcp_write, NULL, NULL		},
+#ifndef _WIN32
+  { "pty",
+    pty_open, pty_close, pty_read, pty_write, NULL, NULL		},
+#endif
+#ifdef USE_HOST_SERIAL
+  { "",
+    host_open, plat_serial_close, host_read, host_write,
+    plat_serial_speed, plat_serial_params				},
+#endif
+  { NULL								}
+};
+
+
+/* Find the backend for a link name, and the argument for it. */
+const serial_bh_t *
+serial_bh_find(const char *name, const char **arg)
+{
+    const serial_bh_t *bh;
+    size_t len;
+
+    for (bh = backends; bh->prefix != NULL; bh++) {
+	len = strlen(bh->prefix);
+	if (! strncmp(name, bh->prefix, len)) {
+		*arg = name + len;
+		return(bh);
+	}
+    }
+
+    return(NULL);
+}
@@ -8,7 +8,7 @@
  *
  *		Implementation of the Generic ESC/P Dot-Matrix printer.
  *
- * Version:	@(#)prt_escp.c	1.0.12	2021/03/18
+ * Version:	@(#)prt_escp.c	1.0.14	2026/10/19
  *
  * Authors:	Michael Dring, <michael@drueing.de>
  *		Fred N. van Kempen, <decwiz@yahoo.com>
@@ -544,18 +544,30 @@ dump_page(escp_t *dev)
 {
     wchar_t path[1024];
     wchar_t temp[128];
+#ifdef USE_LIBPNG
+    uint8_t *pix;
+#endif
 
     wcscpy(path, dev->pagepath);
 #ifdef USE_LIBPNG
-    /* Try PNG first. */
+    /*
+     * Try PNG first.
+     *
+     * Compressing a full page takes a while, so we let the
+     * encoder thread do that, on its own copy of the page.
+     * If it fails to, it saves the page as a PGM/PPM file.
+     */
     plat_tempfile(temp, NULL, L".png");
     wcscat(path, temp);
+    pix = (uint8_t *)mem_alloc(dev->page->pitch * dev->page->h);
+    memcpy(pix, dev->page->pixels, dev->page->pitch * dev->page->h);
 # ifdef USE_COLOR
-    if (! png_write_pal(path, dev->page->pixels, dev->page->w, dev->page->h,
+    if (! png_queue_pal(path, pix, dev->page->w, dev->page->h,
 			dev->page->pitch, dev->palcol)) {
 # else
-    if (! png_write_gray(path, 1, dev->page->pixels, dev->page->w, dev->page->h)) {
+    if (! png_queue_gray(path, 1, pix, dev->page->w, dev->page->h)) {
 # endif
+	free(pix);
 	wcscpy(path, dev->pagepath);
 #endif
 	plat_tempfile(temp, NULL, L".pgm");
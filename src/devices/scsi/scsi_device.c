@@ -8,7 +8,7 @@
  *
  *		The generic SCSI device command handler.
  *
- * Version:	@(#)scsi_device.c	1.0.15	2019/05/17
+ * Version:	@(#)scsi_device.c	1.0.16	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -44,6 +44,7 @@
 #include "../../emu.h"
 #include "../../timer.h"
 #include "../../device.h"
+#include "../../mem.h"
 #include "../disk/hdd.h"
 #include "scsi.h"
 #include "scsi_device.h"
@@ -171,6 +172,7 @@ scsi_device_command_phase0(scsi_device_t *dev, uint8_t *cdb)
 
     /* Execute the SCSI command immediately and get the transfer length. */
     dev->phase = SCSI_PHASE_COMMAND;
+    dev->sg_direct = 0;
     dev->status = target_command(dev, cdb);
 
     if (dev->phase == SCSI_PHASE_STATUS) {
@@ -209,6 +211,94 @@ scsi_device_get_buf_len(scsi_device_t *dev)
 }
 
 
+/* Check if all segments of an S/G list are plain guest RAM. */
+int
+scsi_device_sg_ram(const scsi_sg_t *sg, int count)
+{
+    int i;
+
+    for (i = 0; i < count; i++) {
+	if (mem_get_ram_ptr(sg[i].addr, sg[i].len) == NULL)
+		return 0;
+    }
+
+    return 1;
+}
+
+
+/*
+ * Move a block transfer straight between the medium and the guest
+ * RAM segments of the host adapter's S/G list, skipping cmd_buffer.
+ *
+ * Whole sectors go directly to or from guest memory; only a sector
+ * that straddles two segments is staged through a local buffer. The
+ * host adapter has already checked the list with scsi_device_sg_ram().
+ */
+void
+scsi_device_sg_transfer(scsi_device_t *dev, int write,
+			void (*func)(uint8_t, uint32_t, uint32_t, uint8_t *),
+			uint8_t id, uint32_t sector, uint32_t count)
+{
+    uint8_t bounce[512];
+    const scsi_sg_t *sg = dev->sg;
+    uint32_t pos = 0, n, part, done;
+    uint8_t *ptr;
+    int i = 0;
+
+    while (count > 0) {
+	/* Skip over the segments (or parts thereof) already used. */
+	while ((i < dev->sg_count) && (pos >= sg[i].len)) {
+		pos -= sg[i].len;
+		i++;
+	}
+	if (i >= dev->sg_count)
+		break;
+
+	ptr = mem_get_ram_ptr(sg[i].addr + pos, sg[i].len - pos);
+	n = (sg[i].len - pos) >> 9;
+	if (n > count)
+		n = count;
+
+	if (n > 0) {
+		/* One or more whole sectors fit in this segment. */
+		func(id, sector, n, ptr);
+		if (! write)
+			mem_invalidate_range(sg[i].addr + pos,
+					     sg[i].addr + pos + (n << 9) - 1);
+		sector += n;
+		count -= n;
+		pos += (n << 9);
+		continue;
+	}
+
+	/* This sector is split over two (or more) segments. */
+	if (! write)
+		func(id, sector, 1, bounce);
+	for (done = 0; (done < 512) && (i < dev->sg_count); ) {
+		part = MIN(512 - done, sg[i].len - pos);
+		ptr = mem_get_ram_ptr(sg[i].addr + pos, part);
+		if (write)
+			memcpy(&bounce[done], ptr, part);
+		else {
+			memcpy(ptr, &bounce[done], part);
+			mem_invalidate_range(sg[i].addr + pos,
+					     sg[i].addr + pos + part - 1);
+		}
+		done += part;
+		pos += part;
+		if (pos >= sg[i].len) {
+			pos = 0;
+			i++;
+		}
+	}
+	if (write)
+		func(id, sector, 1, bounce);
+	sector++;
+	count--;
+    }
+}
+
+
 #ifdef _LOGGING
 void
 scsi_log(int level, const char *fmt, ...)
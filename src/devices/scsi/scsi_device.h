@@ -8,7 +8,7 @@
  *
  *		Definitions for the generic SCSI device command handler.
  *
- * Version:	@(#)scsi_device.h	1.0.8	2019/05/17
+ * Version:	@(#)scsi_device.h	1.0.9	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -301,6 +301,12 @@
 #define SCSI_REMOVABLE_CDROM	0x8005
 
 
+/* One segment of a host adapter's scatter/gather list. */
+typedef struct {
+    uint32_t	addr;
+    uint32_t	len;
+} scsi_sg_t;
+
 typedef struct {	
     uint8_t	id, lun;
     uint16_t	type;
@@ -310,6 +316,15 @@ typedef struct {
     int32_t	buffer_length;
     uint8_t	*cmd_buffer;
 
+    /*
+     * If the target sets sg_direct during phase 0, the command is a
+     * plain block transfer, and the host adapter may then hand it a
+     * list of guest RAM segments instead of filling cmd_buffer.
+     */
+    int		sg_direct;
+    int		sg_count;
+    scsi_sg_t	*sg;
+
     void	*p;
     void	(*command)(void *p, uint8_t *cdb);
     void	(*callback)(void *p);
@@ -379,6 +394,10 @@ extern int	scsi_device_cdb_length(scsi_device_t *dev);
 extern void	scsi_device_command_phase0(scsi_device_t *dev, uint8_t *cdb);
 extern void	scsi_device_command_phase1(scsi_device_t *dev);
 extern int32_t	*scsi_device_get_buf_len(scsi_device_t *dev);
+extern int	scsi_device_sg_ram(const scsi_sg_t *sg, int count);
+extern void	scsi_device_sg_transfer(scsi_device_t *dev, int write,
+				void (*func)(uint8_t, uint32_t, uint32_t, uint8_t *),
+				uint8_t id, uint32_t sector, uint32_t count);
 
 
 #endif	/*EMU_SCSI_DEVICE_H*/
@@ -12,7 +12,7 @@
  *		until this is fixed, we return the actual device properties,
  *		and keep the sense data unmodifyable.
  *
- * Version:	@(#)scsi_disk.c	1.0.24	2019/05/17
+ * Version:	@(#)scsi_disk.c	1.0.25	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -833,6 +833,7 @@ disk_command(void *p, uint8_t *cdb)
 
 		set_buf_len(dev, BufLen, &alloc_length);
 		set_phase(dev, SCSI_PHASE_DATA_IN);
+		scsi_devices[dev->drv->bus_id.scsi.id][dev->drv->bus_id.scsi.lun].sg_direct = 1;
 
 		if (dev->requested_blocks > 1)
 			data_command_finish(dev, alloc_length, alloc_length / dev->requested_blocks, alloc_length, 0);
@@ -899,6 +900,9 @@ disk_command(void *p, uint8_t *cdb)
 
 		set_buf_len(dev, BufLen, &alloc_length);
 		set_phase(dev, SCSI_PHASE_DATA_OUT);
+		if ((cdb[0] != GPCMD_VERIFY_6) && (cdb[0] != GPCMD_VERIFY_10) &&
+		    (cdb[0] != GPCMD_VERIFY_12))
+			scsi_devices[dev->drv->bus_id.scsi.id][dev->drv->bus_id.scsi.lun].sg_direct = 1;
 
 		if (dev->requested_blocks > 1)
 			data_command_finish(dev, alloc_length, alloc_length / dev->requested_blocks, alloc_length, 1);
@@ -1167,8 +1171,10 @@ atapi_out:
 static void
 phase_data_in(scsi_disk_t *dev)
 {
-    uint8_t *hdbufferb = scsi_devices[dev->drv->bus_id.scsi.id][dev->drv->bus_id.scsi.lun].cmd_buffer;
-    int32_t *BufLen = &scsi_devices[dev->drv->bus_id.scsi.id][dev->drv->bus_id.scsi.lun].buffer_length;
+    scsi_device_t *sd = &scsi_devices[dev->drv->bus_id.scsi.id][dev->drv->bus_id.scsi.lun];
+    uint8_t *hdbufferb = sd->cmd_buffer;
+    int32_t *BufLen = &sd->buffer_length;
+    uint32_t count;
 
     if (!*BufLen) {
 	DEBUG("scsi_disk_phase_data_in(): Buffer length is 0\n");
@@ -1193,9 +1199,14 @@ phase_data_in(scsi_disk_t *dev)
 	case GPCMD_READ_12:
 		if ((dev->requested_blocks > 0) && (*BufLen > 0)) {
 			if (dev->packet_len > (uint32_t) *BufLen)
-				hdd_image_read(dev->id, dev->sector_pos, *BufLen >> 9, hdbufferb);
+				count = *BufLen >> 9;
 			else
-				hdd_image_read(dev->id, dev->sector_pos, dev->requested_blocks, hdbufferb);
+				count = dev->requested_blocks;
+			if (sd->sg != NULL)
+				scsi_device_sg_transfer(sd, 0, hdd_image_read,
+							dev->id, dev->sector_pos, count);
+			else
+				hdd_image_read(dev->id, dev->sector_pos, count, hdbufferb);
 		}
 		break;
 
@@ -1224,9 +1235,10 @@ phase_data_in(scsi_disk_t *dev)
 static void
 phase_data_out(scsi_disk_t *dev)
 {
-    uint8_t *hdbufferb = scsi_devices[dev->drv->bus_id.scsi.id][dev->drv->bus_id.scsi.lun].cmd_buffer;
+    scsi_device_t *sd = &scsi_devices[dev->drv->bus_id.scsi.id][dev->drv->bus_id.scsi.lun];
+    uint8_t *hdbufferb = sd->cmd_buffer;
     int i;
-    int32_t *BufLen = &scsi_devices[dev->drv->bus_id.scsi.id][dev->drv->bus_id.scsi.lun].buffer_length;
+    int32_t *BufLen = &sd->buffer_length;
     uint32_t last_sector = hdd_image_get_last_sector(dev->id);
     uint32_t c, h, s, last_to_write = 0;
     uint16_t block_desc_len, pos;
@@ -1252,9 +1264,14 @@ phase_data_out(scsi_disk_t *dev)
 	case GPCMD_WRITE_AND_VERIFY_12:
 		if ((dev->requested_blocks > 0) && (*BufLen > 0)) {
 			if (dev->packet_len > (uint32_t) *BufLen)
-				hdd_image_write(dev->id, dev->sector_pos, *BufLen >> 9, hdbufferb);
+				c = *BufLen >> 9;
+			else
+				c = dev->requested_blocks;
+			if (sd->sg != NULL)
+				scsi_device_sg_transfer(sd, 1, hdd_image_write,
+							dev->id, dev->sector_pos, c);
 			else
-				hdd_image_write(dev->id, dev->sector_pos, dev->requested_blocks, hdbufferb);
+				hdd_image_write(dev->id, dev->sector_pos, c, hdbufferb);
 		}
 		break;
 
@@ -10,7 +10,7 @@
  *		NCR and later Symbios and LSI. This controller was designed
  *		for the PCI bus.
  *
- * Version:	@(#)scsi_ncr53c810.c	1.0.17	2019/05/17
+ * Version:	@(#)scsi_ncr53c810.c	1.0.19	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -41,6 +41,7 @@
  *   Boston, MA 02111-1307
  *   USA.
  */
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
@@ -190,6 +191,21 @@
 
 #define NCR_BUF_SIZE	  4096
 
+#define NCR_SCRIPT_BUDGET (4000LL * TIMER_USEC)	/* SCRIPTS time per tick */
+
+
+/* SCRIPTS instruction types, for the statistics. */
+enum {
+    INSN_NOP = 0,
+    INSN_BMOV,
+    INSN_IO,
+    INSN_RW,
+    INSN_TC,
+    INSN_MMOV,
+    INSN_LDST,
+    INSN_MAX
+};
+
 
 typedef enum {
     SCSI_STATE_SEND_COMMAND,
@@ -209,6 +225,13 @@ typedef struct {
     int out;
 } ncr53c810_request_t;
 
+/* A fetched and decoded SCRIPTS instruction. */
+typedef struct {
+    uint32_t	insn,
+		addr;
+    int		type;
+} ncr_insn_t;
+
 typedef struct {
     uint8_t	pci_slot;
     int		has_bios;
@@ -302,9 +325,18 @@ typedef struct {
 
     tmrval_t timer_period;
     tmrval_t timer_enabled;
+
+    uint64_t	insn_count[INSN_MAX];
+    tmrval_t	insn_time[INSN_MAX];
 } ncr53c810_t;
 
 
+static const char *insn_names[INSN_MAX] = {
+    "empty", "block move", "i/o", "read/write",
+    "transfer", "memory move", "load/store"
+};
+
+
 static uint8_t	ncr53c810_reg_readb(ncr53c810_t *dev, uint32_t offset);
 static void	ncr53c810_reg_writeb(ncr53c810_t *dev, uint32_t offset, uint8_t val);
 
@@ -456,6 +488,66 @@ read_dword(ncr53c810_t *dev, uint32_t addr)
 }
 
 
+/*
+ * Fetch the SCRIPTS instruction at DSP, and decode its type.
+ *
+ * The guest (and the chip itself) can patch SCRIPTS at any time, so
+ * nothing is kept between fetches. If both words are in plain RAM they
+ * are loaded directly, which is a lot cheaper than going through the
+ * DMA byte handlers; anything else is fetched the normal way.
+ */
+static void
+ncr53c810_fetch(ncr53c810_t *dev, uint32_t dsp, ncr_insn_t *ci)
+{
+    uint8_t *ptr;
+
+    ptr = mem_get_ram_ptr(dsp, 8);
+    if (ptr != NULL) {
+	ci->insn = *(uint32_t *)ptr;
+	ci->addr = *(uint32_t *)(ptr + 4);
+    } else {
+	ci->insn = read_dword(dev, dsp);
+	ci->addr = (ci->insn) ? read_dword(dev, dsp + 4) : 0;
+    }
+
+    if (! ci->insn)
+	ci->type = INSN_NOP;
+    else switch (ci->insn >> 30) {
+	case 0:
+		ci->type = INSN_BMOV;
+		break;
+
+	case 1:
+		ci->type = (((ci->insn >> 27) & 7) < 5) ? INSN_IO : INSN_RW;
+		break;
+
+	case 2:
+		ci->type = INSN_TC;
+		break;
+
+	case 3:
+		ci->type = (ci->insn & (1 << 29)) ? INSN_LDST : INSN_MMOV;
+		break;
+    }
+}
+
+
+static void
+ncr53c810_dump_stats(ncr53c810_t *dev)
+{
+    int i;
+
+    for (i = 0; i < INSN_MAX; i++) {
+	if (dev->insn_count[i] == 0)
+		continue;
+
+	INFO("NCR 810:  %-12s %" PRIu64 " instructions, %" PRIu64 " us\n",
+	     insn_names[i], dev->insn_count[i],
+	     (uint64_t)(dev->insn_time[i] / TIMER_USEC));
+    }
+}
+
+
 static void
 do_irq(ncr53c810_t *dev, int level)
 {
@@ -972,8 +1064,11 @@ ncr53c810_memcpy(ncr53c810_t *dev, uint32_t dest, uint32_t src, int count)
 static void
 ncr53c810_process_script(ncr53c810_t *dev)
 {
+    ncr_insn_t ci;
     uint32_t insn, addr, id, buf[2], dest;
     int opcode, insn_processed = 0, reg, oper, cond, jmp, n, i, c;
+    int type;
+    tmrval_t start;
     int32_t offset;
     uint8_t op0, op1, data8, mask, data[7];
 #ifdef _LOGGING
@@ -983,18 +1078,23 @@ ncr53c810_process_script(ncr53c810_t *dev)
     dev->sstop = 0;
 again:
     insn_processed++;
-    insn = read_dword(dev, dev->dsp);
+    ncr53c810_fetch(dev, dev->dsp, &ci);
+    insn = ci.insn;
+    type = ci.type;
+    start = dev->timer_period;
     if (!insn) {
 	/* If we receive an empty opcode increment the DSP by 4 bytes
 	   instead of 8 and execute the next opcode at that location */
 	dev->dsp += 4;
 	dev->timer_period += (10LL * TIMER_USEC);
+	dev->insn_count[INSN_NOP]++;
+	dev->insn_time[INSN_NOP] += (10LL * TIMER_USEC);
 	if (insn_processed < 100)
 		goto again;
 	else
 		return;
     }
-    addr = read_dword(dev, dev->dsp + 4);
+    addr = ci.addr;
     DEBUG("SCRIPTS dsp=%08x opcode %08x arg %08x\n", dev->dsp, insn, addr);
     dev->dsps = addr;
     dev->dcmd = insn >> 24;
@@ -1059,6 +1159,8 @@ again:
 				dev->ctest5 = (dev->ctest5 & 0xfc) | ((dev->dbc >> 8) & 3);
 
 				dev->timer_period += (40LL * TIMER_USEC);
+				dev->insn_count[type]++;
+				dev->insn_time[type] += (dev->timer_period - start);
 
 				if (dev->dcntl & NCR_DCNTL_SSM)
 					ncr53c810_script_dma_interrupt(dev, NCR_DSTAT_SSI);
@@ -1333,6 +1435,8 @@ again:
     }
 
     dev->timer_period += (40LL * TIMER_USEC);
+    dev->insn_count[type]++;
+    dev->insn_time[type] += (dev->timer_period - start);
 
     DEBUG("instructions processed %i\n", insn_processed);
     if (insn_processed > 10000 && !dev->waiting) {
@@ -1352,7 +1456,14 @@ again:
 		ncr53c810_script_dma_interrupt(dev, NCR_DSTAT_SSI);
 	} else {
 		DEBUG("NCR 810: SCRIPTS: Normal mode\n");
-		if (insn_processed < 100)
+
+		/*
+		 * Keep going for up to 100 instructions, as before,
+		 * but stop early once a long data move has used up
+		 * this tick's time budget.
+		 */
+		if ((insn_processed < 100) &&
+		    (dev->timer_period < NCR_SCRIPT_BUDGET))
 			goto again;
 	}
     } else {
@@ -2255,6 +2366,8 @@ ncr53c810_close(priv_t priv)
     ncr53c810_t *dev = (ncr53c810_t *)priv;
 
     if (dev) {
+	ncr53c810_dump_stats(dev);
+
 	free(dev);
 	dev = NULL;
     }
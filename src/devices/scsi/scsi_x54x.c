@@ -12,7 +12,7 @@
  *
  *		These controllers were designed for various buses.
  *
- * Version:	@(#)scsi_x54x.c	1.0.21	2021/04/28
+ * Version:	@(#)scsi_x54x.c	1.0.22	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -863,6 +863,92 @@ buf_dma_transfer(x54x_t *dev, Req_t *req, int Is24bit, int TransferLength, int d
 }
 
 
+/*
+ * Build a guest-memory segment list for a block transfer, so that
+ * the target can move the data to or from guest RAM directly rather
+ * than through cmd_buffer. This only works if the direction is the
+ * one the CCB allows, and every segment is plain RAM; otherwise, we
+ * return 0 and the caller falls back to the bounce buffer.
+ */
+static int
+sg_setup(x54x_t *dev, Req_t *req, int Is24bit, int dir)
+{
+    uint32_t DataPointer, DataLength;
+    uint32_t SGEntryLength = (Is24bit ? sizeof(SGE) : sizeof(SGE32));
+    uint8_t ctrl = req->CmdBlock.common.ControlByte;
+    uint32_t BufLen, i;
+    scsi_device_t *sd;
+    scsi_sg_t *sg;
+    SGE32 SGBuffer;
+    int n = 0;
+
+    sd = &scsi_devices[req->TargetID][req->LUN];
+    BufLen = sd->buffer_length;
+
+    if (dir && (ctrl != CCB_DATA_XFER_OUT) && (ctrl != 0x00))
+	return(0);
+    if (!dir && (ctrl != CCB_DATA_XFER_IN) && (ctrl != 0x00))
+	return(0);
+
+    if (Is24bit) {
+	DataPointer = ADDR_TO_U32(req->CmdBlock.old_fmt.DataPointer);
+	DataLength = ADDR_TO_U32(req->CmdBlock.old_fmt.DataLength);
+    } else {
+	DataPointer = req->CmdBlock.new_fmt.DataPointer;
+	DataLength = req->CmdBlock.new_fmt.DataLength;
+    }
+    if ((DataLength == 0) || (BufLen == 0))
+	return(0);
+
+    if ((req->CmdBlock.common.Opcode == SCATTER_GATHER_COMMAND) ||
+	(req->CmdBlock.common.Opcode == SCATTER_GATHER_COMMAND_RES)) {
+	sg = (scsi_sg_t *)mem_alloc((DataLength / SGEntryLength + 1) * sizeof(scsi_sg_t));
+
+	for (i = 0; (i < DataLength) && (BufLen > 0); i += SGEntryLength) {
+		read_sge(dev, Is24bit, DataPointer + i, &SGBuffer);
+		if (SGBuffer.Segment == 0)
+			continue;
+
+		sg[n].addr = SGBuffer.SegmentPointer;
+		sg[n].len = MIN(SGBuffer.Segment, BufLen);
+		BufLen -= sg[n++].len;
+	}
+    } else if ((req->CmdBlock.common.Opcode == SCSI_INITIATOR_COMMAND) ||
+	       (req->CmdBlock.common.Opcode == SCSI_INITIATOR_COMMAND_RES)) {
+	sg = (scsi_sg_t *)mem_alloc(sizeof(scsi_sg_t));
+
+	sg[n].addr = DataPointer;
+	sg[n].len = MIN(DataLength, BufLen);
+	BufLen -= sg[n++].len;
+    } else
+	return(0);
+
+    /* The list must cover the whole transfer, and be all RAM. */
+    if ((BufLen > 0) || !scsi_device_sg_ram(sg, n)) {
+	free(sg);
+	return(0);
+    }
+
+    DEBUG("Direct %s: %i segment(s)\n", dir ? "write" : "read", n);
+
+    sd->sg = sg;
+    sd->sg_count = n;
+
+    return(1);
+}
+
+
+static void
+sg_free(scsi_device_t *sd)
+{
+    if (sd->sg != NULL) {
+	free(sd->sg);
+	sd->sg = NULL;
+    }
+    sd->sg_count = 0;
+}
+
+
 void
 x54x_buf_alloc(scsi_device_t *sd, int length)
 {
@@ -1014,12 +1100,19 @@ scsi_cmd(x54x_t *dev)
 			add_to_period(dev, *BufLen);
 		else
 			dev->media_period += p;
-	    	x54x_buf_alloc(sd, MIN(target_data_len, *BufLen));
-		if (phase == SCSI_PHASE_DATA_OUT)
-			buf_dma_transfer(dev, req, bit24, target_data_len, 1);
-		scsi_device_command_phase1(sd);
-		if (phase == SCSI_PHASE_DATA_IN)
-			buf_dma_transfer(dev, req, bit24, target_data_len, 0);
+		if (sd->sg_direct && (req->CmdBlock.common.ControlByte < 0x03) &&
+		    sg_setup(dev, req, bit24, (phase == SCSI_PHASE_DATA_OUT))) {
+			/* Target moves the data to/from guest RAM itself. */
+			scsi_device_command_phase1(sd);
+			sg_free(sd);
+		} else {
+		    	x54x_buf_alloc(sd, MIN(target_data_len, *BufLen));
+			if (phase == SCSI_PHASE_DATA_OUT)
+				buf_dma_transfer(dev, req, bit24, target_data_len, 1);
+			scsi_device_command_phase1(sd);
+			if (phase == SCSI_PHASE_DATA_IN)
+				buf_dma_transfer(dev, req, bit24, target_data_len, 0);
+		}
 
 		SenseBufferFree(dev, req, (sd->status != SCSI_STATUS_OK));
 	}
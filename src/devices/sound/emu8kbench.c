@@ -0,0 +1,288 @@
+/*
+ * VARCem	Virtual ARchaeological Computer EMulator.
+ *		An emulator of (mostly) x86-based PC systems and devices,
+ *		using the ISA,EISA,VLB,MCA  and PCI system buses, roughly
+ *		spanning the era between 1981 and 1995.
+ *
+ *		This file is part of the VARCem Project.
+ *
+ *		Standalone check and benchmark of the Emu8K voice renderer.
+ *
+ *		Random voices are rendered with the plain C path and with
+ *		each vector path the processor has, for random chunks of
+ *		random controls. The output and the voice states must come
+ *		out bit for bit the same; then each path is timed with all
+ *		32 voices playing and filtering.
+ *
+ *		Usage:	emu8kbench [-r rounds] [-s seed] [-t seconds]
+ *
+ *		It can be built on its own on UNIX systems with:
+ *		  cc -O2 -o emu8kbench emu8kbench.c snd_emu8k_render.c -lm
+ *
+ * Version:	@(#)emu8kbench.c	1.0.1	2026/10/19
+ *
+ * Author:	agent, <agent@local>
+ *
+ *		Copyright 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free  Software  Foundation; either  version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is  distributed in the hope that it will be useful, but
+ * WITHOUT   ANY  WARRANTY;  without  even   the  implied  warranty  of
+ * MERCHANTABILITY  or FITNESS  FOR A PARTICULAR  PURPOSE. See  the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the:
+ *
+ *   Free Software Foundation, Inc.
+ *   59 Temple Place - Suite 330
+ *   Boston, MA 02111-1307
+ *   USA.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include "snd_emu8k_render.h"
+
+
+#define MEM_BLOCKS	8		// distinct 64K word blocks of samples
+
+
+static const char *names[] = { "C", "SSE4.2", "AVX2" };
+static uint32_t	seed = 1;
+static int16_t	*blocks[MEM_BLOCKS];
+static int16_t	*ram_pointers[0x100];
+
+
+static uint32_t
+rnd(void)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+
+    return(seed);
+}
+
+
+/* Fill the sound memory, with some silent and some loud blocks. */
+static void
+mem_init(void)
+{
+    int c, i;
+
+    for (c = 0; c < MEM_BLOCKS; c++) {
+	blocks[c] = (int16_t *)malloc(0x10000 * sizeof(int16_t));
+	for (i = 0; i < 0x10000; i++) switch (c) {
+		case 0:
+			blocks[c][i] = 0;
+			break;
+
+		case 1:
+			blocks[c][i] = (i & 0x40) ? 32767 : -32768;
+			break;
+
+		default:
+			blocks[c][i] = (int16_t)rnd();
+			break;
+	}
+    }
+
+    for (c = 0; c < 0x100; c++)
+	ram_pointers[c] = blocks[rnd() % MEM_BLOCKS];
+}
+
+
+/* Start a random voice in a lane. */
+static void
+lane_init(emu8k_lanes_t *l, int n, int busy)
+{
+    uint32_t start, end;
+    int c;
+
+    start = rnd() & 0xffffff;
+    end = (start + 1 + (rnd() % (busy ? 0x40000 : 64))) & 0xffffff;
+
+    l->voice[n] = n;
+    l->loop_end[n] = ((uint64_t)end) << 32;
+    l->loop_len[n] = ((uint64_t)(uint32_t)(end - start)) << 32;
+    l->addr[n] = ((((uint64_t)start) << 32) | (rnd() & 0xffff0000)) +
+		 (((uint64_t)(rnd() % 256)) << 32);
+    l->filterq[n] = busy ? 1 + (rnd() % 15) : rnd() % 16;
+    l->filt_att[n] = 65536 >> (rnd() % 4);
+    for (c = 0; c < 5; c++)
+	l->filt[c][n] = 0;
+    l->audible[n] = busy || (rnd() % 8);
+    l->vol_l[n] = rnd() & 0xff;
+    l->vol_r[n] = rnd() & 0xff;
+    l->revb[n] = (rnd() % 3) ? rnd() & 0xff : 0;
+    l->chor[n] = (rnd() % 3) ? rnd() & 0xff : 0;
+}
+
+
+/* Make up the controls of a chunk, as the envelopes would. */
+static void
+lanes_controls(emu8k_lanes_t *l, int len, int busy)
+{
+    int i, n, vol, cut;
+
+    for (n = 0; n < l->count; n++) {
+	vol = (busy || (rnd() % 4)) ? rnd() & 0xffff : 0;
+	cut = (busy || (rnd() % 2)) ? rnd() & 0xffff : 0xffff;
+	for (i = 0; i < len; i++) {
+		l->pitch[i][n] = (uint16_t)((rnd() % 8) ? rnd() & 0x7fff : rnd());
+		if (! busy && (rnd() % 16) == 0)
+			vol = (rnd() % 2) ? rnd() & 0xffff : 0;
+		l->volume[i][n] = (uint16_t)vol;
+		l->cutoff[i][n] = (uint16_t)cut;
+	}
+    }
+
+    emu8k_lanes_pad(l);
+}
+
+
+/* Compare a path to the reference, down to the last bit. */
+static int
+check(int simd, int rounds)
+{
+    static emu8k_lanes_t ref, lanes;
+    static int32_t buf[2][EMU8K_CHUNK * 2];
+    static int32_t rev[2][EMU8K_CHUNK], cho[2][EMU8K_CHUNK];
+    int i, n, len, r;
+
+    for (r = 0; r < rounds; r++) {
+	if ((r % 64) == 0) {
+		memset(&ref, 0x00, sizeof(ref));
+		ref.ram_pointers = ram_pointers;
+		ref.count = 1 + (rnd() % EMU8K_LANES);
+		for (n = 0; n < ref.count; n++)
+			lane_init(&ref, n, 0);
+	}
+
+	len = 1 + (rnd() % EMU8K_CHUNK);
+	lanes_controls(&ref, len, 0);
+	memcpy(&lanes, &ref, sizeof(lanes));
+
+	memset(buf, 0x00, sizeof(buf));
+	memset(rev, 0x00, sizeof(rev));
+	memset(cho, 0x00, sizeof(cho));
+	emu8k_lanes_render(&ref, EMU8K_SIMD_NONE, len, buf[0], rev[0], cho[0]);
+	emu8k_lanes_render(&lanes, simd, len, buf[1], rev[1], cho[1]);
+
+	for (i = 0; i < len; i++) {
+		if (buf[0][i*2] != buf[1][i*2] ||
+		    buf[0][i*2+1] != buf[1][i*2+1] ||
+		    rev[0][i] != rev[1][i] || cho[0][i] != cho[1][i]) {
+			printf("%s: round %d, sample %d differs!\n",
+			       names[simd], r, i);
+			return(0);
+		}
+	}
+
+	for (n = 0; n < ref.count; n++) {
+		if (ref.addr[n] != lanes.addr[n] ||
+		    memcmp(ref.filt[0], lanes.filt[0], sizeof(ref.filt))) {
+			printf("%s: round %d, voice %d state differs!\n",
+			       names[simd], r, n);
+			return(0);
+		}
+	}
+    }
+
+    return(1);
+}
+
+
+/* Time a path, in nanoseconds per voice sample. */
+static double
+bench(int simd, double secs)
+{
+    static emu8k_lanes_t lanes;
+    static int32_t buf[EMU8K_CHUNK * 2], rev[EMU8K_CHUNK], cho[EMU8K_CHUNK];
+    clock_t start, end;
+    long runs = 0;
+    int n, k;
+
+    memset(&lanes, 0x00, sizeof(lanes));
+    lanes.ram_pointers = ram_pointers;
+    lanes.count = EMU8K_LANES;
+    for (n = 0; n < lanes.count; n++)
+	lane_init(&lanes, n, 1);
+    lanes_controls(&lanes, EMU8K_CHUNK, 1);
+
+    start = clock();
+    do {
+	for (k = 0; k < 100; k++)
+		emu8k_lanes_render(&lanes, simd, EMU8K_CHUNK, buf, rev, cho);
+	runs += k;
+	end = clock();
+    } while ((end - start) < (clock_t)(secs * CLOCKS_PER_SEC));
+
+    return((double)(end - start) * 1e9 / CLOCKS_PER_SEC /
+	   ((double)runs * EMU8K_CHUNK * EMU8K_LANES));
+}
+
+
+static void
+usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [-r rounds] [-s seed] [-t seconds]\n", prog);
+
+    exit(1);
+}
+
+
+int
+main(int argc, char **argv)
+{
+    double secs = 1.0;
+    double t, ref = 0.0;
+    int rounds = 20000;
+    int i, simd, top, ret = 0;
+
+    for (i = 1; i < argc; i++) {
+	if (!strcmp(argv[i], "-r") && (i + 1 < argc))
+		rounds = atoi(argv[++i]);
+	else if (!strcmp(argv[i], "-s") && (i + 1 < argc))
+		seed = (uint32_t)strtoul(argv[++i], NULL, 0) | 1;
+	else if (!strcmp(argv[i], "-t") && (i + 1 < argc))
+		secs = atof(argv[++i]);
+	else
+		usage(argv[0]);
+    }
+
+    emu8k_lanes_init();
+    mem_init();
+
+    top = emu8k_lanes_simd();
+    printf("Widest path: %s\n", names[top]);
+
+    for (simd = EMU8K_SIMD_SSE42; simd <= top; simd++) {
+	if (check(simd, rounds)) {
+		printf("%s: %d rounds match the C path.\n",
+		       names[simd], rounds);
+	} else
+		ret = 2;
+    }
+
+    for (simd = EMU8K_SIMD_NONE; simd <= top; simd++) {
+	t = bench(simd, secs);
+	if (simd == EMU8K_SIMD_NONE)
+		ref = t;
+	printf("%-7s %7.2f ns/voice sample, %5.2fx\n",
+	       names[simd], t, ref / t);
+    }
+
+    emu8k_lanes_close();
+    for (i = 0; i < MEM_BLOCKS; i++)
+	free(blocks[i]);
+
+    return(ret);
+}
@@ -8,7 +8,7 @@
  *
  *		MIDI support module, main file.
  *
- * Version:	@(#)midi.c	1.0.14	2021/02/14
+ * Version:	@(#)midi.c	1.0.15	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -231,10 +231,10 @@ midi_close(void)
 
 
 void
-midi_poll(void)
+midi_poll(int len)
 {
     if (midi && midi->device && midi->device->poll)
-	midi->device->poll();
+	midi->device->poll(len);
 }
 
 
@@ -8,7 +8,7 @@
  *
  *		Definitions for the MIDI module.
  *
- * Version:	@(#)midi.h	1.0.7	2020/07/11
+ * Version:	@(#)midi.h	1.0.8	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -52,7 +52,7 @@
 typedef struct {
     void	(*play_sysex)(uint8_t *sysex, unsigned int len);
     void	(*play_msg)(uint8_t *msg);
-    void	(*poll)(void);
+    void	(*poll)(int len);
     int		(*write)(uint8_t val);
 } midi_device_t;
 
@@ -83,7 +83,7 @@ extern void		sound_midi_log(int level, const char *fmt, ...);
 extern void		midi_init(const midi_device_t *device);
 extern void		midi_close(void);
 extern void		midi_write(uint8_t val);
-extern void		midi_poll(void);
+extern void		midi_poll(int len);
 
 #ifdef USE_FLUIDSYNTH
 extern void     	fluidsynth_global_init(void);
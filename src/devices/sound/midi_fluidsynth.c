@@ -17,7 +17,7 @@
  *		website (for 32bit and 64bit Windows) are working, and
  *		need no additional support files other than sound fonts.
  *
- * Version:	@(#)midi_fluidsynth.c	1.0.20	2021/03/16
+ * Version:	@(#)midi_fluidsynth.c	1.0.22	2026/10/19
  *
  *		Code borrowed from scummvm.
  *
@@ -142,6 +142,8 @@ typedef struct fluidsynth {
     float		*buffer;
     int16_t		*buffer_int16;
     int			midi_pos;
+    volatile uint32_t	chunks_req,	/* chunks requested by poll */
+			chunks_done;	/* chunks rendered by thread */
     volatile int	on;
 } fluidsynth_t;
 
@@ -157,15 +159,19 @@ fluidsynth_available(void)
 
 
 static void
-fluidsynth_poll(void)
+fluidsynth_poll(int len)
 {
     fluidsynth_t *data = &fsdev;
 
-    data->midi_pos++;
-    if (data->midi_pos == 48000/RENDER_RATE) {
-	data->midi_pos = 0;
-	thread_set_event(data->event);
+    data->midi_pos += len;
+    if (data->midi_pos < 48000/RENDER_RATE)
+	return;
+
+    while (data->midi_pos >= 48000/RENDER_RATE) {
+	data->midi_pos -= 48000/RENDER_RATE;
+	data->chunks_req++;
     }
+    thread_set_event(data->event);
 }
 
 
@@ -182,25 +188,30 @@ fluidsynth_thread(void *param)
 	thread_wait_event(data->event, -1);
 	thread_reset_event(data->event);
 
-	if (config.sound_is_float) {
-		float *buf = (float*)((uint8_t*)data->buffer + buf_pos);
-		memset(buf, 0, buf_size);
-		if (data->synth)
-			f_fluid_synth_write_float(data->synth, buf_size/(2 * sizeof(float)), buf, 0, 2, buf, 1, 2);
-		buf_pos += buf_size;
-		if (buf_pos >= data->buf_size) {
-			openal_buffer_midi(data->buffer, data->buf_size / sizeof(float));
-			buf_pos = 0;
-		}
-	} else {
-		int16_t *buf = (int16_t*)((uint8_t*)data->buffer_int16 + buf_pos);
-		memset(buf, 0, buf_size);
-		if (data->synth)
-			f_fluid_synth_write_s16(data->synth, buf_size/(2 * sizeof(int16_t)), buf, 0, 2, buf, 1, 2);
-		buf_pos += buf_size;
-		if (buf_pos >= data->buf_size) {
-			openal_buffer_midi(data->buffer_int16, data->buf_size / sizeof(int16_t));
-			buf_pos = 0;
+	/* Render as many chunks as were asked for since last time. */
+	while (data->on && (data->chunks_done != data->chunks_req)) {
+		data->chunks_done++;
+
+		if (config.sound_is_float) {
+			float *buf = (float*)((uint8_t*)data->buffer + buf_pos);
+			memset(buf, 0, buf_size);
+			if (data->synth)
+				f_fluid_synth_write_float(data->synth, buf_size/(2 * sizeof(float)), buf, 0, 2, buf, 1, 2);
+			buf_pos += buf_size;
+			if (buf_pos >= data->buf_size) {
+				sound_sink_buffer(SOUND_STREAM_MIDI, data->buffer, data->buf_size / sizeof(float));
+				buf_pos = 0;
+			}
+		} else {
+			int16_t *buf = (int16_t*)((uint8_t*)data->buffer_int16 + buf_pos);
+			memset(buf, 0, buf_size);
+			if (data->synth)
+				f_fluid_synth_write_s16(data->synth, buf_size/(2 * sizeof(int16_t)), buf, 0, 2, buf, 1, 2);
+			buf_pos += buf_size;
+			if (buf_pos >= data->buf_size) {
+				sound_sink_buffer(SOUND_STREAM_MIDI, data->buffer_int16, data->buf_size / sizeof(int16_t));
+				buf_pos = 0;
+			}
 		}
 	}
     }
@@ -352,6 +363,7 @@ fluidsynth_init(const device_t *info, UNUSED(void *parent))
 
     midi_init(dev);
 
+    data->chunks_done = data->chunks_req;
     data->on = 1;
 
     data->start_event = thread_create_event();
@@ -8,7 +8,7 @@
  *
  *		Interface to the MuNT32 MIDI synthesizer.
  *
- * Version:	@(#)midi_mt32.c	1.0.15	2021/03/16
+ * Version:	@(#)midi_mt32.c	1.0.17	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -169,6 +169,8 @@ static int		buf_size = 0;
 static float		*buffer = NULL;
 static int16_t		*buffer_int16 = NULL;
 static int		midi_pos = 0;
+static volatile uint32_t chunks_req = 0,	/* chunks requested by poll */
+			chunks_done = 0;	/* chunks rendered by thread */
 static const mt32emu_report_handler_i handler = { &handler_v0 };
 static mt32emu_context	context = NULL;
 static int		mtroms_present[2] = {-1, -1};
@@ -203,13 +205,17 @@ mt32_stream_int16(int16_t *stream, int len)
 
 
 static void
-mt32_poll(void)
+mt32_poll(int len)
 {
-    midi_pos++;
-    if (midi_pos == (48000 / RENDER_RATE)) {
-	midi_pos = 0;
-	thread_set_event(event);
+    midi_pos += len;
+    if (midi_pos < (48000 / RENDER_RATE))
+	return;
+
+    while (midi_pos >= (48000 / RENDER_RATE)) {
+	midi_pos -= (48000 / RENDER_RATE);
+	chunks_req++;
     }
+    thread_set_event(event);
 }
 
 
@@ -226,25 +232,30 @@ mt32_thread(void *param)
 	thread_wait_event(event, -1);
 	thread_reset_event(event);
 
-	if (config.sound_is_float) {
-		buf = (float *) ((uint8_t*)buffer + buf_pos);
-
-		memset(buf, 0, bsize);
-		mt32_stream(buf, bsize / (2 * sizeof(float)));
-		buf_pos += bsize;
-		if (buf_pos >= buf_size) {
-			openal_buffer_midi(buffer, buf_size / sizeof(float));
-			buf_pos = 0;
-		}
-	} else {
-		buf16 = (int16_t *) ((uint8_t*)buffer_int16 + buf_pos);
-
-		memset(buf16, 0, bsize);
-		mt32_stream_int16(buf16, bsize / (2 * sizeof(int16_t)));
-		buf_pos += bsize;
-		if (buf_pos >= buf_size) {
-			openal_buffer_midi(buffer_int16, buf_size / sizeof(int16_t));
-			buf_pos = 0;
+	/* Render as many chunks as were asked for since last time. */
+	while (mt32_on && (chunks_done != chunks_req)) {
+		chunks_done++;
+
+		if (config.sound_is_float) {
+			buf = (float *) ((uint8_t*)buffer + buf_pos);
+
+			memset(buf, 0, bsize);
+			mt32_stream(buf, bsize / (2 * sizeof(float)));
+			buf_pos += bsize;
+			if (buf_pos >= buf_size) {
+				sound_sink_buffer(SOUND_STREAM_MIDI, buffer, buf_size / sizeof(float));
+				buf_pos = 0;
+			}
+		} else {
+			buf16 = (int16_t *) ((uint8_t*)buffer_int16 + buf_pos);
+
+			memset(buf16, 0, bsize);
+			mt32_stream_int16(buf16, bsize / (2 * sizeof(int16_t)));
+			buf_pos += bsize;
+			if (buf_pos >= buf_size) {
+				sound_sink_buffer(SOUND_STREAM_MIDI, buffer_int16, buf_size / sizeof(int16_t));
+				buf_pos = 0;
+			}
 		}
 	}
     }
@@ -328,6 +339,7 @@ mt32emu_init(wchar_t *control_rom, wchar_t *pcm_rom)
 
     midi_init(dev);
 
+    chunks_done = chunks_req;
     mt32_on = 1;
 
     start_event = thread_create_event();
@@ -8,7 +8,7 @@
  *
  *		Interface to the OpenAL sound processing library.
  *
- * Version:	@(#)openal.c	1.0.22	2021/03/19
+ * Version:	@(#)openal.c	1.0.23	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -72,9 +72,8 @@
 
 #ifdef USE_OPENAL
 static ALuint		buffers[4],		/* front and back buffers */
-			buffers_cd[4],		/* front and back buffers */
 			buffers_midi[4],	/* front and back buffers */
-			source[3];		/* audio source */
+			source[2];		/* audio source */
 static int		nbuffers,
 			nsources;
 static void		*openal_handle = NULL;	/* handle to (open) DLL */
@@ -179,7 +178,6 @@ alutExit(ALvoid)
 	f_alDeleteSources(nsources, source);
 
 	f_alDeleteBuffers(4, buffers);
-	f_alDeleteBuffers(4, buffers_cd);
 	if (nbuffers > 0)
 		f_alDeleteBuffers(nbuffers, buffers_midi);
 
@@ -269,8 +267,8 @@ void
 openal_reset(void)
 {
 #ifdef USE_OPENAL
-    float *buf = NULL, *cd_buf = NULL, *midi_buf = NULL;
-    int16_t *buf_int16 = NULL, *cd_buf_int16 = NULL, *midi_buf_int16 = NULL;
+    float *buf = NULL, *midi_buf = NULL;
+    int16_t *buf_int16 = NULL, *midi_buf_int16 = NULL;
     int c;
 #endif
     int init_midi = 0;
@@ -289,27 +287,24 @@ openal_reset(void)
 #ifdef USE_OPENAL
     if (config.sound_is_float) {
 	buf = (float *)mem_alloc((BUFLEN << 1) * sizeof(float));
-	cd_buf = (float *)mem_alloc((CD_BUFLEN << 1) * sizeof(float));
 	if (init_midi)
 		midi_buf = (float *)mem_alloc(midi_buf_size * sizeof(float));
     } else {
 	buf_int16 = (int16_t *)mem_alloc((BUFLEN << 1) * sizeof(int16_t));
-	cd_buf_int16 = (int16_t *)mem_alloc((CD_BUFLEN << 1) * sizeof(int16_t));
 	if (init_midi)
 		midi_buf_int16 = (int16_t *)mem_alloc(midi_buf_size * sizeof(int16_t));
     }
 
     f_alGenBuffers(4, buffers);
-    f_alGenBuffers(4, buffers_cd);
     if (init_midi) {
 	f_alGenBuffers(4, buffers_midi);
-	f_alGenSources(3, source);
+	f_alGenSources(2, source);
 	nbuffers = 4;
-	nsources = 3;
+	nsources = 2;
     } else {
-	f_alGenSources(2, source);
+	f_alGenSources(1, source);
 	nbuffers = 0;
-	nsources = 2;
+	nsources = 1;
     }
 
     f_alSource3f(source[0], AL_POSITION,        0.0, 0.0, 0.0);
@@ -317,27 +312,20 @@ openal_reset(void)
     f_alSource3f(source[0], AL_DIRECTION,       0.0, 0.0, 0.0);
     f_alSourcef (source[0], AL_ROLLOFF_FACTOR,  0.0          );
     f_alSourcei (source[0], AL_SOURCE_RELATIVE, AL_TRUE      );
-    f_alSource3f(source[1], AL_POSITION,        0.0, 0.0, 0.0);
-    f_alSource3f(source[1], AL_VELOCITY,        0.0, 0.0, 0.0);
-    f_alSource3f(source[1], AL_DIRECTION,       0.0, 0.0, 0.0);
-    f_alSourcef (source[1], AL_ROLLOFF_FACTOR,  0.0          );
-    f_alSourcei (source[1], AL_SOURCE_RELATIVE, AL_TRUE      );
     if (init_midi) {
-	f_alSource3f(source[2], AL_POSITION,        0.0, 0.0, 0.0);
-	f_alSource3f(source[2], AL_VELOCITY,        0.0, 0.0, 0.0);
-	f_alSource3f(source[2], AL_DIRECTION,       0.0, 0.0, 0.0);
-	f_alSourcef (source[2], AL_ROLLOFF_FACTOR,  0.0          );
-	f_alSourcei (source[2], AL_SOURCE_RELATIVE, AL_TRUE      );
+	f_alSource3f(source[1], AL_POSITION,        0.0, 0.0, 0.0);
+	f_alSource3f(source[1], AL_VELOCITY,        0.0, 0.0, 0.0);
+	f_alSource3f(source[1], AL_DIRECTION,       0.0, 0.0, 0.0);
+	f_alSourcef (source[1], AL_ROLLOFF_FACTOR,  0.0          );
+	f_alSourcei (source[1], AL_SOURCE_RELATIVE, AL_TRUE      );
     }
 
     if (config.sound_is_float) {
 	memset(buf,0,BUFLEN*2*sizeof(float));
-	memset(cd_buf,0,BUFLEN*2*sizeof(float));
 	if (init_midi)
 		memset(midi_buf,0,midi_buf_size*sizeof(float));
     } else {
 	memset(buf_int16,0,BUFLEN*2*sizeof(int16_t));
-	memset(cd_buf_int16,0,BUFLEN*2*sizeof(int16_t));
 	if (init_midi)
 		memset(midi_buf_int16,0,midi_buf_size*sizeof(int16_t));
     }
@@ -345,35 +333,29 @@ openal_reset(void)
     for (c=0; c<4; c++) {
 	if (config.sound_is_float) {
 		f_alBufferData(buffers[c], AL_FORMAT_STEREO_FLOAT32, buf, BUFLEN*2*sizeof(float), FREQ);
-		f_alBufferData(buffers_cd[c], AL_FORMAT_STEREO_FLOAT32, cd_buf, CD_BUFLEN*2*sizeof(float), CD_FREQ);
 		if (init_midi)
 			f_alBufferData(buffers_midi[c], AL_FORMAT_STEREO_FLOAT32, midi_buf, midi_buf_size*sizeof(float), midi_freq);
 	} else {
 		f_alBufferData(buffers[c], AL_FORMAT_STEREO16, buf_int16, BUFLEN*2*sizeof(int16_t), FREQ);
-		f_alBufferData(buffers_cd[c], AL_FORMAT_STEREO16, cd_buf_int16, CD_BUFLEN*2*sizeof(int16_t), CD_FREQ);
 		if (init_midi)
 			f_alBufferData(buffers_midi[c], AL_FORMAT_STEREO16, midi_buf_int16, midi_buf_size*sizeof(int16_t), midi_freq);
 	}
     }
 
     f_alSourceQueueBuffers(source[0], 4, buffers);
-    f_alSourceQueueBuffers(source[1], 4, buffers_cd);
     if (init_midi)
-	f_alSourceQueueBuffers(source[2], 4, buffers_midi);
+	f_alSourceQueueBuffers(source[1], 4, buffers_midi);
     f_alSourcePlay(source[0]);
-    f_alSourcePlay(source[1]);
     if (init_midi)
-	f_alSourcePlay(source[2]);
+	f_alSourcePlay(source[1]);
 
     if (config.sound_is_float) {
 	if (init_midi)
 		free(midi_buf);
-	free(cd_buf);
 	free(buf);
     } else {
 	if (init_midi)
 		free(midi_buf_int16);
-	free(cd_buf_int16);
 	free(buf_int16);
     }
 #endif
@@ -423,17 +405,10 @@ openal_buffer(void *buf)
 }
 
 
-void
-openal_buffer_cd(void *buf)
-{
-    openal_buffer_common(buf, 1, CD_BUFLEN << 1, CD_FREQ);
-}
-
-
 void
 openal_buffer_midi(void *buf, uint32_t size)
 {
-    openal_buffer_common(buf, 2, size, midi_freq);
+    openal_buffer_common(buf, 1, size, midi_freq);
 }
 
 
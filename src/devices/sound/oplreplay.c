@@ -0,0 +1,644 @@
+/*
+ * VARCem	Virtual ARchaeological Computer EMulator.
+ *		An emulator of (mostly) x86-based PC systems and devices,
+ *		using the ISA,EISA,VLB,MCA  and PCI system buses, roughly
+ *		spanning the era between 1981 and 1995.
+ *
+ *		This file is part of the VARCem Project.
+ *
+ *		Standalone replay check and benchmark of the Nuked OPL3.
+ *
+ *		A register log (DOSBox DRO version 1 or 2, or an uncompressed
+ *		VGM file) or made-up random register traffic is played twice:
+ *		once a sample at a time through the plain one-slot-at-a-time
+ *		generator, and once in blocks through the batched stream
+ *		generator, as the sound card does it. Both must come out
+ *		bit for bit the same; the time each took is reported.
+ *
+ *		Usage:	oplreplay [-b samples] [-w file.wav] file.dro|file.vgm
+ *			oplreplay [-b samples] [-s seed] -g seconds
+ *
+ *		It can be built on its own on UNIX systems with:
+ *		  cc -O2 -I../.. -o oplreplay oplreplay.c snd_opl_nuked.c
+ *
+ * Version:	@(#)oplreplay.c	1.0.1	2026/10/19
+ *
+ * Author:	agent, <agent@local>
+ *
+ *		Copyright 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free  Software  Foundation; either  version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is  distributed in the hope that it will be useful, but
+ * WITHOUT   ANY  WARRANTY;  without  even   the  implied  warranty  of
+ * MERCHANTABILITY  or FITNESS  FOR A PARTICULAR  PURPOSE. See  the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the:
+ *
+ *   Free Software Foundation, Inc.
+ *   59 Temple Place - Suite 330
+ *   Boston, MA 02111-1307
+ *   USA.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../../emu.h"
+#include "snd_opl_nuked.h"
+
+
+#define FREQ		48000		// output rate, as the sound card uses
+#define HASH_BLOCK	1024		// samples per compared block
+
+
+typedef struct {
+    uint32_t	time;			// output sample the write comes before
+    uint16_t	port;			// 0x220 (low bank) or 0x222 (high bank)
+    uint8_t	reg,
+		val;
+} event_t;
+
+
+static event_t	*events;
+static int	nevents, maxevents;
+static uint32_t	length;			// total output samples
+static int	is_opl3;
+static uint32_t	seed = 1;
+
+
+/* The chip only needs this from the emulator. */
+void *
+mem_alloc(size_t sz)
+{
+    return(malloc(sz));
+}
+
+
+static uint32_t
+rnd(void)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+
+    return(seed);
+}
+
+
+static void
+event_add(uint32_t time, int bank, uint8_t reg, uint8_t val)
+{
+    if (nevents == maxevents) {
+	maxevents = maxevents ? maxevents * 2 : 4096;
+	events = (event_t *)realloc(events, maxevents * sizeof(event_t));
+	if (events == NULL) {
+		fprintf(stderr, "Out of memory!\n");
+		exit(1);
+	}
+    }
+
+    events[nevents].time = time;
+    events[nevents].port = bank ? 0x222 : 0x220;
+    events[nevents].reg = reg;
+    events[nevents].val = val;
+    nevents++;
+}
+
+
+static uint32_t
+get32(const uint8_t *p)
+{
+    return(p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+
+/* Load a DOSBox raw OPL capture, in either of its versions. */
+static int
+load_dro(const uint8_t *p, long size)
+{
+    uint8_t codemap[128];
+    uint8_t sdelay, ldelay, cmlen;
+    uint32_t ms = 0;
+    long pos;
+    int bank = 0;
+    uint8_t code;
+
+    if (get32(p + 8) == 0x00010000) {
+	/* Version 1; early ones have a one byte hardware type field. */
+	is_opl3 = (p[20] != 0);
+	pos = 21;
+	if (size > 24 && !p[21] && !p[22] && !p[23])
+		pos = 24;
+
+	while (pos < size) {
+		code = p[pos++];
+		switch (code) {
+			case 0x00:
+				if (pos >= size)
+					return(0);
+				ms += p[pos++] + 1;
+				break;
+
+			case 0x01:
+				if (pos + 1 >= size)
+					return(0);
+				ms += (p[pos] | (p[pos + 1] << 8)) + 1;
+				pos += 2;
+				break;
+
+			case 0x02:
+			case 0x03:
+				bank = code & 0x01;
+				break;
+
+			case 0x04:
+				if (pos + 1 >= size)
+					return(0);
+				event_add(ms * (FREQ / 1000), bank, p[pos], p[pos + 1]);
+				pos += 2;
+				break;
+
+			default:
+				if (pos >= size)
+					return(0);
+				event_add(ms * (FREQ / 1000), bank, code, p[pos++]);
+				break;
+		}
+	}
+    } else if (get32(p + 8) == 0x00000002) {
+	/* Version 2; register codes through a map, in pairs. */
+	if (size < 26 || p[21] != 0 || p[22] != 0) {
+		fprintf(stderr, "Unsupported DRO format or compression.\n");
+		return(0);
+	}
+	is_opl3 = (p[20] != 0);
+	sdelay = p[23];
+	ldelay = p[24];
+	cmlen = p[25];
+	if (cmlen > 128 || size < 26 + cmlen)
+		return(0);
+	memcpy(codemap, p + 26, cmlen);
+
+	for (pos = 26 + cmlen; pos + 1 < size; pos += 2) {
+		code = p[pos];
+		if (code == sdelay)
+			ms += p[pos + 1] + 1;
+		else if (code == ldelay)
+			ms += (p[pos + 1] + 1) << 8;
+		else if ((code & 0x7f) < cmlen)
+			event_add(ms * (FREQ / 1000), code >> 7,
+				  codemap[code & 0x7f], p[pos + 1]);
+	}
+    } else {
+	fprintf(stderr, "Unknown DRO version.\n");
+	return(0);
+    }
+
+    length = ms * (FREQ / 1000);
+
+    return(1);
+}
+
+
+/* Load the OPL writes of a VGM log, skipping those for other chips. */
+static int
+load_vgm(const uint8_t *p, long size)
+{
+    uint64_t waited = 0;
+    uint32_t time = 0;
+    long pos;
+    uint8_t cmd;
+
+    pos = 0x40;
+    if (get32(p + 8) >= 0x150 && get32(p + 0x34) != 0)
+	pos = 0x34 + get32(p + 0x34);
+    if (size > 0x60 && get32(p + 0x5c) != 0)
+	is_opl3 = 1;
+
+    while (pos < size) {
+	cmd = p[pos];
+	switch (cmd) {
+		case 0x5a:	// YM3812
+		case 0x5b:	// YM3526
+		case 0x5c:	// Y8950
+		case 0x5e:	// YMF262, port 0
+		case 0x5f:	// YMF262, port 1
+			if (pos + 2 >= size)
+				return(0);
+			event_add(time, (cmd == 0x5f), p[pos + 1], p[pos + 2]);
+			pos += 3;
+			break;
+
+		case 0x61:
+			if (pos + 2 >= size)
+				return(0);
+			waited += p[pos + 1] | (p[pos + 2] << 8);
+			pos += 3;
+			break;
+
+		case 0x62:
+			waited += 735;
+			pos++;
+			break;
+
+		case 0x63:
+			waited += 882;
+			pos++;
+			break;
+
+		case 0x66:
+			pos = size;
+			break;
+
+		case 0x67:
+			if (pos + 6 >= size)
+				return(0);
+			pos += 7 + (get32(p + pos + 3) & 0x7fffffff);
+			break;
+
+		case 0x68:
+			pos += 12;
+			break;
+
+		case 0x90:
+		case 0x91:
+		case 0x95:
+			pos += 5;
+			break;
+
+		case 0x92:
+			pos += 6;
+			break;
+
+		case 0x93:
+			pos += 11;
+			break;
+
+		case 0x94:
+			pos += 2;
+			break;
+
+		default:
+			if (cmd >= 0x70 && cmd <= 0x7f)
+				waited += (cmd & 0x0f) + 1;
+			else if (cmd >= 0x80 && cmd <= 0x8f)
+				waited += cmd & 0x0f;
+
+			if (cmd >= 0x30 && cmd <= 0x3f)
+				pos += 2;
+			else if ((cmd >= 0x40 && cmd <= 0x4e) ||
+				 (cmd >= 0x51 && cmd <= 0x5f) ||
+				 (cmd >= 0xa0 && cmd <= 0xbf))
+				pos += 3;
+			else if (cmd == 0x4f || cmd == 0x50)
+				pos += 2;
+			else if (cmd >= 0xc0 && cmd <= 0xdf)
+				pos += 4;
+			else if (cmd >= 0xe0)
+				pos += 5;
+			else
+				pos++;
+			break;
+	}
+
+	/* Log time is in 44.1 kHz samples. */
+	time = (uint32_t)(waited * FREQ / 44100);
+    }
+
+    length = time;
+
+    return(1);
+}
+
+
+static int
+load(const char *fn)
+{
+    uint8_t *p;
+    long size;
+    FILE *fp;
+    int ret = 0;
+
+    if ((fp = fopen(fn, "rb")) == NULL) {
+	fprintf(stderr, "Unable to open '%s'!\n", fn);
+	return(0);
+    }
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    p = (uint8_t *)malloc(size + 1);
+    if (p == NULL || fread(p, 1, size, fp) != (size_t)size) {
+	fprintf(stderr, "Unable to read '%s'!\n", fn);
+	fclose(fp);
+	free(p);
+	return(0);
+    }
+    fclose(fp);
+
+    if (size >= 26 && !memcmp(p, "DBRAWOPL", 8))
+	ret = load_dro(p, size);
+    else if (size >= 0x40 && !memcmp(p, "Vgm ", 4))
+	ret = load_vgm(p, size);
+    else if (size >= 2 && p[0] == 0x1f && p[1] == 0x8b)
+	fprintf(stderr, "Compressed VGM files must be unpacked first.\n");
+    else
+	fprintf(stderr, "'%s' is not a DRO or VGM file.\n", fn);
+
+    free(p);
+
+    return(ret);
+}
+
+
+/* Make up register traffic, with mostly keyed notes and all features. */
+static void
+generate(int secs)
+{
+    static const uint8_t regs[] = { 0x20, 0x40, 0x60, 0x80, 0xe0 };
+    uint32_t time = 0;
+    int bank, n;
+    uint8_t reg, val;
+
+    is_opl3 = 1;
+    length = secs * FREQ;
+
+    event_add(0, 1, 0x05, 0x01);
+    while (time < length) {
+	for (n = rnd() % 8; n > 0; n--) {
+		bank = (rnd() % 3) == 0;
+		val = (uint8_t)rnd();
+		switch (rnd() % 10) {
+			case 0:
+			case 1:
+				reg = regs[rnd() % 5] + (rnd() % 0x16);
+				if ((reg & 0xe0) == 0x60)
+					val |= 0x11;
+				break;
+
+			case 2:
+				reg = 0xa0 + (rnd() % 9);
+				break;
+
+			case 3:
+			case 4:
+				reg = 0xb0 + (rnd() % 9);
+				break;
+
+			case 5:
+				reg = 0xc0 + (rnd() % 9);
+				break;
+
+			case 6:
+				reg = 0xbd;
+				bank = 0;
+				break;
+
+			case 7:
+				reg = 0x04;
+				val &= 0x3f;
+				bank = 1;
+				break;
+
+			case 8:
+				reg = 0x08;
+				bank = 0;
+				break;
+
+			default:
+				reg = (uint8_t)rnd();
+				if (reg == 0x05 && bank)
+					val |= 0x01;
+				break;
+		}
+		event_add(time, bank, reg, val);
+	}
+	time += 1 + (rnd() % ((rnd() % 4) ? 200 : 2000));
+    }
+}
+
+
+static void
+chip_write(priv_t chip, const event_t *ev)
+{
+    uint16_t reg;
+
+    reg = nuked_write_addr(chip, ev->port, ev->reg) & 0x01ff;
+    if (! is_opl3)
+	reg &= 0x00ff;
+
+    nuked_write_reg_buffered(chip, reg, ev->val);
+}
+
+
+static uint32_t
+hash(uint32_t h, const int32_t *buf, int len)
+{
+    int i;
+
+    for (i = 0; i < len * 2; i++)
+	h = (h ^ (uint32_t)buf[i]) * 16777619;
+
+    return(h);
+}
+
+
+static void
+put16(FILE *fp, uint16_t val)
+{
+    fputc(val & 0xff, fp);
+    fputc(val >> 8, fp);
+}
+
+
+static void
+put32(FILE *fp, uint32_t val)
+{
+    put16(fp, val & 0xffff);
+    put16(fp, val >> 16);
+}
+
+
+static void
+wav_header(FILE *fp)
+{
+    fwrite("RIFF", 1, 4, fp);
+    put32(fp, 36 + length * 4);
+    fwrite("WAVEfmt ", 1, 8, fp);
+    put32(fp, 16);
+    put16(fp, 1);
+    put16(fp, 2);
+    put32(fp, FREQ);
+    put32(fp, FREQ * 4);
+    put16(fp, 4);
+    put16(fp, 16);
+    fwrite("data", 1, 4, fp);
+    put32(fp, length * 4);
+}
+
+
+static void
+wav_write(FILE *fp, const int32_t *buf, int len)
+{
+    int32_t val;
+    int i;
+
+    for (i = 0; i < len * 2; i++) {
+	val = buf[i];
+	if (val > 32767)
+		val = 32767;
+	else if (val < -32768)
+		val = -32768;
+	put16(fp, (uint16_t)val);
+    }
+}
+
+
+/*
+ * Play the log, keeping a hash of each block of output samples.
+ *
+ * The writes go in between blocks of at most bsize samples, as they
+ * would between the calls of the sound card poller.
+ */
+static double
+play(int batched, uint32_t *hashes, int bsize, FILE *wav)
+{
+    static int32_t buf[HASH_BLOCK * 2];
+    clock_t start, spent = 0;
+    priv_t chip;
+    uint32_t pos = 0, end, h = 2166136261U;
+    int ev = 0, len, i;
+
+    chip = nuked_init(FREQ);
+
+    while (pos < length) {
+	while (ev < nevents && events[ev].time <= pos)
+		chip_write(chip, &events[ev++]);
+
+	end = (pos / HASH_BLOCK + 1) * HASH_BLOCK;
+	if (end > length)
+		end = length;
+	if (ev < nevents && events[ev].time < end)
+		end = events[ev].time;
+	len = end - pos;
+	if (len > bsize)
+		len = bsize;
+
+	start = clock();
+	if (batched)
+		nuked_generate_stream(chip, buf + (pos % HASH_BLOCK) * 2, len);
+	else for (i = 0; i < len; i++)
+		nuked_generate_resampled(chip, buf + ((pos + i) % HASH_BLOCK) * 2);
+	spent += clock() - start;
+
+	h = hash(h, buf + (pos % HASH_BLOCK) * 2, len);
+	pos += len;
+	if ((pos % HASH_BLOCK) == 0 || pos == length) {
+		hashes[(pos - 1) / HASH_BLOCK] = h;
+		if (wav != NULL)
+			wav_write(wav, buf, ((pos - 1) % HASH_BLOCK) + 1);
+		h = 2166136261U;
+	}
+    }
+
+    nuked_close(chip);
+
+    return((double)spent / CLOCKS_PER_SEC);
+}
+
+
+static void
+usage(const char *prog)
+{
+    fprintf(stderr,
+	"Usage: %s [-b samples] [-w file.wav] file.dro|file.vgm\n"
+	"       %s [-b samples] [-s seed] -g seconds\n", prog, prog);
+
+    exit(1);
+}
+
+
+int
+main(int argc, char **argv)
+{
+    uint32_t *ref, *hashes;
+    const char *fn = NULL, *wfn = NULL;
+    double tref, tbat;
+    FILE *wav = NULL;
+    int bsize = 48000 / 50;		// SOUNDBUFLEN
+    int secs = 0;
+    uint32_t i, blocks;
+
+    for (i = 1; i < (uint32_t)argc; i++) {
+	if (!strcmp(argv[i], "-b") && (i + 1 < (uint32_t)argc))
+		bsize = atoi(argv[++i]);
+	else if (!strcmp(argv[i], "-g") && (i + 1 < (uint32_t)argc))
+		secs = atoi(argv[++i]);
+	else if (!strcmp(argv[i], "-s") && (i + 1 < (uint32_t)argc))
+		seed = (uint32_t)strtoul(argv[++i], NULL, 0) | 1;
+	else if (!strcmp(argv[i], "-w") && (i + 1 < (uint32_t)argc))
+		wfn = argv[++i];
+	else if (argv[i][0] != '-' && fn == NULL)
+		fn = argv[i];
+	else
+		usage(argv[0]);
+    }
+    if ((fn == NULL) == (secs <= 0) || bsize <= 0)
+	usage(argv[0]);
+
+    if (fn != NULL) {
+	if (! load(fn))
+		return(1);
+    } else
+	generate(secs);
+
+    if (length == 0) {
+	fprintf(stderr, "Nothing to play.\n");
+	return(1);
+    }
+    printf("%d writes, %.2f seconds, %s mode.\n",
+	   nevents, (double)length / FREQ, is_opl3 ? "OPL3" : "OPL2");
+
+    if (wfn != NULL) {
+	if ((wav = fopen(wfn, "wb")) == NULL) {
+		fprintf(stderr, "Unable to create '%s'!\n", wfn);
+		return(1);
+	}
+	wav_header(wav);
+    }
+
+    blocks = (length + HASH_BLOCK - 1) / HASH_BLOCK;
+    ref = (uint32_t *)malloc(blocks * sizeof(uint32_t));
+    hashes = (uint32_t *)malloc(blocks * sizeof(uint32_t));
+
+    tref = play(0, ref, bsize, NULL);
+    tbat = play(1, hashes, bsize, wav);
+
+    if (wav != NULL)
+	fclose(wav);
+
+    for (i = 0; i < blocks; i++) {
+	if (ref[i] != hashes[i]) {
+		printf("Output differs from %.3f seconds on!\n",
+		       (double)i * HASH_BLOCK / FREQ);
+		break;
+	}
+    }
+    if (i == blocks)
+	printf("Output matches, bit for bit.\n");
+
+    printf("Single: %.3f s, batched: %.3f s, %.2fx\n",
+	   tref, tbat, (tbat > 0.0) ? tref / tbat : 0.0);
+
+    free(ref);
+    free(hashes);
+    free(events);
+
+    return((i == blocks) ? 0 : 2);
+}
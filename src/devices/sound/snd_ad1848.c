@@ -8,7 +8,7 @@
  *
  *		Emulation of the AD1848 (Windows Sound System) CODEC.
  *
- * Version:	@(#)snd_ad1848.c	1.0.8	2019/05/17
+ * Version:	@(#)snd_ad1848.c	1.0.10	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -141,7 +141,9 @@ void ad1848_speed_changed(ad1848_t *ad1848)
 
 void ad1848_update(ad1848_t *ad1848)
 {
-        for (; ad1848->pos < sound_pos_global; ad1848->pos++)
+        int end = sound_get_pos();
+
+        for (; ad1848->pos < end; ad1848->pos++)
         {
                 ad1848->buffer[ad1848->pos*2]     = ad1848->out_l;
                 ad1848->buffer[ad1848->pos*2 + 1] = ad1848->out_r;
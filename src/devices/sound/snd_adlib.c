@@ -8,7 +8,7 @@
  *
  *		Implementation of the ADLIB sound device.
  *
- * Version:	@(#)snd_adlib.c	1.0.14	2021/03/16
+ * Version:	@(#)snd_adlib.c	1.0.15	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -156,6 +156,8 @@ adlib_close(priv_t priv)
 {
     adlib_t *dev = (adlib_t *)priv;
 
+    opl_close(&dev->opl);
+
     free(dev);
 }
 
@@ -10,7 +10,7 @@
  *
  * TODO:	Stack allocation of big buffers (line 688 et al.)
  *
- * Version:	@(#)snd_adlibgold.c	1.0.19	2021/03/16
+ * Version:	@(#)snd_adlibgold.c	1.0.22	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -560,7 +560,9 @@ uint8_t adgold_read(uint16_t addr, priv_t priv)
 
 void adgold_update(adgold_t *adgold)
 {
-        for (; adgold->pos < sound_pos_global; adgold->pos++)
+        int end = sound_get_pos();
+
+        for (; adgold->pos < end; adgold->pos++)
         {
                 adgold->mma_buffer[0][adgold->pos] = adgold->mma_buffer[1][adgold->pos] = 0;
         
@@ -893,6 +895,8 @@ static void adgold_close(priv_t priv)
                 fclose(f);
         }
 
+        opl_close(&adgold->opl);
+
         free(adgold);
 }
 
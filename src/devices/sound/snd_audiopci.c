@@ -8,7 +8,7 @@
  *
  *		Implementation of the AudioPCI sound device.
  *
- * Version:	@(#)snd_audiopci.c	1.0.23	2021/03/16
+ * Version:	@(#)snd_audiopci.c	1.0.25	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -1129,6 +1129,7 @@ es1371_next_sample_filtered(es1371_t *dev, int dac_nr, int out_idx)
 static void
 es1371_update(es1371_t *dev)
 {
+    int end = sound_get_pos();
     int32_t l, r;
 
     l = (dev->dac[0].out_l * dev->dac[0].vol_l) >> 12;
@@ -1151,7 +1152,7 @@ es1371_update(es1371_t *dev)
     else if (r > 32767)
 	r = 32767;
 
-    for (; dev->pos < sound_pos_global; dev->pos++) {
+    for (; dev->pos < end; dev->pos++) {
 	dev->buffer[dev->pos*2]     = l;
 	dev->buffer[dev->pos*2 + 1] = r;
     }
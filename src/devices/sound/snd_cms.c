@@ -8,7 +8,7 @@
  *
  *		Implementation of the Creative CMS/GameBlaster sound device.
  *
- * Version:	@(#)snd_cms.c	1.0.10	2019/05/13
+ * Version:	@(#)snd_cms.c	1.0.12	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -75,10 +75,11 @@ typedef struct {
 static void
 cms_update(cms_t *dev)
 {
+    int end = sound_get_pos();
     int16_t out_l = 0, out_r = 0;
     int c, d;
 
-    for (; dev->pos < sound_pos_global; dev->pos++) {
+    for (; dev->pos < end; dev->pos++) {
 	for (c = 0; c < 4; c++) {
 		switch (dev->noisetype[c>>1][c&1]) {
 			case 0:
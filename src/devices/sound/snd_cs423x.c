@@ -8,7 +8,7 @@
  *
  *		Implementation of Cirrus Logic Crystal 423x sound devices.
  *
- * Version:	@(#)snd_cs423x.c	1.0.5	2020/01/21
+ * Version:	@(#)snd_cs423x.c	1.0.7	2026/10/19
  *
  * Authors:	Altheos, <altheos@varcem.com>
  *		Fred N. van Kempen, <decwiz@yahoo.com>
@@ -200,7 +200,9 @@ cs423x_write(uint16_t addr, uint8_t val, priv_t priv)
 void
 cs423x_update(cs423x_t *dev)
 {
-    for (; dev->pos < sound_pos_global; dev->pos++) {
+    int end = sound_get_pos();
+
+    for (; dev->pos < end; dev->pos++) {
 	dev->buffer[dev->pos * 2] = dev->out_l;
 	dev->buffer[dev->pos * 2 + 1] = dev->out_r;
     }
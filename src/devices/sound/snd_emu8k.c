@@ -8,7 +8,7 @@
  *
  *		Implementation of Emu8000 emulator.
  *
- * Version:	@(#)snd_emu8k.c	1.0.18	2021/03/16
+ * Version:	@(#)snd_emu8k.c	1.0.24	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -53,20 +53,9 @@
 #include "../../device.h"
 #include "../../plat.h"
 #include "sound.h"
+#include "snd_emu8k_render.h"
 #include "snd_emu8k.h"
 
-
-#if !defined FILTER_INITIAL && !defined FILTER_MOOG && !defined FILTER_CONSTANT
-//#define FILTER_INITIAL
-#define FILTER_MOOG
-//#define FILTER_CONSTANT
-#endif
-
-#if !defined RESAMPLER_LINEAR && !defined RESAMPLER_CUBIC
-//#define RESAMPLER_LINEAR
-#define RESAMPLER_CUBIC
-#endif
-
 //#define EMU8K_DEBUG_REGISTERS
 
 const char *PORT_NAMES[][8] =
@@ -148,11 +137,8 @@ int dmareadbit = 0;
 int dmawritebit = 0;
 
 
-/* cubic and linear tables resolution. Note: higher than 10 does not improve the result. */
-#define CUBIC_RESOLUTION_LOG 10
-#define CUBIC_RESOLUTION (1<<CUBIC_RESOLUTION_LOG)
-/* cubic_table coefficients. */
-static float *cubic_table;
+/* Instruction set the voices are rendered with. */
+static int emu8k_simd;
 
 /* conversion from current pitch to linear frequency change (in 32.32 fixed point). */
 static int64_t *freqtable;
@@ -255,9 +241,6 @@ static const int32_t filter_atten[16] =
         26392, 24630, 22463, 20487, 18470
 };
 
-/*Coefficients for the filters for a defined Q and cutoff.*/
-static int32_t filt_coeffs[16][256][3];
-
 #define READ16_SWITCH(addr, var)       switch ((addr) & 2)                              \
                                 {                                                       \
                                         case 0: ret = (var) & 0xffff;         break;    \
@@ -338,49 +321,6 @@ static inline int16_t EMU8K_READ(emu8k_t *emu8k, uint32_t addr)
         return emu8k->ram_pointers[addrmem.hb_address][addrmem.lw_address];
 }
 
-#if 0	/*NOT_USED*/
-static inline int16_t EMU8K_READ_INTERP_LINEAR(emu8k_t *emu8k, uint32_t int_addr, uint16_t fract)
-{
-        /* The interpolation in AWE32 used a so-called patented 3-point interpolation
-         * ( I guess some sort of spline having one point before and one point after).
-         * Also, it has the consequence that the playback is delayed by one sample.
-         * I simulate the "one sample later" than the address with addr+1 and addr+2 
-         * instead of +0 and +1 */
-        int16_t dat1 = EMU8K_READ(emu8k, int_addr+1);
-        int32_t dat2 = EMU8K_READ(emu8k, int_addr+2);
-        dat1 += ((dat2-(int32_t)dat1)* fract) >> 16;
-        return dat1;
-}
-#endif
-
-static inline int32_t EMU8K_READ_INTERP_CUBIC(emu8k_t *emu8k, uint32_t int_addr, uint16_t fract)
-{
-        /*Since there are four floats in the table for each fraction, the position is 16byte aligned. */
-        fract >>= 16-CUBIC_RESOLUTION_LOG;
-        fract <<=2;
-
-        /* TODO: I still have to verify how this works, but I think that
-         * the card could use two oscillators (usually 31 and 32) where it would
-         * be writing the OPL3 output, and to which, chorus and reverb could be applied to get
-         * those effects for OPL3 sounds.*/
-//        if ((addr & EMU8K_FM_MEM_ADDRESS) == EMU8K_FM_MEM_ADDRESS) {}
-
-        /* This is cubic interpolation.
-         * Not the same than 3-point interpolation, but a better approximation than linear
-         * interpolation.
-         * Also, it takes into account the "Note that the actual audio location is the point
-         * 1 word higher than this value due to interpolation offset".
-         * That's why the pointers are 0, 1, 2, 3 and not -1, 0, 1, 2 */
-        int32_t dat2 = EMU8K_READ(emu8k, int_addr+1);
-        const float *table = &cubic_table[fract];
-        const int32_t dat1 = EMU8K_READ(emu8k, int_addr);
-        const int32_t dat3 = EMU8K_READ(emu8k, int_addr+2);
-        const int32_t dat4 = EMU8K_READ(emu8k, int_addr+3);
-        /* Note: I've ended using float for the table values to avoid some cases of integer overflow. */
-        dat2 = (int32_t) (dat1*table[0] + dat2*table[1] + dat3*table[2] + dat4*table[3]);
-        return dat2;
-}
-
 static inline void EMU8K_WRITE(emu8k_t *emu8k, uint32_t addr, uint16_t val)
 {
         addr &= EMU8K_MEM_ADDRESS_MASK;
@@ -400,6 +340,22 @@ uint16_t emu8k_inw(uint16_t addr, priv_t priv)
 {
         emu8k_t *emu8k = (emu8k_t *)priv;
         uint16_t ret = 0xffff;
+
+        if (emu8k->worker != NULL)
+        {
+                /* The pointer and the sample counter are polled in tight loops, and
+                 * do not depend on the synthesis, so answer those without a sync. */
+                if ((addr & 0xF02) == 0xE02)
+                {
+                        random_helper = (random_helper + 1) & 0x1F;
+                        return ((0x80 | random_helper) << 8) | (emu8k->io_reg << 5) | emu8k->io_voice;
+                }
+                if ((addr & 0xF02) == 0xA02 && emu8k->io_reg == 1 && emu8k->io_voice == 27)
+                        return emu8k->io_wc + (sound_get_pos() * 44100) / 48000;
+
+                /* Everything else sees the state after all writes made so far. */
+                sound_worker_sync(emu8k->worker);
+        }
         
 #ifdef EMU8K_DEBUG_REGISTERS
         if (addr == 0xE22)
@@ -764,14 +720,8 @@ uint16_t emu8k_inw(uint16_t addr, priv_t priv)
         return 0xffff;
 }
 
-void emu8k_outw(uint16_t addr, uint16_t val, priv_t priv)
+static void emu8k_write(emu8k_t *emu8k, uint16_t addr, uint16_t val)
 {
-        emu8k_t *emu8k = (emu8k_t *)priv;
-
-        /*TODO: I would like to not call this here, but i found it was needed or else cubic player would not finish opening (take a looot more of time than usual).
-         * Basically, being here means that the audio is generated in the emulation thread, instead of the audio thread.*/
-        emu8k_update(emu8k);
-
 #ifdef EMU8K_DEBUG_REGISTERS
         if (addr == 0xE22)
         {
@@ -1530,6 +1480,29 @@ void emu8k_outw(uint16_t addr, uint16_t val, priv_t priv)
 
 }
 
+void emu8k_outw(uint16_t addr, uint16_t val, priv_t priv)
+{
+        emu8k_t *emu8k = (emu8k_t *)priv;
+
+        /* With a worker, the write is applied there at the right sample. */
+        if (emu8k->worker != NULL)
+        {
+                if ((addr & 0xF02) == 0xE02)
+                {
+                        emu8k->io_voice = (val & 31);
+                        emu8k->io_reg   = ((val >> 5) & 7);
+                }
+                sound_worker_write(emu8k->worker, addr, val);
+                return;
+        }
+
+        /*TODO: I would like to not call this here, but i found it was needed or else cubic player would not finish opening (take a looot more of time than usual).
+         * Basically, being here means that the audio is generated in the emulation thread, instead of the audio thread.*/
+        emu8k_update(emu8k);
+
+        emu8k_write(emu8k, addr, val);
+}
+
 uint8_t emu8k_inb(uint16_t addr, priv_t priv)
 {
         /* Reading a single byte is a feature that at least Impulse tracker uses,
@@ -1739,348 +1712,295 @@ int32_t emu8k_vol_slide(emu8k_slide_t* slide, int32_t target)
         return slide->last;
 }
 
-//int32_t old_pitch[32]={0};
-//int32_t old_cut[32]={0};
-//int32_t old_vol[32]={0};
-void emu8k_update(emu8k_t *emu8k)
+/* Move the oscillator on by one sample, looping as needed. */
+static inline void emu8k_voice_advance(emu8k_voice_t *emu_voice)
 {
-        int new_pos = (sound_pos_global * 44100) / 48000;
-        if (emu8k->pos >= new_pos)
-                return;
-
-        int32_t *buf;
-        emu8k_voice_t* emu_voice;
-        int pos;
-        int c;
-
-        /* Clean the buffers since we will accumulate into them. */
-        buf = &emu8k->buffer[emu8k->pos*2];
-        memset(buf, 0, 2*(new_pos-emu8k->pos)*sizeof(emu8k->buffer[0]));
-        memset(&emu8k->chorus_in_buffer[emu8k->pos], 0, (new_pos-emu8k->pos)*sizeof(emu8k->chorus_in_buffer[0]));
-        memset(&emu8k->reverb_in_buffer[emu8k->pos], 0, (new_pos-emu8k->pos)*sizeof(emu8k->reverb_in_buffer[0]));
-
-        /* Voices section  */
-        for (c = 0; c < 32; c++)
+        emu_voice->addr.addr += ((uint64_t)emu_voice->cpf_curr_pitch) << 18;
+        if (emu_voice->addr.addr >= emu_voice->loop_end.addr)
         {
-                emu_voice = &emu8k->voice[c];
-                buf = &emu8k->buffer[emu8k->pos*2];
-                
-                for (pos = emu8k->pos; pos < new_pos; pos++)
-                {
-                        int32_t dat;
-
-                        if (emu_voice->cvcf_curr_volume) {
-                                /* Waveform oscillator */
-#ifdef RESAMPLER_LINEAR
-                                dat = EMU8K_READ_INTERP_LINEAR(emu8k, emu_voice->addr.int_address, 
-                                                        emu_voice->addr.fract_address);
-
-#elif defined RESAMPLER_CUBIC
-                                dat = EMU8K_READ_INTERP_CUBIC(emu8k, emu_voice->addr.int_address, 
-                                                        emu_voice->addr.fract_address);
-#endif
-
-                                /* Filter section */
-                                if (emu_voice->filterq_idx || emu_voice->cvcf_curr_filt_ctoff != 0xFFFF ) {
-                                        int cutoff = emu_voice->cvcf_curr_filt_ctoff >> 8;
-                                        const int64_t coef0 = filt_coeffs[emu_voice->filterq_idx][cutoff][0];
-                                        const int64_t coef1 = filt_coeffs[emu_voice->filterq_idx][cutoff][1];
-                                        const int64_t coef2 = filt_coeffs[emu_voice->filterq_idx][cutoff][2];
-                        /* clip at twice the range */
-                        #define ClipBuffer(buf) (buf < -16777216) ? -16777216 : (buf > 16777216) ? 16777216 : buf
-
-                        #ifdef FILTER_INITIAL
-                                        #define NOOP(x) (void)x;
-                                        NOOP(coef1)
-                                        /* Apply expected attenuation. (FILTER_MOOG does it implicitly, but this one doesn't). 
-                                        * Work in 24bits. */
-                                        dat = (dat * emu_voice->filt_att) >> 8;
-                                
-                                        int64_t vhp = ((-emu_voice->filt_buffer[0] * coef2) >> 24) - emu_voice->filt_buffer[1] - dat;
-                                        emu_voice->filt_buffer[1] += (emu_voice->filt_buffer[0] * coef0) >> 24;
-                                        emu_voice->filt_buffer[0] += (vhp * coef0) >> 24;
-                                        dat = (int32_t)(emu_voice->filt_buffer[1] >> 8);
-                                        if (dat > 32767) { dat = 32767; }
-                                        else if (dat < -32768) { dat = -32768; }
-
-                        #elif defined FILTER_MOOG
-
-                                        /*move to 24bits*/
-                                        dat <<= 8;
-                                
-                                        dat -= (int32_t) ((coef2 * emu_voice->filt_buffer[4]) >> 24); /*feedback*/
-                                        int64_t t1 = emu_voice->filt_buffer[1];
-                                        emu_voice->filt_buffer[1] = ((dat + emu_voice->filt_buffer[0]) * coef0 - emu_voice->filt_buffer[1] * coef1) >> 24;
-                                        emu_voice->filt_buffer[1] = ClipBuffer(emu_voice->filt_buffer[1]);
-
-                                        int64_t t2 = emu_voice->filt_buffer[2];
-                                        emu_voice->filt_buffer[2] = ((emu_voice->filt_buffer[1] + t1) * coef0 - emu_voice->filt_buffer[2] * coef1) >> 24;
-                                        emu_voice->filt_buffer[2] = ClipBuffer(emu_voice->filt_buffer[2]);
-
-                                        int64_t t3 = emu_voice->filt_buffer[3];
-                                        emu_voice->filt_buffer[3] = ((emu_voice->filt_buffer[2] + t2) * coef0 - emu_voice->filt_buffer[3] * coef1) >> 24;
-                                        emu_voice->filt_buffer[3] = ClipBuffer(emu_voice->filt_buffer[3]);
+                emu_voice->addr.int_address -= (emu_voice->loop_end.int_address - emu_voice->loop_start.int_address);
+                emu_voice->addr.int_address &= EMU8K_MEM_ADDRESS_MASK;
+        }
+}
 
-                                        emu_voice->filt_buffer[4] = ((emu_voice->filt_buffer[3] + t3) * coef0 - emu_voice->filt_buffer[4] * coef1) >> 24;
-                                        emu_voice->filt_buffer[4] = ClipBuffer(emu_voice->filt_buffer[4]);
+/* A voice is idle when it is silent and will stay so: its envelopes are
+ * not running and the volume has fully slid down to a zero target. */
+static inline int emu8k_voice_idle(const emu8k_voice_t *emu_voice)
+{
+        return !emu_voice->env_engine_on && !emu_voice->cvcf_curr_volume &&
+               !emu_voice->volumeslide.last && !emu_voice->vtft_vol_target;
+}
 
-                                        emu_voice->filt_buffer[0] = ClipBuffer(dat);
+/* Idle voices only move their oscillator and track their targets, so do just that:
+ * one sample at the current pitch, then straight from one loop wrap to the next. */
+static void emu8k_voice_skip(emu8k_voice_t *emu_voice, int count)
+{
+        uint64_t step, k;
 
-                                        dat = (int32_t)(emu_voice->filt_buffer[4] >> 8);
-                                        if (dat > 32767) { dat = 32767; }
-                                        else if (dat < -32768) { dat = -32768; }
+        if (count <= 0)
+                return;
 
-                        #elif defined FILTER_CONSTANT
+        emu8k_voice_advance(emu_voice);
+        emu_voice->cpf_curr_pitch = emu_voice->ptrx_pit_target;
+        emu_voice->cvcf_curr_filt_ctoff = emu_voice->vtft_filter_target;
+        count--;
 
-                                        /* Apply expected attenuation. (FILTER_MOOG does it implicitly, but this one is constant gain). 
-                                        * Also stay at 24bits.*/
-                                        dat = (dat * emu_voice->filt_att) >> 8;
+        step = ((uint64_t)emu_voice->cpf_curr_pitch) << 18;
+        while (count > 0)
+        {
+                /* Samples up to and including the next wrap. */
+                if (emu_voice->addr.addr >= emu_voice->loop_end.addr)
+                        k = 1;
+                else if (step == 0)
+                        break;
+                else
+                        k = (emu_voice->loop_end.addr - emu_voice->addr.addr + step - 1) / step;
 
-                                        emu_voice->filt_buffer[0] = (coef1 * emu_voice->filt_buffer[0]
-                                                + coef0 * (dat + 
-                                                ((coef2 * (emu_voice->filt_buffer[0] - emu_voice->filt_buffer[1]))>>24))
-                                                ) >> 24;
-                                        emu_voice->filt_buffer[1] = (coef1 * emu_voice->filt_buffer[1] 
-                                                + coef0 * emu_voice->filt_buffer[0]) >> 24;
+                if (k > (uint64_t)count)
+                {
+                        emu_voice->addr.addr += count * step;
+                        break;
+                }
+                emu_voice->addr.addr += (k - 1) * step;
+                emu8k_voice_advance(emu_voice);
+                count -= (int)k;
+        }
+}
 
-                                        emu_voice->filt_buffer[0] = ClipBuffer(emu_voice->filt_buffer[0]);
-                                        emu_voice->filt_buffer[1] = ClipBuffer(emu_voice->filt_buffer[1]);
+/* Run the envelopes and LFOs of a voice for one sample, and set its targets from them. */
+static void emu8k_voice_envelope(emu8k_voice_t *emu_voice)
+{
+        int32_t attenuation = emu_voice->initial_att;
+        int32_t filtercut = emu_voice->initial_filter;
+        int32_t currentpitch = emu_voice->ip;
+        /* run envelopes */
+        emu8k_envelope_t *volenv = &emu_voice->vol_envelope;
+        switch (volenv->state)
+        {
+                case ENV_DELAY:
+                volenv->delay_samples--;
+                if (volenv->delay_samples <=0)
+                {
+                        volenv->state=ENV_ATTACK;
+                        volenv->delay_samples=0;
+                }
+                attenuation = 0x1FFFFF;
+                break;
+                
+                case ENV_ATTACK:
+                /* Attack amount is in linear amplitude */
+                volenv->value_amp_hz += volenv->attack_amount_amp_hz;
+                if (volenv->value_amp_hz >= (1 << 21))
+                {
+                        volenv->value_amp_hz = 1 << 21;
+                        volenv->value_db_oct = 0;
+                        if (volenv->hold_samples)
+                        {
+                                volenv->state = ENV_HOLD;
+                        }
+                        else
+                        {
+                                /* RAMP_UP since db value is inverted and it is 0 at this point. */
+                                volenv->state = ENV_RAMP_UP;
+                        }
+                }
+                attenuation += env_vol_amplitude_to_db[volenv->value_amp_hz >> 5] << 5;
+                break;
 
-                                        dat = (int32_t)(emu_voice->filt_buffer[1] >> 8);
-                                        if (dat > 32767) { dat = 32767; }
-                                        else if (dat < -32768) { dat = -32768; }
+                case ENV_HOLD:
+                volenv->hold_samples--;
+                if (volenv->hold_samples <=0)
+                {
+                    volenv->state=ENV_RAMP_UP;
+                }
+                attenuation += volenv->value_db_oct;
+                break;
 
-                        #endif
-                                }
-                        
-                                if (( emu8k->hwcf3 & 0x04) && !CCCA_DMA_ACTIVE(emu_voice->ccca)) {
-                                        /*volume and pan*/
-                                        dat = (dat * emu_voice->cvcf_curr_volume) >> 16;
+                case ENV_RAMP_DOWN:
+                /* Decay/release amount is in fraction of dBs and is always positive */
+                volenv->value_db_oct -= volenv->ramp_amount_db_oct;
+                if (volenv->value_db_oct <= volenv->sustain_value_db_oct)
+                {
+                        volenv->value_db_oct = volenv->sustain_value_db_oct;
+                        volenv->state = ENV_SUSTAIN;
+                }
+                attenuation += volenv->value_db_oct;
+                break;
 
-                                        (*buf++) += (dat * emu_voice->vol_l) >> 8;
-                                        (*buf++) += (dat * emu_voice->vol_r) >> 8;
+                case ENV_RAMP_UP:
+                /* Decay/release amount is in fraction of dBs and is always positive */
+                volenv->value_db_oct += volenv->ramp_amount_db_oct;
+                if (volenv->value_db_oct >= volenv->sustain_value_db_oct)
+                {
+                        volenv->value_db_oct = volenv->sustain_value_db_oct;
+                        volenv->state = ENV_SUSTAIN;
+                }
+                attenuation += volenv->value_db_oct;
+                break;
+                
+                case ENV_SUSTAIN:
+                attenuation += volenv->value_db_oct;
+                break;
+                
+                case ENV_STOPPED:
+                attenuation = 0x1FFFFF;
+                break;
+        }
 
-                                        /* Effects section */
-                                        if (emu_voice->ptrx_revb_send > 0) {
-                                                emu8k->reverb_in_buffer[pos]+=(dat*emu_voice->ptrx_revb_send) >> 8;
-                                        }
-                                        if (emu_voice->csl_chor_send > 0) {
-                                                emu8k->chorus_in_buffer[pos]+=(dat*emu_voice->csl_chor_send) >> 8;
-                                        }
-                                }
+        emu8k_envelope_t *modenv = &emu_voice->mod_envelope;
+        switch (modenv->state)
+        {
+                case ENV_DELAY:
+                modenv->delay_samples--;
+                if (modenv->delay_samples <=0)
+                {
+                        modenv->state=ENV_ATTACK;
+                        modenv->delay_samples=0;
+                }
+                break;
+                
+                case ENV_ATTACK:
+                /* Attack amount is in linear amplitude */
+                modenv->value_amp_hz += modenv->attack_amount_amp_hz;
+                modenv->value_db_oct = env_mod_hertz_to_octave[modenv->value_amp_hz >> 5] << 5;
+                if (modenv->value_amp_hz >= (1 << 21))
+                {
+                        modenv->value_amp_hz = 1 << 21;
+                        modenv->value_db_oct = 1 << 21;
+                        if (modenv->hold_samples)
+                        {
+                                modenv->state = ENV_HOLD;
                         }
-
-                        if ( emu_voice->env_engine_on)
+                        else
                         {
-                                int32_t attenuation = emu_voice->initial_att;
-                                int32_t filtercut = emu_voice->initial_filter;
-                                int32_t currentpitch = emu_voice->ip;
-                                /* run envelopes */
-                                emu8k_envelope_t *volenv = &emu_voice->vol_envelope;
-                                switch (volenv->state)
-                                {
-                                        case ENV_DELAY:
-                                        volenv->delay_samples--;
-                                        if (volenv->delay_samples <=0)
-                                        {
-                                                volenv->state=ENV_ATTACK;
-                                                volenv->delay_samples=0;
-                                        }
-                                        attenuation = 0x1FFFFF;
-                                        break;
-                                        
-                                        case ENV_ATTACK:
-                                        /* Attack amount is in linear amplitude */
-                                        volenv->value_amp_hz += volenv->attack_amount_amp_hz;
-                                        if (volenv->value_amp_hz >= (1 << 21))
-                                        {
-                                                volenv->value_amp_hz = 1 << 21;
-                                                volenv->value_db_oct = 0;
-                                                if (volenv->hold_samples)
-                                                {
-                                                        volenv->state = ENV_HOLD;
-                                                }
-                                                else
-                                                {
-                                                        /* RAMP_UP since db value is inverted and it is 0 at this point. */
-                                                        volenv->state = ENV_RAMP_UP;
-                                                }
-                                        }
-                                        attenuation += env_vol_amplitude_to_db[volenv->value_amp_hz >> 5] << 5;
-                                        break;
-                        
-                                        case ENV_HOLD:
-                                        volenv->hold_samples--;
-                                        if (volenv->hold_samples <=0)
-                                        {
-                                            volenv->state=ENV_RAMP_UP;
-                                        }
-                                        attenuation += volenv->value_db_oct;
-                                        break;
+                                modenv->state = ENV_RAMP_DOWN;
+                        }
+                }
+                break;
 
-                                        case ENV_RAMP_DOWN:
-                                        /* Decay/release amount is in fraction of dBs and is always positive */
-                                        volenv->value_db_oct -= volenv->ramp_amount_db_oct;
-                                        if (volenv->value_db_oct <= volenv->sustain_value_db_oct)
-                                        {
-                                                volenv->value_db_oct = volenv->sustain_value_db_oct;
-                                                volenv->state = ENV_SUSTAIN;
-                                        }
-                                        attenuation += volenv->value_db_oct;
-                                        break;
+                case ENV_HOLD:
+                modenv->hold_samples--;
+                if (modenv->hold_samples <=0)
+                {
+                        modenv->state=ENV_RAMP_UP;
+                }
+                break;
+                
+                case ENV_RAMP_DOWN:
+                /* Decay/release amount is in fraction of octave and is always positive */
+                modenv->value_db_oct -= modenv->ramp_amount_db_oct;
+                if (modenv->value_db_oct <= modenv->sustain_value_db_oct)
+                {
+                        modenv->value_db_oct = modenv->sustain_value_db_oct;
+                        modenv->state = ENV_SUSTAIN;
+                }
+                break;
 
-                                        case ENV_RAMP_UP:
-                                        /* Decay/release amount is in fraction of dBs and is always positive */
-                                        volenv->value_db_oct += volenv->ramp_amount_db_oct;
-                                        if (volenv->value_db_oct >= volenv->sustain_value_db_oct)
-                                        {
-                                                volenv->value_db_oct = volenv->sustain_value_db_oct;
-                                                volenv->state = ENV_SUSTAIN;
-                                        }
-                                        attenuation += volenv->value_db_oct;
-                                        break;
-                                        
-                                        case ENV_SUSTAIN:
-                                        attenuation += volenv->value_db_oct;
-                                        break;
-                                        
-                                        case ENV_STOPPED:
-                                        attenuation = 0x1FFFFF;
-                                        break;
-                                }
+                case ENV_RAMP_UP:
+                /* Decay/release amount is in fraction of octave and is always positive */
+                modenv->value_db_oct += modenv->ramp_amount_db_oct;
+                if (modenv->value_db_oct >= modenv->sustain_value_db_oct)
+                {
+                        modenv->value_db_oct = modenv->sustain_value_db_oct;
+                        modenv->state = ENV_SUSTAIN;
+                }
+                break;
+        }
 
-                                emu8k_envelope_t *modenv = &emu_voice->mod_envelope;
-                                switch (modenv->state)
-                                {
-                                        case ENV_DELAY:
-                                        modenv->delay_samples--;
-                                        if (modenv->delay_samples <=0)
-                                        {
-                                                modenv->state=ENV_ATTACK;
-                                                modenv->delay_samples=0;
-                                        }
-                                        break;
-                                        
-                                        case ENV_ATTACK:
-                                        /* Attack amount is in linear amplitude */
-                                        modenv->value_amp_hz += modenv->attack_amount_amp_hz;
-                                        modenv->value_db_oct = env_mod_hertz_to_octave[modenv->value_amp_hz >> 5] << 5;
-                                        if (modenv->value_amp_hz >= (1 << 21))
-                                        {
-                                                modenv->value_amp_hz = 1 << 21;
-                                                modenv->value_db_oct = 1 << 21;
-                                                if (modenv->hold_samples)
-                                                {
-                                                        modenv->state = ENV_HOLD;
-                                                }
-                                                else
-                                                {
-                                                        modenv->state = ENV_RAMP_DOWN;
-                                                }
-                                        }
-                                        break;
+        /* run lfos */
+        if (emu_voice->lfo1_delay_samples)
+        {
+                emu_voice->lfo1_delay_samples--;
+        }
+        else
+        {
+                emu_voice->lfo1_count.addr += emu_voice->lfo1_speed;
+                emu_voice->lfo1_count.int_address &= 0xFFFF;
+        }
+        if (emu_voice->lfo2_delay_samples)
+        {
+                emu_voice->lfo2_delay_samples--;
+        }
+        else
+        {
+                emu_voice->lfo2_count.addr += emu_voice->lfo2_speed;
+                emu_voice->lfo2_count.int_address &= 0xFFFF;
+        }
 
-                                        case ENV_HOLD:
-                                        modenv->hold_samples--;
-                                        if (modenv->hold_samples <=0)
-                                        {
-                                                modenv->state=ENV_RAMP_UP;
-                                        }
-                                        break;
-                                        
-                                        case ENV_RAMP_DOWN:
-                                        /* Decay/release amount is in fraction of octave and is always positive */
-                                        modenv->value_db_oct -= modenv->ramp_amount_db_oct;
-                                        if (modenv->value_db_oct <= modenv->sustain_value_db_oct)
-                                        {
-                                                modenv->value_db_oct = modenv->sustain_value_db_oct;
-                                                modenv->state = ENV_SUSTAIN;
-                                        }
-                                        break;
 
-                                        case ENV_RAMP_UP:
-                                        /* Decay/release amount is in fraction of octave and is always positive */
-                                        modenv->value_db_oct += modenv->ramp_amount_db_oct;
-                                        if (modenv->value_db_oct >= modenv->sustain_value_db_oct)
-                                        {
-                                                modenv->value_db_oct = modenv->sustain_value_db_oct;
-                                                modenv->state = ENV_SUSTAIN;
-                                        }
-                                        break;
-                                }
+        if (emu_voice->fixed_modenv_pitch_height)
+        {
+                /* modenv range 1<<21, pitch height range 1<<14 desired range 0x1000 (+/-one octave) */
+                currentpitch += ((modenv->value_db_oct>>9)*emu_voice->fixed_modenv_pitch_height) >> 14;
+        }
 
-                                /* run lfos */
-                                if (emu_voice->lfo1_delay_samples)
-                                {
-                                        emu_voice->lfo1_delay_samples--;
-                                }
-                                else
-                                {
-                                        emu_voice->lfo1_count.addr += emu_voice->lfo1_speed;
-                                        emu_voice->lfo1_count.int_address &= 0xFFFF;
-                                }
-                                if (emu_voice->lfo2_delay_samples)
-                                {
-                                        emu_voice->lfo2_delay_samples--;
-                                }
-                                else
-                                {
-                                        emu_voice->lfo2_count.addr += emu_voice->lfo2_speed;
-                                        emu_voice->lfo2_count.int_address &= 0xFFFF;
-                                }
+        if (emu_voice->fixed_lfo1_vibrato)
+        {
+                /* table range 1<<15, pitch mod range 1<<14 desired range 0x1000 (+/-one octave) */
+                int32_t lfo1_vibrato = (lfotable[emu_voice->lfo1_count.int_address]*emu_voice->fixed_lfo1_vibrato) >> 17;
+                currentpitch += lfo1_vibrato;
+        }
+        if (emu_voice->fixed_lfo2_vibrato)
+        {
+                /* table range 1<<15, pitch mod range 1<<14 desired range 0x1000 (+/-one octave) */
+                int32_t lfo2_vibrato = (lfotable[emu_voice->lfo2_count.int_address]*emu_voice->fixed_lfo2_vibrato) >> 17;
+                currentpitch += lfo2_vibrato;
+        }
 
+        if (emu_voice->fixed_modenv_filter_height)
+        {
+                /* modenv range 1<<21, pitch height range 1<<14 desired range 0x200000 (+/-full filter range) */
+                filtercut += ((modenv->value_db_oct>>9)*emu_voice->fixed_modenv_filter_height) >> 5;
+        }
 
-                                if (emu_voice->fixed_modenv_pitch_height)
-                                {
-                                        /* modenv range 1<<21, pitch height range 1<<14 desired range 0x1000 (+/-one octave) */
-                                        currentpitch += ((modenv->value_db_oct>>9)*emu_voice->fixed_modenv_pitch_height) >> 14;
-                                }
+        if (emu_voice->fixed_lfo1_filt_mod)
+        {
+                /* table range 1<<15, pitch mod range 1<<14 desired range 0x100000 (+/-three octaves) */
+                int32_t lfo1_filtmod = (lfotable[emu_voice->lfo1_count.int_address]*emu_voice->fixed_lfo1_filt_mod) >> 9;
+                filtercut += lfo1_filtmod;
+        }
 
-                                if (emu_voice->fixed_lfo1_vibrato)
-                                {
-                                        /* table range 1<<15, pitch mod range 1<<14 desired range 0x1000 (+/-one octave) */
-                                        int32_t lfo1_vibrato = (lfotable[emu_voice->lfo1_count.int_address]*emu_voice->fixed_lfo1_vibrato) >> 17;
-                                        currentpitch += lfo1_vibrato;
-                                }
-                                if (emu_voice->fixed_lfo2_vibrato)
-                                {
-                                        /* table range 1<<15, pitch mod range 1<<14 desired range 0x1000 (+/-one octave) */
-                                        int32_t lfo2_vibrato = (lfotable[emu_voice->lfo2_count.int_address]*emu_voice->fixed_lfo2_vibrato) >> 17;
-                                        currentpitch += lfo2_vibrato;
-                                }
+        if (emu_voice->fixed_lfo1_tremolo)
+        {
+                /* table range 1<<15, pitch mod range 1<<14 desired range 0x40000 (+/-12dBs). */
+                int32_t lfo1_tremolo = (lfotable[emu_voice->lfo1_count.int_address]*emu_voice->fixed_lfo1_tremolo) >> 11;
+                attenuation += lfo1_tremolo;
+        }
 
-                                if (emu_voice->fixed_modenv_filter_height)
-                                {
-                                        /* modenv range 1<<21, pitch height range 1<<14 desired range 0x200000 (+/-full filter range) */
-                                        filtercut += ((modenv->value_db_oct>>9)*emu_voice->fixed_modenv_filter_height) >> 5;
-                                }
+        if (currentpitch > 0xFFFF) currentpitch = 0xFFFF;
+        if (currentpitch < 0) currentpitch = 0;
+        if (attenuation > 0x1FFFFF) attenuation = 0x1FFFFF;
+        if (attenuation < 0) attenuation = 0;
+        if (filtercut > 0x1FFFFF) filtercut = 0x1FFFFF;
+        if (filtercut < 0) filtercut = 0;
 
-                                if (emu_voice->fixed_lfo1_filt_mod)
-                                {
-                                        /* table range 1<<15, pitch mod range 1<<14 desired range 0x100000 (+/-three octaves) */
-                                        int32_t lfo1_filtmod = (lfotable[emu_voice->lfo1_count.int_address]*emu_voice->fixed_lfo1_filt_mod) >> 9;
-                                        filtercut += lfo1_filtmod;
-                                }
+        emu_voice->vtft_vol_target = env_vol_db_to_vol_target[attenuation >> 5];
+        emu_voice->vtft_filter_target = filtercut >> 5;
+        emu_voice->ptrx_pit_target = (int16_t) (freqtable[currentpitch]>>18);
+}
 
-                                if (emu_voice->fixed_lfo1_tremolo)
-                                {
-                                        /* table range 1<<15, pitch mod range 1<<14 desired range 0x40000 (+/-12dBs). */
-                                        int32_t lfo1_tremolo = (lfotable[emu_voice->lfo1_count.int_address]*emu_voice->fixed_lfo1_tremolo) >> 11;
-                                        attenuation += lfo1_tremolo;
-                                }
+/* Run the controls of a voice for a chunk, noting the pitch, volume and
+ * filter cutoff its lane will use for each sample. */
+static void emu8k_voice_control(emu8k_voice_t *emu_voice, emu8k_lanes_t *lanes, int n, int len)
+{
+        int i;
+
+        for (i = 0; i < len; i++)
+        {
+                lanes->pitch[i][n] = emu_voice->cpf_curr_pitch;
+                lanes->volume[i][n] = emu_voice->cvcf_curr_volume;
+                lanes->cutoff[i][n] = emu_voice->cvcf_curr_filt_ctoff;
 
-                                if (currentpitch > 0xFFFF) currentpitch = 0xFFFF;
-                                if (currentpitch < 0) currentpitch = 0;
-                                if (attenuation > 0x1FFFFF) attenuation = 0x1FFFFF;
-                                if (attenuation < 0) attenuation = 0;
-                                if (filtercut > 0x1FFFFF) filtercut = 0x1FFFFF;
-                                if (filtercut < 0) filtercut = 0;
+                if (emu_voice->env_engine_on)
+                        emu8k_voice_envelope(emu_voice);
 
-                                emu_voice->vtft_vol_target = env_vol_db_to_vol_target[attenuation >> 5];
-                                emu_voice->vtft_filter_target = filtercut >> 5;
-                                emu_voice->ptrx_pit_target = (int16_t) (freqtable[currentpitch]>>18);
+                /* TODO: How and when are the target and current values updated */
+                emu_voice->cpf_curr_pitch = emu_voice->ptrx_pit_target;
+                emu_voice->cvcf_curr_volume = emu8k_vol_slide(&emu_voice->volumeslide,emu_voice->vtft_vol_target);
+                emu_voice->cvcf_curr_filt_ctoff = emu_voice->vtft_filter_target;
+        }
+}
 
-                        }
 /*
 I've recopilated these sentences to get an idea of how to loop
 
@@ -2096,38 +2016,102 @@ I've recopilated these sentences to get an idea of how to loop
 -In programs that use the awe, they generally set the loop address as "loopaddress -1" to compensate for the above.
 (Note: I am already using address+1 in the interpolators so these things are already as they should.)
 */
-                        emu_voice->addr.addr += ((uint64_t)emu_voice->cpf_curr_pitch) << 18;
-                        if (emu_voice->addr.addr >= emu_voice->loop_end.addr)
-                        {
-                                emu_voice->addr.int_address -= (emu_voice->loop_end.int_address - emu_voice->loop_start.int_address);
-                                emu_voice->addr.int_address &= EMU8K_MEM_ADDRESS_MASK;
-                        }
 
-                        /* TODO: How and when are the target and current values updated */
-                        emu_voice->cpf_curr_pitch = emu_voice->ptrx_pit_target;
-                        emu_voice->cvcf_curr_volume = emu8k_vol_slide(&emu_voice->volumeslide,emu_voice->vtft_vol_target);
-                        emu_voice->cvcf_curr_filt_ctoff = emu_voice->vtft_filter_target;
+/* Render output into a buffer, from *ppos up to new_pos (in 44.1kHz samples.) */
+static void emu8k_render(emu8k_t *emu8k, int32_t *buffer, int *ppos, int new_pos)
+{
+        int start = *ppos;
+        if (start >= new_pos)
+                return;
+
+        emu8k_lanes_t *lanes = emu8k->lanes;
+        int32_t *buf;
+        emu8k_voice_t* emu_voice;
+        int pos, len;
+        int c, n;
+
+        /* Clean the buffers since we will accumulate into them. */
+        buf = &buffer[start*2];
+        memset(buf, 0, 2*(new_pos-start)*sizeof(buffer[0]));
+        memset(&emu8k->chorus_in_buffer[start], 0, (new_pos-start)*sizeof(emu8k->chorus_in_buffer[0]));
+        memset(&emu8k->reverb_in_buffer[start], 0, (new_pos-start)*sizeof(emu8k->reverb_in_buffer[0]));
+
+        /* Voices section: idle voices just move on, the others each get a lane. */
+        lanes->count = 0;
+        for (c = 0; c < 32; c++)
+        {
+                emu_voice = &emu8k->voice[c];
+                if (emu8k_voice_idle(emu_voice))
+                {
+                        emu8k_voice_skip(emu_voice, new_pos - start);
+                        continue;
                 }
-                
-                /* Update EMU voice registers. */
+
+                n = lanes->count++;
+                lanes->voice[n] = c;
+                lanes->addr[n] = emu_voice->addr.addr;
+                lanes->loop_end[n] = emu_voice->loop_end.addr;
+                lanes->loop_len[n] = ((uint64_t)(emu_voice->loop_end.int_address - emu_voice->loop_start.int_address)) << 32;
+                lanes->filterq[n] = emu_voice->filterq_idx;
+                lanes->filt_att[n] = emu_voice->filt_att;
+                lanes->filt[0][n] = emu_voice->filt_buffer[0];
+                lanes->filt[1][n] = emu_voice->filt_buffer[1];
+                lanes->filt[2][n] = emu_voice->filt_buffer[2];
+                lanes->filt[3][n] = emu_voice->filt_buffer[3];
+                lanes->filt[4][n] = emu_voice->filt_buffer[4];
+                /* Neither of these change while rendering. */
+                lanes->audible[n] = (emu8k->hwcf3 & 0x04) && !CCCA_DMA_ACTIVE(emu_voice->ccca);
+                lanes->vol_l[n] = emu_voice->vol_l;
+                lanes->vol_r[n] = emu_voice->vol_r;
+                lanes->revb[n] = emu_voice->ptrx_revb_send;
+                lanes->chor[n] = emu_voice->csl_chor_send;
+        }
+
+        if (lanes->count)
+        {
+                emu8k_lanes_pad(lanes);
+
+                /* Run the envelopes a chunk ahead, then the audio of all lanes for that chunk. */
+                for (pos = start; pos < new_pos; pos += len)
+                {
+                        len = new_pos - pos;
+                        if (len > EMU8K_CHUNK)
+                                len = EMU8K_CHUNK;
+
+                        for (n = 0; n < lanes->count; n++)
+                                emu8k_voice_control(&emu8k->voice[lanes->voice[n]], lanes, n, len);
+
+                        emu8k_lanes_render(lanes, emu8k_simd, len, &buffer[pos*2],
+                                           &emu8k->reverb_in_buffer[pos], &emu8k->chorus_in_buffer[pos]);
+                }
+
+                for (n = 0; n < lanes->count; n++)
+                {
+                        emu_voice = &emu8k->voice[lanes->voice[n]];
+                        emu_voice->addr.addr = lanes->addr[n];
+                        emu_voice->filt_buffer[0] = lanes->filt[0][n];
+                        emu_voice->filt_buffer[1] = lanes->filt[1][n];
+                        emu_voice->filt_buffer[2] = lanes->filt[2][n];
+                        emu_voice->filt_buffer[3] = lanes->filt[3][n];
+                        emu_voice->filt_buffer[4] = lanes->filt[4][n];
+                }
+        }
+
+        /* Update EMU voice registers. */
+        for (c = 0; c < 32; c++)
+        {
+                emu_voice = &emu8k->voice[c];
                 emu_voice->ccca = (((uint32_t)emu_voice->ccca_qcontrol) << 24) | emu_voice->addr.int_address;
                 emu_voice->cpf_curr_frac_addr = emu_voice->addr.fract_address;
-
-                //if ( emu_voice->cvcf_curr_volume != old_vol[c]) {
-                //    DEBUG("EMUVOL (%d):%d\n", c, emu_voice->cvcf_curr_volume);
-                //    old_vol[c]=emu_voice->cvcf_curr_volume;
-                //}
-                //DEBUG("EMUFILT :%d\n", emu_voice->cvcf_curr_filt_ctoff);
         }
 
-        
-        buf = &emu8k->buffer[emu8k->pos*2];
-        emu8k_work_reverb(&emu8k->reverb_in_buffer[emu8k->pos], buf, &emu8k->reverb_engine, new_pos-emu8k->pos);
-        emu8k_work_chorus(&emu8k->chorus_in_buffer[emu8k->pos], buf, &emu8k->chorus_engine, new_pos-emu8k->pos);
-        emu8k_work_eq(buf, new_pos-emu8k->pos);
+        buf = &buffer[start*2];
+        emu8k_work_reverb(&emu8k->reverb_in_buffer[start], buf, &emu8k->reverb_engine, new_pos-start);
+        emu8k_work_chorus(&emu8k->chorus_in_buffer[start], buf, &emu8k->chorus_engine, new_pos-start);
+        emu8k_work_eq(buf, new_pos-start);
         
         // Clip signal
-        for (pos = emu8k->pos; pos < new_pos; pos++)        
+        for (pos = start; pos < new_pos; pos++)        
         {
                 if (buf[0] < -32768)
                         buf[0] = -32768;
@@ -2143,10 +2127,49 @@ I've recopilated these sentences to get an idea of how to loop
         }
 
         /* Update EMU clock. */
-        emu8k->wc += (new_pos - emu8k->pos);
+        emu8k->wc += (new_pos - start);
         
-        emu8k->pos = new_pos;
+        *ppos = new_pos;
+}
+
+void emu8k_update(emu8k_t *emu8k)
+{
+        if (emu8k->worker != NULL)
+        {
+                /* Collect the block once the mixer asks for it. */
+                if (sound_get_pos() == SOUNDBUFLEN && emu8k->pos == 0)
+                {
+                        sound_worker_block(emu8k->worker, emu8k->buffer);
+                        emu8k->pos = EMU8K_BLOCKLEN;
+                        emu8k->io_wc += EMU8K_BLOCKLEN;
+                }
+                return;
+        }
+
+        emu8k_render(emu8k, emu8k->buffer, &emu8k->pos, (sound_get_pos() * 44100) / 48000);
+}
+static void emu8k_worker_write(priv_t priv, uint16_t reg, uint32_t val)
+{
+        emu8k_write((emu8k_t *)priv, reg, (uint16_t)val);
+}
+
+static void emu8k_worker_render(priv_t priv, int pos)
+{
+        emu8k_t *emu8k = (emu8k_t *)priv;
+
+        emu8k_render(emu8k, emu8k->wbuffer, &emu8k->wpos, (pos * 44100) / 48000);
+}
+
+static void emu8k_worker_block(priv_t priv, int32_t *out)
+{
+        emu8k_t *emu8k = (emu8k_t *)priv;
+
+        emu8k_render(emu8k, emu8k->wbuffer, &emu8k->wpos, EMU8K_BLOCKLEN);
+
+        memcpy(out, emu8k->wbuffer, sizeof(emu8k->wbuffer));
+        emu8k->wpos = 0;
 }
+
 /* onboard_ram in kilobytes */
 void emu8k_init(emu8k_t *emu8k, const wchar_t *romfile, uint16_t emu_addr, int onboard_ram)
 {
@@ -2177,7 +2200,6 @@ void emu8k_init(emu8k_t *emu8k, const wchar_t *romfile, uint16_t emu_addr, int o
 	 * To save on .bss space, we allocate these on the
 	 * heap as needed, and free them on device close.
 	 */
-	cubic_table = (float *)mem_alloc(CUBIC_RESOLUTION*4*sizeof(float));
 	freqtable = (int64_t *)mem_alloc(65536*sizeof(int64_t));
 	attentable = (int32_t *)mem_alloc(256*sizeof(int32_t));
 	env_vol_db_to_vol_target = (int32_t *)mem_alloc(65537*sizeof(int32_t));
@@ -2329,49 +2351,13 @@ void emu8k_init(emu8k_t *emu8k, const wchar_t *romfile, uint16_t emu_addr, int o
         }        
         
         
-        /* Filter coefficients tables. Note: Values are multiplied by *16777216 to left shift 24 bits. (i.e. 8.24 fixed point) */
-        int qidx;
-        for (qidx = 0; qidx < 16; qidx++)
-        {
-                out = 125.0; /* Start at 125Hz */
-                for (c = 0; c < 256; c++)
-                {
-#ifdef FILTER_INITIAL
-                        float w0 = sin(2.0*M_PI*out / 44100.0);
-                        /* The value 102.5f has been selected a bit randomly. Pretends to reach 0.2929 at w0 = 1.0 */
-                        float q = (qidx / 102.5f) * (1.0 + 1.0 / w0);
-                        /* Limit max value. Else it would be 470. */
-                        if (q > 200) q=200;
-                        filt_coeffs[qidx][c][0] = (int32_t)(w0 * 16777216.0);
-                        filt_coeffs[qidx][c][1] = 16777216.0;
-                        filt_coeffs[qidx][c][2] = (int32_t)((1.0f / (0.7071f + q)) * 16777216.0);
-#elif defined FILTER_MOOG 
-                        float w0 = (float) (sin(2.0*M_PI*out / 44100.0));
-                        float q_factor = 1.0f - w0;
-                        float p = w0 + 0.8f * w0 * q_factor;
-                        float f = p + p - 1.0f;
-                        float resonance = (float) ((1.0-pow(2.0,-qidx*24.0/90.0))*0.8);
-                        float q = resonance * (1.0f + 0.5f * q_factor * (w0 + 5.6f * q_factor * q_factor));
-                        filt_coeffs[qidx][c][0] = (int32_t)(p * 16777216.0);
-                        filt_coeffs[qidx][c][1] = (int32_t)(f * 16777216.0);
-                        filt_coeffs[qidx][c][2] = (int32_t)(q * 16777216.0);
-#elif defined FILTER_CONSTANT
-                        float q = (1.0-pow(2.0,-qidx*24.0/90.0))*0.8;
-                        float coef0 = sin(2.0*M_PI*out / 44100.0);
-                        float coef1 = 1.0 - coef0;
-                        float coef2 = q * (1.0 + 1.0 / coef1);
-                        filt_coeffs[qidx][c][0] = (int32_t)(coef0 * 16777216.0); 
-                        filt_coeffs[qidx][c][1] = (int32_t)(coef1 * 16777216.0);
-                        filt_coeffs[qidx][c][2] = (int32_t)(coef2 * 16777216.0);
-#endif //FILTER_TYPE
-                        /* 42.66 divisions per octave (the doc says quarter seminotes which is 48, but then it would be almost an octave less) */
-                        out *= 1.016378315;
-                        /* 42 divisions. This moves the max frequency to 8.5Khz.*/
-                        //out *= 1.0166404394;
-                        /* This is a linear increment method, that corresponds to the NRPN table, but contradicts the EMU8KPRM doc: */
-                        //out = 100.0 + (c+1.0)*31.25; //31.25Hz steps */
-                }
-        }
+        /* The resampler and filter tables. */
+        emu8k_lanes_init();
+        emu8k->lanes = (emu8k_lanes_t *)mem_alloc(sizeof(emu8k_lanes_t));
+        memset(emu8k->lanes, 0, sizeof(emu8k_lanes_t));
+        emu8k->lanes->ram_pointers = emu8k->ram_pointers;
+        emu8k_simd = emu8k_lanes_simd();
+
         /* NOTE! read_pos and buffer content is implicitly initialized to zero by the sb_t structure memset on sb_awe32_init() */
         emu8k->reverb_engine.reflections[0].bufsize=2*REV_BUFSIZE_STEP;
         emu8k->reverb_engine.reflections[1].bufsize=4*REV_BUFSIZE_STEP;
@@ -2391,32 +2377,29 @@ void emu8k_init(emu8k_t *emu8k, const wchar_t *romfile, uint16_t emu_addr, int o
         
 
         
-        /* Cubic Resampling  ( 4point cubic spline) */
-        double const resdouble = 1.0/(double)CUBIC_RESOLUTION;
-        for (c = 0; c < CUBIC_RESOLUTION; c++)
-        {
-                double x = (double)c * resdouble;
-                /* Cubic resolution is made of four table, but I've put them all in one table to optimize memory access. */
-                cubic_table[c*4]   = (float) ((-0.5 * x * x * x +       x * x - 0.5 * x)      );
-                cubic_table[c*4+1] = (float) (( 1.5 * x * x * x - 2.5 * x * x           + 1.0));
-                cubic_table[c*4+2] = (float) ((-1.5 * x * x * x + 2.0 * x * x + 0.5 * x)      );
-                cubic_table[c*4+3] = (float) (( 0.5 * x * x * x - 0.5 * x * x)                );
-        }
         /* Even when the documentation says that this has to be written by applications to initialize the card, 
          * several applications and drivers ( aweman on windows, linux oss driver..) read it to detect an AWE card. */
         emu8k->hwcf1 = 0x59;
         emu8k->hwcf2 = 0x20;
         /* Initial state is muted. 0x04 is unmuted. */
         emu8k->hwcf3 = 0x00;
+
+        /* Move the voice rendering off the emulation thread. */
+        emu8k->worker = sound_worker_init("EMU8000", emu8k, SOUNDBUFLEN * 2,
+                                          emu8k_worker_write, emu8k_worker_render, emu8k_worker_block);
 }
 
 void emu8k_close(emu8k_t *emu8k)
 {
+        sound_worker_close(emu8k->worker);
+        emu8k->worker = NULL;
+
         free(emu8k->rom);
         free(emu8k->ram);
 
 	/* Release the allocated buffers. */
-	free(cubic_table); cubic_table = NULL;
+	emu8k_lanes_close();
+	free(emu8k->lanes); emu8k->lanes = NULL;
 	free(freqtable); freqtable = NULL;
 	free(attentable); attentable = NULL;
 	free(env_vol_db_to_vol_target); env_vol_db_to_vol_target = NULL;
@@ -8,7 +8,7 @@
  *
  *		Definitions for the Emu8K emulator.
  *
- * Version:	@(#)snd_emu8k.h	1.0.3	2019/05/17
+ * Version:	@(#)snd_emu8k.h	1.0.6	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -46,6 +46,7 @@
 #define EMU8K_FM_MEM_ADDRESS 0xFFFFE0
 #define EMU8K_RAM_POINTERS_MASK 0x3F 
 #define EMU8K_LFOCHORUS_SIZE 0x4000
+#define EMU8K_BLOCKLEN ((SOUNDBUFLEN * 44100) / 48000)
 
 /*
  * Everything in this file assumes little endian
@@ -419,6 +420,19 @@ typedef struct emu8k_t
         
         int pos;
         int32_t buffer[SOUNDBUFLEN * 2];
+
+        /* Running voices, laid out side by side for rendering. */
+        struct emu8k_lanes *lanes;
+
+        /* Synthesis worker, and its own output position and buffer. */
+        sndworker_t *worker;
+        int wpos;
+        int32_t wbuffer[SOUNDBUFLEN * 2];
+
+        /* Pointer and sample counter as seen by the emulation, so that
+         * polling them does not have to wait for the worker. */
+        int io_reg, io_voice;
+        uint16_t io_wc;
 } emu8k_t;
 
 
@@ -0,0 +1,857 @@
+/*
+ * VARCem	Virtual ARchaeological Computer EMulator.
+ *		An emulator of (mostly) x86-based PC systems and devices,
+ *		using the ISA,EISA,VLB,MCA  and PCI system buses, roughly
+ *		spanning the era between 1981 and 1995.
+ *
+ *		This file is part of the VARCem Project.
+ *
+ *		Render the audio path of the Emu8K voices.
+ *
+ *		The oscillators, filters and mixing of the running voices
+ *		are kept side by side, one lane per voice, so that they can
+ *		be run 4 (SSE4.2) or 8 (AVX2) voices at a time. The plain C
+ *		path is the reference, and the vector paths give the exact
+ *		same output; emu8kbench.c checks this, and times them.
+ *
+ *		Only the default Moog filter and cubic resampler are done
+ *		in vector form; other builds always use the plain C path.
+ *
+ * Version:	@(#)snd_emu8k_render.c	1.0.1	2026/10/19
+ *
+ * Author:	agent, <agent@local>
+ *
+ *		Copyright 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free  Software  Foundation; either  version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is  distributed in the hope that it will be useful, but
+ * WITHOUT   ANY  WARRANTY;  without  even   the  implied  warranty  of
+ * MERCHANTABILITY  or FITNESS  FOR A PARTICULAR  PURPOSE. See  the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the:
+ *
+ *   Free Software Foundation, Inc.
+ *   59 Temple Place - Suite 330
+ *   Boston, MA 02111-1307
+ *   USA.
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "snd_emu8k_render.h"
+
+#if (defined(__x86_64__) || defined(__i386__) || \
+     defined(_M_X64) || defined(_M_IX86)) && \
+    defined(FILTER_MOOG) && defined(RESAMPLER_CUBIC)
+# define USE_SIMD
+# ifdef _MSC_VER
+#  include <intrin.h>
+#  define TARGET(x)
+# else
+#  define TARGET(x)	__attribute__((target(x)))
+# endif
+# include <immintrin.h>
+#endif
+
+/*
+ * The cubic resampler is done in float, and the vector paths must
+ * round exactly like the plain C path, so never fuse its multiplies
+ * and adds, whatever the -march.
+ */
+#if defined(__clang__)
+# pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+# pragma GCC optimize("fp-contract=off")
+#endif
+
+
+#ifndef M_PI
+# define M_PI		3.14159265358979323846
+#endif
+
+/* clip at twice the range */
+#define ClipBuffer(buf)	(buf < -16777216) ? -16777216 : (buf > 16777216) ? 16777216 : buf
+
+
+/* cubic_table coefficients. */
+static float	*cubic_table;
+
+/* Coefficients for the filters for a defined Q and cutoff. */
+static int32_t	filt_coeffs[16][256][3];
+
+
+static __inline int16_t
+mem_read(const emu8k_lanes_t *l, uint32_t addr)
+{
+    return(l->ram_pointers[(addr >> 16) & 0xff][addr & 0xffff]);
+}
+
+
+#ifdef RESAMPLER_LINEAR
+static __inline int32_t
+read_interp_linear(const emu8k_lanes_t *l, uint32_t int_addr, uint16_t fract)
+{
+    /*
+     * The interpolation in AWE32 used a so-called patented 3-point
+     * interpolation (I guess some sort of spline having one point
+     * before and one point after.) Also, it has the consequence that
+     * the playback is delayed by one sample. I simulate the "one
+     * sample later" than the address with addr+1 and addr+2 instead
+     * of +0 and +1.
+     */
+    int16_t dat1 = mem_read(l, int_addr + 1);
+    int32_t dat2 = mem_read(l, int_addr + 2);
+
+    dat1 += ((dat2 - (int32_t)dat1) * fract) >> 16;
+
+    return(dat1);
+}
+#endif
+
+
+/*
+ * This is cubic interpolation. Not the same than 3-point interpolation,
+ * but a better approximation than linear interpolation. Also, it takes
+ * into account the "Note that the actual audio location is the point
+ * 1 word higher than this value due to interpolation offset". That's
+ * why the pointers are 0, 1, 2, 3 and not -1, 0, 1, 2.
+ */
+static __inline const float *
+read_points(const emu8k_lanes_t *l, uint32_t int_addr, uint16_t fract,
+	    int32_t *dat)
+{
+    const int16_t *ptr;
+
+    if ((int_addr & 0xffff) <= 0xfffc) {
+	/* All four points are in the same block, look it up once. */
+	ptr = &l->ram_pointers[(int_addr >> 16) & 0xff][int_addr & 0xffff];
+	dat[0] = ptr[0];
+	dat[1] = ptr[1];
+	dat[2] = ptr[2];
+	dat[3] = ptr[3];
+    } else {
+	dat[0] = mem_read(l, int_addr);
+	dat[1] = mem_read(l, int_addr + 1);
+	dat[2] = mem_read(l, int_addr + 2);
+	dat[3] = mem_read(l, int_addr + 3);
+    }
+
+    /* There are four floats in the table for each fraction. */
+    return(&cubic_table[(fract >> (16 - CUBIC_RESOLUTION_LOG)) << 2]);
+}
+
+
+static __inline int32_t
+read_interp_cubic(const emu8k_lanes_t *l, uint32_t int_addr, uint16_t fract)
+{
+    const float *table;
+    int32_t dat[4];
+
+    table = read_points(l, int_addr, fract, dat);
+
+    /* Float avoids some cases of integer overflow. */
+    return((int32_t)(dat[0]*table[0] + dat[1]*table[1] +
+		     dat[2]*table[2] + dat[3]*table[3]));
+}
+
+
+/* The reference path, one voice after the other. */
+static void
+render_c(emu8k_lanes_t *l, int len, int32_t *buf, int32_t *reverb,
+	 int32_t *chorus)
+{
+    int64_t coef0, coef1, coef2;
+    int64_t fb[5], t1, t2, t3;
+#ifdef FILTER_INITIAL
+    int64_t vhp;
+#endif
+    uint64_t addr;
+    int32_t dat;
+    int cutoff, vol;
+    int c, i, n;
+
+    for (n = 0; n < l->count; n++) {
+	addr = l->addr[n];
+	for (c = 0; c < 5; c++)
+		fb[c] = l->filt[c][n];
+
+	for (i = 0; i < len; i++) {
+		vol = l->volume[i][n];
+		if (vol != 0) {
+			/* Waveform oscillator. */
+#ifdef RESAMPLER_LINEAR
+			dat = read_interp_linear(l, (uint32_t)(addr >> 32),
+						 (uint16_t)(addr >> 16));
+#elif defined RESAMPLER_CUBIC
+			dat = read_interp_cubic(l, (uint32_t)(addr >> 32),
+						(uint16_t)(addr >> 16));
+#endif
+
+			/* Filter section. */
+			if (l->filterq[n] || l->cutoff[i][n] != 0xffff) {
+				cutoff = l->cutoff[i][n] >> 8;
+				coef0 = filt_coeffs[l->filterq[n]][cutoff][0];
+				coef1 = filt_coeffs[l->filterq[n]][cutoff][1];
+				coef2 = filt_coeffs[l->filterq[n]][cutoff][2];
+
+#ifdef FILTER_INITIAL
+				(void)coef1;
+
+				/*
+				 * Apply expected attenuation. (FILTER_MOOG
+				 * does it implicitly, but this one doesn't.)
+				 * Work in 24bits.
+				 */
+				dat = (dat * l->filt_att[n]) >> 8;
+
+				vhp = ((-fb[0] * coef2) >> 24) - fb[1] - dat;
+				fb[1] += (fb[0] * coef0) >> 24;
+				fb[0] += (vhp * coef0) >> 24;
+				dat = (int32_t)(fb[1] >> 8);
+#elif defined FILTER_MOOG
+				/* Move to 24bits. */
+				dat <<= 8;
+
+				dat -= (int32_t)((coef2 * fb[4]) >> 24); /*feedback*/
+				t1 = fb[1];
+				fb[1] = ((dat + fb[0]) * coef0 - fb[1] * coef1) >> 24;
+				fb[1] = ClipBuffer(fb[1]);
+
+				t2 = fb[2];
+				fb[2] = ((fb[1] + t1) * coef0 - fb[2] * coef1) >> 24;
+				fb[2] = ClipBuffer(fb[2]);
+
+				t3 = fb[3];
+				fb[3] = ((fb[2] + t2) * coef0 - fb[3] * coef1) >> 24;
+				fb[3] = ClipBuffer(fb[3]);
+
+				fb[4] = ((fb[3] + t3) * coef0 - fb[4] * coef1) >> 24;
+				fb[4] = ClipBuffer(fb[4]);
+
+				fb[0] = ClipBuffer(dat);
+
+				dat = (int32_t)(fb[4] >> 8);
+#elif defined FILTER_CONSTANT
+				/*
+				 * Apply expected attenuation. (FILTER_MOOG
+				 * does it implicitly, but this one is constant
+				 * gain.) Also stay at 24bits.
+				 */
+				dat = (dat * l->filt_att[n]) >> 8;
+
+				fb[0] = (coef1 * fb[0] + coef0 * (dat +
+					 ((coef2 * (fb[0] - fb[1])) >> 24))) >> 24;
+				fb[1] = (coef1 * fb[1] + coef0 * fb[0]) >> 24;
+
+				fb[0] = ClipBuffer(fb[0]);
+				fb[1] = ClipBuffer(fb[1]);
+
+				dat = (int32_t)(fb[1] >> 8);
+#endif
+				if (dat > 32767)
+					dat = 32767;
+				else if (dat < -32768)
+					dat = -32768;
+			}
+
+			if (l->audible[n]) {
+				/* Volume and pan. */
+				dat = (dat * vol) >> 16;
+
+				buf[i*2] += (dat * l->vol_l[n]) >> 8;
+				buf[i*2+1] += (dat * l->vol_r[n]) >> 8;
+
+				/* Effects section. */
+				if (l->revb[n] > 0)
+					reverb[i] += (dat * l->revb[n]) >> 8;
+				if (l->chor[n] > 0)
+					chorus[i] += (dat * l->chor[n]) >> 8;
+			}
+		}
+
+		/* Move the oscillator on, looping as needed. */
+		addr += ((uint64_t)l->pitch[i][n]) << 18;
+		if (addr >= l->loop_end[n])
+			addr = (addr - l->loop_len[n]) & EMU8K_LANE_ADDR_MASK;
+	}
+
+	l->addr[n] = addr;
+	for (c = 0; c < 5; c++)
+		l->filt[c][n] = fb[c];
+    }
+}
+
+
+#ifdef USE_SIMD
+/*
+ * Load the four points and the cubic weights of each playing lane of
+ * a group, for the vector paths. Silent lanes read as zero.
+ */
+static __inline void
+lanes_fetch(const emu8k_lanes_t *l, const uint64_t *addr,
+	    const uint16_t *vol, int n, int32_t (*dat)[8], float (*wgt)[8])
+{
+    const float *table;
+    int32_t d[4];
+    int c, k;
+
+    for (k = 0; k < n; k++) {
+	if (vol[k] == 0) {
+		for (c = 0; c < 4; c++) {
+			dat[c][k] = 0;
+			wgt[c][k] = 0.0f;
+		}
+		continue;
+	}
+
+	table = read_points(l, (uint32_t)(addr[k] >> 32),
+			    (uint16_t)(addr[k] >> 16), d);
+	for (c = 0; c < 4; c++) {
+		dat[c][k] = d[c];
+		wgt[c][k] = table[c];
+	}
+    }
+}
+
+
+/* Load the filter coefficients of the filtering lanes of a group. */
+static __inline void
+lanes_coeffs(const emu8k_lanes_t *l, int base, const uint16_t *cut,
+	     int mask, int n, int32_t (*coef)[8])
+{
+    const int32_t *p;
+    int k;
+
+    for (k = 0; k < n; k++) {
+	if (mask & (1 << k)) {
+		p = filt_coeffs[l->filterq[base + k]][cut[k] >> 8];
+		coef[0][k] = p[0];
+		coef[1][k] = p[1];
+		coef[2][k] = p[2];
+	} else {
+		coef[0][k] = coef[1][k] = coef[2][k] = 0;
+	}
+    }
+}
+
+
+/*
+ * The Moog filter state stays within +/- 1 << 24, and every product
+ * of the filter fits in 53 bits, so each stage can be done with
+ * 32x32->64 multiplies, keeping bits 24..55 of the result.
+ */
+TARGET("sse4.2") static __inline __m128i
+mul24_sse(__m128i a, __m128i b)
+{
+    __m128i ev, od;
+
+    ev = _mm_srli_epi64(_mm_mul_epi32(a, b), 24);
+    od = _mm_slli_epi64(_mm_mul_epi32(_mm_srli_epi64(a, 32),
+				      _mm_srli_epi64(b, 32)), 8);
+
+    return(_mm_blend_epi16(ev, od, 0xcc));
+}
+
+
+/* (a * c0 - b * c1) >> 24, as for the stages of the filter. */
+TARGET("sse4.2") static __inline __m128i
+stage_sse(__m128i a, __m128i c0, __m128i b, __m128i c1)
+{
+    __m128i ev, od;
+
+    ev = _mm_sub_epi64(_mm_mul_epi32(a, c0), _mm_mul_epi32(b, c1));
+    od = _mm_sub_epi64(_mm_mul_epi32(_mm_srli_epi64(a, 32),
+				     _mm_srli_epi64(c0, 32)),
+		       _mm_mul_epi32(_mm_srli_epi64(b, 32),
+				     _mm_srli_epi64(c1, 32)));
+    ev = _mm_srli_epi64(ev, 24);
+    od = _mm_slli_epi64(od, 8);
+
+    return(_mm_min_epi32(_mm_max_epi32(_mm_blend_epi16(ev, od, 0xcc),
+				       _mm_set1_epi32(-16777216)),
+			 _mm_set1_epi32(16777216)));
+}
+
+
+/* Render 4 lanes at a time. */
+TARGET("sse4.2") static void
+render_sse42(emu8k_lanes_t *l, int len, int32_t *buf, int32_t *reverb,
+	     int32_t *chorus)
+{
+    int32_t dat[4][8], coef[3][8], fs[5][8];
+    float wgt[4][8];
+    uint64_t addr[8];
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi32(-1);
+    const __m128i sign = _mm_set1_epi64x(INT64_MIN);
+    const __m128i mask = _mm_set1_epi64x(EMU8K_LANE_ADDR_MASK);
+    __m128i a0, a1, le0, le1, ln0, ln1, ge, step;
+    __m128i fq, aud, vl, vr, rv, ch;
+    __m128i f0, f1, f2, f3, f4, n1, n2, n3, n4;
+    __m128i vol, act, cut, fm, x, y, c0, c1, c2;
+    __m128i sl, sr, sv, sc;
+    __m128 s;
+    int b, c, i, k;
+
+    for (b = 0; b < l->count; b += 4) {
+	a0 = _mm_loadu_si128((__m128i *)&l->addr[b]);
+	a1 = _mm_loadu_si128((__m128i *)&l->addr[b + 2]);
+	le0 = _mm_xor_si128(_mm_loadu_si128((__m128i *)&l->loop_end[b]), sign);
+	le1 = _mm_xor_si128(_mm_loadu_si128((__m128i *)&l->loop_end[b + 2]), sign);
+	ln0 = _mm_loadu_si128((__m128i *)&l->loop_len[b]);
+	ln1 = _mm_loadu_si128((__m128i *)&l->loop_len[b + 2]);
+
+	fq = _mm_loadu_si128((__m128i *)&l->filterq[b]);
+	aud = _mm_xor_si128(_mm_cmpeq_epi32(_mm_loadu_si128((__m128i *)&l->audible[b]), zero), ones);
+	vl = _mm_loadu_si128((__m128i *)&l->vol_l[b]);
+	vr = _mm_loadu_si128((__m128i *)&l->vol_r[b]);
+	rv = _mm_loadu_si128((__m128i *)&l->revb[b]);
+	ch = _mm_loadu_si128((__m128i *)&l->chor[b]);
+	fq = _mm_xor_si128(_mm_cmpeq_epi32(fq, zero), ones);
+
+	for (c = 0; c < 5; c++)
+		for (k = 0; k < 4; k++)
+			fs[c][k] = (int32_t)l->filt[c][b + k];
+	f0 = _mm_loadu_si128((__m128i *)fs[0]);
+	f1 = _mm_loadu_si128((__m128i *)fs[1]);
+	f2 = _mm_loadu_si128((__m128i *)fs[2]);
+	f3 = _mm_loadu_si128((__m128i *)fs[3]);
+	f4 = _mm_loadu_si128((__m128i *)fs[4]);
+
+	for (i = 0; i < len; i++) {
+		vol = _mm_cvtepu16_epi32(_mm_loadl_epi64((__m128i *)&l->volume[i][b]));
+		act = _mm_xor_si128(_mm_cmpeq_epi32(vol, zero), ones);
+
+		if (! _mm_testz_si128(act, act)) {
+			_mm_storeu_si128((__m128i *)&addr[0], a0);
+			_mm_storeu_si128((__m128i *)&addr[2], a1);
+			lanes_fetch(l, addr, &l->volume[i][b], 4, dat, wgt);
+
+			/* Waveform oscillator. */
+			s = _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((__m128i *)dat[0])),
+				       _mm_loadu_ps(wgt[0]));
+			s = _mm_add_ps(s, _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((__m128i *)dat[1])),
+						     _mm_loadu_ps(wgt[1])));
+			s = _mm_add_ps(s, _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((__m128i *)dat[2])),
+						     _mm_loadu_ps(wgt[2])));
+			s = _mm_add_ps(s, _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((__m128i *)dat[3])),
+						     _mm_loadu_ps(wgt[3])));
+			x = _mm_cvttps_epi32(s);
+
+			/* Filter section. */
+			cut = _mm_cvtepu16_epi32(_mm_loadl_epi64((__m128i *)&l->cutoff[i][b]));
+			fm = _mm_or_si128(fq, _mm_xor_si128(_mm_cmpeq_epi32(cut, _mm_set1_epi32(0xffff)), ones));
+			fm = _mm_and_si128(fm, act);
+			if (! _mm_testz_si128(fm, fm)) {
+				lanes_coeffs(l, b, &l->cutoff[i][b],
+					     _mm_movemask_ps(_mm_castsi128_ps(fm)), 4, coef);
+				c0 = _mm_loadu_si128((__m128i *)coef[0]);
+				c1 = _mm_loadu_si128((__m128i *)coef[1]);
+				c2 = _mm_loadu_si128((__m128i *)coef[2]);
+
+				y = _mm_sub_epi32(_mm_slli_epi32(x, 8), mul24_sse(c2, f4));
+				n1 = stage_sse(_mm_add_epi32(y, f0), c0, f1, c1);
+				n2 = stage_sse(_mm_add_epi32(n1, f1), c0, f2, c1);
+				n3 = stage_sse(_mm_add_epi32(n2, f2), c0, f3, c1);
+				n4 = stage_sse(_mm_add_epi32(n3, f3), c0, f4, c1);
+				y = _mm_min_epi32(_mm_max_epi32(y, _mm_set1_epi32(-16777216)),
+						  _mm_set1_epi32(16777216));
+
+				f0 = _mm_blendv_epi8(f0, y, fm);
+				f1 = _mm_blendv_epi8(f1, n1, fm);
+				f2 = _mm_blendv_epi8(f2, n2, fm);
+				f3 = _mm_blendv_epi8(f3, n3, fm);
+				f4 = _mm_blendv_epi8(f4, n4, fm);
+
+				y = _mm_min_epi32(_mm_max_epi32(_mm_srai_epi32(n4, 8),
+								_mm_set1_epi32(-32768)),
+						  _mm_set1_epi32(32767));
+				x = _mm_blendv_epi8(x, y, fm);
+			}
+
+			/* Volume, pan and effects sends. */
+			act = _mm_and_si128(act, aud);
+			if (! _mm_testz_si128(act, act)) {
+				x = _mm_srai_epi32(_mm_mullo_epi32(_mm_and_si128(x, act), vol), 16);
+				sl = _mm_srai_epi32(_mm_mullo_epi32(x, vl), 8);
+				sr = _mm_srai_epi32(_mm_mullo_epi32(x, vr), 8);
+				sv = _mm_srai_epi32(_mm_mullo_epi32(x, rv), 8);
+				sc = _mm_srai_epi32(_mm_mullo_epi32(x, ch), 8);
+				x = _mm_hadd_epi32(_mm_hadd_epi32(sl, sr),
+						   _mm_hadd_epi32(sv, sc));
+
+				_mm_storel_epi64((__m128i *)&buf[i*2],
+						 _mm_add_epi32(_mm_loadl_epi64((__m128i *)&buf[i*2]), x));
+				reverb[i] += _mm_extract_epi32(x, 2);
+				chorus[i] += _mm_extract_epi32(x, 3);
+			}
+		}
+
+		/* Move the oscillators on, looping as needed. */
+		y = _mm_loadl_epi64((__m128i *)&l->pitch[i][b]);
+		step = _mm_slli_epi64(_mm_cvtepu16_epi64(y), 18);
+		a0 = _mm_add_epi64(a0, step);
+		ge = _mm_cmpgt_epi64(le0, _mm_xor_si128(a0, sign));
+		a0 = _mm_blendv_epi8(_mm_and_si128(_mm_sub_epi64(a0, ln0), mask), a0, ge);
+		step = _mm_slli_epi64(_mm_cvtepu16_epi64(_mm_srli_si128(y, 4)), 18);
+		a1 = _mm_add_epi64(a1, step);
+		ge = _mm_cmpgt_epi64(le1, _mm_xor_si128(a1, sign));
+		a1 = _mm_blendv_epi8(_mm_and_si128(_mm_sub_epi64(a1, ln1), mask), a1, ge);
+	}
+
+	_mm_storeu_si128((__m128i *)&l->addr[b], a0);
+	_mm_storeu_si128((__m128i *)&l->addr[b + 2], a1);
+	_mm_storeu_si128((__m128i *)fs[0], f0);
+	_mm_storeu_si128((__m128i *)fs[1], f1);
+	_mm_storeu_si128((__m128i *)fs[2], f2);
+	_mm_storeu_si128((__m128i *)fs[3], f3);
+	_mm_storeu_si128((__m128i *)fs[4], f4);
+	for (c = 0; c < 5; c++)
+		for (k = 0; k < 4; k++)
+			l->filt[c][b + k] = fs[c][k];
+    }
+}
+
+
+TARGET("avx2") static __inline __m256i
+mul24_avx2(__m256i a, __m256i b)
+{
+    __m256i ev, od;
+
+    ev = _mm256_srli_epi64(_mm256_mul_epi32(a, b), 24);
+    od = _mm256_slli_epi64(_mm256_mul_epi32(_mm256_srli_epi64(a, 32),
+					    _mm256_srli_epi64(b, 32)), 8);
+
+    return(_mm256_blend_epi32(ev, od, 0xaa));
+}
+
+
+TARGET("avx2") static __inline __m256i
+stage_avx2(__m256i a, __m256i c0, __m256i b, __m256i c1)
+{
+    __m256i ev, od;
+
+    ev = _mm256_sub_epi64(_mm256_mul_epi32(a, c0), _mm256_mul_epi32(b, c1));
+    od = _mm256_sub_epi64(_mm256_mul_epi32(_mm256_srli_epi64(a, 32),
+					   _mm256_srli_epi64(c0, 32)),
+			  _mm256_mul_epi32(_mm256_srli_epi64(b, 32),
+					   _mm256_srli_epi64(c1, 32)));
+    ev = _mm256_srli_epi64(ev, 24);
+    od = _mm256_slli_epi64(od, 8);
+
+    return(_mm256_min_epi32(_mm256_max_epi32(_mm256_blend_epi32(ev, od, 0xaa),
+					     _mm256_set1_epi32(-16777216)),
+			    _mm256_set1_epi32(16777216)));
+}
+
+
+/* Render 8 lanes at a time. */
+TARGET("avx2") static void
+render_avx2(emu8k_lanes_t *l, int len, int32_t *buf, int32_t *reverb,
+	    int32_t *chorus)
+{
+    int32_t dat[4][8], coef[3][8], fs[5][8];
+    float wgt[4][8];
+    uint64_t addr[8];
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi32(-1);
+    const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+    const __m256i mask = _mm256_set1_epi64x(EMU8K_LANE_ADDR_MASK);
+    __m256i a0, a1, le0, le1, ln0, ln1, ge, step;
+    __m256i fq, aud, vl, vr, rv, ch;
+    __m256i f0, f1, f2, f3, f4, n1, n2, n3, n4;
+    __m256i vol, act, cut, fm, x, y, c0, c1, c2;
+    __m256i sl, sr, sv, sc;
+    __m256 s;
+    __m128i h, p;
+    int b, c, i, k;
+
+    for (b = 0; b < l->count; b += 8) {
+	a0 = _mm256_loadu_si256((__m256i *)&l->addr[b]);
+	a1 = _mm256_loadu_si256((__m256i *)&l->addr[b + 4]);
+	le0 = _mm256_xor_si256(_mm256_loadu_si256((__m256i *)&l->loop_end[b]), sign);
+	le1 = _mm256_xor_si256(_mm256_loadu_si256((__m256i *)&l->loop_end[b + 4]), sign);
+	ln0 = _mm256_loadu_si256((__m256i *)&l->loop_len[b]);
+	ln1 = _mm256_loadu_si256((__m256i *)&l->loop_len[b + 4]);
+
+	fq = _mm256_loadu_si256((__m256i *)&l->filterq[b]);
+	aud = _mm256_xor_si256(_mm256_cmpeq_epi32(_mm256_loadu_si256((__m256i *)&l->audible[b]), zero), ones);
+	vl = _mm256_loadu_si256((__m256i *)&l->vol_l[b]);
+	vr = _mm256_loadu_si256((__m256i *)&l->vol_r[b]);
+	rv = _mm256_loadu_si256((__m256i *)&l->revb[b]);
+	ch = _mm256_loadu_si256((__m256i *)&l->chor[b]);
+	fq = _mm256_xor_si256(_mm256_cmpeq_epi32(fq, zero), ones);
+
+	for (c = 0; c < 5; c++)
+		for (k = 0; k < 8; k++)
+			fs[c][k] = (int32_t)l->filt[c][b + k];
+	f0 = _mm256_loadu_si256((__m256i *)fs[0]);
+	f1 = _mm256_loadu_si256((__m256i *)fs[1]);
+	f2 = _mm256_loadu_si256((__m256i *)fs[2]);
+	f3 = _mm256_loadu_si256((__m256i *)fs[3]);
+	f4 = _mm256_loadu_si256((__m256i *)fs[4]);
+
+	for (i = 0; i < len; i++) {
+		vol = _mm256_cvtepu16_epi32(_mm_loadu_si128((__m128i *)&l->volume[i][b]));
+		act = _mm256_xor_si256(_mm256_cmpeq_epi32(vol, zero), ones);
+
+		if (! _mm256_testz_si256(act, act)) {
+			_mm256_storeu_si256((__m256i *)&addr[0], a0);
+			_mm256_storeu_si256((__m256i *)&addr[4], a1);
+			lanes_fetch(l, addr, &l->volume[i][b], 8, dat, wgt);
+
+			/* Waveform oscillator. */
+			s = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_loadu_si256((__m256i *)dat[0])),
+					  _mm256_loadu_ps(wgt[0]));
+			s = _mm256_add_ps(s, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_loadu_si256((__m256i *)dat[1])),
+							   _mm256_loadu_ps(wgt[1])));
+			s = _mm256_add_ps(s, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_loadu_si256((__m256i *)dat[2])),
+							   _mm256_loadu_ps(wgt[2])));
+			s = _mm256_add_ps(s, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_loadu_si256((__m256i *)dat[3])),
+							   _mm256_loadu_ps(wgt[3])));
+			x = _mm256_cvttps_epi32(s);
+
+			/* Filter section. */
+			cut = _mm256_cvtepu16_epi32(_mm_loadu_si128((__m128i *)&l->cutoff[i][b]));
+			fm = _mm256_or_si256(fq, _mm256_xor_si256(_mm256_cmpeq_epi32(cut, _mm256_set1_epi32(0xffff)), ones));
+			fm = _mm256_and_si256(fm, act);
+			if (! _mm256_testz_si256(fm, fm)) {
+				lanes_coeffs(l, b, &l->cutoff[i][b],
+					     _mm256_movemask_ps(_mm256_castsi256_ps(fm)), 8, coef);
+				c0 = _mm256_loadu_si256((__m256i *)coef[0]);
+				c1 = _mm256_loadu_si256((__m256i *)coef[1]);
+				c2 = _mm256_loadu_si256((__m256i *)coef[2]);
+
+				y = _mm256_sub_epi32(_mm256_slli_epi32(x, 8), mul24_avx2(c2, f4));
+				n1 = stage_avx2(_mm256_add_epi32(y, f0), c0, f1, c1);
+				n2 = stage_avx2(_mm256_add_epi32(n1, f1), c0, f2, c1);
+				n3 = stage_avx2(_mm256_add_epi32(n2, f2), c0, f3, c1);
+				n4 = stage_avx2(_mm256_add_epi32(n3, f3), c0, f4, c1);
+				y = _mm256_min_epi32(_mm256_max_epi32(y, _mm256_set1_epi32(-16777216)),
+						     _mm256_set1_epi32(16777216));
+
+				f0 = _mm256_blendv_epi8(f0, y, fm);
+				f1 = _mm256_blendv_epi8(f1, n1, fm);
+				f2 = _mm256_blendv_epi8(f2, n2, fm);
+				f3 = _mm256_blendv_epi8(f3, n3, fm);
+				f4 = _mm256_blendv_epi8(f4, n4, fm);
+
+				y = _mm256_min_epi32(_mm256_max_epi32(_mm256_srai_epi32(n4, 8),
+								      _mm256_set1_epi32(-32768)),
+						     _mm256_set1_epi32(32767));
+				x = _mm256_blendv_epi8(x, y, fm);
+			}
+
+			/* Volume, pan and effects sends. */
+			act = _mm256_and_si256(act, aud);
+			if (! _mm256_testz_si256(act, act)) {
+				x = _mm256_srai_epi32(_mm256_mullo_epi32(_mm256_and_si256(x, act), vol), 16);
+				sl = _mm256_srai_epi32(_mm256_mullo_epi32(x, vl), 8);
+				sr = _mm256_srai_epi32(_mm256_mullo_epi32(x, vr), 8);
+				sv = _mm256_srai_epi32(_mm256_mullo_epi32(x, rv), 8);
+				sc = _mm256_srai_epi32(_mm256_mullo_epi32(x, ch), 8);
+				x = _mm256_hadd_epi32(_mm256_hadd_epi32(sl, sr),
+						      _mm256_hadd_epi32(sv, sc));
+				h = _mm_add_epi32(_mm256_castsi256_si128(x),
+						  _mm256_extracti128_si256(x, 1));
+
+				_mm_storel_epi64((__m128i *)&buf[i*2],
+						 _mm_add_epi32(_mm_loadl_epi64((__m128i *)&buf[i*2]), h));
+				reverb[i] += _mm_extract_epi32(h, 2);
+				chorus[i] += _mm_extract_epi32(h, 3);
+			}
+		}
+
+		/* Move the oscillators on, looping as needed. */
+		p = _mm_loadu_si128((__m128i *)&l->pitch[i][b]);
+		step = _mm256_slli_epi64(_mm256_cvtepu16_epi64(p), 18);
+		a0 = _mm256_add_epi64(a0, step);
+		ge = _mm256_cmpgt_epi64(le0, _mm256_xor_si256(a0, sign));
+		a0 = _mm256_blendv_epi8(_mm256_and_si256(_mm256_sub_epi64(a0, ln0), mask), a0, ge);
+		step = _mm256_slli_epi64(_mm256_cvtepu16_epi64(_mm_srli_si128(p, 8)), 18);
+		a1 = _mm256_add_epi64(a1, step);
+		ge = _mm256_cmpgt_epi64(le1, _mm256_xor_si256(a1, sign));
+		a1 = _mm256_blendv_epi8(_mm256_and_si256(_mm256_sub_epi64(a1, ln1), mask), a1, ge);
+	}
+
+	_mm256_storeu_si256((__m256i *)&l->addr[b], a0);
+	_mm256_storeu_si256((__m256i *)&l->addr[b + 4], a1);
+	_mm256_storeu_si256((__m256i *)fs[0], f0);
+	_mm256_storeu_si256((__m256i *)fs[1], f1);
+	_mm256_storeu_si256((__m256i *)fs[2], f2);
+	_mm256_storeu_si256((__m256i *)fs[3], f3);
+	_mm256_storeu_si256((__m256i *)fs[4], f4);
+	for (c = 0; c < 5; c++)
+		for (k = 0; k < 8; k++)
+			l->filt[c][b + k] = fs[c][k];
+    }
+}
+#endif	/*USE_SIMD*/
+
+
+/* Set up the resampler and filter tables. */
+void
+emu8k_lanes_init(void)
+{
+    double out, x;
+    int c, qidx;
+
+    if (cubic_table == NULL)
+	cubic_table = (float *)malloc(CUBIC_RESOLUTION*4*sizeof(float));
+
+    /* Cubic Resampling (4point cubic spline.) */
+    for (c = 0; c < CUBIC_RESOLUTION; c++) {
+	x = (double)c / (double)CUBIC_RESOLUTION;
+
+	/* Four tables, in one to optimize memory access. */
+	cubic_table[c*4]   = (float)((-0.5 * x * x * x +       x * x - 0.5 * x)      );
+	cubic_table[c*4+1] = (float)(( 1.5 * x * x * x - 2.5 * x * x           + 1.0));
+	cubic_table[c*4+2] = (float)((-1.5 * x * x * x + 2.0 * x * x + 0.5 * x)      );
+	cubic_table[c*4+3] = (float)(( 0.5 * x * x * x - 0.5 * x * x)                );
+    }
+
+    /*
+     * Filter coefficients tables. Note: Values are multiplied
+     * by *16777216 to left shift 24 bits. (i.e. 8.24 fixed point)
+     */
+    for (qidx = 0; qidx < 16; qidx++) {
+	out = 125.0; /* Start at 125Hz */
+	for (c = 0; c < 256; c++) {
+#ifdef FILTER_INITIAL
+		float w0 = sin(2.0*M_PI*out / 44100.0);
+		/* The value 102.5f has been selected a bit randomly. Pretends to reach 0.2929 at w0 = 1.0 */
+		float q = (qidx / 102.5f) * (1.0 + 1.0 / w0);
+		/* Limit max value. Else it would be 470. */
+		if (q > 200) q=200;
+		filt_coeffs[qidx][c][0] = (int32_t)(w0 * 16777216.0);
+		filt_coeffs[qidx][c][1] = 16777216.0;
+		filt_coeffs[qidx][c][2] = (int32_t)((1.0f / (0.7071f + q)) * 16777216.0);
+#elif defined FILTER_MOOG
+		float w0 = (float) (sin(2.0*M_PI*out / 44100.0));
+		float q_factor = 1.0f - w0;
+		float p = w0 + 0.8f * w0 * q_factor;
+		float f = p + p - 1.0f;
+		float resonance = (float) ((1.0-pow(2.0,-qidx*24.0/90.0))*0.8);
+		float q = resonance * (1.0f + 0.5f * q_factor * (w0 + 5.6f * q_factor * q_factor));
+		filt_coeffs[qidx][c][0] = (int32_t)(p * 16777216.0);
+		filt_coeffs[qidx][c][1] = (int32_t)(f * 16777216.0);
+		filt_coeffs[qidx][c][2] = (int32_t)(q * 16777216.0);
+#elif defined FILTER_CONSTANT
+		float q = (1.0-pow(2.0,-qidx*24.0/90.0))*0.8;
+		float coef0 = sin(2.0*M_PI*out / 44100.0);
+		float coef1 = 1.0 - coef0;
+		float coef2 = q * (1.0 + 1.0 / coef1);
+		filt_coeffs[qidx][c][0] = (int32_t)(coef0 * 16777216.0);
+		filt_coeffs[qidx][c][1] = (int32_t)(coef1 * 16777216.0);
+		filt_coeffs[qidx][c][2] = (int32_t)(coef2 * 16777216.0);
+#endif //FILTER_TYPE
+		/* 42.66 divisions per octave (the doc says quarter seminotes which is 48, but then it would be almost an octave less) */
+		out *= 1.016378315;
+		/* 42 divisions. This moves the max frequency to 8.5Khz.*/
+		//out *= 1.0166404394;
+		/* This is a linear increment method, that corresponds to the NRPN table, but contradicts the EMU8KPRM doc: */
+		//out = 100.0 + (c+1.0)*31.25; //31.25Hz steps */
+	}
+    }
+}
+
+
+void
+emu8k_lanes_close(void)
+{
+    free(cubic_table);
+    cubic_table = NULL;
+}
+
+
+/* Find the widest path this processor can run. */
+int
+emu8k_lanes_simd(void)
+{
+#ifdef USE_SIMD
+# ifdef _MSC_VER
+    int regs[4];
+    int avx;
+
+    __cpuid(regs, 1);
+    avx = (regs[2] & (1 << 27)) && (regs[2] & (1 << 28)) &&
+	  ((_xgetbv(0) & 6) == 6);
+    if (! (regs[2] & (1 << 20)))
+	return(EMU8K_SIMD_NONE);
+
+    __cpuidex(regs, 7, 0);
+    if (avx && (regs[1] & (1 << 5)))
+	return(EMU8K_SIMD_AVX2);
+
+    return(EMU8K_SIMD_SSE42);
+# else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+	return(EMU8K_SIMD_AVX2);
+    if (__builtin_cpu_supports("sse4.2"))
+	return(EMU8K_SIMD_SSE42);
+# endif
+#endif
+
+    return(EMU8K_SIMD_NONE);
+}
+
+
+/*
+ * Make the lanes after the last voice, up to a whole group of 8,
+ * silent and still, so the vector paths can run them along.
+ */
+void
+emu8k_lanes_pad(emu8k_lanes_t *l)
+{
+    int c, i, n;
+
+    for (n = l->count; n < ((l->count + 7) & ~7); n++) {
+	l->voice[n] = -1;
+	l->addr[n] = 0;
+	l->loop_end[n] = ~(uint64_t)0;
+	l->loop_len[n] = 0;
+	l->filterq[n] = l->filt_att[n] = 0;
+	for (c = 0; c < 5; c++)
+		l->filt[c][n] = 0;
+	l->audible[n] = 0;
+	l->vol_l[n] = l->vol_r[n] = 0;
+	l->revb[n] = l->chor[n] = 0;
+
+	for (i = 0; i < EMU8K_CHUNK; i++)
+		l->pitch[i][n] = l->volume[i][n] = l->cutoff[i][n] = 0;
+    }
+}
+
+
+/*
+ * Render len samples of all lanes, adding them into the (stereo)
+ * output and the reverb and chorus sends.
+ */
+void
+emu8k_lanes_render(emu8k_lanes_t *l, int simd, int len,
+		   int32_t *buf, int32_t *reverb, int32_t *chorus)
+{
+    switch (simd) {
+#ifdef USE_SIMD
+	case EMU8K_SIMD_AVX2:
+		render_avx2(l, len, buf, reverb, chorus);
+		break;
+
+	case EMU8K_SIMD_SSE42:
+		render_sse42(l, len, buf, reverb, chorus);
+		break;
+#endif
+
+	default:
+		render_c(l, len, buf, reverb, chorus);
+		break;
+    }
+}
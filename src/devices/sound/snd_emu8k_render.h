@@ -0,0 +1,111 @@
+/*
+ * VARCem	Virtual ARchaeological Computer EMulator.
+ *		An emulator of (mostly) x86-based PC systems and devices,
+ *		using the ISA,EISA,VLB,MCA  and PCI system buses, roughly
+ *		spanning the era between 1981 and 1995.
+ *
+ *		This file is part of the VARCem Project.
+ *
+ *		Definitions for the Emu8K voice renderer.
+ *
+ * Version:	@(#)snd_emu8k_render.h	1.0.1	2026/10/19
+ *
+ * Author:	agent, <agent@local>
+ *
+ *		Copyright 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free  Software  Foundation; either  version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is  distributed in the hope that it will be useful, but
+ * WITHOUT   ANY  WARRANTY;  without  even   the  implied  warranty  of
+ * MERCHANTABILITY  or FITNESS  FOR A PARTICULAR  PURPOSE. See  the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the:
+ *
+ *   Free Software Foundation, Inc.
+ *   59 Temple Place - Suite 330
+ *   Boston, MA 02111-1307
+ *   USA.
+ */
+#ifndef SOUND_EMU8K_RENDER_H
+# define SOUND_EMU8K_RENDER_H
+
+
+#if !defined FILTER_INITIAL && !defined FILTER_MOOG && !defined FILTER_CONSTANT
+//#define FILTER_INITIAL
+#define FILTER_MOOG
+//#define FILTER_CONSTANT
+#endif
+
+#if !defined RESAMPLER_LINEAR && !defined RESAMPLER_CUBIC
+//#define RESAMPLER_LINEAR
+#define RESAMPLER_CUBIC
+#endif
+
+/* cubic and linear tables resolution. Note: higher than 10 does not improve the result. */
+#define CUBIC_RESOLUTION_LOG	10
+#define CUBIC_RESOLUTION	(1 << CUBIC_RESOLUTION_LOG)
+
+#define EMU8K_LANES		32	// one lane per voice
+#define EMU8K_CHUNK		64	// samples per control chunk
+
+/* EMU8K_MEM_ADDRESS_MASK, applied to a whole oscillator address. */
+#define EMU8K_LANE_ADDR_MASK	((((uint64_t)0xffffff) << 32) | 0xffffffff)
+
+/* Instruction sets the lanes can be rendered with. */
+#define EMU8K_SIMD_NONE		0
+#define EMU8K_SIMD_SSE42	1	// 4 lanes at a time
+#define EMU8K_SIMD_AVX2		2	// 8 lanes at a time
+
+
+/*
+ * The audio path of the running voices, in structure-of-arrays form.
+ *
+ * The envelopes and LFOs are run per voice first, and leave the pitch,
+ * volume and filter cutoff used for every sample of a chunk in the
+ * control arrays. The oscillators, filters and mixing of all lanes
+ * are then run side by side from those.
+ */
+typedef struct emu8k_lanes {
+    int		count;			// number of lanes in use
+    int		voice[EMU8K_LANES];	// voice of each lane
+
+    int16_t	**ram_pointers;		// sound memory, per 64K block
+
+    /* Oscillator, as in emu8k_mem_internal_t. */
+    uint64_t	addr[EMU8K_LANES];
+    uint64_t	loop_end[EMU8K_LANES];
+    uint64_t	loop_len[EMU8K_LANES];	// loop length, in the int address
+
+    /* Filter. */
+    int32_t	filterq[EMU8K_LANES];
+    int32_t	filt_att[EMU8K_LANES];
+    int64_t	filt[5][EMU8K_LANES];
+
+    /* Output. */
+    int32_t	audible[EMU8K_LANES];
+    int32_t	vol_l[EMU8K_LANES], vol_r[EMU8K_LANES];
+    int32_t	revb[EMU8K_LANES], chor[EMU8K_LANES];
+
+    /* Controls, as used for each sample. */
+    uint16_t	pitch[EMU8K_CHUNK][EMU8K_LANES];
+    uint16_t	volume[EMU8K_CHUNK][EMU8K_LANES];
+    uint16_t	cutoff[EMU8K_CHUNK][EMU8K_LANES];
+} emu8k_lanes_t;
+
+
+extern void	emu8k_lanes_init(void);
+extern void	emu8k_lanes_close(void);
+extern int	emu8k_lanes_simd(void);
+extern void	emu8k_lanes_pad(emu8k_lanes_t *lanes);
+extern void	emu8k_lanes_render(emu8k_lanes_t *lanes, int simd, int len,
+				   int32_t *buf, int32_t *reverb,
+				   int32_t *chorus);
+
+
+#endif	/*SOUND_EMU8K_RENDER_H*/
@@ -8,7 +8,7 @@
  *
  *		Implementation of the Gravis UltraSound sound device.
  *
- * Version:	@(#)snd_gus.c	1.0.19	2021/06/05
+ * Version:	@(#)snd_gus.c	1.0.21	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -1003,7 +1003,9 @@ poll_timer_2(priv_t priv)
 static void
 gus_update(gus_t *dev)
 {
-    for (; dev->pos < sound_pos_global; dev->pos++) {
+    int end = sound_get_pos();
+
+    for (; dev->pos < end; dev->pos++) {
 	if (dev->out_l < -32768)
 		dev->buffer[0][dev->pos] = -32768;
 	else if (dev->out_l > 32767)
@@ -8,7 +8,7 @@
  *
  *		Implemantation of LPT-based sound devices.
  *
- * Version:	@(#)snd_lpt_dac.c	1.0.13	2021/03/12
+ * Version:	@(#)snd_lpt_dac.c	1.0.15	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -69,7 +69,9 @@ typedef struct {
 static void
 dac_update(lpt_dac_t *dev)
 {
-    for (; dev->pos < sound_pos_global; dev->pos++) {
+    int end = sound_get_pos();
+
+    for (; dev->pos < end; dev->pos++) {
 	dev->buffer[0][dev->pos] = (int8_t)(dev->dac_val_l ^ 0x80) * 0x40;
 	dev->buffer[1][dev->pos] = (int8_t)(dev->dac_val_r ^ 0x80) * 0x40;
     }
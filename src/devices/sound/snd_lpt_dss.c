@@ -8,7 +8,7 @@
  *
  *		Implementation of the LPT-based DSS sound device.
  *
- * Version:	@(#)snd_lpt_dss.c	1.0.14	2021/03/12
+ * Version:	@(#)snd_lpt_dss.c	1.0.16	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -71,7 +71,9 @@ typedef struct {
 static void
 dss_update(dss_t *dev)
 {
-    for (; dev->pos < sound_pos_global; dev->pos++)
+    int end = sound_get_pos();
+
+    for (; dev->pos < end; dev->pos++)
 	dev->buffer[dev->pos] = (int8_t)(dev->dac_val ^ 0x80) * 0x40;
 }
 
@@ -12,7 +12,7 @@
  *		poll-like function for "update" so the sound card can call
  *		that and get a buffer-full of sample data.
  *
- * Version:	@(#)snd_opl.c	1.0.9	2020/07/19
+ * Version:	@(#)snd_opl.c	1.0.11	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -147,7 +147,13 @@ static void
 opl_write(opl_t *dev, uint16_t port, uint8_t val)
 {
     if (! (port & 1)) {
-	dev->port = nuked_write_addr(dev->opl, port, val) & 0x01ff;
+	if (dev->worker != NULL) {
+		/* The chip belongs to the worker, so decode it here. */
+		dev->port = val;
+		if ((port & 0x0002) && (val == 0x05 || dev->newm))
+			dev->port |= 0x0100;
+	} else
+		dev->port = nuked_write_addr(dev->opl, port, val) & 0x01ff;
 
 	if (! dev->is_opl3)
 		dev->port &= 0x00ff;
@@ -155,7 +161,12 @@ opl_write(opl_t *dev, uint16_t port, uint8_t val)
 	return;
     }
 
-    nuked_write_reg_buffered(dev->opl, dev->port, val);
+    if (dev->worker != NULL) {
+	if (dev->port == 0x0105)
+		dev->newm = val & 0x01;
+	sound_worker_write(dev->worker, dev->port, val);
+    } else
+	nuked_write_reg_buffered(dev->opl, dev->port, val);
 
     switch (dev->port) {
 	case 0x02:	// timer 1
@@ -198,6 +209,71 @@ opl_set_do_cycles(opl_t *dev, int8_t do_cycles)
 }
 
 
+/* Render output into a buffer, up to the given position. */
+static void
+opl_render(opl_t *dev, int32_t *buf, int *pos, int new_pos)
+{
+    if (*pos >= new_pos)
+	return;
+
+    nuked_generate_stream(dev->opl, &buf[*pos * 2], new_pos - *pos);
+
+    for (; *pos < new_pos; (*pos)++) {
+	buf[*pos * 2] /= 2;
+	if (dev->is_opl3)
+		buf[(*pos * 2) + 1] /= 2;
+	  else
+		buf[(*pos * 2) + 1] = buf[*pos * 2];
+    }
+}
+
+
+static void
+opl_update(opl_t *dev)
+{
+    if (dev->worker != NULL) {
+	/* Collect the block once the mixer asks for it. */
+	if ((sound_get_pos() == SOUNDBUFLEN) && (dev->pos < SOUNDBUFLEN)) {
+		sound_worker_block(dev->worker, dev->buffer);
+		dev->pos = SOUNDBUFLEN;
+	}
+	return;
+    }
+
+    opl_render(dev, dev->buffer, &dev->pos, sound_get_pos());
+}
+
+
+static void
+worker_write(priv_t priv, uint16_t reg, uint32_t val)
+{
+    opl_t *dev = (opl_t *)priv;
+
+    nuked_write_reg_buffered(dev->opl, reg, (uint8_t)val);
+}
+
+
+static void
+worker_render(priv_t priv, int pos)
+{
+    opl_t *dev = (opl_t *)priv;
+
+    opl_render(dev, dev->wbuffer, &dev->wpos, pos);
+}
+
+
+static void
+worker_block(priv_t priv, int32_t *out)
+{
+    opl_t *dev = (opl_t *)priv;
+
+    opl_render(dev, dev->wbuffer, &dev->wpos, SOUNDBUFLEN);
+
+    memcpy(out, dev->wbuffer, sizeof(dev->wbuffer));
+    dev->wpos = 0;
+}
+
+
 static void
 opl_init(opl_t *dev, int is_opl3)
 {
@@ -211,12 +287,23 @@ opl_init(opl_t *dev, int is_opl3)
 
     timer_add(timer_1, dev, &dev->timers[0], &dev->timers_enable[0]);
     timer_add(timer_2, dev, &dev->timers[1], &dev->timers_enable[1]);
+
+    /* Timers and status stay here, the synthesis can run elsewhere. */
+    dev->worker = sound_worker_init(is_opl3 ? "OPL3" : "OPL2", dev,
+				    SOUNDBUFLEN * 2, worker_write,
+				    worker_render, worker_block);
 }
 
 
 void
 opl_close(opl_t *dev)
 {
+    /* Stop the worker before the chip goes away. */
+    if (dev->worker != NULL) {
+	sound_worker_close(dev->worker);
+	dev->worker = NULL;
+    }
+
     /* Release the NukedOPL object. */
     if (dev->opl) {
 	nuked_close(dev->opl);
@@ -260,17 +347,7 @@ opl2_init(opl_t *dev)
 void
 opl2_update(opl_t *dev)
 {
-    if (dev->pos >= sound_pos_global)
-	return;
-
-    nuked_generate_stream(dev->opl,
-			  &dev->buffer[dev->pos * 2],
-			  sound_pos_global - dev->pos);
-
-    for (; dev->pos < sound_pos_global; dev->pos++) {
-	dev->buffer[dev->pos * 2] /= 2;
-	dev->buffer[(dev->pos * 2) + 1] = dev->buffer[dev->pos * 2];
-    }
+    opl_update(dev);
 }
 
 
@@ -310,15 +387,5 @@ opl3_init(opl_t *dev)
 void
 opl3_update(opl_t *dev)
 {
-    if (dev->pos >= sound_pos_global)
-	return;
-
-    nuked_generate_stream(dev->opl,
-			  &dev->buffer[dev->pos * 2],
-			  sound_pos_global - dev->pos);
-
-    for (; dev->pos < sound_pos_global; dev->pos++) {
-	dev->buffer[dev->pos * 2] /= 2;
-	dev->buffer[(dev->pos * 2) + 1] /= 2;
-    }
+    opl_update(dev);
 }
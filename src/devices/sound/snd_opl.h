@@ -8,7 +8,7 @@
  *
  *		Definitions for the OPL interface.
  *
- * Version:	@(#)snd_opl.h	1.0.4	2020/07/19
+ * Version:	@(#)snd_opl.h	1.0.5	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -51,7 +51,8 @@ typedef struct {
     void	*opl;
 #endif
     int8_t	is_opl3,
-		do_cycles;
+		do_cycles,
+		newm;			/* copy of OPL3 mode, for worker */
 
     uint16_t	port;
     uint8_t	status;
@@ -64,10 +65,16 @@ typedef struct {
 
     int		pos;
     int32_t	buffer[SOUNDBUFLEN * 2];
+
+    /* Synthesis worker, and its own output position and buffer. */
+    sndworker_t	*worker;
+    int		wpos;
+    int32_t	wbuffer[SOUNDBUFLEN * 2];
 } opl_t;
 
 
 extern void	opl_set_do_cycles(opl_t *dev, int8_t do_cycles);
+extern void	opl_close(opl_t *dev);
 
 extern uint8_t	opl2_read(uint16_t port, priv_t);
 extern void	opl2_write(uint16_t port, uint8_t val, priv_t);
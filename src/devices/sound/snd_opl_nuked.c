@@ -27,7 +27,7 @@
  *		in that order. The OPL2, however, is mono. What should
  *		we generate for that?
  *
- * Version:	@(#)snd_opl_nuked.c	1.0.6	2021/03/19
+ * Version:	@(#)snd_opl_nuked.c	1.0.8	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -69,6 +69,10 @@
 #define WRBUF_SIZE	1024
 #define WRBUF_DELAY	1
 #define RSM_FRAC	10
+#define BATCH_SIZE	64		// samples per envelope batch
+#define BATCH_MIN	4		// shorter ones go one slot at a time
+#define EG_RATES	65		// envelope rates, and one for "none"
+#define EG_CLOCKS	112		// envelope clock states, see nuked_batch
 
 
 // Channel types
@@ -103,11 +107,6 @@ typedef struct slot {
     int16_t	fbmod;
     int16_t	*mod;
     int16_t	prout;
-    int16_t	eg_rout;
-    int16_t	eg_out;
-    uint8_t	eg_inc;
-    uint8_t	eg_gen;
-    uint8_t	eg_rate;
     uint8_t	eg_ksl;
     uint8_t	*trem;
     uint8_t	reg_vib;
@@ -123,8 +122,6 @@ typedef struct slot {
     uint8_t	reg_wf;
     uint8_t	key;
     uint32_t	pg_reset;
-    uint32_t	pg_phase;
-    uint16_t	pg_phase_out;
     uint8_t	slot_num;
 } slot_t;
 
@@ -154,6 +151,18 @@ typedef struct wrbuf {
 typedef struct chip {
     chan_t	chan[18];
     slot_t	slot[36];
+
+    /* Envelope and phase generator state of the slots. */
+    uint16_t	eg_rout[36];
+    uint8_t	eg_gen[36];
+    uint32_t	pg_phase[36];
+
+    /* Envelope level and phase of all slots, for each batched sample. */
+    int		bt_pos,
+		bt_len;
+    uint16_t	bt_eg[BATCH_SIZE][36];
+    uint16_t	bt_pg[BATCH_SIZE][36];
+
     uint16_t	timer;
     tmrval_t	eg_timer;
     uint8_t	eg_timerrem;
@@ -297,6 +306,9 @@ static const uint8_t ch_slot[18] = {
     0, 1, 2, 6, 7, 8, 12, 13, 14, 18, 19, 20, 24, 25, 26, 30, 31, 32
 };
 
+// Envelope shift, by rate and envelope clock state
+static uint8_t eg_shift_tab[EG_RATES][EG_CLOCKS];
+
 // Envelope generator
 typedef int16_t(*env_sinfunc)(uint16_t phase, uint16_t envelope);
 typedef void(*env_genfunc)(slot_t *slot);
@@ -467,6 +479,86 @@ static const env_sinfunc env_sin[8] = {
 };
 
 
+/*
+ * Once the attenuation is large enough (env >= 0x180), the exp
+ * lookup yields zero for any phase, and all that is left of the
+ * waveform is its sign.
+ */
+static int16_t
+env_calc_sign(uint8_t wf, uint16_t phase)
+{
+    switch (wf) {
+	case 0:
+	case 6:
+	case 7:
+		return((phase & 0x0200) ? -1 : 0);
+
+	case 4:
+		return(((phase & 0x0300) == 0x0100) ? -1 : 0);
+
+	default:
+		break;
+    }
+
+    return(0);
+}
+
+
+/*
+ * Work out the envelope shift of env_calc() for every rate, and for
+ * every state of the envelope clocks: eg_add, the timer's low 2 bits
+ * and eg_state, as (eg_add << 3) | (timer << 1) | eg_state. The last
+ * row, for a rate of 0, is all zeroes.
+ */
+static void
+env_shift_init(void)
+{
+    uint8_t rate_hi, rate_lo, eg_shift, shift;
+    uint8_t eg_add, timer, eg_state;
+    int rate, clk;
+
+    for (rate = 0; rate < EG_RATES - 1; rate++) {
+	rate_hi = rate >> 2;
+	rate_lo = rate & 0x03;
+
+	for (clk = 0; clk < EG_CLOCKS; clk++) {
+		eg_add = clk >> 3;
+		timer = (clk >> 1) & 0x03;
+		eg_state = clk & 0x01;
+		eg_shift = rate_hi + eg_add;
+		shift = 0;
+
+		if (rate_hi < 12) {
+			if (eg_state) switch (eg_shift) {
+				case 12:
+					shift = 1;
+					break;
+
+				case 13:
+					shift = (rate_lo >> 1) & 0x01;
+					break;
+
+				case 14:
+					shift = rate_lo & 0x01;
+					break;
+
+				default:
+					break;
+			}
+		} else {
+			shift = (rate_hi & 0x03) + eg_incstep[rate_lo][timer];
+			if (shift & 0x04)
+				shift = 0x03;
+			if (! shift)
+				shift = eg_state;
+		}
+
+		eg_shift_tab[rate][clk] = shift;
+	}
+    }
+}
+
+
 static void
 env_update_ksl(slot_t *slot)
 {
@@ -480,9 +572,11 @@ env_update_ksl(slot_t *slot)
 }
 
 
-static void
+static int16_t
 env_calc(slot_t *slot)
 {
+    nuked_t *dev = slot->dev;
+    uint8_t n = slot->slot_num;
     uint8_t nonzero;
     uint8_t rate;
     uint8_t rate_hi;
@@ -492,15 +586,27 @@ env_calc(slot_t *slot)
     uint8_t eg_shift, shift;
     uint16_t eg_rout;
     int16_t eg_inc;
+    int16_t eg_out;
     uint8_t eg_off;
     uint8_t reset = 0;
 
-    slot->eg_out = slot->eg_rout + (slot->reg_tl << 2) +
-		   (slot->eg_ksl >> kslshift[slot->reg_ksl]) + *slot->trem;
-    if (slot->key && slot->eg_gen == envelope_gen_num_release) {
+    eg_out = dev->eg_rout[n] + (slot->reg_tl << 2) +
+	     (slot->eg_ksl >> kslshift[slot->reg_ksl]) + *slot->trem;
+
+    /*
+     * A keyed-off slot whose envelope has run out stays that way,
+     * and this is the state most slots are in most of the time.
+     */
+    if (!slot->key && dev->eg_gen[n] == envelope_gen_num_release &&
+	dev->eg_rout[n] == 0x01ff) {
+	slot->pg_reset = 0;
+	return(eg_out);
+    }
+
+    if (slot->key && dev->eg_gen[n] == envelope_gen_num_release) {
 	reset = 1;
 	reg_rate = slot->reg_ar;
-    } else switch (slot->eg_gen) {
+    } else switch (dev->eg_gen[n]) {
 	case envelope_gen_num_attack:
 		reg_rate = slot->reg_ar;
 		break;
@@ -527,12 +633,12 @@ env_calc(slot_t *slot)
     rate_lo = rate & 0x03;
     if (rate_hi & 0x10)
 	rate_hi = 0x0f;
-    eg_shift = rate_hi + slot->dev->eg_add;
+    eg_shift = rate_hi + dev->eg_add;
     shift = 0;
 
     if (nonzero) {
 	if (rate_hi < 12) {
-		if (slot->dev->eg_state) switch (eg_shift) {
+		if (dev->eg_state) switch (eg_shift) {
 			case 12:
 				shift = 1;
 				break;
@@ -549,15 +655,15 @@ env_calc(slot_t *slot)
 				break;
 		}
 	} else {
-		shift = (rate_hi & 0x03) + eg_incstep[rate_lo][slot->dev->timer & 0x03];
+		shift = (rate_hi & 0x03) + eg_incstep[rate_lo][dev->timer & 0x03];
 		if (shift & 0x04)
 			shift = 0x03;
 		if (! shift)
-			shift = slot->dev->eg_state;
+			shift = dev->eg_state;
 	}
     }
 
-    eg_rout = slot->eg_rout;
+    eg_rout = dev->eg_rout[n];
     eg_inc = 0;
     eg_off = 0;
 
@@ -566,23 +672,23 @@ env_calc(slot_t *slot)
 	eg_rout = 0x00;
 
     // Envelope off
-    if ((slot->eg_rout & 0x1f8) == 0x1f8)
+    if ((dev->eg_rout[n] & 0x1f8) == 0x1f8)
 	eg_off = 1;
 
-    if (slot->eg_gen != envelope_gen_num_attack && !reset && eg_off)
+    if (dev->eg_gen[n] != envelope_gen_num_attack && !reset && eg_off)
 	eg_rout = 0x1ff;
 
-    switch (slot->eg_gen) {
+    switch (dev->eg_gen[n]) {
 	case envelope_gen_num_attack:
-		if (! slot->eg_rout)
-	    		slot->eg_gen = envelope_gen_num_decay;
+		if (! dev->eg_rout[n])
+	    		dev->eg_gen[n] = envelope_gen_num_decay;
 		else if (slot->key && shift > 0 && rate_hi != 0x0f)
-	    		eg_inc = ((~slot->eg_rout) << shift) >> 4;
+	    		eg_inc = ((~dev->eg_rout[n]) << shift) >> 4;
 		break;
 
 	case envelope_gen_num_decay:
-		if ((slot->eg_rout >> 4) == slot->reg_sl)
-			slot->eg_gen = envelope_gen_num_sustain;
+		if ((dev->eg_rout[n] >> 4) == slot->reg_sl)
+			dev->eg_gen[n] = envelope_gen_num_sustain;
 		else if (!eg_off && !reset && shift > 0)
 			eg_inc = 1 << (shift - 1);
 		break;
@@ -593,14 +699,16 @@ env_calc(slot_t *slot)
 			eg_inc = 1 << (shift - 1);
 		break;
     }
-    slot->eg_rout = (eg_rout + eg_inc) & 0x1ff;
+    dev->eg_rout[n] = (eg_rout + eg_inc) & 0x1ff;
 
     // Key off
     if (reset)
-	slot->eg_gen = envelope_gen_num_attack;
+	dev->eg_gen[n] = envelope_gen_num_attack;
 
     if (! slot->key)
-	slot->eg_gen = envelope_gen_num_release;
+	dev->eg_gen[n] = envelope_gen_num_release;
+
+    return(eg_out);
 }
 
 
@@ -618,10 +726,10 @@ env_key_off(slot_t *slot, uint8_t type)
 }
 
 
-static void
+static uint16_t
 phase_generate(slot_t *slot)
 {
-    uint16_t f_num;
+    uint16_t f_num, phase_out;
     uint32_t basefreq;
     uint8_t rm_xor, n_bit;
     uint32_t noise;
@@ -648,15 +756,15 @@ phase_generate(slot_t *slot)
     }
 
     basefreq = (f_num << slot->chan->block) >> 1;
-    phase = (uint16_t)(slot->pg_phase >> 9);
+    phase = (uint16_t)(dev->pg_phase[slot->slot_num] >> 9);
 
     if (slot->pg_reset)
-	slot->pg_phase = 0;
-    slot->pg_phase += (basefreq * mt[slot->reg_mult]) >> 1;
+	dev->pg_phase[slot->slot_num] = 0;
+    dev->pg_phase[slot->slot_num] += (basefreq * mt[slot->reg_mult]) >> 1;
 
     // Rhythm mode
     noise = dev->noise;
-    slot->pg_phase_out = phase;
+    phase_out = phase;
     if (slot->slot_num == 13) {	// hh
 	dev->rm_hh_bit2 = (phase >> 2) & 1;
 	dev->rm_hh_bit3 = (phase >> 3) & 1;
@@ -674,20 +782,20 @@ phase_generate(slot_t *slot)
 
 	switch (slot->slot_num) {
 		case 13: // hh
-			slot->pg_phase_out = rm_xor << 9;
+			phase_out = rm_xor << 9;
 			if (rm_xor ^ (noise & 1))
-				slot->pg_phase_out |= 0xd0;
+				phase_out |= 0xd0;
 			 else
-				slot->pg_phase_out |= 0x34;
+				phase_out |= 0x34;
 			break;
 
 		case 16: // sd
-			slot->pg_phase_out = (dev->rm_hh_bit8 << 9) |
+			phase_out = (dev->rm_hh_bit8 << 9) |
 				((dev->rm_hh_bit8 ^ (noise & 1)) << 8);
 			break;
 
 		case 17: // tc
-			slot->pg_phase_out = (rm_xor << 9) | 0x80;
+			phase_out = (rm_xor << 9) | 0x80;
 			break;
 
 		default:
@@ -698,6 +806,8 @@ phase_generate(slot_t *slot)
     n_bit = ((noise >> 14) ^ noise) & 0x01;
 
     dev->noise = (noise >> 1) | (n_bit << 22);
+
+    return(phase_out);
 }
 
 
@@ -757,10 +867,12 @@ slot_write_e0(slot_t *slot, uint8_t data)
 
 
 static void
-slot_generate(slot_t *slot)
+slot_generate(slot_t *slot, uint16_t phase, uint16_t eg_out)
 {
-    slot->out = env_sin[slot->reg_wf](slot->pg_phase_out + *slot->mod,
-							slot->eg_out);
+    if (eg_out >= 0x0180)
+	slot->out = env_calc_sign(slot->reg_wf, phase + *slot->mod);
+    else
+	slot->out = env_sin[slot->reg_wf](phase + *slot->mod, eg_out);
 }
 
 
@@ -1214,20 +1326,18 @@ nuked_write_reg_buffered(priv_t priv, uint16_t reg, uint8_t val)
 }
 
 
-void
-nuked_generate(priv_t priv, int32_t *bufp)
+/* Run the operators and the mixer, from the envelope and phase of all slots. */
+static void
+nuked_output(nuked_t *dev, int32_t *bufp, const uint16_t *eg, const uint16_t *pg)
 {
-    nuked_t *dev = (nuked_t *)priv;
-    int16_t accm, shift = 0;
+    int16_t accm;
     uint8_t i, j;
 
     bufp[1] = dev->mixbuff[1];
 
     for (i = 0; i < 15; i++) {
 	slot_calc_fb(&dev->slot[i]);
-	env_calc(&dev->slot[i]);
-	phase_generate(&dev->slot[i]);
-	slot_generate(&dev->slot[i]);
+	slot_generate(&dev->slot[i], pg[i], eg[i]);
     }
 
     dev->mixbuff[0] = 0;
@@ -1242,18 +1352,14 @@ nuked_generate(priv_t priv, int32_t *bufp)
     }
     for (i = 15; i < 18; i++) {
 	slot_calc_fb(&dev->slot[i]);
-	env_calc(&dev->slot[i]);
-	phase_generate(&dev->slot[i]);
-	slot_generate(&dev->slot[i]);
+	slot_generate(&dev->slot[i], pg[i], eg[i]);
     }
 
     bufp[0] = dev->mixbuff[0];
 
     for (i = 18; i < 33; i++) {
 	slot_calc_fb(&dev->slot[i]);
-	env_calc(&dev->slot[i]);
-	phase_generate(&dev->slot[i]);
-	slot_generate(&dev->slot[i]);
+	slot_generate(&dev->slot[i], pg[i], eg[i]);
     }
 
     dev->mixbuff[1] = 0;
@@ -1269,10 +1375,16 @@ nuked_generate(priv_t priv, int32_t *bufp)
 
     for (i = 33; i < 36; i++) {
 	slot_calc_fb(&dev->slot[i]);
-	env_calc(&dev->slot[i]);
-	phase_generate(&dev->slot[i]);
-	slot_generate(&dev->slot[i]);
+	slot_generate(&dev->slot[i], pg[i], eg[i]);
     }
+}
+
+
+/* Advance the timer, tremolo, vibrato and envelope clocks by one sample. */
+static void
+nuked_clock(nuked_t *dev)
+{
+    int16_t shift = 0;
 
     if ((dev->timer & 0x3f) == 0x3f)
 	dev->tremolopos = (dev->tremolopos + 1) % 210;
@@ -1309,7 +1421,13 @@ nuked_generate(priv_t priv, int32_t *bufp)
     }
 
     dev->eg_state ^= 1;
+}
 
+
+/* Do the buffered register writes that are due after this sample. */
+static void
+nuked_writes(nuked_t *dev)
+{
     while (dev->wrbuf[dev->wrbuf_cur].time <= (tmrval_t)dev->wrbuf_samplecnt) {
 	if (! (dev->wrbuf[dev->wrbuf_cur].reg & 0x200))
 	    break;
@@ -1326,6 +1444,292 @@ nuked_generate(priv_t priv, int32_t *bufp)
 }
 
 
+/*
+ * Step the noise generator once for each of a number of slots.
+ *
+ * Up to 9 new bits only depend on the bits already there, so that
+ * many steps can be taken at once.
+ */
+static __inline uint32_t
+noise_step(uint32_t noise, int count)
+{
+    int n;
+
+    while (count > 0) {
+	n = (count < 9) ? count : 9;
+	noise = (noise >> n) |
+		(((noise ^ (noise >> 14)) & ((1 << n) - 1)) << (23 - n));
+	count -= n;
+    }
+
+    return(noise);
+}
+
+
+/* Row of the envelope shift table for a slot's rate. */
+static __inline uint8_t
+env_rate_index(uint8_t ks, uint8_t reg_rate)
+{
+    uint8_t rate;
+
+    if (! reg_rate)
+	return(EG_RATES - 1);
+
+    rate = ks + (reg_rate << 2);
+    if (rate >= 64)
+	rate = 0x3c | (rate & 0x03);
+
+    return(rate);
+}
+
+
+/*
+ * Run the envelope and phase generators of all slots for a batch of
+ * samples, leaving their outputs in bt_eg and bt_pg.
+ *
+ * No register can change within the batch, so what the generators use
+ * from the registers is worked out once, and each slot then runs on its
+ * own through all samples. The clocks do not depend on the slots, and
+ * are run first; only the rhythm slots and the noise generator tie the
+ * slots of a sample together, and are done last, sample by sample.
+ *
+ * This must come out the same as env_calc() and phase_generate() do.
+ */
+static void
+nuked_batch(nuked_t *dev, int len)
+{
+    uint8_t ck_eg[BATCH_SIZE], ck_trem[BATCH_SIZE], ck_vib[BATCH_SIZE];
+    uint32_t noise_hh[BATCH_SIZE], noise_sd[BATCH_SIZE];
+    uint8_t rates[4];
+    uint8_t ks, shift, instant;
+    uint8_t key, gen, sl, tmask, mult, block, vib, reset, eg_off;
+    uint8_t rm_xor;
+    uint16_t base, rout, eg_rout, f_num, f, phase;
+    int16_t eg_inc;
+    int8_t range;
+    uint32_t pg, vinc[8];
+    slot_t *slot;
+    int i, n;
+
+    dev->bt_pos = 0;
+    dev->bt_len = len;
+
+    /* Short batches are not worth setting up each slot for. */
+    if (len < BATCH_MIN) {
+	for (n = 0; n < len; n++) {
+		for (i = 0; i < 36; i++) {
+			dev->bt_eg[n][i] = env_calc(&dev->slot[i]);
+			dev->bt_pg[n][i] = phase_generate(&dev->slot[i]);
+		}
+		nuked_clock(dev);
+	}
+	return;
+    }
+
+    /* The clocks, as seen by each sample. */
+    for (n = 0; n < len; n++) {
+	ck_eg[n] = (dev->eg_add << 3) | ((dev->timer & 0x03) << 1) |
+		   dev->eg_state;
+	ck_trem[n] = dev->tremolo;
+	ck_vib[n] = dev->vibpos;
+	nuked_clock(dev);
+    }
+
+    for (i = 0; i < 36; i++) {
+	slot = &dev->slot[i];
+
+	key = slot->key;
+	gen = dev->eg_gen[i];
+	rout = dev->eg_rout[i];
+	pg = dev->pg_phase[i];
+	reset = 0;
+
+	base = (slot->reg_tl << 2) + (slot->eg_ksl >> kslshift[slot->reg_ksl]);
+	tmask = (slot->trem == &dev->tremolo) ? 0xff : 0x00;
+	ks = slot->chan->ksv >> ((slot->reg_ksr ^ 1) << 1);
+	sl = slot->reg_sl;
+	rates[envelope_gen_num_attack] = env_rate_index(ks, slot->reg_ar);
+	rates[envelope_gen_num_decay] = env_rate_index(ks, slot->reg_dr);
+	rates[envelope_gen_num_sustain] =
+		env_rate_index(ks, slot->reg_type ? 0 : slot->reg_rr);
+	rates[envelope_gen_num_release] = env_rate_index(ks, slot->reg_rr);
+	instant = ((rates[envelope_gen_num_attack] >> 2) == 0x0f);
+
+	f_num = slot->chan->f_num;
+	block = slot->chan->block;
+	mult = mt[slot->reg_mult];
+	vib = slot->reg_vib;
+
+	/* Phase step for each vibrato position, as in phase_generate(). */
+	for (n = 0; n < 8; n++) {
+		f = f_num;
+		if (vib) {
+			range = (f_num >> 7) & 7;
+
+			if (! (n & 3))
+				range = 0;
+			else if (n & 1)
+				range >>= 1;
+			range >>= dev->vibshift;
+
+			if (n & 4)
+				range = -range;
+			f += range;
+		}
+		vinc[n] = ((((uint32_t)f << block) >> 1) * mult) >> 1;
+	}
+
+	/* A slot that is done stays done for the whole batch. */
+	if (!key && gen == envelope_gen_num_release && rout == 0x01ff) {
+		for (n = 0; n < len; n++) {
+			dev->bt_eg[n][i] = rout + base + (ck_trem[n] & tmask);
+			dev->bt_pg[n][i] = (uint16_t)(pg >> 9);
+			pg += vinc[ck_vib[n]];
+		}
+		slot->pg_reset = 0;
+		dev->pg_phase[i] = pg;
+		continue;
+	}
+
+	for (n = 0; n < len; n++) {
+		/* Envelope, as in env_calc(). */
+		dev->bt_eg[n][i] = rout + base + (ck_trem[n] & tmask);
+
+		if (!key && gen == envelope_gen_num_release && rout == 0x01ff) {
+			reset = 0;
+		} else {
+			reset = (key && gen == envelope_gen_num_release);
+			shift = eg_shift_tab[rates[reset ? envelope_gen_num_attack : gen]][ck_eg[n]];
+
+			eg_rout = rout;
+			eg_inc = 0;
+			eg_off = ((rout & 0x1f8) == 0x1f8);
+
+			if (reset && instant)
+				eg_rout = 0x00;
+
+			if (gen != envelope_gen_num_attack && !reset && eg_off)
+				eg_rout = 0x1ff;
+
+			switch (gen) {
+				case envelope_gen_num_attack:
+					if (! rout)
+						gen = envelope_gen_num_decay;
+					else if (key && shift > 0 && !instant)
+						eg_inc = ((~rout) << shift) >> 4;
+					break;
+
+				case envelope_gen_num_decay:
+					if ((rout >> 4) == sl)
+						gen = envelope_gen_num_sustain;
+					else if (!eg_off && !reset && shift > 0)
+						eg_inc = 1 << (shift - 1);
+					break;
+
+				case envelope_gen_num_sustain:
+				case envelope_gen_num_release:
+					if (!eg_off && !reset && shift > 0)
+						eg_inc = 1 << (shift - 1);
+					break;
+			}
+			rout = (eg_rout + eg_inc) & 0x1ff;
+
+			if (reset)
+				gen = envelope_gen_num_attack;
+			if (! key)
+				gen = envelope_gen_num_release;
+		}
+
+		/* Phase, as in phase_generate(). */
+		dev->bt_pg[n][i] = (uint16_t)(pg >> 9);
+		if (reset)
+			pg = 0;
+		pg += vinc[ck_vib[n]];
+	}
+
+	slot->pg_reset = reset;
+	dev->eg_gen[i] = gen;
+	dev->eg_rout[i] = rout;
+	dev->pg_phase[i] = pg;
+    }
+
+    /* The noise generator is stepped once per slot. */
+    for (n = 0; n < len; n++) {
+	dev->noise = noise_step(dev->noise, 13);
+	noise_hh[n] = dev->noise;
+	dev->noise = noise_step(dev->noise, 3);
+	noise_sd[n] = dev->noise;
+	dev->noise = noise_step(dev->noise, 20);
+    }
+
+    /* Rhythm mode, as in phase_generate(). */
+    for (n = 0; n < len; n++) {
+	phase = dev->bt_pg[n][13];
+	dev->rm_hh_bit2 = (phase >> 2) & 1;
+	dev->rm_hh_bit3 = (phase >> 3) & 1;
+	dev->rm_hh_bit7 = (phase >> 7) & 1;
+	dev->rm_hh_bit8 = (phase >> 8) & 1;
+	if (! (dev->rhy & 0x20))
+		continue;
+
+	rm_xor = (dev->rm_hh_bit2 ^ dev->rm_hh_bit7) |
+		 (dev->rm_hh_bit3 ^ dev->rm_tc_bit5) |
+		 (dev->rm_tc_bit3 ^ dev->rm_tc_bit5);
+	phase = rm_xor << 9;
+	if (rm_xor ^ (noise_hh[n] & 1))
+		phase |= 0xd0;
+	else
+		phase |= 0x34;
+	dev->bt_pg[n][13] = phase;
+
+	dev->bt_pg[n][16] = (dev->rm_hh_bit8 << 9) |
+			    ((dev->rm_hh_bit8 ^ (noise_sd[n] & 1)) << 8);
+
+	phase = dev->bt_pg[n][17];
+	dev->rm_tc_bit3 = (phase >> 3) & 1;
+	dev->rm_tc_bit5 = (phase >> 5) & 1;
+	rm_xor = (dev->rm_hh_bit2 ^ dev->rm_hh_bit7) |
+		 (dev->rm_hh_bit3 ^ dev->rm_tc_bit5) |
+		 (dev->rm_tc_bit3 ^ dev->rm_tc_bit5);
+	dev->bt_pg[n][17] = (rm_xor << 9) | 0x80;
+    }
+}
+
+
+/* Work out an output sample between the last two chip samples. */
+static __inline void
+nuked_resample(nuked_t *dev, int32_t *bufp)
+{
+    bufp[0] = (int32_t)((dev->oldsamples[0] * (dev->rateratio - dev->samplecnt)
+		     + dev->samples[0] * dev->samplecnt) / dev->rateratio);
+    bufp[1] = (int32_t)((dev->oldsamples[1] * (dev->rateratio - dev->samplecnt)
+		     + dev->samples[1] * dev->samplecnt) / dev->rateratio);
+
+    dev->samplecnt += 1 << RSM_FRAC;
+}
+
+
+/* Generate one chip sample, one slot at a time. */
+void
+nuked_generate(priv_t priv, int32_t *bufp)
+{
+    nuked_t *dev = (nuked_t *)priv;
+    uint16_t eg[36], pg[36];
+    uint8_t i;
+
+    for (i = 0; i < 36; i++) {
+	eg[i] = env_calc(&dev->slot[i]);
+	pg[i] = phase_generate(&dev->slot[i]);
+    }
+
+    nuked_output(dev, bufp, eg, pg);
+
+    nuked_clock(dev);
+
+    nuked_writes(dev);
+}
+
+
 void
 nuked_generate_resampled(priv_t priv, int32_t *bufp)
 {
@@ -1338,23 +1742,62 @@ nuked_generate_resampled(priv_t priv, int32_t *bufp)
 	dev->samplecnt -= dev->rateratio;
     }
 
-    bufp[0] = (int32_t)((dev->oldsamples[0] * (dev->rateratio - dev->samplecnt)
-		     + dev->samples[0] * dev->samplecnt) / dev->rateratio);
-    bufp[1] = (int32_t)((dev->oldsamples[1] * (dev->rateratio - dev->samplecnt)
-		     + dev->samples[1] * dev->samplecnt) / dev->rateratio);
-
-    dev->samplecnt += 1 << RSM_FRAC;
+    nuked_resample(dev, bufp);
 }
 
 
+/*
+ * Generate a stream of output samples, running the envelope and phase
+ * generators in batches that end where a buffered write is due.
+ */
 void
 nuked_generate_stream(priv_t priv, int32_t *sndptr, uint32_t num)
 {
     nuked_t *dev = (nuked_t *)priv;
+    wrbuf_t *wr;
+    tmrval_t due;
+    uint32_t need = 0;
+    int32_t cnt;
     uint32_t i;
+    int len;
 
+    /* Count the chip samples needed for the stream. */
+    cnt = dev->samplecnt;
     for (i = 0; i < num; i++) {
-	nuked_generate_resampled(dev, sndptr);
+	while (cnt >= dev->rateratio) {
+		cnt -= dev->rateratio;
+		need++;
+	}
+	cnt += 1 << RSM_FRAC;
+    }
+
+    for (i = 0; i < num; i++) {
+	while (dev->samplecnt >= dev->rateratio) {
+		if (dev->bt_pos == dev->bt_len) {
+			len = (need < BATCH_SIZE) ? need : BATCH_SIZE;
+
+			/* The first pending write is done after this sample. */
+			wr = &dev->wrbuf[dev->wrbuf_cur];
+			if (wr->reg & 0x200) {
+				due = wr->time - (tmrval_t)dev->wrbuf_samplecnt;
+				if (due < len)
+					len = (due > 0) ? (int)due + 1 : 1;
+			}
+
+			nuked_batch(dev, len);
+			need -= len;
+		}
+
+		dev->oldsamples[0] = dev->samples[0];
+		dev->oldsamples[1] = dev->samples[1];
+		nuked_output(dev, dev->samples,
+			     dev->bt_eg[dev->bt_pos], dev->bt_pg[dev->bt_pos]);
+		dev->bt_pos++;
+		nuked_writes(dev);
+		dev->samplecnt -= dev->rateratio;
+	}
+
+	nuked_resample(dev, sndptr);
 	sndptr += 2;
     }
 }
@@ -1369,14 +1812,15 @@ nuked_init(uint32_t samplerate)
     dev = (nuked_t *)mem_alloc(sizeof(nuked_t));
     memset(dev, 0x00, sizeof(nuked_t));
 
+    env_shift_init();
+
     for (i = 0; i < 36; i++) {
 	dev->slot[i].dev = dev;
 	dev->slot[i].mod = &dev->zeromod;
-	dev->slot[i].eg_rout = 0x01ff;
-	dev->slot[i].eg_out = 0x01ff;
-	dev->slot[i].eg_gen = envelope_gen_num_release;
 	dev->slot[i].trem = (uint8_t*)&dev->zeromod;
 	dev->slot[i].slot_num = i;
+	dev->eg_rout[i] = 0x01ff;
+	dev->eg_gen[i] = envelope_gen_num_release;
     }
 
     for (i = 0; i < 18; i++) {
@@ -79,7 +79,7 @@
  *		FF88 - board model
  *		  3 = PAS16
  *
- * Version:	@(#)snd_pas16.c	1.0.17	2020/07/17
+ * Version:	@(#)snd_pas16.c	1.0.20	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -692,9 +692,11 @@ static void pas16_out_base(uint16_t port, uint8_t val, priv_t priv)
 
 static void pas16_update(pas16_t *pas16)
 {
+        int end = sound_get_pos();
+
         if (!(pas16->audiofilt & PAS16_FILT_MUTE))
         {
-                for (; pas16->pos < sound_pos_global; pas16->pos++)
+                for (; pas16->pos < end; pas16->pos++)
                 {
                         pas16->pcm_buffer[0][pas16->pos] = 0;
                         pas16->pcm_buffer[1][pas16->pos] = 0;
@@ -702,7 +704,7 @@ static void pas16_update(pas16_t *pas16)
         }
         else
         {
-                for (; pas16->pos < sound_pos_global; pas16->pos++)
+                for (; pas16->pos < end; pas16->pos++)
                 {
                         pas16->pcm_buffer[0][pas16->pos] = (int16_t)pas16->pcm_dat_l;
                         pas16->pcm_buffer[1][pas16->pos] = (int16_t)pas16->pcm_dat_r;
@@ -754,6 +756,8 @@ static void pas16_close(priv_t priv)
 {
         pas16_t *pas16 = (pas16_t *)priv;
 
+        opl_close(&pas16->opl);
+
         free(pas16);
 }
 
@@ -10,7 +10,7 @@
  *
  * FIXME:	THIS FILE IS A HORRIBLE NIGHTMARE
  *
- * Version:	@(#)snd_sb.c	1.0.20	2021/03/16
+ * Version:	@(#)snd_sb.c	1.0.21	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -1394,6 +1394,8 @@ void sb_close(priv_t priv)
 {
         sb_t *sb = (sb_t *)priv;
         sb_dsp_close(&sb->dsp);
+        opl_close(&sb->opl);
+        opl_close(&sb->opl2);
         #ifdef SB_DSP_RECORD_DEBUG
             if (soundfsb != 0)
             {
@@ -14,7 +14,7 @@
  *		  486-50 - 32kHz
  *		  Pentium - 45kHz
  *
- * Version:	@(#)snd_sb_dsp.c	1.0.14	2020/07/14
+ * Version:	@(#)snd_sb_dsp.c	1.0.16	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -1298,12 +1298,14 @@ sb_poll_i(priv_t priv)
 void 
 sb_dsp_update(sb_dsp_t *dsp)
 {
+    int end = sound_get_pos();
+
     if (dsp->muted) {
 	dsp->sbdatl=0;
 	dsp->sbdatr=0;
     }
     
-    for (; dsp->pos < sound_pos_global; dsp->pos++) {
+    for (; dsp->pos < end; dsp->pos++) {
 	dsp->buffer[dsp->pos*2] = dsp->sbdatl;
 	dsp->buffer[dsp->pos*2 + 1] = dsp->sbdatr;
     }
@@ -8,7 +8,7 @@
  *
  *		Implementation of the TI SN74689 PSG sound devices.
  *
- * Version:	@(#)snd_sn76489.c	1.0.9	2019/05/13
+ * Version:	@(#)snd_sn76489.c	1.0.11	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -64,7 +64,9 @@ static float volslog[16]=
 
 void sn76489_update(sn76489_t *sn76489)
 {
-        for (; sn76489->pos < sound_pos_global; sn76489->pos++)
+        int end = sound_get_pos();
+
+        for (; sn76489->pos < end; sn76489->pos++)
         {
                 int c;
                 int16_t result = 0;
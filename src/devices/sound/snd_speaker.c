@@ -8,7 +8,7 @@
  *
  *		Implementation of the PC-Speaker device.
  *
- * Version:	@(#)snd_speaker.c	1.0.9	2020/01/31
+ * Version:	@(#)snd_speaker.c	1.0.11	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -85,6 +85,7 @@ get_buffer(int32_t *buffer, int len, priv_t priv)
 void
 speaker_update(void)
 {
+    int end = sound_get_pos();
     int32_t val;
     double timer2_count, amplitude;
     
@@ -94,10 +95,10 @@ speaker_update(void)
     if (amplitude > 5120.0)
 	amplitude = 5120.0;
 
-    if (speaker_pos >= sound_pos_global)
+    if (speaker_pos >= end)
 	return;
 
-    for (; speaker_pos < sound_pos_global; speaker_pos++) {
+    for (; speaker_pos < end; speaker_pos++) {
 	if (speaker_gated && speaker_was_enable) {
 		if ((pit.m[2] == 0) || (pit.m[2] == 4))
 			val = (int32_t) amplitude;
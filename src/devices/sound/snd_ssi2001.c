@@ -8,7 +8,7 @@
  *
  *		Implementation of the SSI2001 sound device.
  *
- * Version:	@(#)snd_ssi2001.c	1.0.12	2021/03/24
+ * Version:	@(#)snd_ssi2001.c	1.0.14	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -102,12 +102,14 @@ typedef struct {
 static void
 ssi_update(ssi2001_t *dev)
 {
-    if (dev->pos >= sound_pos_global) return;
+    int end = sound_get_pos();
+
+    if (dev->pos >= end) return;
 
     FUNC(fillbuf)(&dev->buffer[dev->pos],
-		  sound_pos_global - dev->pos, dev->psid);
+		  end - dev->pos, dev->psid);
 
-    dev->pos = sound_pos_global;
+    dev->pos = end;
 }
 
 
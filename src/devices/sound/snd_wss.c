@@ -8,7 +8,7 @@
  *
  *		Implementation of the Windows Sound System sound device.
  *
- * Version:	@(#)snd_wss.c	1.0.14	2021/03/16
+ * Version:	@(#)snd_wss.c	1.0.15	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		TheCollector1995, <mariogplayer@gmail.com>
@@ -181,6 +181,8 @@ wss_close(priv_t priv)
 {
     wss_t *dev = (wss_t *)priv;
 
+    opl_close(&dev->opl);
+
     free(dev);
 }
 
@@ -8,7 +8,7 @@
  *
  *		Sound emulation core.
  *
- * Version:	@(#)sound.c	1.0.21	2020/07/14
+ * Version:	@(#)sound.c	1.0.26	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -36,6 +36,7 @@
  *   Boston, MA 02111-1307
  *   USA.
  */
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
@@ -59,6 +60,9 @@
 #include "snd_speaker.h"
 
 
+#define WORKERS_MAX	4			/* synthesis workers */
+
+
 typedef struct {
     void	(*get_buffer)(int32_t *buffer, int len, priv_t);
     priv_t	priv;
@@ -68,227 +72,174 @@ typedef struct {
 #ifdef ENABLE_SOUND_LOG
 int		sound_do_log = ENABLE_SOUND_LOG;
 #endif
-int		sound_pos_global = 0;
 
 
 static sndhnd_t	handlers[8];
 static int	handlers_num;
 static tmrval_t	poll_time = 0,
 		poll_latch;
+static int	poll_inblock = 0;
 static int32_t	*outbuffer;
 static float	*outbuffer_ex;
 static int16_t	*outbuffer_ex_int16;
 
-static int16_t	cd_buffer[CDROM_NUM][CD_BUFLEN * 2];
-static float	cd_out_buffer[CD_BUFLEN * 2];
-static int16_t	cd_out_buffer_int16[CD_BUFLEN * 2];
-static thread_t	*cd_thread_h;
-static event_t	*cd_event;
-static event_t	*cd_start_event;
+static int16_t	cd_buffer[CDROM_NUM][(CD_BLOCKLEN + 1) * 2];
 static unsigned	cd_vol_l,
 		cd_vol_r;
-static int	cd_buf_update = CD_BUFLEN / SOUNDBUFLEN;
-static int	cd_thread_enable = 0;
-static volatile int cd_audioon = 0;
+static int	cd_enable = 0;
+
+static void	*workers[WORKERS_MAX];
+static tmrval_t	worker_time = 0,
+		worker_enable = 0;
+
+
+static void	worker_poll(void *priv);
 
 
+/*
+ * Mix the CD-Audio of all drives into the block.
+ *
+ * Each drive delivers one block's worth of 44.1kHz data, which is
+ * resampled to 48kHz. The drive's own (ATAPI/SCSI) volume and the
+ * channel selection are folded together with the sound card's CD
+ * volume into a 2x2 gain matrix once per block, so the sample loop
+ * itself has no branches.
+ */
 static void
-cd_thread(void *param)
+cd_mix(int32_t *out)
 {
-    float cd_buffer_temp[2] = {0.0, 0.0};
-    float cd_buffer_temp2[2] = {0.0, 0.0};
-    int32_t audio_vol_l;
-    int32_t audio_vol_r;
+    const uint32_t step = (CD_BLOCKLEN << 16) / SOUNDBUFLEN;
+    float vol[2], gain[4];
+    float l, r, frac;
+    uint32_t pos;
+    int16_t *in;
     int ch_sel[2];
-    int c, i, r, has_audio;
+    int c, i, k;
 
-    thread_set_event(cd_start_event);
-
-    while (cd_audioon) {
-	thread_wait_event(cd_event, -1);
-	thread_reset_event(cd_event);
+    for (i = 0; i < CDROM_NUM; i++) {
+	if ((cdrom[i].bus_type == CDROM_BUS_DISABLED) || !cdrom[i].ops ||
+	    !cdrom[i].ops->audio_callback) continue;
+
+	/* Slot 0 holds the last frame of the previous block. */
+	in = cd_buffer[i];
+	if (! cdrom[i].ops->audio_callback(&cdrom[i], &in[2], CD_BLOCKLEN * 2) ||
+	    !cdrom[i].sound_on) {
+		in[0] = in[1] = 0;
+		continue;
+	}
 
-	if (! cd_audioon) return;
+	if (cdrom[i].get_volume) {
+		vol[0] = (float)cdrom[i].get_volume(cdrom[i].priv, 0) / 511.0f;
+		vol[1] = (float)cdrom[i].get_volume(cdrom[i].priv, 1) / 511.0f;
+	} else
+		vol[0] = vol[1] = 255.0f / 511.0f;
+
+	if (cdrom[i].get_channel) {
+		ch_sel[0] = cdrom[i].get_channel(cdrom[i].priv, 0);
+		ch_sel[1] = cdrom[i].get_channel(cdrom[i].priv, 1);
+	} else {
+		ch_sel[0] = 1;
+		ch_sel[1] = 2;
+	}
 
-	for (c = 0; c < CD_BUFLEN*2; c += 2) {
-		if (config.sound_is_float) {
-			cd_out_buffer[c] = 0.0;
-			cd_out_buffer[c+1] = 0.0;
-		} else {
-			cd_out_buffer_int16[c] = 0;
-			cd_out_buffer_int16[c+1] = 0;
-		}
+	/* Left from left, left from right, right from left, right from right. */
+	for (k = 0; k < 2; k++) {
+		gain[k]     = (ch_sel[k] & 1) ? vol[k] * (float)cd_vol_l / 65535.0f : 0.0f;
+		gain[k + 2] = (ch_sel[k] & 2) ? vol[k] * (float)cd_vol_r / 65535.0f : 0.0f;
 	}
 
-	for (i = 0; i < CDROM_NUM; i++) {
-		has_audio = 0;
-
-		if ((cdrom[i].bus_type == CDROM_BUS_DISABLED) || !cdrom[i].ops) continue;
-
-		if (cdrom[i].ops->audio_callback) {
-			r = cdrom[i].ops->audio_callback(&cdrom[i], cd_buffer[i], CD_BUFLEN*2);
-			has_audio = (cdrom[i].bus_type && cdrom[i].sound_on/* && r*/);
-		} else
-			continue;
-
-		if (has_audio) {
-			if (cdrom[i].get_volume) {
-				audio_vol_l = cdrom[i].get_volume(cdrom[i].priv, 0);
-				audio_vol_r = cdrom[i].get_volume(cdrom[i].priv, 1);
-			} else {
-				audio_vol_l = 255;
-				audio_vol_r = 255;
-			}
-
-			if (cdrom[i].get_channel) {
-				ch_sel[0] = cdrom[i].get_channel(cdrom[i].priv, 0);
-				ch_sel[1] = cdrom[i].get_channel(cdrom[i].priv, 1);
-			} else {
-				ch_sel[0] = 1;
-				ch_sel[1] = 2;
-			}
-
-			if (! r) {
-				for (c = 0; c < CD_BUFLEN*2; c += 2) {
-					if (config.sound_is_float) {
-						cd_out_buffer[c] += 0.0;
-						cd_out_buffer[c+1] += 0.0;
-					} else {
-						cd_out_buffer_int16[c] += 0;
-						cd_out_buffer_int16[c+1] += 0;
-					}
-				}
-				continue;
-			}
-
-			for (c = 0; c < CD_BUFLEN*2; c += 2) {
-				/* First, transfer the CD audio data to the temporary buffer. */
-				cd_buffer_temp[0] = (float)cd_buffer[i][c];
-				cd_buffer_temp[1] = (float)cd_buffer[i][c+1];
-
-				/* Then, adjust input from drive according to ATAPI/SCSI volume. */
-				cd_buffer_temp[0] *= (float)audio_vol_l;
-				cd_buffer_temp[0] /= 511.0;
-				cd_buffer_temp[1] *= (float)audio_vol_r;
-				cd_buffer_temp[1] /= 511.0;
-
-				/*Apply ATAPI channel select*/
-				cd_buffer_temp2[0] = cd_buffer_temp2[1] = 0.0;
-				if (ch_sel[0] & 1)
-					cd_buffer_temp2[0] += cd_buffer_temp[0];
-				if (ch_sel[0] & 2)
-					cd_buffer_temp2[1] += cd_buffer_temp[0];
-				if (ch_sel[1] & 1)
-					cd_buffer_temp2[0] += cd_buffer_temp[1];
-				if (ch_sel[1] & 2)
-					cd_buffer_temp2[1] += cd_buffer_temp[1];
-
-				/*Apply sound card CD volume*/
-				cd_buffer_temp2[0] *= (float)cd_vol_l;
-				cd_buffer_temp2[0] /= 65535.0;
-
-				cd_buffer_temp2[1] *= (float)cd_vol_r;
-				cd_buffer_temp2[1] /= 65535.0;
-
-				if (config.sound_is_float) {
-					cd_out_buffer[c] += (float)(cd_buffer_temp2[0] / 32768.0);
-					cd_out_buffer[c+1] += (float)(cd_buffer_temp2[1] / 32768.0);
-				} else {
-					if (cd_buffer_temp2[0] > 32767)
-						cd_buffer_temp2[0] = 32767;
-					if (cd_buffer_temp2[0] < -32768)
-						cd_buffer_temp2[0] = -32768;
-					if (cd_buffer_temp2[1] > 32767)
-						cd_buffer_temp2[1] = 32767;
-					if (cd_buffer_temp2[1] < -32768)
-						cd_buffer_temp2[1] = -32768;
-
-					cd_out_buffer_int16[c] += (int16_t)cd_buffer_temp2[0];
-					cd_out_buffer_int16[c+1] += (int16_t)cd_buffer_temp2[1];
-				}
-			}
-		}
+	for (c = 0; c < SOUNDBUFLEN; c++) {
+		pos = c * step;
+		k = (pos >> 16) * 2;
+		frac = (float)(pos & 0xffff) / 65536.0f;
+
+		l = in[k]     + (in[k + 2] - in[k])     * frac;
+		r = in[k + 1] + (in[k + 3] - in[k + 1]) * frac;
+
+		out[c * 2]     += (int32_t)(l * gain[0] + r * gain[1]);
+		out[c * 2 + 1] += (int32_t)(l * gain[2] + r * gain[3]);
 	}
 
-	if (config.sound_is_float)
-		openal_buffer_cd(cd_out_buffer);
-	else
-		openal_buffer_cd(cd_out_buffer_int16);
+	in[0] = in[CD_BLOCKLEN * 2];
+	in[1] = in[CD_BLOCKLEN * 2 + 1];
     }
 }
 
 
-static void
-cd_thread_end(void)
+/*
+ * Return the current output sample position within this block.
+ *
+ * The sound timer only fires once per block, so the position is
+ * worked out from the time left until the block ends. Devices use
+ * this as a timestamp to catch up their own output up to the exact
+ * sample at which a register is written.
+ */
+int
+sound_get_pos(void)
 {
-    if (! cd_audioon) return;
+    tmrval_t left;
+    int pos;
 
-    cd_audioon = 0;
+    /* While mixing the block, everyone renders up to its end. */
+    if (poll_inblock)
+	return(SOUNDBUFLEN);
 
-    DEBUG("Waiting for CD Audio thread to terminate...\n");
+    if (poll_latch <= 0)
+	return(0);
 
-    thread_set_event(cd_event);
-    thread_wait(cd_thread_h, -1);
+    left = poll_time - timer_elapsed();
+    if (left <= 0)
+	return(SOUNDBUFLEN - 1);
 
-    DEBUG("CD Audio thread terminated...\n");
+    pos = SOUNDBUFLEN - (int)((left + poll_latch - 1) / poll_latch);
+    if (pos < 0)
+	pos = 0;
+    else if (pos > (SOUNDBUFLEN - 1))
+	pos = SOUNDBUFLEN - 1;
 
-    if (cd_event) {
-	thread_destroy_event(cd_event);
-	cd_event = NULL;
-    }
-    cd_thread_h = NULL;
-
-    if (cd_start_event) {
-	thread_destroy_event(cd_start_event);
-	cd_start_event = NULL;
-    }
+    return(pos);
 }
 
 
+/* Generate one block of output, and hand it to the output module. */
 static void
 sound_poll(void *priv)
 {
+    int32_t v;
     int c;
 
-    poll_time += poll_latch;
+    poll_time += (poll_latch * SOUNDBUFLEN);
 
-    midi_poll();
+    midi_poll(SOUNDBUFLEN);
 
-    sound_pos_global++;
-    if (sound_pos_global == SOUNDBUFLEN) {
-	memset(outbuffer, 0, SOUNDBUFLEN * 2 * sizeof(int32_t));
+    poll_inblock = 1;
 
-	for (c = 0; c < handlers_num; c++)
-		handlers[c].get_buffer(outbuffer, SOUNDBUFLEN, handlers[c].priv);
+    memset(outbuffer, 0, SOUNDBUFLEN * 2 * sizeof(int32_t));
 
-	for (c = 0; c < SOUNDBUFLEN * 2; c++) {
-		if (config.sound_is_float) {
-			outbuffer_ex[c] = (float)((outbuffer[c]) / 32768.0);
-		} else {
-			if (outbuffer[c] > 32767)
-				outbuffer[c] = 32767;
-			if (outbuffer[c] < -32768)
-				outbuffer[c] = -32768;
-
-			outbuffer_ex_int16[c] = outbuffer[c];
-		}
-	}
+    for (c = 0; c < handlers_num; c++)
+	handlers[c].get_buffer(outbuffer, SOUNDBUFLEN, handlers[c].priv);
 
-	if (config.sound_is_float)
-		openal_buffer(outbuffer_ex);
-	else
-		openal_buffer(outbuffer_ex_int16);
-	
-	if (cd_thread_enable) {
-		cd_buf_update--;
-		if (! cd_buf_update) {
-			cd_buf_update = (48000 / SOUNDBUFLEN) / (CD_FREQ / CD_BUFLEN);
-			thread_set_event(cd_event);
-		}
+    if (cd_enable)
+	cd_mix(outbuffer);
+
+    /* Keep these loops simple, so the compiler can vectorize them. */
+    if (config.sound_is_float) {
+	for (c = 0; c < SOUNDBUFLEN * 2; c++)
+		outbuffer_ex[c] = (float)outbuffer[c] * (1.0f / 32768.0f);
+
+	sound_sink_buffer(SOUND_STREAM_MAIN, outbuffer_ex, SOUNDBUFLEN * 2);
+    } else {
+	for (c = 0; c < SOUNDBUFLEN * 2; c++) {
+		v = outbuffer[c];
+		v = (v > 32767) ? 32767 : v;
+		v = (v < -32768) ? -32768 : v;
+		outbuffer_ex_int16[c] = (int16_t)v;
 	}
 
-	sound_pos_global = 0;
+	sound_sink_buffer(SOUND_STREAM_MAIN, outbuffer_ex_int16, SOUNDBUFLEN * 2);
     }
+
+    poll_inblock = 0;
 }
 
 
@@ -317,7 +268,7 @@ sound_reset(void)
 
     INFO("SOUND: reset (current=%i)\n", config.sound_card);
 
-    /* Kill the CD-Audio thread. */
+    /* Stop any CD-Audio playback. */
     sound_cd_stop();
 
     /* Reset the sound module buffers. */
@@ -336,10 +287,11 @@ sound_reset(void)
     /* Reset the MIDI devices. */
     midi_device_init();
 
-    /* Reset OpenAL. */
-    openal_reset();
+    /* Reset the output sink. */
+    sound_sink_reset();
 
     timer_add(sound_poll, NULL, &poll_time, TIMER_ALWAYS_ENABLED);
+    timer_add(worker_poll, NULL, &worker_time, &worker_enable);
 
     sound_cd_set_volume(65535, 65535);
 
@@ -364,10 +316,9 @@ sound_reset(void)
 void
 sound_init(void)
 {
-    int drives, i;
 
-    /* Initialize the OpenAL module. */
-    openal_init();
+    /* Initialize the output sink. */
+    sound_sink_init();
 
 #ifdef USE_FLUIDSYNTH
     /* Initialize the FluidSynth module. */
@@ -389,31 +340,8 @@ sound_init(void)
 
     outbuffer = (int32_t *)mem_alloc(SOUNDBUFLEN * 2 * sizeof(int32_t));
 
-    /* Set up the CD-AUDIO thread. */
-    drives = 0;
-    for (i = 0; i < CDROM_NUM; i++) {
-	if (cdrom[i].bus_type != CDROM_BUS_DISABLED)
-		drives++;
-    }	
-
-    if (drives) {
-	cd_audioon = 1;
-
-	cd_start_event = thread_create_event();
-
-	cd_event = thread_create_event();
-	cd_thread_h = thread_create(cd_thread, NULL);
-
-	DEBUG("Waiting for CD start event...\n");
-
-	thread_wait_event(cd_start_event, -1);
-	thread_reset_event(cd_start_event);
-
-	DEBUG("Done!\n");
-    } else
-	cd_audioon = 0;
-
-    cd_thread_enable = drives ? 1 : 0;
+    /* CD-Audio is mixed in if we have any drives. */
+    sound_cd_stop();
 }
 
 
@@ -421,14 +349,14 @@ sound_init(void)
 void
 sound_close(void)
 {
-    /* Kill the CD-Audio thread if needed. */
+    /* Stop any CD-Audio playback. */
     sound_cd_stop();
 
     /* Close down the MIDI module. */
     midi_close();
 
-    /* Close the OpenAL interface. */
-    openal_close();
+    /* Close the output sink. */
+    sound_sink_close();
 }
 
 
@@ -442,23 +370,12 @@ sound_cd_stop(void)
 	if (cdrom[i].ops && cdrom[i].ops->audio_stop)
 	       	cdrom[i].ops->audio_stop(&cdrom[i]);
 	if (cdrom[i].bus_type != CDROM_BUS_DISABLED)
-			drives++;
-    }
-    if (drives && !cd_thread_enable) {
-	cd_audioon = 1;
-
-	cd_start_event = thread_create_event();
-
-	cd_event = thread_create_event();
-	cd_thread_h = thread_create(cd_thread, NULL);
+		drives++;
 
-	thread_wait_event(cd_start_event, -1);
-	thread_reset_event(cd_start_event);
-    } else if (!drives && cd_thread_enable) {
-	cd_thread_end();
+	memset(cd_buffer[i], 0x00, sizeof(cd_buffer[i]));
     }
 
-    cd_thread_enable = drives ? 1 : 0;
+    cd_enable = drives ? 1 : 0;
 }
 
 
@@ -479,6 +396,311 @@ sound_add_handler(void (*get_buffer)(int32_t *buffer, int len, void *p), void *p
 }
 
 
+/*
+ * Synthesis workers.
+ *
+ * Sound chips that are expensive to render (OPL, EMU8000) can hand
+ * their synthesis off to a thread of their own. The emulation side
+ * queues register writes, stamped with the sample position within
+ * the current block at which they happened, and the worker renders
+ * up to each stamp before applying the write, so the output is the
+ * same as when rendering inline. A few times per block, a progress
+ * marker lets the worker render ahead while the emulation runs, so
+ * that when the card queues the end marker, only the last bit of the
+ * block is left to do, and the block is mixed in right away, in step
+ * with everything else.
+ */
+#define WORKER_QUEUE	4096			/* must be a power of 2 */
+#define WORKER_STEPS	8			/* progress markers per block */
+#define WORKER_MARK	0xfffe			/* progress marker */
+#define WORKER_END	0xffff			/* end-of-block marker */
+
+
+typedef struct {
+    uint16_t	pos;
+    uint16_t	reg;
+    uint32_t	val;
+} wcmd_t;
+
+typedef struct {
+    const char	*name;
+    priv_t	priv;
+    void	(*write)(priv_t, uint16_t reg, uint32_t val);
+    void	(*render)(priv_t, int pos);
+    void	(*block)(priv_t, int32_t *out);
+
+    int		buflen;				/* entries per block */
+    int32_t	*buffer;			/* one block of output */
+
+    thread_t	*thread;
+    event_t	*wake,
+		*idle;
+    volatile int running;
+
+    volatile uint32_t head,			/* written by emulator */
+		tail;				/* consumed by worker */
+    volatile uint32_t blocks_req,
+		blocks_done;
+
+    uint64_t	writes,
+		syncs,
+		stalls;
+
+    wcmd_t	queue[WORKER_QUEUE];
+} worker_t;
+
+
+static void
+worker_thread(void *param)
+{
+    worker_t *w = (worker_t *)param;
+    wcmd_t *cmd;
+    int pos = 0;
+
+    thread_set_event(w->idle);
+
+    while (w->running) {
+	thread_wait_event(w->wake, -1);
+	thread_reset_event(w->wake);
+
+	while (w->running && (w->tail != w->head)) {
+		thread_barrier();
+		cmd = &w->queue[w->tail & (WORKER_QUEUE - 1)];
+
+		/* Catch up to the moment of the write. */
+		if (cmd->pos > pos) {
+			w->render(w->priv, cmd->pos);
+			pos = cmd->pos;
+		}
+
+		if (cmd->reg == WORKER_END) {
+			w->block(w->priv, w->buffer);
+			pos = 0;
+			thread_barrier();
+			w->blocks_done++;
+		} else if (cmd->reg != WORKER_MARK)
+			w->write(w->priv, cmd->reg, cmd->val);
+
+		thread_barrier();
+		w->tail++;
+	}
+
+	thread_set_event(w->idle);
+    }
+}
+
+
+/* Wait for the worker to drain its queue down to 'left' entries. */
+static void
+worker_wait(worker_t *w, uint32_t left)
+{
+    while ((w->head - w->tail) > left) {
+	/* Re-check after the reset, so a wakeup cannot get lost. */
+	thread_reset_event(w->idle);
+	if ((w->head - w->tail) <= left)
+		break;
+
+	thread_set_event(w->wake);
+	thread_wait_event(w->idle, -1);
+    }
+    thread_barrier();
+}
+
+
+static void
+worker_queue(worker_t *w, int pos, uint16_t reg, uint32_t val)
+{
+    wcmd_t *cmd;
+
+    if ((w->head - w->tail) == WORKER_QUEUE) {
+	w->stalls++;
+	worker_wait(w, WORKER_QUEUE / 2);
+    }
+
+    cmd = &w->queue[w->head & (WORKER_QUEUE - 1)];
+    cmd->pos = pos;
+    cmd->reg = reg;
+    cmd->val = val;
+
+    thread_barrier();
+    w->head++;
+
+    /* Do not let too much work pile up for the end of the block. */
+    if ((w->head - w->tail) == (WORKER_QUEUE / 4))
+	thread_set_event(w->wake);
+}
+
+
+/* Let all workers render up to the current position. */
+static void
+worker_poll(void *priv)
+{
+    worker_t *w;
+    int pos, i;
+
+    worker_time += (poll_latch * (SOUNDBUFLEN / WORKER_STEPS));
+
+    pos = sound_get_pos();
+    if (pos == 0)
+	return;
+
+    for (i = 0; i < WORKERS_MAX; i++) {
+	w = (worker_t *)workers[i];
+	if (w == NULL)
+		continue;
+
+	worker_queue(w, pos, WORKER_MARK, 0);
+	thread_set_event(w->wake);
+    }
+}
+
+
+/*
+ * Create a worker for a device.
+ *
+ * The callbacks are only ever called on the worker thread: 'write'
+ * applies a register write, 'render' catches up the output to the
+ * given position (0..SOUNDBUFLEN) in the block, and 'block' finishes
+ * the block, copies 'buflen' entries of it to 'out' and rewinds.
+ */
+sndworker_t *
+sound_worker_init(const char *name, priv_t priv, int buflen,
+		  void (*write)(priv_t, uint16_t reg, uint32_t val),
+		  void (*render)(priv_t, int pos),
+		  void (*block)(priv_t, int32_t *out))
+{
+    worker_t *w;
+    int i;
+
+    for (i = 0; i < WORKERS_MAX; i++)
+	if (workers[i] == NULL) break;
+    if (i == WORKERS_MAX) {
+	ERRLOG("SOUND: too many workers, rendering %s inline\n", name);
+	return(NULL);
+    }
+
+    w = (worker_t *)mem_alloc(sizeof(worker_t));
+    memset(w, 0x00, sizeof(worker_t));
+    w->name = name;
+    w->priv = priv;
+    w->write = write;
+    w->render = render;
+    w->block = block;
+    w->buflen = buflen;
+    w->buffer = (int32_t *)mem_alloc(buflen * sizeof(int32_t));
+    memset(w->buffer, 0x00, buflen * sizeof(int32_t));
+
+    w->wake = thread_create_event();
+    w->idle = thread_create_event();
+    w->running = 1;
+
+    w->thread = thread_create(worker_thread, w);
+    if (w->thread == NULL) {
+	ERRLOG("SOUND: unable to create %s worker, rendering inline\n", name);
+	thread_destroy_event(w->wake);
+	thread_destroy_event(w->idle);
+	free(w->buffer);
+	free(w);
+	return(NULL);
+    }
+
+    thread_wait_event(w->idle, -1);
+    thread_reset_event(w->idle);
+
+    workers[i] = w;
+    worker_enable = 1;
+
+    INFO("SOUND: %s synthesis running on worker thread\n", name);
+
+    return((sndworker_t *)w);
+}
+
+
+void
+sound_worker_close(sndworker_t *priv)
+{
+    worker_t *w = (worker_t *)priv;
+
+    int i, n = 0;
+
+    if (w == NULL)
+	return;
+
+    for (i = 0; i < WORKERS_MAX; i++) {
+	if (workers[i] == w)
+		workers[i] = NULL;
+	else if (workers[i] != NULL)
+		n++;
+    }
+    worker_enable = (n > 0);
+
+    w->running = 0;
+    thread_set_event(w->wake);
+    thread_wait(w->thread, -1);
+
+    INFO("SOUND: %s worker: %" PRIu64 " writes, %" PRIu64 " syncs, %" PRIu64 " stalls, %" PRIu32 " blocks\n",
+	 w->name, w->writes, w->syncs, w->stalls, w->blocks_done);
+
+    thread_destroy_event(w->wake);
+    thread_destroy_event(w->idle);
+    free(w->buffer);
+    free(w);
+}
+
+
+/* Queue a register write, stamped with the current position. */
+void
+sound_worker_write(sndworker_t *priv, uint16_t reg, uint32_t val)
+{
+    worker_t *w = (worker_t *)priv;
+
+    w->writes++;
+
+    worker_queue(w, sound_get_pos(), reg, val);
+}
+
+
+/*
+ * Wait until all queued writes have been applied.
+ *
+ * Used before register reads that depend on the synthesis state,
+ * after which the caller has the device to itself until it queues
+ * the next write.
+ */
+void
+sound_worker_sync(sndworker_t *priv)
+{
+    worker_t *w = (worker_t *)priv;
+
+    if (w->head == w->tail)
+	return;
+
+    w->syncs++;
+
+    worker_wait(w, 0);
+}
+
+
+/*
+ * End the current block, and collect it into 'out'.
+ *
+ * Thanks to the progress markers, the worker only has the tail end
+ * of the block left to render by now.
+ */
+void
+sound_worker_block(sndworker_t *priv, int32_t *out)
+{
+    worker_t *w = (worker_t *)priv;
+
+    worker_queue(w, SOUNDBUFLEN, WORKER_END, 0);
+    w->blocks_req++;
+
+    worker_wait(w, 0);
+
+    memcpy(out, w->buffer, w->buflen * sizeof(int32_t));
+}
+
+
 void
 sound_speed_changed(void)
 {
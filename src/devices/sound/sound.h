@@ -8,7 +8,7 @@
  *
  *		Definitions for the Sound Emulation core.
  *
- * Version:	@(#)sound.h	1.0.13	2021/06/03
+ * Version:	@(#)sound.h	1.0.18	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -43,17 +43,55 @@
 #define SOUNDBUFLEN	(48000/50)
 
 #define CD_FREQ		44100
-#define CD_BUFLEN	(CD_FREQ / 10)
+#define CD_BLOCKLEN	(CD_FREQ / 50)
 
 #define SOUND_NONE	0
 #define SOUND_INTERNAL	1
 
+/* Audio output sinks. */
+#define SOUND_SINK_OPENAL	0
+#define SOUND_SINK_NULL		1
+#define SOUND_SINK_WAV		2
+#define SOUND_SINK_RING		3
+
+/* Audio streams handed to the sink. */
+#define SOUND_STREAM_MAIN	0
+#define SOUND_STREAM_MIDI	1
+
+/*
+ * The shared ring buffer of the "ring" sink.
+ *
+ * This header is followed by 'size' bytes of ring, holding the main
+ * mix as interleaved stereo samples of the given format. The emulator
+ * only moves 'head' and the consumer only moves 'tail'; both count
+ * bytes, and wrap around. The data waiting is at (tail % size), and
+ * is (head - tail) bytes long. If 'open' goes to 0, the emulator has
+ * closed the ring, and the consumer should map it again by name.
+ */
+#define SNDRING_MAGIC	0x474e5253		// 'SRNG'
+#define SNDRING_SIZE	(256 * 1024)		// must be a power of 2
+
+typedef struct {
+    uint32_t	magic;			// SNDRING_MAGIC
+    uint32_t	size;			// size of the ring, in bytes
+    uint32_t	offset;			// start of the ring
+    uint32_t	rate;			// samples per second
+    uint16_t	channels,		// always 2
+		is_float;		// 32-bit float or 16-bit int
+    volatile uint32_t open;		// ring is in use
+    volatile uint32_t head;		// written by the emulator
+    volatile uint32_t tail;		// written by the consumer
+    volatile uint32_t drops;		// blocks the consumer missed
+} sndring_t;
+
+
+typedef void sndworker_t;
+
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-extern int	sound_pos_global;
 
 #ifdef EMU_DEVICE_H
 /* Sound card devices. */
@@ -104,6 +142,17 @@ extern void	sound_card_init(void);
 extern void	sound_card_reset(void);
 
 extern void	sound_speed_changed(void);
+extern int	sound_get_pos(void);
+
+extern sndworker_t	*sound_worker_init(const char *name, priv_t priv,
+				   int buflen,
+				   void (*write)(priv_t, uint16_t, uint32_t),
+				   void (*render)(priv_t, int pos),
+				   void (*block)(priv_t, int32_t *out));
+extern void	sound_worker_close(sndworker_t *);
+extern void	sound_worker_write(sndworker_t *, uint16_t reg, uint32_t val);
+extern void	sound_worker_sync(sndworker_t *);
+extern void	sound_worker_block(sndworker_t *, int32_t *out);
 
 extern void	sound_reset(void);
 extern void	sound_init(void);
@@ -112,11 +161,17 @@ extern void	sound_close(void);
 extern void	sound_cd_stop(void);
 extern void	sound_cd_set_volume(unsigned int vol_l, unsigned int vol_r);
 
+extern const char	*sound_sink_get_internal_name(int sink);
+extern int	sound_sink_get_from_internal_name(const char *s);
+extern void	sound_sink_init(void);
+extern void	sound_sink_reset(void);
+extern void	sound_sink_close(void);
+extern void	sound_sink_buffer(int stream, void *buf, int len);
+
 extern void	openal_close(void);
 extern void	openal_init(void);
 extern void	openal_reset(void);
 extern void	openal_buffer(void *buf);
-extern void	openal_buffer_cd(void *buf);
 extern void	openal_buffer_midi(void *buf, uint32_t size);
 extern void	openal_set_midi(int freq, int buf_size);
 
@@ -0,0 +1,508 @@
+/*
+ * VARCem	Virtual ARchaeological Computer EMulator.
+ *		An emulator of (mostly) x86-based PC systems and devices,
+ *		using the ISA,EISA,VLB,MCA  and PCI system buses, roughly
+ *		spanning the era between 1981 and 1995.
+ *
+ *		This file is part of the VARCem Project.
+ *
+ *		Audio output sinks.
+ *
+ *		The mixer and the MIDI synthesizers hand their finished
+ *		buffers to the selected sink, which can be the OpenAL
+ *		library (the default), a null sink that just throws them
+ *		away, a WAV file writer, or a ring buffer in shared
+ *		memory, from which other programs can read the main mix.
+ *
+ * Version:	@(#)sound_sink.c	1.0.6	2026/10/19
+ *
+ * Author:	agent, <agent@local>
+ *
+ *		Copyright 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free  Software  Foundation; either  version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is  distributed in the hope that it will be useful, but
+ * WITHOUT   ANY  WARRANTY;  without  even   the  implied  warranty  of
+ * MERCHANTABILITY  or FITNESS  FOR A PARTICULAR  PURPOSE. See  the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the:
+ *
+ *   Free Software Foundation, Inc.
+ *   59 Temple Place - Suite 330
+ *   Boston, MA 02111-1307
+ *   USA.
+ */
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <wchar.h>
+#ifdef _WIN32
+# define WIN32_LEAN_AND_MEAN
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <unistd.h>
+#endif
+#define dbglog sound_log
+#include "../../emu.h"
+#include "../../config.h"
+#include "../../plat.h"
+#include "../../misc/capture.h"
+#include "sound.h"
+
+
+#define RING_NAME	"VARCem.Sound"		/* default ring name */
+#ifdef _WIN32
+# define RING_PREFIX	""
+#else
+# define RING_PREFIX	"/"			/* shm_open() wants one */
+#endif
+
+
+typedef struct {
+    const char	*internal_name;
+    void	(*init)(void);
+    void	(*close)(void);
+    void	(*reset)(void);
+    void	(*buffer)(int stream, void *buf, int len);
+} sink_t;
+
+
+/* Standard RIFF/WAVE file header. */
+#pragma pack(push,1)
+typedef struct {
+    char	riff[4];
+    uint32_t	riff_len;
+    char	wave[4];
+    char	fmt[4];
+    uint32_t	fmt_len;
+    uint16_t	format,
+		channels;
+    uint32_t	rate,
+		byte_rate;
+    uint16_t	align,
+		bits;
+    char	data[4];
+    uint32_t	data_len;
+} wav_hdr_t;
+#pragma pack(pop)
+
+
+static const sink_t	*sink;
+static uint64_t		sink_blocks,
+			sink_samples;
+
+static FILE		*wav_fp;
+static uint32_t		wav_len;
+static int		wav_float,
+			wav_seq;
+
+static sndring_t	*ring = NULL;
+static uint8_t		*ring_buf;
+static size_t		ring_size;
+static char		ring_name[72];
+#ifdef _WIN32
+static HANDLE		ring_map = NULL;
+#endif
+
+
+static int
+sample_size(void)
+{
+    return(config.sound_is_float ? sizeof(float) : sizeof(int16_t));
+}
+
+
+static void
+openal_sink_buffer(int stream, void *buf, int len)
+{
+    switch (stream) {
+	case SOUND_STREAM_MAIN:
+		openal_buffer(buf);
+		break;
+
+	case SOUND_STREAM_MIDI:
+		openal_buffer_midi(buf, len);
+		break;
+    }
+}
+
+
+static void
+null_sink_init(void)
+{
+    INFO("SOUND: using null output, audio is discarded\n");
+}
+
+
+static void
+null_sink_close(void)
+{
+}
+
+
+static void
+null_sink_reset(void)
+{
+}
+
+
+static void
+null_sink_buffer(UNUSED(int stream), UNUSED(void *buf), UNUSED(int len))
+{
+}
+
+
+/* Write (or re-write) the WAV header for the current length. */
+static void
+wav_header(void)
+{
+    wav_hdr_t hdr;
+
+    memcpy(hdr.riff, "RIFF", 4);
+    hdr.riff_len = sizeof(hdr) - 8 + wav_len;
+    memcpy(hdr.wave, "WAVE", 4);
+    memcpy(hdr.fmt, "fmt ", 4);
+    hdr.fmt_len = 16;
+    hdr.format = wav_float ? 3 : 1;		/* IEEE float or PCM */
+    hdr.channels = 2;
+    hdr.rate = 48000;
+    hdr.bits = (wav_float ? sizeof(float) : sizeof(int16_t)) * 8;
+    hdr.align = hdr.channels * (hdr.bits / 8);
+    hdr.byte_rate = hdr.rate * hdr.align;
+    memcpy(hdr.data, "data", 4);
+    hdr.data_len = wav_len;
+
+    (void)fseek(wav_fp, 0, SEEK_SET);
+    (void)fwrite(&hdr, 1, sizeof(hdr), wav_fp);
+    (void)fseek(wav_fp, 0, SEEK_END);
+}
+
+
+/*
+ * Open the next WAV file.
+ *
+ * The first one uses the configured name as-is, any following
+ * ones (after a format change, or when a file is full) get a
+ * sequence number added before the extension.
+ */
+static void
+wav_open(void)
+{
+    wchar_t temp[1024];
+    const wchar_t *ext;
+
+    if (wav_seq == 0) {
+	wcsncpy(temp, config.sound_file, sizeof_w(temp) - 1);
+	temp[sizeof_w(temp) - 1] = L'\0';
+    } else {
+	ext = wcsrchr(config.sound_file, L'.');
+	if (ext == NULL)
+		ext = config.sound_file + wcslen(config.sound_file);
+	swprintf(temp, sizeof_w(temp), L"%.*ls-%i%ls",
+		 (int)(ext - config.sound_file), config.sound_file,
+		 wav_seq, ext);
+    }
+    wav_seq++;
+
+    wav_fp = plat_fopen(temp, L"wb");
+    if (wav_fp == NULL) {
+	ERRLOG("SOUND: unable to create WAV file '%ls'\n", temp);
+	return;
+    }
+
+    wav_float = config.sound_is_float;
+    wav_len = 0;
+    wav_header();
+
+    INFO("SOUND: recording to '%ls'\n", temp);
+}
+
+
+static void
+wav_sink_init(void)
+{
+    if (config.sound_file[0] == L'\0') {
+	ERRLOG("SOUND: no file set for WAV output, audio is discarded\n");
+	return;
+    }
+
+    wav_seq = 0;
+    wav_open();
+}
+
+
+static void
+wav_sink_close(void)
+{
+    if (wav_fp == NULL) return;
+
+    wav_header();
+    (void)fclose(wav_fp);
+    wav_fp = NULL;
+
+    INFO("SOUND: WAV file closed, %" PRIu32 " bytes of audio\n", wav_len);
+}
+
+
+/* Keep recording into the same file, unless the format changed. */
+static void
+wav_sink_reset(void)
+{
+    if (wav_fp == NULL) return;
+
+    if (wav_float == config.sound_is_float) {
+	wav_header();
+	(void)fflush(wav_fp);
+	return;
+    }
+
+    wav_sink_close();
+    wav_open();
+}
+
+
+/* Only the main mix is recorded, the other streams have their own rates. */
+static void
+wav_sink_buffer(int stream, void *buf, int len)
+{
+    if ((wav_fp == NULL) || (stream != SOUND_STREAM_MAIN)) return;
+
+    /* The RIFF lengths are 32 bits, so go on in a new file when full. */
+    len *= sample_size();
+    if ((uint32_t)len > (UINT32_MAX - (sizeof(wav_hdr_t) - 8) - wav_len)) {
+	wav_sink_close();
+	wav_open();
+	if (wav_fp == NULL) return;
+    }
+
+    (void)fwrite(buf, 1, len, wav_fp);
+    wav_len += len;
+}
+
+
+/*
+ * Set up the ring in shared memory, under the configured name, so
+ * other programs can map it and read the main mix from it.
+ */
+static void
+ring_sink_init(void)
+{
+    const char *name = config.sound_ring_name;
+    sndring_t *ptr = NULL;
+    size_t size;
+
+    if (*name == '\0')
+	name = RING_NAME;
+    snprintf(ring_name, sizeof(ring_name), RING_PREFIX "%s", name);
+    size = sizeof(sndring_t) + SNDRING_SIZE;
+
+#ifdef _WIN32
+    ring_map = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL,
+				  PAGE_READWRITE,
+				  (DWORD)((uint64_t)size >> 32),
+				  (DWORD)size, ring_name);
+    if (ring_map != NULL) {
+	ptr = (sndring_t *)MapViewOfFile(ring_map, FILE_MAP_ALL_ACCESS,
+					 0, 0, size);
+	if (ptr == NULL) {
+		CloseHandle(ring_map);
+		ring_map = NULL;
+	}
+    }
+#else
+    {
+	int fd;
+
+	fd = shm_open(ring_name, O_CREAT | O_RDWR, 0600);
+	if (fd >= 0) {
+		if (ftruncate(fd, size) == 0) {
+			ptr = (sndring_t *)mmap(NULL, size,
+						PROT_READ | PROT_WRITE,
+						MAP_SHARED, fd, 0);
+			if (ptr == (sndring_t *)MAP_FAILED)
+				ptr = NULL;
+		}
+		(void)close(fd);
+
+		if (ptr == NULL)
+			(void)shm_unlink(ring_name);
+	}
+    }
+#endif
+
+    if (ptr == NULL) {
+	ERRLOG("SOUND: unable to share ring buffer '%s', no output!\n", ring_name);
+	return;
+    }
+
+    memset(ptr, 0x00, sizeof(sndring_t));
+    ptr->magic = SNDRING_MAGIC;
+    ptr->size = SNDRING_SIZE;
+    ptr->offset = sizeof(sndring_t);
+    ptr->rate = 48000;
+    ptr->channels = 2;
+    ptr->is_float = config.sound_is_float ? 1 : 0;
+    ring_buf = (uint8_t *)ptr + ptr->offset;
+    ring_size = size;
+
+    thread_barrier();
+    ptr->open = 1;
+    ring = ptr;
+
+    INFO("SOUND: main mix goes to a %i KB ring buffer, shared as '%s'\n",
+	 SNDRING_SIZE / 1024, ring_name);
+}
+
+
+static void
+ring_sink_close(void)
+{
+    if (ring == NULL) return;
+
+    ring->open = 0;
+    thread_barrier();
+
+    INFO("SOUND: ring buffer closed, %" PRIu32 " blocks dropped\n", ring->drops);
+
+    /* A consumer still has its own mapping, this only drops ours. */
+#ifdef _WIN32
+    (void)UnmapViewOfFile(ring);
+    CloseHandle(ring_map);
+    ring_map = NULL;
+#else
+    (void)munmap(ring, ring_size);
+    (void)shm_unlink(ring_name);
+#endif
+    ring = NULL;
+    ring_buf = NULL;
+}
+
+
+static void
+ring_sink_reset(void)
+{
+    if (ring == NULL) return;
+
+    ring->head = ring->tail;
+}
+
+
+/*
+ * Add a block to the ring.
+ *
+ * If the consumer does not keep up, the block is dropped, as
+ * we never want the emulation to wait for it.
+ */
+static void
+ring_sink_buffer(int stream, void *buf, int len)
+{
+    uint32_t head, off, n;
+
+    if ((ring == NULL) || (stream != SOUND_STREAM_MAIN)) return;
+
+    head = ring->head;
+    len *= sample_size();
+    if ((uint32_t)len > (SNDRING_SIZE - (head - ring->tail))) {
+	ring->drops++;
+	return;
+    }
+
+    off = head & (SNDRING_SIZE - 1);
+    n = SNDRING_SIZE - off;
+    if (n > (uint32_t)len)
+	n = len;
+    memcpy(&ring_buf[off], buf, n);
+    if (n < (uint32_t)len)
+	memcpy(ring_buf, (uint8_t *)buf + n, len - n);
+
+    /* Make sure the data is stored before we publish it. */
+    thread_barrier();
+    ring->head = head + len;
+}
+
+
+static const sink_t sinks[] = {
+  { "openal",
+    openal_init, openal_close, openal_reset, openal_sink_buffer		},
+  { "null",
+    null_sink_init, null_sink_close, null_sink_reset, null_sink_buffer	},
+  { "wav",
+    wav_sink_init, wav_sink_close, wav_sink_reset, wav_sink_buffer	},
+  { "ring",
+    ring_sink_init, ring_sink_close, ring_sink_reset, ring_sink_buffer	},
+  { NULL								}
+};
+
+
+const char *
+sound_sink_get_internal_name(int id)
+{
+    return(sinks[id].internal_name);
+}
+
+
+int
+sound_sink_get_from_internal_name(const char *s)
+{
+    int c = 0;
+
+    while (sinks[c].internal_name != NULL) {
+	if (! strcmp(sinks[c].internal_name, s))
+		return(c);
+	c++;
+    }
+
+    /* Not found, use the default. */
+    return(SOUND_SINK_OPENAL);
+}
+
+
+void
+sound_sink_init(void)
+{
+    sink = &sinks[config.sound_output];
+
+    sink->init();
+}
+
+
+void
+sound_sink_reset(void)
+{
+    sink->reset();
+}
+
+
+void
+sound_sink_close(void)
+{
+    sink->close();
+
+    INFO("SOUND: %s output: %" PRIu64 " blocks, %" PRIu64 " samples\n",
+	 sink->internal_name, sink_blocks, sink_samples);
+}
+
+
+/* Hand a buffer of 'len' samples (both channels) to the sink. */
+void
+sound_sink_buffer(int stream, void *buf, int len)
+{
+    if (stream == SOUND_STREAM_MAIN) {
+	sink_blocks++;
+	sink_samples += len;
+
+	capture_audio(buf, len);
+    }
+
+    sink->buffer(stream, buf, len);
+}
@@ -8,7 +8,7 @@
  *
  *		Implementation of the Intel DMA controllers.
  *
- * Version:	@(#)dma.c	1.0.12	2019/05/17
+ * Version:	@(#)dma.c	1.0.15	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -939,6 +939,118 @@ dma_channel_write(int channel, uint16_t val)
 }
 
 
+/*
+ * Block transfers.
+ *
+ * These move as many units as they can in one go between a device
+ * buffer and memory, up to 'len' bytes, the terminal count, or the
+ * point where the address counter wraps around. The channel checks,
+ * address update and terminal count handling are done once for the
+ * whole block, instead of for every byte or word.
+ *
+ * The return value is the number of bytes moved, ORed with DMA_OVER
+ * if the terminal count was reached, or DMA_NODATA if the channel is
+ * not ready for this transfer. Callers loop until they are done.
+ */
+static int
+dma_block(int channel, uint8_t *buf, int len, int to_mem)
+{
+    dma_t *dma_c = &dma[channel];
+    uint32_t addr, wrap, mask;
+    int unit, units, left, i;
+
+    if (((channel < 4) ? dma_command : dma16_command) & 0x04)
+	return(DMA_NODATA);
+    if (dma_m & (1 << channel))
+	return(DMA_NODATA);
+    if ((dma_c->mode & 0x0c) != (to_mem ? 4 : 8))
+	return(DMA_NODATA);
+
+    unit = dma_c->size ? 2 : 1;
+    if (len > DMA_BLOCK_MAX)
+	len = DMA_BLOCK_MAX;
+    units = len / unit;
+    if (units > (dma_c->cc + 1))
+	units = dma_c->cc + 1;
+
+    /* The AT-style controllers wrap within a 64K (or 128K) page. */
+    if (! dma_ps2.is_ps2) {
+	mask = dma_c->size ? 0x1ffff : 0xffff;
+	if (dma_c->mode & 0x20)
+		left = ((dma_c->ac & mask) / unit) + 1;
+	  else
+		left = ((mask + 1) - (dma_c->ac & mask)) / unit;
+	if (units > left)
+		units = left;
+    } else
+	mask = 0xffffffff;
+    if (units <= 0)
+	return(DMA_NODATA);
+
+    if (! AT) {
+	for (i = 0; i < units; i++)
+		refreshread();
+    }
+
+    len = units * unit;
+    if (dma_c->mode & 0x20) {
+	/* Decrementing, units are still stored low byte first. */
+	for (i = 0; i < len; i += unit) {
+		if (to_mem)
+			mem_write_phys_block(dma_c->ac - i, &buf[i], unit);
+		  else
+			mem_read_phys_block(dma_c->ac - i, &buf[i], unit);
+	}
+	addr = dma_c->ac - len + unit;
+	wrap = dma_c->ac - len;
+    } else {
+	/* Incrementing, the whole block is one run. */
+	addr = dma_c->ac;
+	if (to_mem)
+		mem_write_phys_block(addr, buf, len);
+	  else
+		mem_read_phys_block(addr, buf, len);
+	wrap = dma_c->ac + len;
+    }
+    if (to_mem)
+	mem_invalidate_range(addr, addr + len - 1);
+
+    dma_c->ac = (dma_c->ac & ~mask) | (wrap & mask);
+
+    dma_stat_rq |= (1 << channel);
+
+    dma_c->cc -= units;
+    if (dma_c->cc < 0) {
+	if (dma_c->mode & 0x10) { /*Auto-init*/
+		dma_c->cc = dma_c->cb;
+		dma_c->ac = dma_c->ab;
+	} else
+		dma_m |= (1 << channel);
+	dma_stat |= (1 << channel);
+
+	return(len | DMA_OVER);
+    }
+
+    return(len);
+}
+
+
+/* Move data from memory to the device. */
+int
+dma_channel_read_block(int channel, uint8_t *buf, int len)
+{
+    return(dma_block(channel, buf, len, 0));
+}
+
+
+/* Move data from the device to memory. */
+int
+dma_channel_write_block(int channel, const uint8_t *buf, int len)
+{
+    return(dma_block(channel, (uint8_t *)buf, len, 1));
+}
+
+
 int
 dma_mode(int channel)
 {
@@ -953,29 +1065,16 @@ dma_mode(int channel)
 void
 DMAPageRead(uint32_t PhysAddress, uint8_t *DataRead, uint32_t TotalSize)
 {
-    uint32_t i = 0;
-
-#if 0
-    memcpy(DataRead, &ram[PhysAddress], TotalSize);
-#else
-    for (i = 0; i < TotalSize; i++)
-	DataRead[i] = mem_readb_phys(PhysAddress + i);
-#endif
+    mem_read_phys_block(PhysAddress, DataRead, TotalSize);
 }
 
 
 void
 DMAPageWrite(uint32_t PhysAddress, const uint8_t *DataWrite, uint32_t TotalSize)
 {
-    uint32_t i = 0;
+    if (TotalSize == 0) return;
 
-#if 0
-    mem_invalidate_range(PhysAddress, PhysAddress + TotalSize - 1);
-    memcpy(&ram[PhysAddress], DataWrite, TotalSize);
-#else
-    for (i = 0; i < TotalSize; i++)
-	mem_writeb_phys(PhysAddress + i, DataWrite[i]);
+    mem_write_phys_block(PhysAddress, DataWrite, TotalSize);
 
     mem_invalidate_range(PhysAddress, PhysAddress + TotalSize - 1);
-#endif
 }
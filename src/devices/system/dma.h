@@ -8,7 +8,7 @@
  *
  *		Definitions for the Intel DMA controller.
  *
- * Version:	@(#)dma.h	1.0.4	2019/05/17
+ * Version:	@(#)dma.h	1.0.5	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -43,6 +43,7 @@
 #define DMA_NODATA	-1
 #define DMA_OVER	0x10000
 #define DMA_VERIFY	0x20000
+#define DMA_BLOCK_MAX	0x8000		/* max bytes per block call */
 
 
 typedef struct {
@@ -76,6 +77,9 @@ extern void	dma_set_drq(int channel, int set);
 
 extern int	dma_channel_read(int channel);
 extern int	dma_channel_write(int channel, uint16_t val);
+extern int	dma_channel_read_block(int channel, uint8_t *buf, int len);
+extern int	dma_channel_write_block(int channel, const uint8_t *buf,
+					int len);
 
 extern void	DMAPageRead(uint32_t PhysAddress, uint8_t *DataRead,
 			    uint32_t TotalSize);
@@ -12,7 +12,7 @@
  *		    word 0 - base address
  *		    word 1 - bits 1-15 = byte count, bit 31 = end of transfer
  *
- * Version:	@(#)intel_piix.c	1.0.13	2019/05/17
+ * Version:	@(#)intel_piix.c	1.0.14	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -609,35 +609,50 @@ piix_bus_master_readl(uint16_t port, priv_t priv)
 }
 
 
+/* Where piix_bus_master_dma_op() moves the data to or from. */
+typedef struct {
+    uint8_t	*data;
+    int		out;
+} piix_copy_t;
+
+
+/* Copy one PRD region between guest memory and a linear buffer. */
+static void
+piix_bus_master_copy(uint32_t addr, int pos, int len, priv_t arg)
+{
+    piix_copy_t *cp = (piix_copy_t *)arg;
+
+    if (cp->out)
+	DMAPageWrite(addr, cp->data + pos, len);
+    else
+	DMAPageRead(addr, cp->data + pos, len);
+}
+
+
+/*
+ * Walk the PRD table for a transfer of 'transfer_length' bytes,
+ * handing each region (or the part of it this transfer uses) to
+ * 'func', along with its offset into the transfer.
+ */
 static int
-piix_bus_master_dma_op(int channel, uint8_t *data, int transfer_length, int out, priv_t priv)
+piix_bus_master_walk(piix_busmaster_t *dev, int transfer_length,
+		     void (*func)(uint32_t addr, int pos, int len, priv_t arg),
+		     priv_t arg)
 {
-    piix_busmaster_t *dev = (piix_busmaster_t *)priv;
     int force_end = 0, buffer_pos = 0;
-#ifdef _LOGGING
-    char *sop = out ? "Writ" : "Read";
-#endif
 
     if (! (dev->status & 1))
 	return 2;                                    /*DMA disabled*/
 
-    DBGLOG(1, "PIIX Bus master %s: %i bytes\n", out ? "read" : "write", transfer_length);
-
     while (1) {
 	if (dev->count <= transfer_length) {
-		DBGLOG(1, "%sing %i bytes to %08X\n", sop, dev->count, dev->addr);
-		if (out)
-			DMAPageWrite(dev->addr, (uint8_t *)(data + buffer_pos), dev->count);
-		else
-			DMAPageRead(dev->addr, (uint8_t *)(data + buffer_pos), dev->count);
+		DBGLOG(1, "Moving %i bytes at %08X\n", dev->count, dev->addr);
+		func(dev->addr, buffer_pos, dev->count, arg);
 		transfer_length -= dev->count;
 		buffer_pos += dev->count;
 	} else {
-		DBGLOG(1, "%sing %i bytes to %08X\n", sop, transfer_length, dev->addr);
-		if (out)
-			DMAPageWrite(dev->addr, (uint8_t *)(data + buffer_pos), transfer_length);
-		else
-			DMAPageRead(dev->addr, (uint8_t *)(data + buffer_pos), transfer_length);
+		DBGLOG(1, "Moving %i bytes at %08X\n", transfer_length, dev->addr);
+		func(dev->addr, buffer_pos, transfer_length, arg);
 		/* Increase addr and decrease count so that resumed transfers do not mess up. */
 		dev->addr += transfer_length;
 		dev->count -= transfer_length;
@@ -672,6 +687,21 @@ piix_bus_master_dma_op(int channel, uint8_t *data, int transfer_length, int out,
 }
 
 
+static int
+piix_bus_master_dma_op(int channel, uint8_t *data, int transfer_length, int out, priv_t priv)
+{
+    piix_busmaster_t *dev = (piix_busmaster_t *)priv;
+    piix_copy_t cp;
+
+    DBGLOG(1, "PIIX Bus master %s: %i bytes\n", out ? "read" : "write", transfer_length);
+
+    cp.data = data;
+    cp.out = out;
+
+    return piix_bus_master_walk(dev, transfer_length, piix_bus_master_copy, &cp);
+}
+
+
 int
 piix_bus_master_dma_read(int channel, uint8_t *data, int transfer_length, priv_t priv)
 {
@@ -686,6 +716,23 @@ piix_bus_master_dma_write(int channel, uint8_t *data, int transfer_length, priv_
 }
 
 
+/*
+ * Scatter/gather version, for drives that can move each region
+ * straight between their media and guest memory themselves.
+ */
+int
+piix_bus_master_dma_sg(int channel, int transfer_length,
+		       void (*func)(uint32_t addr, int pos, int len, priv_t arg),
+		       priv_t arg, priv_t priv)
+{
+    piix_busmaster_t *dev = (piix_busmaster_t *)priv;
+
+    DBGLOG(1, "PIIX Bus master S/G: %i bytes\n", transfer_length);
+
+    return piix_bus_master_walk(dev, transfer_length, func, arg);
+}
+
+
 void
 piix_bus_master_set_irq(int channel, priv_t priv)
 {
@@ -857,6 +904,7 @@ piix_init(const device_t *info, UNUSED(void *parent))
 
     ide_set_bus_master(piix_bus_master_dma_read, piix_bus_master_dma_write,
 		       piix_bus_master_set_irq, &dev->bm[0], &dev->bm[1]);
+    ide_set_bus_master_sg(piix_bus_master_dma_sg);
 
     device_add_parent(&port92_device, (priv_t)dev);
 
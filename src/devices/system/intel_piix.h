@@ -8,7 +8,7 @@
  *
  *		Emulation of the Intel PIIX and PIIX3 Xcelerators.
  *
- * Version:	@(#)intel_piix.h	1.0.3	2019/05/13
+ * Version:	@(#)intel_piix.h	1.0.4	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -49,6 +49,9 @@ extern const device_t piix_pb640_device;
 
 extern int	piix_bus_master_dma_read(int channel, uint8_t *data, int transfer_length, priv_t priv);
 extern int	piix_bus_master_dma_write(int channel, uint8_t *data, int transfer_length, priv_t priv);
+extern int	piix_bus_master_dma_sg(int channel, int transfer_length,
+				       void (*func)(uint32_t addr, int pos, int len, priv_t arg),
+				       priv_t arg, priv_t priv);
 
 extern void	piix_bus_master_set_irq(int channel, priv_t priv);
 
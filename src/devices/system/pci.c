@@ -8,7 +8,7 @@
  *
  *		Implement the PCI bus.
  *
- * Version:	@(#)pci.c	1.0.13	2021/09/30
+ * Version:	@(#)pci.c	1.0.14	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -129,55 +129,151 @@ pci_cf8_read(UNUSED(uint16_t port), UNUSED(priv_t priv))
 }
 
 
+/* Find the card selected by the current CONFIG_ADDRESS, if any. */
+static pci_card_t *
+pci_selected(void)
+{
+    uint8_t slot;
+
+    if (!pci_enable || pci_bus)
+	return NULL;
+
+    slot = pci_card_to_slot_mapping[pci_card];
+    if (slot == 0xff)
+	return NULL;
+
+    return &pci_cards[slot];
+}
+
+
 static void
 pci_write(uint16_t port, uint8_t val, UNUSED(priv_t priv))
 {
-    uint8_t slot = 0;
+    pci_card_t *dev = pci_selected();
 
-    switch (port) {
-	case 0xcfc: case 0xcfd: case 0xcfe: case 0xcff:
-		if (! pci_enable) 
-			return;
-		   
-		if (! pci_bus) {
-			slot = pci_card_to_slot_mapping[pci_card];
-			if (slot != 0xff) {
-				if (pci_cards[slot].write) {
-					DBGLOG(1, "PCI: writing card on slot %02X (pci_cards[%i])...\n", pci_card, slot);
-					pci_cards[slot].write(pci_func, pci_index | (port & 3), val, pci_cards[slot].priv);
-				}
-			}
-		}
-		
-		break;
+    if ((dev != NULL) && dev->write) {
+	DBGLOG(1, "PCI: writing card on slot %02X...\n", pci_card);
+	dev->write(pci_func, pci_index | (port & 3), val, dev->priv);
     }
 }
 
 
+/*
+ * Word and dword accesses are decoded only once, and then
+ * handed to the card as a series of byte accesses. Accesses
+ * that run past 0xCFF are split up like io.c would do.
+ */
+static void
+pci_writew(uint16_t port, uint16_t val, priv_t priv)
+{
+    pci_card_t *dev;
+    int addr;
+
+    if ((port & 3) == 3) {
+	pci_write(port, val & 0xff, priv);
+	outb(port + 1, val >> 8);
+	return;
+    }
+
+    dev = pci_selected();
+    if ((dev == NULL) || !dev->write)
+	return;
+
+    DBGLOG(1, "PCI: writing card on slot %02X (word)...\n", pci_card);
+    addr = pci_index | (port & 3);
+    dev->write(pci_func, addr, val & 0xff, dev->priv);
+    dev->write(pci_func, addr + 1, val >> 8, dev->priv);
+}
+
+
+static void
+pci_writel(uint16_t port, uint32_t val, priv_t priv)
+{
+    pci_card_t *dev;
+    int addr;
+
+    if (port & 3) {
+	pci_writew(port, val & 0xffff, priv);
+	outw(port + 2, val >> 16);
+	return;
+    }
+
+    dev = pci_selected();
+    if ((dev == NULL) || !dev->write)
+	return;
+
+    DBGLOG(1, "PCI: writing card on slot %02X (dword)...\n", pci_card);
+    addr = pci_index;
+    dev->write(pci_func, addr, val & 0xff, dev->priv);
+    dev->write(pci_func, addr + 1, (val >> 8) & 0xff, dev->priv);
+    dev->write(pci_func, addr + 2, (val >> 16) & 0xff, dev->priv);
+    dev->write(pci_func, addr + 3, val >> 24, dev->priv);
+}
+
+
 static uint8_t
 pci_read(uint16_t port, UNUSED(priv_t priv))
 {
-    uint8_t slot = 0;
+    pci_card_t *dev = pci_selected();
 
-    switch (port) {
-	case 0xcfc: case 0xcfd: case 0xcfe: case 0xcff:
-		if (! pci_enable) 
-			return 0xff;
-
-		if (! pci_bus) {
-			slot = pci_card_to_slot_mapping[pci_card];
-			if (slot != 0xff) {
-				if (pci_cards[slot].read) {
-					DBGLOG(1, "PCI: reading from card on slot %02X (pci_cards[%i]) (%02X:%02X)...\n", pci_card, slot, pci_func, pci_index);
-					return pci_cards[slot].read(pci_func, pci_index | (port & 3), pci_cards[slot].priv);
-				}
-			}
-		}
+    if ((dev == NULL) || !dev->read)
+	return 0xff;
+
+    DBGLOG(1, "PCI: reading from card on slot %02X (%02X:%02X)...\n", pci_card, pci_func, pci_index);
+
+    return dev->read(pci_func, pci_index | (port & 3), dev->priv);
+}
+
+
+static uint16_t
+pci_readw(uint16_t port, priv_t priv)
+{
+    pci_card_t *dev;
+    uint16_t ret;
+    int addr;
 
-		return 0xff;
+    if ((port & 3) == 3) {
+	ret = pci_read(port, priv);
+	return ret | (inb(port + 1) << 8);
     }
 
-    return 0xff;
+    dev = pci_selected();
+    if ((dev == NULL) || !dev->read)
+	return 0xffff;
+
+    DBGLOG(1, "PCI: reading from card on slot %02X (%02X:%02X) (word)...\n", pci_card, pci_func, pci_index);
+    addr = pci_index | (port & 3);
+    ret = dev->read(pci_func, addr, dev->priv);
+    ret |= dev->read(pci_func, addr + 1, dev->priv) << 8;
+
+    return ret;
+}
+
+
+static uint32_t
+pci_readl(uint16_t port, priv_t priv)
+{
+    pci_card_t *dev;
+    uint32_t ret;
+    int addr;
+
+    if (port & 3) {
+	ret = pci_readw(port, priv);
+	return ret | ((uint32_t)inw(port + 2) << 16);
+    }
+
+    dev = pci_selected();
+    if ((dev == NULL) || !dev->read)
+	return 0xffffffff;
+
+    DBGLOG(1, "PCI: reading from card on slot %02X (%02X:%02X) (dword)...\n", pci_card, pci_func, pci_index);
+    addr = pci_index;
+    ret = dev->read(pci_func, addr, dev->priv);
+    ret |= dev->read(pci_func, addr + 1, dev->priv) << 8;
+    ret |= dev->read(pci_func, addr + 2, dev->priv) << 16;
+    ret |= (uint32_t)dev->read(pci_func, addr + 3, dev->priv) << 24;
+
+    return ret;
 }
 
 
@@ -667,7 +763,8 @@ pci_init(int type)
 	io_sethandler(0x0cf8, 1,
 		      NULL,NULL,pci_cf8_read, NULL,NULL,pci_cf8_write, NULL);
 	io_sethandler(0x0cfc, 4,
-		      pci_read,NULL,NULL, pci_write,NULL,NULL, NULL);
+		      pci_read,pci_readw,pci_readl,
+		      pci_write,pci_writew,pci_writel, NULL);
     } else {
 	io_sethandler(0x0cf8, 1,
 		      pci_type2_read,NULL,NULL, pci_type2_write,NULL,NULL, NULL);
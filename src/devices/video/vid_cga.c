@@ -8,7 +8,7 @@
  *
  *		Emulation of the old and new IBM CGA graphics cards.
  *
- * Version:	@(#)vid_cga.c	1.0.21	2021/05/24
+ * Version:	@(#)vid_cga.c	1.0.22	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -164,6 +164,8 @@ cga_out(uint16_t port, uint8_t val, priv_t priv)
 		if (old != val) {
 			if ((dev->crtcreg < 0x0e) || (dev->crtcreg > 0x10)) {
 				fullchange = changeframecount;
+				if ((dev->crtcreg < 0x0c) || (dev->crtcreg > 0x0d))
+					dev->fullchange = changeframecount;
 				cga_recalctimings(dev);
 			}
 		}
@@ -173,6 +175,7 @@ cga_out(uint16_t port, uint8_t val, priv_t priv)
 		old = dev->cgamode;
 		dev->cgamode = val;
 		if (old ^ val) {
+			dev->fullchange = changeframecount;
 			if (((old ^ val) & 0x05) && dev->cpriv)
 				cga_comp_update(dev->cpriv, val);
 			cga_recalctimings(dev);
@@ -271,18 +274,35 @@ cga_hline(bitmap_t *b, int x1, int y, int x2, uint8_t col)
 }
 
 
+/*
+ * Lines are drawn as colors, so that cells which did not change can
+ * be left alone. The composite decoder wants the palette indices.
+ */
+static uint32_t
+cga_pel(cga_t *dev, int col)
+{
+    if (dev->composite)
+	return(col);
+
+    return(pal_lookup[col]);
+}
+
+
 void
 cga_poll(priv_t priv)
 {
     cga_t *dev = (cga_t *)priv;
     uint16_t ca = (dev->crtc[15] | (dev->crtc[14] << 8)) & 0x3fff;
-    int drawcursor;
-    int x, c;
+    int drawcursor, newrow;
+    int x, c, o, w;
     int oldvc;
-    uint8_t chr, attr;
+    uint8_t chr, attr, flags;
     uint8_t border;
     uint16_t dat;
-    int cols[4];
+    uint32_t cols[4];
+    uint32_t fg, bg;
+    const uint32_t *m;
+    pel_t *p0, *p1;
     int col;
     int oldsc;
 
@@ -295,6 +315,13 @@ cga_poll(priv_t priv)
 	if ((dev->crtc[8] & 3) == 3) 
 		dev->sc = ((dev->sc << 1) + dev->oddeven) & 7;
 
+	p0 = screen->line[dev->displine << 1];
+	p1 = screen->line[(dev->displine << 1) + 1];
+	if (dev->cgamode & 1)
+		w = dev->crtc[1] << 3;
+	else
+		w = dev->crtc[1] << 4;
+
 	if (dev->cgadispon) {
 		if (dev->displine < dev->firstline) {
 			dev->firstline = dev->displine;
@@ -302,91 +329,71 @@ cga_poll(priv_t priv)
 		}
 		dev->lastline = dev->displine;
 
-		for (c = 0; c < 8; c++) {
-			if ((dev->cgamode & 0x12) == 0x12) {
-				screen->line[(dev->displine << 1)][c].pal =
-				screen->line[(dev->displine << 1) + 1][c].pal = 0;
-				if (dev->cgamode & 1) {
-					screen->line[(dev->displine << 1)][c + (dev->crtc[1] << 3) + 8].pal =
-					screen->line[(dev->displine << 1) + 1][c + (dev->crtc[1] << 3) + 8].pal = 0;
-				} else {
-					screen->line[(dev->displine << 1)][c + (dev->crtc[1] << 4) + 8].pal =
-					screen->line[(dev->displine << 1) + 1][c + (dev->crtc[1] << 4) + 8].pal = 0;
-				}
-			} else {
-				screen->line[(dev->displine << 1)][c].pal =
-				screen->line[(dev->displine << 1) + 1][c].pal = (dev->cgacol & 15) + 16;
-				if (dev->cgamode & 1) {
-					screen->line[(dev->displine << 1)][c + (dev->crtc[1] << 3) + 8].pal =
-					screen->line[(dev->displine << 1) + 1][c + (dev->crtc[1] << 3) + 8].pal = (dev->cgacol & 15) + 16;
-				} else {
-					screen->line[(dev->displine << 1)][c + (dev->crtc[1] << 4) + 8].pal =
-					screen->line[(dev->displine << 1) + 1][c + (dev->crtc[1] << 4) + 8].pal = (dev->cgacol & 15) + 16;
-				}
-			}
-		}
-
-		if (dev->cgamode & 1) {
-			for (x = 0; x < dev->crtc[1]; x++) {
-				if (dev->cgamode & 8) {	
+		if ((dev->cgamode & 0x12) == 0x12)
+			cols[0] = cga_pel(dev, 0);
+		else
+			cols[0] = cga_pel(dev, (dev->cgacol & 15) + 16);
+		for (c = 0; c < 8; c++)
+			p0[c].val = p1[c].val = p0[c + w + 8].val = p1[c + w + 8].val = cols[0];
+
+		if (! (dev->cgamode & 2)) {
+			/*
+			 * Only draw the cells that changed since the last frame.
+			 * The composite decoder needs the whole line, and snow
+			 * changes the cells from one scan line to the next.
+			 */
+			newrow = text_row(&dev->text, dev->ma, dev->displine,
+					  dev->fullchange || dev->composite || dev->snow_enabled);
+			if (!newrow && !dev->text.dirty)
+				x = dev->crtc[1];
+			else
+				x = 0;
+			dev->ma += x;
+
+			for (; x < dev->crtc[1]; x++) {
+				if (! (dev->cgamode & 8))
+					chr = attr = 0;
+				else if (dev->cgamode & 1) {
 					chr = dev->charbuffer[x << 1];
 					attr = dev->charbuffer[(x << 1) + 1];
-				} else
-					chr = attr = 0;
-				drawcursor = ((dev->ma == ca) && dev->con && dev->cursoron);
-				cols[1] = (attr & 15) + 16;
-				if (dev->cgamode & 0x20) {
-					cols[0] = ((attr >> 4) & 7) + 16;
-					if ((dev->cgablink & 8) && (attr & 0x80) && !dev->drawcursor) 
-						cols[1] = cols[0];
-				} else
-					cols[0] = (attr >> 4) + 16;
-				if (drawcursor) {
-					for (c = 0; c < 8; c++) {
-						screen->line[(dev->displine << 1)][(x << 3) + c + 8].pal =
-						screen->line[(dev->displine << 1) + 1][(x << 3) + c + 8].pal =
-							cols[(fontdat[chr + dev->fontbase][dev->sc & 7] & (1 << (c ^ 7))) ? 1 : 0] ^ 15;
-					}
 				} else {
-					for (c = 0; c < 8; c++) {
-						screen->line[(dev->displine << 1)][(x << 3) + c + 8].pal =
-						screen->line[(dev->displine << 1) + 1][(x << 3) + c + 8].pal =
-							cols[(fontdat[chr + dev->fontbase][dev->sc & 7] & (1 << (c ^ 7))) ? 1 : 0];
-					}
-				}
-				dev->ma++;
-			}
-		} else if (! (dev->cgamode & 2)) {
-			for (x = 0; x < dev->crtc[1]; x++) {
-				if (dev->cgamode & 8) {
 					chr  = dev->vram[((dev->ma << 1) & 0x3fff)];
 					attr = dev->vram[(((dev->ma << 1) + 1) & 0x3fff)];
-				} else
-					chr = attr = 0;
-				drawcursor = ((dev->ma == ca) && dev->con && dev->cursoron);
-				cols[1] = (attr & 15) + 16;
+				}
+				flags = 0;
+				if ((dev->ma == ca) && dev->cursoron)
+					flags |= TEXT_CURSOR;
+				if ((dev->cgamode & 0x20) && (dev->cgablink & 8) && (attr & 0x80))
+					flags |= TEXT_BLINK;
+				dev->ma++;
+
+				if (! text_cell(&dev->text, x, newrow, TEXT_KEY(chr, attr, flags)))
+					continue;
+
+				fg = (attr & 15) + 16;
 				if (dev->cgamode & 0x20) {
-					cols[0] = ((attr >> 4) & 7) + 16;
-					if ((dev->cgablink & 8) && (attr & 0x80))
-						cols[1] = cols[0];
+					bg = ((attr >> 4) & 7) + 16;
+					if (flags & TEXT_BLINK)
+						fg = bg;
 				} else
-					cols[0] = (attr >> 4) + 16;
-				dev->ma++;
+					bg = (attr >> 4) + 16;
+				drawcursor = ((flags & TEXT_CURSOR) && dev->con);
 				if (drawcursor) {
-					for (c = 0; c < 8; c++) {
-						screen->line[(dev->displine << 1)][(x << 4) + (c << 1) + 8].pal =
-						screen->line[(dev->displine << 1)][(x << 4) + (c << 1) + 1 + 8].pal =
-						screen->line[(dev->displine << 1) + 1][(x << 4) + (c << 1) + 8].pal =
-						screen->line[(dev->displine << 1) + 1][(x << 4) + (c << 1) + 1 + 8].pal =
-							cols[(fontdat[chr + dev->fontbase][dev->sc & 7] & (1 << (c ^ 7))) ? 1 : 0] ^ 15;
-					}
+					fg ^= 15;
+					bg ^= 15;
+				}
+
+				/* Draw the cell as a run of pels from the pre-expanded glyph row. */
+				fg = cga_pel(dev, fg);
+				bg = cga_pel(dev, bg);
+				m = glyphmask[fontdat[chr + dev->fontbase][dev->sc & 7]];
+				if (dev->cgamode & 1) {
+					for (c = 0; c < 8; c++)
+						p0[(x << 3) + c + 8].val = p1[(x << 3) + c + 8].val = bg ^ ((fg ^ bg) & m[c]);
 				} else {
 					for (c = 0; c < 8; c++) {
-						screen->line[(dev->displine << 1)][(x << 4) + (c << 1) + 8].pal =
-						screen->line[(dev->displine << 1)][(x << 4) + (c << 1) + 1 + 8].pal =
-						screen->line[(dev->displine << 1) + 1][(x << 4) + (c << 1) + 8].pal =
-						screen->line[(dev->displine << 1) + 1][(x << 4) + (c << 1) + 1 + 8].pal =
-						cols[(fontdat[chr + dev->fontbase][dev->sc & 7] & (1 << (c ^ 7))) ? 1 : 0];
+						o = (x << 4) + (c << 1) + 8;
+						p0[o].val = p0[o + 1].val = p1[o].val = p1[o + 1].val = bg ^ ((fg ^ bg) & m[c]);
 					}
 				}
 			}
@@ -406,6 +413,8 @@ cga_poll(priv_t priv)
 				cols[2] = col | 4;
 				cols[3] = col | 6;
 			}
+			for (c = 0; c < 4; c++)
+				cols[c] = cga_pel(dev, cols[c]);
 
 			for (x = 0; x < dev->crtc[1]; x++) {
 				if (dev->cgamode & 8)
@@ -414,16 +423,14 @@ cga_poll(priv_t priv)
 					dat = 0;
 				dev->ma++;
 				for (c = 0; c < 8; c++) {
-					screen->line[(dev->displine << 1)][(x << 4) + (c << 1) + 8].pal =
-					screen->line[(dev->displine << 1)][(x << 4) + (c << 1) + 1 + 8].pal =
-					screen->line[(dev->displine << 1) + 1][(x << 4) + (c << 1) + 8].pal =
-					screen->line[(dev->displine << 1) + 1][(x << 4) + (c << 1) + 1 + 8].pal =
-						cols[dat >> 14];
+					o = (x << 4) + (c << 1) + 8;
+					p0[o].val = p0[o + 1].val = p1[o].val = p1[o + 1].val = cols[dat >> 14];
 					dat <<= 2;
 				}
 			}
 		} else {
-			cols[0] = 0; cols[1] = (dev->cgacol & 15) + 16;
+			cols[0] = cga_pel(dev, 0);
+			cols[1] = cga_pel(dev, (dev->cgacol & 15) + 16);
 			for (x = 0; x < dev->crtc[1]; x++) {
 				if (dev->cgamode & 8)	
 					dat = (dev->vram[((dev->ma << 1) & 0x1fff) + ((dev->sc & 1) * 0x2000)] << 8) | dev->vram[((dev->ma << 1) & 0x1fff) + ((dev->sc & 1) * 0x2000) + 1];
@@ -431,22 +438,18 @@ cga_poll(priv_t priv)
 					dat = 0;
 				dev->ma++;
 				for (c = 0; c < 16; c++) {
-					screen->line[(dev->displine << 1)][(x << 4) + c + 8].pal =
-					screen->line[(dev->displine << 1) + 1][(x << 4) + c + 8].pal =
-						cols[dat >> 15];
+					p0[(x << 4) + c + 8].val = p1[(x << 4) + c + 8].val = cols[dat >> 15];
 					dat <<= 1;
 				}
 			}
 		}
-	} else {
-		cols[0] = ((dev->cgamode & 0x12) == 0x12) ? 0 : (dev->cgacol & 15) + 16;
-		if (dev->cgamode & 1) {
-			cga_hline(screen, 0, (dev->displine << 1), (dev->crtc[1] << 3) + 16, cols[0]);
-			cga_hline(screen, 0, (dev->displine << 1) + 1, (dev->crtc[1] << 3) + 16, cols[0]);
-		} else {
-			cga_hline(screen, 0, (dev->displine << 1), (dev->crtc[1] << 4) + 16, cols[0]);
-			cga_hline(screen, 0, (dev->displine << 1) + 1, (dev->crtc[1] << 4) + 16, cols[0]);
-		}
+	} else if (((dev->displine << 1) + 1) < screen->h) {
+		if ((dev->cgamode & 0x12) == 0x12)
+			cols[0] = cga_pel(dev, 0);
+		else
+			cols[0] = cga_pel(dev, (dev->cgacol & 15) + 16);
+		for (c = 0; c < (w + 16); c++)
+			p0[c].val = p1[c].val = cols[0];
 	}
 
 	if (dev->cgamode & 1)
@@ -557,12 +560,8 @@ cga_poll(priv_t priv)
 						video_force_resize_set(0);
 				}
 
-				if (dev->composite) 
-					video_blit_start(0, 0, (dev->firstline - 4) << 1, 0, ((dev->lastline - dev->firstline) + 8) << 1,
-							       xsize, ((dev->lastline - dev->firstline) + 8) << 1);
-				else
-					video_blit_start(1, 0, (dev->firstline - 4) << 1, 0, ((dev->lastline - dev->firstline) + 8) << 1,
-								 xsize, ((dev->lastline - dev->firstline) + 8) << 1);
+				video_blit_start(0, 0, (dev->firstline - 4) << 1, 0, ((dev->lastline - dev->firstline) + 8) << 1,
+						       xsize, ((dev->lastline - dev->firstline) + 8) << 1);
 				frames++;
 
 				video_res_x = xsize - 16;
@@ -585,6 +584,8 @@ cga_poll(priv_t priv)
 			dev->lastline = 0;
 			dev->cgablink++;
 			dev->oddeven ^= 1;
+			if (dev->fullchange)
+				dev->fullchange--;
 		}
 	} else {
 		dev->sc++;
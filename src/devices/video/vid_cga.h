@@ -8,7 +8,7 @@
  *
  *		Definitions for the CGA driver.
  *
- * Version:	@(#)vid_cga.h	1.0.10	2019/05/17
+ * Version:	@(#)vid_cga.h	1.0.11	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -84,6 +84,9 @@ typedef struct {
 
     int		composite;
     priv_t	cpriv;
+
+    int		fullchange;
+    textcache_t	text;
 } cga_t;
 
 
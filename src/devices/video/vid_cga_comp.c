@@ -15,7 +15,11 @@
  *
  *		Reworked to have its data on the heap.
  *
- * Version:	@(#)vid_cga_comp.c	1.0.9	2019/05/17
+ *		Decoded lines are cached, so a line is only run through
+ *		the filter again if its pels, the mode or the border have
+ *		changed, or if the filter settings were updated.
+ *
+ * Version:	@(#)vid_cga_comp.c	1.0.10	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -86,6 +90,19 @@ static const double intensity[4] = {
 /* 2048x1536 is the maximum we can possibly support. */
 #define SCALER_MAXWIDTH 2048
 
+#define LINE_CACHE	1024		/* must be a power of 2 */
+
+
+typedef struct {
+    const pel_t	*line;			/* line this entry is for */
+    uint32_t	gen;			/* settings it was decoded with */
+    uint32_t	blocks;
+    uint8_t	mode,
+		border;
+    int		size;			/* allocated pels */
+    uint8_t	*in;			/* input palette indices */
+    uint32_t	*out;			/* decoded pels */
+} comp_line_t;
 
 typedef struct {
     int		new_cga;
@@ -103,11 +120,22 @@ typedef struct {
 		sharpness,
 		hue_offset;
 
+    int		ri, rq, gi,		/* integer copies of the above */
+		gq, bi, bq;
+
     int		temp[SCALER_MAXWIDTH + 10];
     int		atemp[SCALER_MAXWIDTH + 2];
     int		btemp[SCALER_MAXWIDTH + 2];
+    int		ltemp[SCALER_MAXWIDTH + 2];
+    int		itemp[SCALER_MAXWIDTH];
+    int		qtemp[SCALER_MAXWIDTH];
+    uint8_t	in[SCALER_MAXWIDTH];
 
     int		table[1024];
+
+    uint32_t	gen;			/* bumped on every update */
+    comp_line_t	*last;			/* most recently decoded line */
+    comp_line_t	cache[LINE_CACHE];
 } cga_comp_t;
 
 
@@ -120,88 +148,147 @@ byte_clamp(int v)
 }
 
 
-void
-cga_comp_process(priv_t priv, uint8_t cgamode, uint8_t border,
-		 uint32_t blocks/*, int8_t doublewidth*/, pel_t *pels)
+static comp_line_t *
+cache_slot(cga_comp_t *state, const pel_t *pels)
 {
-    cga_comp_t *state = (cga_comp_t *)priv;
-    uint32_t x2;
-    pel_t *ptr;
+    uint32_t h = (uint32_t)((uintptr_t)pels / sizeof(pel_t));
+
+    h = (h * 2654435761U) >> 16;
+
+    return(&state->cache[h & (LINE_CACHE - 1)]);
+}
+
+
+/* See if a cache entry holds the decoded version of this input. */
+static int
+cache_match(cga_comp_t *state, const comp_line_t *cl,
+	    uint8_t mode, uint8_t border, uint32_t blocks)
+{
+    return((cl->in != NULL) && (cl->gen == state->gen) &&
+	   (cl->blocks == blocks) && (cl->mode == mode) &&
+	   (cl->border == border) &&
+	   !memcmp(cl->in, state->in, blocks * 4));
+}
+
+
+/* Run one line through the filter, into the 'out' array. */
+static void
+comp_decode(cga_comp_t *state, uint8_t mode, uint8_t border,
+	    uint32_t blocks, uint32_t *out)
+{
+    const uint8_t *in = state->in;
+    int *o, *b2, *i, *ap, *bp, *lp;
     int x, w = blocks*4;
-    int *o, *b2, *i, *ap, *bp;
-
-#define COMPOSITE_CONVERT(I, Q) do { \
-        i[1] = (i[1]<<3) - ap[1]; \
-        a = ap[0]; \
-        b = bp[0]; \
-        c = i[0]+i[0]; \
-        d = i[-1]+i[1]; \
-        y = ((c+d)<<8) + state->video_sharpness*(c-d); \
-        rr = (int)(y + state->video_ri*(I) + state->video_rq*(Q)); \
-        gg = (int)(y + state->video_gi*(I) + state->video_gq*(Q)); \
-        bb = (int)(y + state->video_bi*(I) + state->video_bq*(Q)); \
-        ++i; \
-        ++ap; \
-        ++bp; \
-        ptr[0].val = (byte_clamp(rr)<<16) | (byte_clamp(gg)<<8) | byte_clamp(bb); \
-        ptr++; \
-    } while (0)
+    int c, d, y, rr, gg, bb;
 
 #define OUT(v) do { *o = (v); ++o; } while (0)
 
     /* Simulate CGA composite output. */
-    ptr = pels;
     o = state->temp;
     b2 = &state->table[border * 68];
     for (x = 0; x < 4; ++x)
 	OUT(b2[(x+3)&3]);
-    OUT(state->table[(border<<6) | ((ptr[0].pal & 0x0f)<<2) | 3]);
+    OUT(state->table[(border<<6) | (in[0]<<2) | 3]);
 
-    for (x = 0; x < w-1; ++x) {
-	OUT(state->table[((ptr[0].pal & 0x0f)<<6) | ((ptr[1].pal & 0x0f)<<2) | (x&3)]);
-	ptr++;
-    }
-    OUT(state->table[((ptr[0].pal & 0x0f)<<6) | (border<<2) | 3]);
+    for (x = 0; x < w-1; ++x)
+	OUT(state->table[(in[x]<<6) | (in[x+1]<<2) | (x&3)]);
+    OUT(state->table[(in[w-1]<<6) | (border<<2) | 3]);
 
     for (x = 0; x < 5; ++x)
 	OUT(b2[x&3]);
 
-    ptr = pels;
-    if ((cgamode & 4) != 0) {
+    if (mode != 0) {
 	/* Decode. */
 	i = state->temp + 5;
-	for (x2 = 0; x2 < blocks*4; ++x2) {
-		int c = (i[0]+i[0])<<3;
-		int d = (i[-1]+i[1])<<3;
-		int y = ((c+d)<<8) + state->video_sharpness*(c-d);
-		++i;
-		ptr[0].val = byte_clamp(y)*0x10101;
-		ptr++;
-	}
-    } else {
-	/* Store chroma. */
-	i = state->temp + 4;
-	ap = state->atemp + 1;
-	bp = state->btemp + 1;
-	for (x = -1; x < w + 1; ++x) {
-		ap[x] = i[-4]-((i[-2]-i[0]+i[2])<<1)+i[4];
-		bp[x] = (i[-3]-i[-1]+i[1]-i[3])<<1;
-		++i;
+	for (x = 0; x < w; ++x) {
+		c = (i[x]+i[x])<<3;
+		d = (i[x-1]+i[x+1])<<3;
+		y = ((c+d)<<8) + state->video_sharpness*(c-d);
+		out[x] = byte_clamp(y)*0x10101;
 	}
+	return;
+    }
 
-	/* Decode. */
-	i = state->temp + 5;
-	i[-1] = (i[-1]<<3) - ap[-1];
-	i[0] = (i[0]<<3) - ap[0];
-	for (x2 = 0; x2 < blocks; ++x2) {
-		int y,a,b,c,d,rr,gg,bb;
-
-		COMPOSITE_CONVERT(a, b);
-		COMPOSITE_CONVERT(-b, a);
-		COMPOSITE_CONVERT(-a, -b);
-		COMPOSITE_CONVERT(b, -a);
+    /* Store chroma. */
+    i = state->temp + 5;
+    ap = state->atemp + 1;
+    bp = state->btemp + 1;
+    for (x = -1; x < w + 1; ++x) {
+	ap[x] = i[x-4]-((i[x-2]-i[x]+i[x+2])<<1)+i[x+4];
+	bp[x] = (i[x-3]-i[x-1]+i[x+1]-i[x+3])<<1;
+    }
+
+    /* Luma, with the chroma taken out. */
+    i = state->temp + 5;
+    lp = state->ltemp + 1;
+    for (x = -1; x < w + 1; ++x)
+	lp[x] = (i[x]<<3) - ap[x];
+
+    /* Demodulate I and Q, the carrier phase repeats every 4 pels. */
+    for (x = 0; x < w; x += 4) {
+	state->itemp[x] = ap[x];	state->qtemp[x] = bp[x];
+	state->itemp[x+1] = -bp[x+1];	state->qtemp[x+1] = ap[x+1];
+	state->itemp[x+2] = -ap[x+2];	state->qtemp[x+2] = -bp[x+2];
+	state->itemp[x+3] = bp[x+3];	state->qtemp[x+3] = -ap[x+3];
+    }
+
+    /* Decode. This loop has no dependencies, so it vectorizes well. */
+    for (x = 0; x < w; ++x) {
+	c = lp[x]+lp[x];
+	d = lp[x-1]+lp[x+1];
+	y = ((c+d)<<8) + state->video_sharpness*(c-d);
+	rr = y + state->ri*state->itemp[x] + state->rq*state->qtemp[x];
+	gg = y + state->gi*state->itemp[x] + state->gq*state->qtemp[x];
+	bb = y + state->bi*state->itemp[x] + state->bq*state->qtemp[x];
+	out[x] = (byte_clamp(rr)<<16) | (byte_clamp(gg)<<8) | byte_clamp(bb);
+    }
+}
+
+
+void
+cga_comp_process(priv_t priv, uint8_t cgamode, uint8_t border,
+		 uint32_t blocks/*, int8_t doublewidth*/, pel_t *pels)
+{
+    cga_comp_t *state = (cga_comp_t *)priv;
+    uint8_t mode = cgamode & 4;
+    comp_line_t *cl, *last;
+    int x, w = blocks*4;
+
+    if ((w == 0) || (w > SCALER_MAXWIDTH)) return;
+
+    for (x = 0; x < w; x++)
+	state->in[x] = pels[x].pal & 0x0f;
+
+    cl = cache_slot(state, pels);
+    last = state->last;
+    state->last = cl;
+
+    if ((cl->line != pels) || !cache_match(state, cl, mode, border, blocks)) {
+	/* (Re-)use the entry for this line. */
+	if (cl->size < w) {
+		if (cl->out != NULL)
+			free(cl->out);
+		cl->out = (uint32_t *)mem_alloc(w * (sizeof(uint32_t) + 1));
+		cl->in = (uint8_t *)(cl->out + w);
+		cl->size = w;
 	}
+	cl->line = pels;
+	cl->gen = state->gen;
+	cl->blocks = blocks;
+	cl->mode = mode;
+	cl->border = border;
+	memcpy(cl->in, state->in, w);
+
+	/* Lines are often drawn twice, so check the previous one. */
+	if ((last != NULL) && (last != cl) &&
+	    cache_match(state, last, mode, border, blocks))
+		memcpy(cl->out, last->out, w * sizeof(uint32_t));
+	else
+		comp_decode(state, mode, border, blocks, cl->out);
     }
+
+    for (x = 0; x < w; x++)
+	pels[x].val = cl->out[x];
 }
 
 
@@ -283,6 +370,17 @@ cga_comp_update(priv_t priv, uint8_t cgamode)
     state->video_bi = (int) (bi * iq_adjust_i + bq * iq_adjust_q);
     state->video_bq = (int) (-bi * iq_adjust_q + bq * iq_adjust_i);
     state->video_sharpness = (int) ((state->sharpness * 256) / 100);
+
+    /* The matrix values are whole numbers, so integer math is exact. */
+    state->ri = (int)state->video_ri;
+    state->rq = (int)state->video_rq;
+    state->gi = (int)state->video_gi;
+    state->gq = (int)state->video_gq;
+    state->bi = (int)state->video_bi;
+    state->bq = (int)state->video_bq;
+
+    /* Anything we decoded before is no longer valid. */
+    state->gen++;
 }
 
 
@@ -309,6 +407,12 @@ void
 cga_comp_close(priv_t priv)
 {
     cga_comp_t *state = (cga_comp_t *)priv;
+    int i;
+
+    for (i = 0; i < LINE_CACHE; i++) {
+	if (state->cache[i].out != NULL)
+		free(state->cache[i].out);
+    }
 
     free(state);
 }
@@ -9,7 +9,7 @@
  *		Emulation of the EGA, Chips & Technologies SuperEGA, and
  *		AX JEGA graphics cards.
  *
- * Version:	@(#)vid_ega.c	1.0.21	2019/05/17
+ * Version:	@(#)vid_ega.c	1.0.26	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -263,6 +263,22 @@ LoadFontxFile(const wchar_t *fn)
 #endif
 
 
+/* Does the text renderer only draw the changed cells? */
+#ifdef JEGA
+static int
+ega_text_cells(ega_t *dev)
+{
+    return(! jega_enabled(dev));
+}
+#else
+static int
+ega_text_cells(UNUSED(ega_t *dev))
+{
+    return(1);
+}
+#endif
+
+
 void
 ega_recalctimings(ega_t *dev)
 {
@@ -350,14 +366,13 @@ ega_poll(priv_t priv)
 		if (dev->scrblank)
 			ega_render_blank(dev);
 		else if (!(dev->gdcreg[6] & 1)) {
-			if (fullchange) {
 #ifdef JEGA
-				if (jega_enabled(dev))
+			if (jega_enabled(dev)) {
+				if (fullchange)
 					ega_render_text_jega(dev, drawcursor);
-				else
+			} else
 #endif
-				ega_render_text_standard(dev, drawcursor);
-			}
+			ega_render_text_standard(dev, drawcursor);
 		} else {
 			switch (dev->gdcreg[5] & 0x20) {
 				case 0x00:
@@ -427,12 +442,18 @@ ega_poll(priv_t priv)
 			dev->cursoron = 0;
 		else
 			dev->cursoron = dev->blink & 16;
-		if (!(dev->gdcreg[6] & 1) && !(dev->blink & 15)) 
+		if (!(dev->gdcreg[6] & 1) && !(dev->blink & 15) &&
+		    !ega_text_cells(dev)) 
 			fullchange = 2;
 		dev->blink++;
 
 		if (fullchange) 
 			fullchange--;
+
+		for (x = 0; x < (0x40000 >> 12); x++) {
+			if (dev->changedvram[x])
+				dev->changedvram[x]--;
+		}
 	}
 
 	if (dev->vc == dev->vsyncstart) {
@@ -570,8 +591,7 @@ ega_out(uint16_t port, uint8_t val, priv_t priv)
 		   dev->attraddr = val & 31;
 		else {
 			dev->attrregs[dev->attraddr & 31] = val;
-			if (dev->attraddr < 16) 
-				fullchange = changeframecount;
+			fullchange = changeframecount;
 			if (dev->attraddr == 0x10 || dev->attraddr == 0x14 || dev->attraddr < 0x10) {
 				for (c = 0; c < 16; c++) {
 					if (dev->attrregs[0x10] & 0x80)
@@ -589,6 +609,7 @@ ega_out(uint16_t port, uint8_t val, priv_t priv)
 		dev->vres = !(val & 0x80);
 		dev->pallook = dev->vres ? pallook16 : pallook64;
 		dev->vidclock = val & 4;
+		fullchange = changeframecount;
 		dev->miscout = val;
 		break;
 
@@ -599,8 +620,10 @@ ega_out(uint16_t port, uint8_t val, priv_t priv)
 	case 0x03c5:
 		o = dev->seqregs[dev->seqaddr & 0x0f];
 		dev->seqregs[dev->seqaddr & 0x0f] = val;
-		if (o != val && (dev->seqaddr & 0x0f) == 1) 
+		if (o != val && (dev->seqaddr & 0x0f) == 1) {
+			fullchange = changeframecount;
 			ega_recalctimings(dev);
+		}
 		switch (dev->seqaddr & 0x0f) {
 			case 1: 
 				if (dev->scrblank && !(val & 0x20)) 
@@ -615,6 +638,7 @@ ega_out(uint16_t port, uint8_t val, priv_t priv)
 			case 3:
 				dev->charsetb = (((val >> 2) & 3) * 0x10000) + 2;
 				dev->charseta = ((val & 3)	* 0x10000) + 2;
+				fullchange = changeframecount;
 				break;
 
 			case 4:
@@ -642,9 +666,11 @@ ega_out(uint16_t port, uint8_t val, priv_t priv)
 				dev->writemode = val & 3;
 				dev->readmode = val & 8; 
 				dev->chain2_read = val & 0x10;
+				fullchange = changeframecount;
 				break;
 
 			case 6:
+				fullchange = changeframecount;
 				switch (val & 0x0c) {
 					case 0x00: /*128K at A0000*/
 						mem_map_set_addr(&dev->mapping, 0xa0000, 0x20000);
@@ -787,8 +813,10 @@ ega_write(uint32_t addr, uint8_t val, priv_t priv)
     if (addr >= dev->vram_limit)
 	return;
 
-    if (!(dev->gdcreg[6] & 1)) 
+    /* Only a font change needs a full redraw if cells are tracked. */
+    if (!(dev->gdcreg[6] & 1) && (!ega_text_cells(dev) || (writemask2 & 4))) 
 	fullchange = 2;
+    dev->changedvram[addr >> 12] = changeframecount;
 
     switch (dev->writemode) {
 	case 1:
@@ -996,6 +1024,8 @@ ega_init(ega_t *dev, int monitor_type, int is_mono)
     int c, d, e;
 	
     dev->vram = (uint8_t *)mem_alloc(0x40000);
+    dev->changedvram = (uint8_t *)mem_alloc(0x40000 >> 12);
+    memset(dev->changedvram, 0x00, 0x40000 >> 12);
     dev->vram_limit = 256 * 1024;
     dev->vrammask = dev->vram_limit - 1;
 
@@ -1007,15 +1037,6 @@ ega_init(ega_t *dev, int monitor_type, int is_mono)
 	}
     }
 
-    for (c = 0; c < 4; c++) {
-	for (d = 0; d < 4; d++) {
-		edatlookup[c][d] = 0;
-		if (c & 1) edatlookup[c][d] |= 1;
-		if (d & 1) edatlookup[c][d] |= 2;
-		if (c & 2) edatlookup[c][d] |= 0x10;
-		if (d & 2) edatlookup[c][d] |= 0x20;
-	}
-    }
 
     if (is_mono) {
 	for (c = 0; c < 256; c++) {
@@ -1118,6 +1139,7 @@ ega_close(priv_t priv)
     ega_t *dev = (ega_t *)priv;
 
     free(dev->vram);
+    free(dev->changedvram);
 
     free(dev);
 }
@@ -8,7 +8,7 @@
  *
  *		Definitions for the IBM EGA driver.
  *
- * Version:	@(#)vid_ega.h	1.0.7	2019/05/17
+ * Version:	@(#)vid_ega.h	1.0.9	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -140,12 +140,15 @@ typedef struct {
     int		displine;
         
     uint8_t	*vram;
+    uint8_t	*changedvram;
     int		vrammask;
 
     uint32_t	vram_limit;
 
     int		video_res_x, video_res_y, video_bpp;
 
+    textcache_t	text;
+
 #ifdef JEGA
     uint8_t	RMOD1, RMOD2, RDAGS, RDFFB, RDFSB, RDFAP,
 		RPESL, RPULP, RPSSC, RPSSU, RPSSL;
@@ -9,7 +9,7 @@
  *		EGA renderers.
  * NOTE:	FIXME: make sure this works (line 99 shadow parameter)
  *
- * Version:	@(#)vid_ega_render.c	1.0.7	2019/05/17
+ * Version:	@(#)vid_ega_render.c	1.0.9	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -102,22 +102,39 @@ ega_render_text_standard(ega_t *ega, int draw)
 {
     int x_add = (enable_overscan) ? 8 : 0;
     int dl = ega_display_line(ega);
-    int x, xx;
-	
+    int newrow, x, xx;
+
+    /* Only draw the cells that changed since the last frame. */
+    newrow = text_row(&ega->text, ega->ma, ega->displine, fullchange);
+    if (!newrow && !ega->text.dirty)
+	return;
+
     for (x = 0; x < ega->hdisp; x++) {
-	int do_draw = ((ega->ma == ega->ca) && ega->con && ega->cursoron);
 	uint8_t chr  = ega->vram[(ega->ma << 1) & ega->vrammask];
 	uint8_t attr = ega->vram[((ega->ma << 1) + 1) & ega->vrammask];
-	uint8_t dat;
-	uint32_t fg, bg;
+	uint8_t dat, flags = 0;
+	uint32_t fg, bg, pel;
 	uint32_t charaddr;
-	
+	const uint32_t *m;
+	int o;
+
+	if ((ega->ma == ega->ca) && ega->cursoron)
+		flags |= TEXT_CURSOR;
+	if ((attr & 0x80) && (ega->attrregs[0x10] & 8) && (ega->blink & 16))
+		flags |= TEXT_BLINK;
+
+	if (! text_cell(&ega->text, x, newrow, TEXT_KEY(chr, attr, flags))) {
+		ega->ma += 4; 
+		ega->ma &= ega->vrammask;
+		continue;
+	}
+
 	if (attr & 8)
 		charaddr = ega->charsetb + (chr * 128);
 	else
 		charaddr = ega->charseta + (chr * 128);
 
-	if (do_draw) { 
+	if ((flags & TEXT_CURSOR) && ega->con) { 
 		bg = ega->pallook[ega->egapal[attr & 15]]; 
 		fg = ega->pallook[ega->egapal[attr >> 4]]; 
 	} else {
@@ -125,36 +142,32 @@ ega_render_text_standard(ega_t *ega, int draw)
 		bg = ega->pallook[ega->egapal[attr >> 4]];
 		if (attr & 0x80 && ega->attrregs[0x10] & 8) {
 			bg = ega->pallook[ega->egapal[(attr >> 4) & 7]];
-			if (ega->blink & 16) 
+			if (flags & TEXT_BLINK)
 				fg = bg;
 		}
 	}
 
+	/* Draw the cell as a run of pels from the pre-expanded glyph row. */
 	dat = ega->vram[charaddr + (ega->sc << 2)];
+	m = glyphmask[dat];
+	fg ^= bg;
+	if ((ega->seqregs[1] & 1) || (chr & ~0x1f) != 0xc0 || !(ega->attrregs[0x10] & 4))
+		pel = bg;
+	else
+		pel = bg ^ (fg & m[7]);
+
 	if (ega->seqregs[1] & 8) {
-		if (ega->seqregs[1] & 1) { 
-			for (xx = 0; xx < 8; xx++) 
-				screen->line[dl][((x << 4) + 32 + (xx << 1) + x_add) & 2047].val = screen->line[dl][((x << 4) + 33 + (xx << 1) + x_add) & 2047].val = (dat & (0x80 >> xx)) ? fg : bg; 
-		} else {
-			for (xx = 0; xx < 8; xx++) 
-				screen->line[dl][((x * 18) + 32 + (xx << 1) + x_add) & 2047].val = screen->line[dl][((x * 18) + 33 + (xx << 1) + x_add) & 2047].val = (dat & (0x80 >> xx)) ? fg : bg;
-			if ((chr & ~0x1f) != 0xc0 || !(ega->attrregs[0x10] & 4)) 
-				screen->line[dl][((x * 18) + 32 + 16 + x_add) & 2047].val = screen->line[dl][((x * 18) + 32 + 17 + x_add) & 2047].val = bg;
-			else
-				screen->line[dl][((x * 18) + 32 + 16 + x_add) & 2047].val = screen->line[dl][((x * 18) + 32 + 17 + x_add) & 2047].val = (dat & 1) ? fg : bg;
-		}
+		o = x * ((ega->seqregs[1] & 1) ? 16 : 18) + 32 + x_add;
+		for (xx = 0; xx < 8; xx++) 
+			screen->line[dl][(o + (xx << 1)) & 2047].val = screen->line[dl][(o + (xx << 1) + 1) & 2047].val = bg ^ (fg & m[xx]);
+		if (! (ega->seqregs[1] & 1))
+			screen->line[dl][(o + 16) & 2047].val = screen->line[dl][(o + 17) & 2047].val = pel;
 	} else {
-		if (ega->seqregs[1] & 1) { 
-			for (xx = 0; xx < 8; xx++) 
-				screen->line[dl][((x << 3) + 32 + xx + x_add) & 2047].val = (dat & (0x80 >> xx)) ? fg : bg; 
-		} else {
-			for (xx = 0; xx < 8; xx++) 
-				screen->line[dl][((x * 9) + 32 + xx + x_add) & 2047].val = (dat & (0x80 >> xx)) ? fg : bg;
-			if ((chr & ~0x1f) != 0xc0 || !(ega->attrregs[0x10] & 4)) 
-				screen->line[dl][((x * 9) + 32 + 8 + x_add) & 2047].val = bg;
-			else		  
-				screen->line[dl][((x * 9) + 32 + 8 + x_add) & 2047].val = (dat & 1) ? fg : bg;
-		}
+		o = x * ((ega->seqregs[1] & 1) ? 8 : 9) + 32 + x_add;
+		for (xx = 0; xx < 8; xx++) 
+			screen->line[dl][(o + xx) & 2047].val = bg ^ (fg & m[xx]);
+		if (! (ega->seqregs[1] & 1))
+			screen->line[dl][(o + 8) & 2047].val = pel;
 	}
 
 	ega->ma += 4; 
@@ -405,125 +418,139 @@ ega_render_2bpp(ega_t *ega)
 }
 
 
-void
-ega_render_4bpp_lowres(ega_t *ega)
+/* Work out where in the planar memory the current character is. */
+static uint32_t
+ega_4bpp_addr(ega_t *ega, uint32_t ma, int *oddeven)
 {
-    int x_add = (enable_overscan) ? 8 : 0;
-    int dl = ega_display_line(ega);
-    int offset = ((8 - ega->scrollcache) << 1) + 16;
-    int x;
+    uint32_t addr = ma;
+
+    *oddeven = 0;
+
+    if (!(ega->crtc[0x17] & 0x40)) {
+	addr = (addr << 1) & ega->vrammask;
+	if (ega->seqregs[1] & 4)
+		*oddeven = (addr & 4) ? 1 : 0;
+	addr &= ~7;
+	if ((ega->crtc[0x17] & 0x20) && (ma & 0x20000))
+		addr |= 4;
+	if (!(ega->crtc[0x17] & 0x20) && (ma & 0x8000))
+		addr |= 4;
+    }
+    if (!(ega->crtc[0x17] & 0x01))
+	addr = (addr & ~0x8000) | ((ega->sc & 1) ? 0x8000 : 0);
+    if (!(ega->crtc[0x17] & 0x02))
+	addr = (addr & ~0x10000) | ((ega->sc & 2) ? 0x10000 : 0);
+
+    return(addr);
+}
+
+
+/*
+ * Check if any of the memory shown on this line was written to
+ * recently. If not, and nothing else changed, the line we drew
+ * before is still good, and we only have to skip over it.
+ */
+static int
+ega_4bpp_changed(ega_t *ega)
+{
+    uint32_t ma = ega->ma;
+    int step = (ega->seqregs[1] & 4) ? 2 : 4;
+    int oddeven, x;
+
+    if (fullchange)
+	return(1);
 
     for (x = 0; x <= ega->hdisp; x++) {
-	uint8_t edat[4];
-	uint8_t dat;
-	uint32_t addr = ega->ma;
-	int oddeven = 0;
+	if (ega->changedvram[ega_4bpp_addr(ega, ma, &oddeven) >> 12])
+		return(1);
+	ma = (ma + step) & ega->vrammask;
+    }
 
-	if (!(ega->crtc[0x17] & 0x40)) {
-		addr = (addr << 1) & ega->vrammask;
-		if (ega->seqregs[1] & 4)
-			oddeven = (addr & 4) ? 1 : 0;
-		addr &= ~7;
-		if ((ega->crtc[0x17] & 0x20) && (ega->ma & 0x20000))
-			addr |= 4;
-		if (!(ega->crtc[0x17] & 0x20) && (ega->ma & 0x8000))
-			addr |= 4;
-	}
-	if (!(ega->crtc[0x17] & 0x01))
-		addr = (addr & ~0x8000) | ((ega->sc & 1) ? 0x8000 : 0);
-	if (!(ega->crtc[0x17] & 0x02))
-		addr = (addr & ~0x10000) | ((ega->sc & 2) ? 0x10000 : 0);
+    ega->ma = ma;
 
-	if (ega->seqregs[1] & 4) {
-		edat[0] = ega->vram[addr | oddeven];
-		edat[2] = ega->vram[addr | oddeven | 0x2];
-		edat[1] = edat[3] = 0;
-		ega->ma += 2;
-	} else {
-		edat[0] = ega->vram[addr];
-		edat[1] = ega->vram[addr | 0x1];
-		edat[2] = ega->vram[addr | 0x2];
-		edat[3] = ega->vram[addr | 0x3];
-		ega->ma += 4;
-	}
-	ega->ma &= ega->vrammask;
+    return(0);
+}
 
-	dat = edatlookup[edat[0] & 3][edat[1] & 3] | (edatlookup[edat[2] & 3][edat[3] & 3] << 2);
-	screen->line[dl][(x << 4) + 14 + offset + x_add].val = screen->line[dl][(x << 4) + 15 + offset + x_add].val = ega->pallook[ega->egapal[(dat & 0xf) & ega->attrregs[0x12]]];
-	screen->line[dl][(x << 4) + 12 + offset + x_add].val = screen->line[dl][(x << 4) + 13 + offset + x_add].val = ega->pallook[ega->egapal[(dat >> 4)  & ega->attrregs[0x12]]];
 
-	dat = edatlookup[(edat[0] >> 2) & 3][(edat[1] >> 2) & 3] | (edatlookup[(edat[2] >> 2) & 3][(edat[3] >> 2) & 3] << 2);
-	screen->line[dl][(x << 4) + 10 + offset + x_add].val = screen->line[dl][(x << 4) + 11 + offset + x_add].val = ega->pallook[ega->egapal[(dat & 0xf) & ega->attrregs[0x12]]];
-	screen->line[dl][(x << 4) +  8 + offset + x_add].val = screen->line[dl][(x << 4) +  9 + offset + x_add].val = ega->pallook[ega->egapal[(dat >> 4)  & ega->attrregs[0x12]]];
+/* Fetch the next character and merge its planes into 8 pels. */
+static uint32_t
+ega_4bpp_fetch(ega_t *ega)
+{
+    uint32_t addr;
+    int oddeven;
 
-	dat = edatlookup[(edat[0] >> 4) & 3][(edat[1] >> 4) & 3] | (edatlookup[(edat[2] >> 4) & 3][(edat[3] >> 4) & 3] << 2);
-	screen->line[dl][(x << 4) +  6 + offset + x_add].val = screen->line[dl][(x << 4) +  7 + offset + x_add].val = ega->pallook[ega->egapal[(dat & 0xf) & ega->attrregs[0x12]]];
-	screen->line[dl][(x << 4) +  4 + offset + x_add].val = screen->line[dl][(x << 4) +  5 + offset + x_add].val = ega->pallook[ega->egapal[(dat >> 4)  & ega->attrregs[0x12]]];
+    addr = ega_4bpp_addr(ega, ega->ma, &oddeven);
 
-	dat = edatlookup[edat[0] >> 6][edat[1] >> 6] | (edatlookup[edat[2] >> 6][edat[3] >> 6] << 2);
-	screen->line[dl][(x << 4) +  2 + offset + x_add].val = screen->line[dl][(x << 4) +  3 + offset + x_add].val = ega->pallook[ega->egapal[(dat & 0xf) & ega->attrregs[0x12]]];
-	screen->line[dl][(x << 4) +      offset + x_add].val = screen->line[dl][(x << 4) +  1 + offset + x_add].val = ega->pallook[ega->egapal[(dat >> 4)  & ega->attrregs[0x12]]];
+    if (ega->seqregs[1] & 4) {
+	ega->ma = (ega->ma + 2) & ega->vrammask;
+
+	return(planelookup[ega->vram[addr | oddeven]] |
+	       (planelookup[ega->vram[addr | oddeven | 0x2]] << 2));
     }
+
+    ega->ma = (ega->ma + 4) & ega->vrammask;
+
+    return(planelookup[ega->vram[addr]] |
+	   (planelookup[ega->vram[addr | 0x1]] << 1) |
+	   (planelookup[ega->vram[addr | 0x2]] << 2) |
+	   (planelookup[ega->vram[addr | 0x3]] << 3));
+}
+
+
+/* Look up the colors of all 16 pels for this line just once. */
+static void
+ega_4bpp_colors(ega_t *ega, uint32_t *col)
+{
+    int c;
+
+    for (c = 0; c < 16; c++)
+	col[c] = ega->pallook[ega->egapal[c & ega->attrregs[0x12]]];
 }
 
 
 void
-ega_render_4bpp_highres(ega_t *ega)
+ega_render_4bpp_lowres(ega_t *ega)
 {
     int x_add = (enable_overscan) ? 8 : 0;
     int dl = ega_display_line(ega);
-    int offset = (8 - ega->scrollcache) + 24;
-    int x;
+    int offset = ((8 - ega->scrollcache) << 1) + 16;
+    uint32_t col[16], px;
+    pel_t *p;
+    int x, i;
 
-    for (x = 0; x <= ega->hdisp; x++) {
-	uint8_t edat[4];
-	uint8_t dat;
-	uint32_t addr = ega->ma;
-	int oddeven = 0;
+    if (! ega_4bpp_changed(ega)) return;
 
-	if (!(ega->crtc[0x17] & 0x40)) {
-		addr = (addr << 1) & ega->vrammask;
-		if (ega->seqregs[1] & 4)
-			oddeven = (addr & 4) ? 1 : 0;
-		addr &= ~7;
-		if ((ega->crtc[0x17] & 0x20) && (ega->ma & 0x20000))
-			addr |= 4;
-		if (!(ega->crtc[0x17] & 0x20) && (ega->ma & 0x8000))
-			addr |= 4;
-	}
-	if (!(ega->crtc[0x17] & 0x01))
-	       addr = (addr & ~0x8000) | ((ega->sc & 1) ? 0x8000 : 0);
-	if (!(ega->crtc[0x17] & 0x02))
-		addr = (addr & ~0x10000) | ((ega->sc & 2) ? 0x10000 : 0);
+    ega_4bpp_colors(ega, col);
+
+    p = &screen->line[dl][offset + x_add];
+    for (x = 0; x <= ega->hdisp; x++) {
+	px = ega_4bpp_fetch(ega);
+	for (i = 0; i < 16; i += 2, px >>= 4)
+		p[i].val = p[i + 1].val = col[px & 0x0f];
+	p += 16;
+    }
+}
 
-	if (ega->seqregs[1] & 4) {
-		edat[0] = ega->vram[addr | oddeven];
-		edat[2] = ega->vram[addr | oddeven | 0x2];
-		edat[1] = edat[3] = 0;
-		ega->ma += 2;
-	} else {
-		edat[0] = ega->vram[addr];
-		edat[1] = ega->vram[addr | 0x1];
-		edat[2] = ega->vram[addr | 0x2];
-		edat[3] = ega->vram[addr | 0x3];
-		ega->ma += 4;
-	}
-	ega->ma &= ega->vrammask;
 
-	dat = edatlookup[edat[0] & 3][edat[1] & 3] | (edatlookup[edat[2] & 3][edat[3] & 3] << 2);
-	screen->line[dl][(x << 3) + 7 + offset + x_add].val = ega->pallook[ega->egapal[(dat & 0xf) & ega->attrregs[0x12]]];
-	screen->line[dl][(x << 3) + 6 + offset + x_add].val = ega->pallook[ega->egapal[(dat >> 4)  & ega->attrregs[0x12]]];
+void
+ega_render_4bpp_highres(ega_t *ega)
+{
+    int x_add = (enable_overscan) ? 8 : 0;
+    int dl = ega_display_line(ega);
+    int offset = (8 - ega->scrollcache) + 24;
+    uint32_t col[16], px;
+    pel_t *p;
+    int x, i;
 
-	dat = edatlookup[(edat[0] >> 2) & 3][(edat[1] >> 2) & 3] | (edatlookup[(edat[2] >> 2) & 3][(edat[3] >> 2) & 3] << 2);
-	screen->line[dl][(x << 3) + 5 + offset + x_add].val = ega->pallook[ega->egapal[(dat & 0xf) & ega->attrregs[0x12]]];
-	screen->line[dl][(x << 3) + 4 + offset + x_add].val = ega->pallook[ega->egapal[(dat >> 4)  & ega->attrregs[0x12]]];
+    if (! ega_4bpp_changed(ega)) return;
 
-	dat = edatlookup[(edat[0] >> 4) & 3][(edat[1] >> 4) & 3] | (edatlookup[(edat[2] >> 4) & 3][(edat[3] >> 4) & 3] << 2);
-	screen->line[dl][(x << 3) + 3 + offset + x_add].val = ega->pallook[ega->egapal[(dat & 0xf) & ega->attrregs[0x12]]];
-	screen->line[dl][(x << 3) + 2 + offset + x_add].val = ega->pallook[ega->egapal[(dat >> 4)  & ega->attrregs[0x12]]];
+    ega_4bpp_colors(ega, col);
 
-	dat = edatlookup[edat[0] >> 6][edat[1] >> 6] | (edatlookup[edat[2] >> 6][edat[3] >> 6] << 2);
-	screen->line[dl][(x << 3) + 1 + offset + x_add].val = ega->pallook[ega->egapal[(dat & 0xf) & ega->attrregs[0x12]]];
-	screen->line[dl][(x << 3) +     offset + x_add].val = ega->pallook[ega->egapal[(dat >> 4)  & ega->attrregs[0x12]]];
+    p = &screen->line[dl][offset + x_add];
+    for (x = 0; x <= ega->hdisp; x++) {
+	px = ega_4bpp_fetch(ega);
+	for (i = 0; i < 8; i++, px >>= 4)
+		p[i].val = col[px & 0x0f];
+	p += 8;
     }
 }
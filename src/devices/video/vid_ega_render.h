@@ -8,7 +8,7 @@
  *
  *		Definitions for the EGA renderer.
  *
- * Version:	@(#)vid_ega_render.h	1.0.1	2018/02/14
+ * Version:	@(#)vid_ega_render.h	1.0.2	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -49,7 +49,7 @@ extern int con, cursoron, cgablink;
 
 extern int scrollcache;
 
-extern uint8_t edatlookup[4][4];
+extern uint32_t planelookup[256];
 
 void ega_render_blank(ega_t *ega);
 void ega_render_text_standard(ega_t *ega, int drawcursor);
@@ -8,7 +8,7 @@
  *
  *		Hercules emulation.
  *
- * Version:	@(#)vid_hercules.c	1.0.23	2021/10/23
+ * Version:	@(#)vid_hercules.c	1.0.24	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -88,6 +88,9 @@ typedef struct {
 
     uint8_t	cols[256][2][2];
 
+    int		fullchange;
+    textcache_t	text;
+
     uint8_t	*vram;
 } hercules_t;
 
@@ -145,6 +148,8 @@ hercules_out(uint16_t addr, uint8_t val, priv_t priv)
 		if (old != val) {
 			if ((dev->crtcreg < 0xe) || (dev->crtcreg > 0x10)) {
 				fullchange = changeframecount;
+				if ((dev->crtcreg < 0xc) || (dev->crtcreg > 0xd))
+					dev->fullchange = changeframecount;
 				recalc_timings(dev);
 			}
 		}
@@ -164,8 +169,10 @@ hercules_out(uint16_t addr, uint8_t val, priv_t priv)
 			dev->ctrl |= 0x80;
 
 		dev->ctrl = (dev->ctrl & 0x82) | (val & 0x7d);
-		if (old != val)
+		if (old != val) {
+			dev->fullchange = changeframecount;
 			recalc_timings(dev);
+		}
 		break;
 
 	case 0x03bf:
@@ -288,11 +295,14 @@ static void
 hercules_poll(priv_t priv)
 {
     hercules_t *dev = (hercules_t *)priv;
-    uint8_t chr, attr;
+    uint8_t chr, attr, flags;
     uint16_t ca, dat, pa;
+    uint32_t fg, bg, last;
+    const uint32_t *m;
     int oldsc, blink;
     int x, c, oldvc;
-    int drawcursor;
+    int drawcursor, newrow;
+    pel_t *pels;
 
     ca = (dev->crtc[15] | (dev->crtc[14] << 8)) & 0x3fff;
 
@@ -334,36 +344,62 @@ hercules_poll(priv_t priv)
 				}
 			}
 		} else {
-			for (x = 0; x < dev->crtc[1]; x++) {
+			pels = screen->line[dev->displine];
+
+			/* Only draw the cells that changed since the last frame. */
+			newrow = text_row(&dev->text, dev->ma, dev->displine, dev->fullchange);
+			if (!newrow && !dev->text.dirty)
+				x = dev->crtc[1];
+			else
+				x = 0;
+			if (dev->ctrl2 & 0x01)
+				dev->ma = (dev->ma + x) & 0x3fff;
+			else
+				dev->ma = (dev->ma + x) & 0x7ff;
+
+			for (; x < dev->crtc[1]; x++) {
 				if (dev->ctrl & 8) {
 					chr  = dev->vram[(dev->ma << 1) & 0xfff];
 					attr = dev->vram[((dev->ma << 1) + 1) & 0xfff];
 				} else
 					chr = attr = 0;
-				drawcursor = ((dev->ma == ca) && dev->con && dev->cursoron);
-				blink = ((dev->blink & 16) && (dev->ctrl & 0x20) && (attr & 0x80) && !drawcursor);
-
-				if (dev->sc == 12 && ((attr & 7) == 1)) {
-					for (c = 0; c < 9; c++)
-					    screen->line[dev->displine][(x * 9) + c].pal = dev->cols[attr][blink][1];
-				} else {
-					for (c = 0; c < 8; c++)
-					    screen->line[dev->displine][(x * 9) + c].pal = dev->cols[attr][blink][(fontdatm[chr][dev->sc] & (1 << (c ^ 7))) ? 1 : 0];
-
-					if ((chr & ~0x1f) == 0xc0)
-						screen->line[dev->displine][(x * 9) + 8].pal = dev->cols[attr][blink][fontdatm[chr][dev->sc] & 1];
-					  else
-						screen->line[dev->displine][(x * 9) + 8].pal = dev->cols[attr][blink][0];
-				}
+				flags = 0;
+				if ((dev->ma == ca) && dev->cursoron)
+					flags |= TEXT_CURSOR;
+				if ((dev->blink & 16) && (dev->ctrl & 0x20) && (attr & 0x80))
+					flags |= TEXT_BLINK;
 				if (dev->ctrl2 & 0x01)
 					dev->ma = (dev->ma + 1) & 0x3fff;
 				else
 					dev->ma = (dev->ma + 1) & 0x7ff;
 
+				if (! text_cell(&dev->text, x, newrow, TEXT_KEY(chr, attr, flags)))
+					continue;
+
+				drawcursor = ((flags & TEXT_CURSOR) && dev->con);
+				blink = ((flags & TEXT_BLINK) && !drawcursor);
+				fg = dev->cols[attr][blink][1];
+				bg = dev->cols[attr][blink][0];
 				if (drawcursor) {
-					for (c = 0; c < 9; c++)
-					    screen->line[dev->displine][(x * 9) + c].pal ^= dev->cols[attr][0][1];
+					fg ^= dev->cols[attr][0][1];
+					bg ^= dev->cols[attr][0][1];
 				}
+
+				if (dev->sc == 12 && ((attr & 7) == 1)) {
+					dat = 0xff;
+					last = fg;
+				} else {
+					dat = fontdatm[chr][dev->sc];
+					last = (((chr & ~0x1f) == 0xc0) && (dat & 1)) ? fg : bg;
+				}
+
+				/* Draw the cell as a run of pels from the pre-expanded glyph row. */
+				fg = pal_lookup[fg];
+				bg = pal_lookup[bg];
+				m = glyphmask[dat];
+				for (c = 0; c < 8; c++)
+					pels[(x * 9) + c].val = bg ^ ((fg ^ bg) & m[c]);
+				pels[(x * 9) + 8].val = pal_lookup[last];
 			}
 		}
 	}
@@ -457,7 +493,8 @@ hercules_poll(priv_t priv)
 						video_force_resize_set(0);
 				}
 
-				video_blit_start(1, 0, dev->firstline, 0, ysize, xsize, ysize);
+				/* Text cells are drawn in color, graphics as palette indices. */
+				video_blit_start(dev->ctrl & 2, 0, dev->firstline, 0, ysize, xsize, ysize);
 				frames++;
 
 				if (dev->ctrl & 2) {
@@ -473,6 +510,8 @@ hercules_poll(priv_t priv)
 			dev->firstline = 1000;
 			dev->lastline = 0;
 			dev->blink++;
+			if (dev->fullchange)
+				dev->fullchange--;
 		}
 	} else {
 		dev->sc++;
@@ -8,7 +8,7 @@
  *
  *		MDA emulation.
  *
- * Version:	@(#)vid_mda.c	1.0.18	2019/05/17
+ * Version:	@(#)vid_mda.c	1.0.19	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -92,6 +92,9 @@ mda_out(uint16_t port, uint8_t val, priv_t priv)
 	case 0x03b5:
 	case 0x03b7:
 		dev->crtc[dev->crtcreg] = val;
+		/* Start and cursor address changes show up in the cells. */
+		if ((dev->crtcreg < 12) || (dev->crtcreg > 15))
+			dev->fullchange = changeframecount;
 		if (dev->crtc[10] == 6 && dev->crtc[11] == 7) {
 			/*Fix for Generic Turbo XT BIOS,
 			 * which sets up cursor registers wrong*/
@@ -102,6 +105,8 @@ mda_out(uint16_t port, uint8_t val, priv_t priv)
 		break;
 
 	case 0x03b8:
+		if (val != dev->ctrl)
+			dev->fullchange = changeframecount;
 		dev->ctrl = val;
 		break;
     }
@@ -167,7 +172,10 @@ mda_poll(priv_t priv)
     int drawcursor;
     int x, c;
     int oldvc;
-    uint8_t chr, attr;
+    uint8_t chr, attr, dat, flags;
+    uint32_t fg, bg, last;
+    const uint32_t *m;
+    int newrow;
     int oldsc;
     int blink;
     pel_t *pels;
@@ -189,28 +197,51 @@ mda_poll(priv_t priv)
 		}
 		dev->lastline = dev->displine;
 
-		for (x = 0; x < dev->crtc[1]; x++) {
+		/* Only draw the cells that changed since the last frame. */
+		newrow = text_row(&dev->text, dev->ma, dev->displine, dev->fullchange);
+		if (!newrow && !dev->text.dirty)
+			x = dev->crtc[1];
+		else
+			x = 0;
+		dev->ma += x;
+
+		for (; x < dev->crtc[1]; x++) {
 			chr  = dev->vram[(dev->ma << 1) & 0xfff];
 			attr = dev->vram[((dev->ma << 1) + 1) & 0xfff];
-			drawcursor = ((dev->ma == ca) && dev->con && dev->cursoron);
-			blink = ((dev->blink & 16) && (dev->ctrl & 0x20) && (attr & 0x80) && !drawcursor);
-			if (dev->sc == 12 && ((attr & 7) == 1)) {
-				for (c = 0; c < 9; c++)
-				    pels[(x * 9) + c].pal = dev->cols[attr][blink][1];
-			} else {
-				for (c = 0; c < 8; c++)
-				    pels[(x * 9) + c].pal = dev->cols[attr][blink][(fontdatm[chr][dev->sc] & (1 << (c ^ 7))) ? 1 : 0];
-				if ((chr & ~0x1f) == 0xc0)
-					pels[(x * 9) + 8].pal = dev->cols[attr][blink][fontdatm[chr][dev->sc] & 1];
-				else
-					pels[(x * 9) + 8].pal = dev->cols[attr][blink][0];
-			}
+			flags = 0;
+			if ((dev->ma == ca) && dev->cursoron)
+				flags |= TEXT_CURSOR;
+			if ((dev->blink & 16) && (dev->ctrl & 0x20) && (attr & 0x80))
+				flags |= TEXT_BLINK;
 			dev->ma++;
+			if (! text_cell(&dev->text, x, newrow, TEXT_KEY(chr, attr, flags)))
+				continue;
 
+			drawcursor = ((flags & TEXT_CURSOR) && dev->con);
+			blink = ((flags & TEXT_BLINK) && !drawcursor);
+			fg = dev->cols[attr][blink][1];
+			bg = dev->cols[attr][blink][0];
 			if (drawcursor) {
-				for (c = 0; c < 9; c++)
-				    pels[(x * 9) + c].pal ^= dev->cols[attr][0][1];
+				fg ^= dev->cols[attr][0][1];
+				bg ^= dev->cols[attr][0][1];
 			}
+
+			if (dev->sc == 12 && ((attr & 7) == 1)) {
+				dat = 0xff;
+				last = fg;
+			} else {
+				dat = fontdatm[chr][dev->sc];
+				last = (((chr & ~0x1f) == 0xc0) && (dat & 1)) ? fg : bg;
+			}
+
+			/* Draw the cell as a run of pels from the pre-expanded glyph row. */
+			fg = pal_lookup[fg];
+			bg = pal_lookup[bg];
+			last = pal_lookup[last];
+			m = glyphmask[dat];
+			for (c = 0; c < 8; c++)
+				pels[(x * 9) + c].val = bg ^ ((fg ^ bg) & m[c]);
+			pels[(x * 9) + 8].val = last;
 		}
 	}
 	dev->sc = oldsc;
@@ -284,7 +315,7 @@ mda_poll(priv_t priv)
 						video_force_resize_set(0);
 				}
 
-				video_blit_start(1, 0, dev->firstline, 0, ysize, xsize, ysize);
+				video_blit_start(0, 0, dev->firstline, 0, ysize, xsize, ysize);
 				frames++;
 
 				video_res_x = dev->crtc[1];
@@ -295,6 +326,8 @@ mda_poll(priv_t priv)
 			dev->firstline = 1000;
 			dev->lastline = 0;
 			dev->blink++;
+			if (dev->fullchange)
+				dev->fullchange--;
 		}
 	} else {
 		dev->sc++;
@@ -444,4 +477,5 @@ void
 mda_setcol(mda_t *dev, int chr, int blink, int fg, uint8_t cga_ink)
 {
     dev->cols[chr][blink][fg] = pal_lookup[cga_ink];
+    dev->fullchange = changeframecount;
 }
@@ -8,7 +8,7 @@
  *
  *		Definitions for the MDA driver.
  *
- * Version:	@(#)vid_mda.h	1.0.3	2019/05/17
+ * Version:	@(#)vid_mda.h	1.0.4	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *
@@ -64,6 +64,9 @@ typedef struct {
 
     uint8_t	cols[256][2][2];
 
+    int		fullchange;
+    textcache_t	text;
+
     uint8_t	*vram;
 } mda_t;
 
@@ -11,7 +11,7 @@
  *		This is intended to be used by another VGA/SVGA driver,
  *		and not as a card in it's own right.
  *
- * Version:	@(#)vid_svga.c	1.0.31	2021/09/30
+ * Version:	@(#)vid_svga.c	1.0.34	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -60,7 +60,6 @@
 
 
 extern int	cyc_total;
-extern uint8_t	edatlookup[4][4];
 
 uint8_t		svga_rotate[8][256];
 
@@ -72,6 +71,15 @@ static svga_t	*svga_pri;
 void svga_doblit(int y1, int y2, int wx, int wy, svga_t *svga);
 
 
+/* Is the text renderer one that only draws the changed cells? */
+static int
+svga_text_cells(svga_t *svga)
+{
+    return((svga->render == svga_render_text_80) ||
+	   (svga->render == svga_render_text_40));
+}
+
+
 svga_t *
 svga_get_pri(void)
 {
@@ -113,7 +121,9 @@ svga_out(uint16_t addr, uint8_t val, priv_t priv)
 				svga->fullchange = changeframecount;
 			o = svga->attrregs[svga->attraddr & 31];
 			svga->attrregs[svga->attraddr & 31] = val;
-			if (svga->attraddr < 16) 
+			/* Palette, mode control and color select all change the colors. */
+			if ((svga->attraddr < 16) ||
+			    (((svga->attraddr == 0x10) || (svga->attraddr == 0x14)) && (o != val)))
 				svga->fullchange = changeframecount;
 			if (svga->attraddr == 0x10 || svga->attraddr == 0x14 || svga->attraddr < 0x10) {
 				for (c = 0; c < 16; c++) {
@@ -183,6 +193,7 @@ svga_out(uint16_t addr, uint8_t val, priv_t priv)
 					svga->charseta += 0x8000;
 				if (val & 0x20)
 					svga->charsetb += 0x8000;
+				svga->fullchange = changeframecount;
 				break;
 
 			case 4: 
@@ -756,7 +767,8 @@ svga_poll(priv_t priv)
 		else
 			svga->cursoron = svga->blink & 16;
 
-		if (!(svga->gdcreg[6] & 1) && !(svga->blink & 15)) 
+		if (!(svga->gdcreg[6] & 1) && !(svga->blink & 15) &&
+		    !svga_text_cells(svga)) 
 			svga->fullchange = 2;
 		svga->blink++;
 
@@ -997,9 +1009,6 @@ svga_write_common(uint32_t addr, uint8_t val, uint8_t linear, priv_t priv)
 			return;
     }
 
-    if (!(svga->gdcreg[6] & 1))
-		svga->fullchange = 2;
-
     if ((svga->adv_flags & FLAG_ADDR_BY16) && (svga->writemode == 4 || svga->writemode == 5))
 	addr <<= 4;
     else if ((svga->adv_flags & FLAG_ADDR_BY8) && (svga->writemode < 4))
@@ -1028,6 +1037,15 @@ svga_write_common(uint32_t addr, uint8_t val, uint8_t linear, priv_t priv)
 
     addr &= svga->vram_mask;
 
+    /*
+     * The text renderers that track cells see changes to the
+     * characters and attributes themselves, so they only need
+     * a full redraw if the font (in plane 2) was written to.
+     */
+    if (!(svga->gdcreg[6] & 1) && (!svga_text_cells(svga) ||
+	(writemask2 & 4) || (svga->adv_flags & (FLAG_ADDR_BY8 | FLAG_ADDR_BY16))))
+		svga->fullchange = 2;
+
     svga->changedvram[addr >> 12] = changeframecount;
 
     /* standard VGA latched access */
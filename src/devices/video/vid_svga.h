@@ -8,7 +8,7 @@
  *
  *		Definitions for the generic SVGA driver.
  *
- * Version:	@(#)vid_svga.h	1.0.13	2021/09/21
+ * Version:	@(#)vid_svga.h	1.0.14	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -108,6 +108,8 @@ typedef struct svga_t
 	     *map8, pallook[512];
 
     latch_t latch;
+
+    textcache_t text;
     
     PALETTE vgapal;
 
@@ -8,7 +8,7 @@
  *
  *		SVGA renderers.
  *
- * Version:	@(#)vid_svga_render.c	1.0.20	2021/10/21
+ * Version:	@(#)vid_svga_render.c	1.0.22	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -91,67 +91,99 @@ svga_render_blank(svga_t *svga)
 }
 
 
+/*
+ * Fetch the character cell at svga->ma, and see if it has to be
+ * drawn on this scan line. If so, return its character, the font
+ * byte for the line, and the colors to use.
+ */
+static int
+text_fetch(svga_t *svga, int col, int newrow,
+	   uint8_t *chr, uint8_t *dat, uint32_t *fg, uint32_t *bg)
+{
+    uint32_t addr = svga->remap_func(svga, svga->ma) & svga->vram_display_mask;
+    uint32_t charaddr;
+    uint8_t attr, flags = 0;
+
+    *chr = svga->vram[addr];
+    attr = svga->vram[addr+1];
+
+    if ((svga->ma == svga->ca) && svga->cursoron)
+	flags |= TEXT_CURSOR;
+    if ((attr & 0x80) && (svga->attrregs[0x10] & 8) && (svga->blink & 16))
+	flags |= TEXT_BLINK;
+
+    if (! text_cell(&svga->text, col, newrow, TEXT_KEY(*chr, attr, flags)))
+	return(0);
+
+    if (attr & 8)
+	charaddr = svga->charsetb + (*chr * 128);
+    else
+	charaddr = svga->charseta + (*chr * 128);
+
+    if ((flags & TEXT_CURSOR) && svga->con) {
+	*bg = svga->pallook[svga->egapal[attr & 15]];
+	*fg = svga->pallook[svga->egapal[attr >> 4]];
+    } else {
+	*fg = svga->pallook[svga->egapal[attr & 15]];
+	*bg = svga->pallook[svga->egapal[attr >> 4]];
+
+	if (attr & 0x80 && svga->attrregs[0x10] & 8) {
+		*bg = svga->pallook[svga->egapal[(attr >> 4) & 7]];
+		if (flags & TEXT_BLINK)
+			*fg = *bg;
+	}
+    }
+
+    *dat = svga->vram[charaddr + (svga->sc << 2)];
+
+    return(1);
+}
+
+
 void
 svga_render_text_40(svga_t *svga)
 {     
     int y_add = enable_overscan ? (overscan_y >> 1) : 0;
     int x_add = enable_overscan ? 8 : 0;
     int xinc = (svga->seqregs[1] & 1) ? 16 : 18;
-    uint8_t chr, attr, dat;
-    uint32_t charaddr;
-    int bg, fg, x, xx;
-    int drawcursor;
+    const uint32_t *m;
+    uint8_t chr, dat;
+    uint32_t bg, fg;
+    int col, x, xx;
+    int newrow;
     pel_t *p;
 
     if (svga->firstline_draw == 2000) 
 	svga->firstline_draw = svga->displine;
     svga->lastline_draw = svga->displine;
-	
-    if (svga->fullchange) {
-	p = &screen->line[svga->displine + y_add][32 + x_add];
 
-	for (x = 0; x < svga->hdisp; x += xinc) {
-		uint32_t addr = svga->remap_func(svga, svga->ma) & svga->vram_display_mask;
-		drawcursor = ((svga->ma == svga->ca) && svga->con && svga->cursoron);
-		chr  = svga->vram[addr];
-		attr = svga->vram[addr+1];
-		if (attr & 8)
-			charaddr = svga->charsetb + (chr * 128);
-		else
-			charaddr = svga->charseta + (chr * 128);
+    /* Only draw the cells that changed since the last frame. */
+    newrow = text_row(&svga->text, svga->ma, svga->displine,
+		      svga->fullchange || svga->interlace);
+    if (!newrow && !svga->text.dirty)
+	return;
 
-		if (drawcursor) { 
-			bg = svga->pallook[svga->egapal[attr & 15]]; 
-			fg = svga->pallook[svga->egapal[attr >> 4]]; 
-		} else {
-			fg = svga->pallook[svga->egapal[attr & 15]];
-			bg = svga->pallook[svga->egapal[attr >> 4]];
-			if (attr & 0x80 && svga->attrregs[0x10] & 8) {
-				bg = svga->pallook[svga->egapal[(attr >> 4) & 7]];
-				if (svga->blink & 16) 
-					fg = bg;
-			}
-		}
+    p = &screen->line[svga->displine + y_add][32 + x_add];
 
-		dat = svga->vram[charaddr + (svga->sc << 2)];
-		if (svga->seqregs[1] & 1) { 
-			for (xx = 0; xx < 16; xx += 2) 
-				p[xx].val = p[xx + 1].val = (dat & (0x80 >> (xx >> 1))) ? fg : bg;
-		} else {
-			for (xx = 0; xx < 16; xx += 2)
-				p[xx].val = p[xx + 1].val = (dat & (0x80 >> (xx >> 1))) ? fg : bg;
+    for (x = col = 0; x < svga->hdisp; x += xinc, col++) {
+	if (text_fetch(svga, col, newrow, &chr, &dat, &fg, &bg)) {
+		m = glyphmask[dat];
+		fg ^= bg;
+		for (xx = 0; xx < 8; xx++)
+			p[xx << 1].val = p[(xx << 1) + 1].val = bg ^ (fg & m[xx]);
+		if (! (svga->seqregs[1] & 1)) {
 			if ((chr & ~0x1F) != 0xC0 || !(svga->attrregs[0x10] & 4))
 				p[16].val = p[17].val = bg;
 			else		  
-				p[16].val = p[17].val = (dat & 1) ? fg : bg;
+				p[16].val = p[17].val = bg ^ (fg & m[7]);
 		}
-
-		svga->ma += 4; 
-		p += xinc;
 	}
 
-	svga->ma &= svga->vram_display_mask;
+	svga->ma += 4; 
+	p += xinc;
     }
+
+    svga->ma &= svga->vram_display_mask;
 }
 
 
@@ -161,63 +193,45 @@ svga_render_text_80(svga_t *svga)
     int y_add = enable_overscan ? (overscan_y >> 1) : 0;
     int x_add = enable_overscan ? 8 : 0;
     int xinc = (svga->seqregs[1] & 1) ? 8 : 9;
-    uint8_t chr, attr, dat;
-    uint32_t charaddr;
-    int bg, fg, x, xx;
-    int drawcursor;
+    const uint32_t *m;
+    uint8_t chr, dat;
+    uint32_t bg, fg;
+    int col, x, xx;
+    int newrow;
     pel_t *p;
 
     if (svga->firstline_draw == 2000) 
 	svga->firstline_draw = svga->displine;
     svga->lastline_draw = svga->displine;
-	
-    if (svga->fullchange) {
-	p = &screen->line[svga->displine + y_add][32 + x_add];
-
-	for (x = 0; x < svga->hdisp; x += xinc) {
-		uint32_t addr = svga->remap_func(svga, svga->ma) & svga->vram_display_mask;
-		drawcursor = ((svga->ma == svga->ca) && svga->con && svga->cursoron);
-		chr  = svga->vram[addr];
-		attr = svga->vram[addr+1];
 
-		if (attr & 8)
-			charaddr = svga->charsetb + (chr * 128);
-		else
-			charaddr = svga->charseta + (chr * 128);
+    /* Only draw the cells that changed since the last frame. */
+    newrow = text_row(&svga->text, svga->ma, svga->displine,
+		      svga->fullchange || svga->interlace);
+    if (!newrow && !svga->text.dirty)
+	return;
 
-		if (drawcursor) { 
-			bg = svga->pallook[svga->egapal[attr & 15]]; 
-			fg = svga->pallook[svga->egapal[attr >> 4]]; 
-		} else {
-			fg = svga->pallook[svga->egapal[attr & 15]];
-			bg = svga->pallook[svga->egapal[attr >> 4]];
+    p = &screen->line[svga->displine + y_add][32 + x_add];
 
-			if (attr & 0x80 && svga->attrregs[0x10] & 8) {
-				bg = svga->pallook[svga->egapal[(attr >> 4) & 7]];
-				if (svga->blink & 16) 
-					fg = bg;
-			}
-		}
-
-		dat = svga->vram[charaddr + (svga->sc << 2)];
-		if (svga->seqregs[1] & 1) { 
-			for (xx = 0; xx < 8; xx++) 
-				p[xx].val = (dat & (0x80 >> xx)) ? fg : bg;
-		} else {
-			for (xx = 0; xx < 8; xx++) 
-				p[xx].val = (dat & (0x80 >> xx)) ? fg : bg;
+    for (x = col = 0; x < svga->hdisp; x += xinc, col++) {
+	if (text_fetch(svga, col, newrow, &chr, &dat, &fg, &bg)) {
+		/* Whole 8-pel run from the pre-expanded glyph row. */
+		m = glyphmask[dat];
+		fg ^= bg;
+		for (xx = 0; xx < 8; xx++)
+			p[xx].val = bg ^ (fg & m[xx]);
+		if (! (svga->seqregs[1] & 1)) {
 			if ((chr & ~0x1F) != 0xC0 || !(svga->attrregs[0x10] & 4)) 
 				p[8].val = bg;
 			else		  
-				p[8].val = (dat & 1) ? fg : bg;
+				p[8].val = bg ^ (fg & m[7]);
 		}
-
-		svga->ma += 4; 
-		p += xinc;
 	}
 
-	svga->ma &= svga->vram_display_mask;
+	svga->ma += 4; 
+	p += xinc;
     }
+
+    svga->ma &= svga->vram_display_mask;
 }
 
 
@@ -423,14 +437,25 @@ svga_render_2bpp_highres(svga_t *svga)
 }
 
 
+/* Look up the colors of all 16 pels for this line just once. */
+static void
+svga_4bpp_colors(svga_t *svga, uint32_t *col)
+{
+    int c;
+
+    for (c = 0; c < 16; c++)
+	col[c] = svga->pallook[svga->egapal[c & svga->plane_mask]];
+}
+
+
 void
 svga_render_4bpp_lowres(svga_t *svga)
 {
     int y_add = enable_overscan ? (overscan_y >> 1) : 0;
     int x_add = enable_overscan ? 8 : 0;
-    int offset, x;
-    uint8_t edat[4], dat;
-    uint32_t *eptr = (uint32_t *)edat;
+    int offset, x, i;
+    uint32_t col[16], px;
+    uint8_t *edat;
     pel_t *p;
     uint32_t changed_addr = svga->remap_func(svga, svga->ma);
 
@@ -442,25 +467,18 @@ svga_render_4bpp_lowres(svga_t *svga)
 		svga->firstline_draw = svga->displine;
 	svga->lastline_draw = svga->displine;
 
+	svga_4bpp_colors(svga, col);
+
 	for (x = 0; x <= svga->hdisp; x += 16) {
-		uint32_t addr = svga->remap_func(svga, svga->ma);
-		*eptr = *(uint32_t *)(&svga->vram[addr]);			
+		edat = &svga->vram[svga->remap_func(svga, svga->ma)];
 
 		svga->ma += 4; 
 		svga->ma &= svga->vram_display_mask;
 
-		dat = edatlookup[edat[0] >> 6][edat[1] >> 6] | (edatlookup[edat[2] >> 6][edat[3] >> 6] << 2);
-		p[0].val  = p[1].val  = svga->pallook[svga->egapal[(dat >> 4) & svga->plane_mask]];
-		p[2].val  = p[3].val  = svga->pallook[svga->egapal[dat & svga->plane_mask]];
-		dat = edatlookup[(edat[0] >> 4) & 3][(edat[1] >> 4) & 3] | (edatlookup[(edat[2] >> 4) & 3][(edat[3] >> 4) & 3] << 2);
-		p[4].val  = p[5].val  = svga->pallook[svga->egapal[(dat >> 4) & svga->plane_mask]];
-		p[6].val  = p[7].val  = svga->pallook[svga->egapal[dat & svga->plane_mask]];
-		dat = edatlookup[(edat[0] >> 2) & 3][(edat[1] >> 2) & 3] | (edatlookup[(edat[2] >> 2) & 3][(edat[3] >> 2) & 3] << 2);
-		p[8].val  = p[9].val  = svga->pallook[svga->egapal[(dat >> 4) & svga->plane_mask]];
-		p[10].val = p[11].val = svga->pallook[svga->egapal[dat & svga->plane_mask]];
-		dat = edatlookup[edat[0] & 3][edat[1] & 3] | (edatlookup[edat[2] & 3][edat[3] & 3] << 2);
-		p[12].val = p[13].val = svga->pallook[svga->egapal[(dat >> 4) & svga->plane_mask]];
-		p[14].val = p[15].val = svga->pallook[svga->egapal[dat & svga->plane_mask]];
+		px = planelookup[edat[0]] | (planelookup[edat[1]] << 1) |
+		     (planelookup[edat[2]] << 2) | (planelookup[edat[3]] << 3);
+		for (i = 0; i < 16; i += 2, px >>= 4)
+			p[i].val = p[i + 1].val = col[px & 0x0f];
 
 		p += 16;
 	}
@@ -473,9 +491,9 @@ svga_render_4bpp_highres(svga_t *svga)
 {
     int y_add = enable_overscan ? (overscan_y >> 1) : 0;
     int x_add = enable_overscan ? 8 : 0;
-    int offset, x;
-    uint8_t edat[4], dat;
-    uint32_t *eptr = (uint32_t *)edat;
+    int offset, x, i;
+    uint32_t col[16], px;
+    uint8_t *edat;
     pel_t *p;
     uint32_t changed_addr = svga->remap_func(svga, svga->ma);
 
@@ -487,24 +505,20 @@ svga_render_4bpp_highres(svga_t *svga)
 		svga->firstline_draw = svga->displine;
 	svga->lastline_draw = svga->displine;
 
+	svga_4bpp_colors(svga, col);
+
 	for (x = 0; x <= svga->hdisp; x += 8) {
-		uint32_t addr = svga->remap_func(svga, svga->ma);
-		*eptr = *(uint32_t *)(&svga->vram[addr]);
+		edat = &svga->vram[svga->remap_func(svga, svga->ma)];
+
 		svga->ma += 4;
 		svga->ma &= svga->vram_display_mask;
 
-		dat = edatlookup[edat[0] >> 6][edat[1] >> 6] | (edatlookup[edat[2] >> 6][edat[3] >> 6] << 2);
-		p++->val = svga->pallook[svga->egapal[(dat >> 4) & svga->plane_mask]];
-		p++->val = svga->pallook[svga->egapal[dat & svga->plane_mask]];
-		dat = edatlookup[(edat[0] >> 4) & 3][(edat[1] >> 4) & 3] | (edatlookup[(edat[2] >> 4) & 3][(edat[3] >> 4) & 3] << 2);
-		p++->val = svga->pallook[svga->egapal[(dat >> 4) & svga->plane_mask]];
-		p++->val = svga->pallook[svga->egapal[dat & svga->plane_mask]];
-		dat = edatlookup[(edat[0] >> 2) & 3][(edat[1] >> 2) & 3] | (edatlookup[(edat[2] >> 2) & 3][(edat[3] >> 2) & 3] << 2);
-		p++->val = svga->pallook[svga->egapal[(dat >> 4) & svga->plane_mask]];
-		p++->val = svga->pallook[svga->egapal[dat & svga->plane_mask]];
-		dat = edatlookup[edat[0] & 3][edat[1] & 3] | (edatlookup[edat[2] & 3][edat[3] & 3] << 2);
-		p++->val = svga->pallook[svga->egapal[(dat >> 4) & svga->plane_mask]];
-		p++->val = svga->pallook[svga->egapal[dat & svga->plane_mask]];
+		px = planelookup[edat[0]] | (planelookup[edat[1]] << 1) |
+		     (planelookup[edat[2]] << 2) | (planelookup[edat[3]] << 3);
+		for (i = 0; i < 8; i++, px >>= 4)
+			p[i].val = col[px & 0x0f];
+
+		p += 8;
 	}
     }
 }
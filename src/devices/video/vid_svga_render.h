@@ -8,7 +8,7 @@
  *
  *		Definitions for the SVGA renderers.
  *
- * Version:	@(#)vid_svga_render.h	1.0.4	2020/11/16
+ * Version:	@(#)vid_svga_render.h	1.0.5	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -46,7 +46,7 @@ extern int	sc;
 extern uint32_t	ma, ca;
 extern int	con, cursoron, cgablink;
 extern int	scrollcache;
-extern uint8_t	edatlookup[4][4];
+extern uint32_t	planelookup[256];
 
 extern void	svga_recalc_remap_func(svga_t *svga);
 
@@ -8,7 +8,7 @@
  *
  *		Main video-rendering module.
  *
- * Version:	@(#)video.c	1.0.35	2021/10/22
+ * Version:	@(#)video.c	1.0.40	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -55,6 +55,7 @@
 #include "../../device.h"
 #include "../../timer.h"
 #include "../../plat.h"
+#include "../../misc/capture.h"
 #include "video.h"
 #include "vid_mda.h"
 #include "vid_svga.h"
@@ -78,13 +79,15 @@ uint32_t	*video_6to8 = NULL,
 		*video_15to32 = NULL,
 		*video_16to32 = NULL;
 uint32_t	pal_lookup[256];
-uint8_t		edatlookup[4][4];
+uint32_t	planelookup[256];
+uint32_t	glyphmask[256][8];
 int		xsize = 1,
 		ysize = 1;
 int		cga_palette = 0;
 int		changeframecount = 2;
 int		frames = 0;
 int		fullchange = 0;
+static uint32_t	blit_count = 0;
 int		displine = 0;
 int		enable_overscan,
 		update_overscan,
@@ -411,6 +414,9 @@ blit_thread(void *param)
 	thread_wait_event(blit->wake_ev, -1);
 	thread_reset_event(blit->wake_ev);
 
+	vidfb_publish(screen, blit->x, blit->y,
+		      blit->y1, blit->y2, blit->w, blit->h);
+
 	if (blit->func != NULL)
 		blit->func(screen, blit->x, blit->y,
 			   blit->y1, blit->y2, blit->w, blit->h);
@@ -546,6 +552,11 @@ video_blit_start(int pal, int x, int y, int y1, int y2, int w, int h)
 	}
     }
 
+    blit_count++;
+
+    /* Record the frame if we are capturing. */
+    capture_video(x, y, y1, y2, w, h);
+
     /* Wait for access to the blitter. */
     video_blit_wait();
 
@@ -572,6 +583,9 @@ video_palette_rebuild(void)
     /* We cannot do this (yet) if we have not been enabled yet. */
     if (video_6to8 == NULL) return;
 
+    /* Cells drawn with the old colors are no longer valid. */
+    blit_count++;
+
     for (c = 0; c < 256; c++) {
 	pal_lookup[c] = makecol(video_6to8[cgapal[c].r],
 			        video_6to8[cgapal[c].g],
@@ -777,16 +791,31 @@ video_init(void)
 	}
     }
 
-    for (c = 0; c < 4; c++) {
-	for (d = 0; d < 4; d++) {
-		edatlookup[c][d] = 0;
-		if (c & 1) edatlookup[c][d] |= 1;
-		if (d & 1) edatlookup[c][d] |= 2;
-		if (c & 2) edatlookup[c][d] |= 0x10;
-		if (d & 2) edatlookup[c][d] |= 0x20;
+    /*
+     * Spread the 8 bits of a plane byte out over a 32-bit word,
+     * one per nibble, with the leftmost pel in the low nibble.
+     * OR-ing the entries for the four planes together (shifted
+     * by their plane number) then gives us all 8 pel colors in
+     * one go.
+     */
+    for (c = 0; c < 256; c++) {
+	planelookup[c] = 0;
+	for (d = 0; d < 8; d++) {
+		if (c & (0x80 >> d))
+			planelookup[c] |= (1 << (d << 2));
 	}
     }
 
+    /*
+     * The pre-expanded glyph rows, with an all-ones mask for every
+     * pel that is set in a font byte. A text renderer can then draw
+     * a pel as (bg ^ ((fg ^ bg) & mask)), without testing any bits.
+     */
+    for (c = 0; c < 256; c++) {
+	for (d = 0; d < 8; d++)
+		glyphmask[c][d] = (c & (0x80 >> d)) ? 0xffffffff : 0x00000000;
+    }
+
     video_6to8 = (uint32_t *)mem_alloc(4 * 256);
     for (c = 0; c < 256; c++)
 	video_6to8[c] = calc_6to8(c);
@@ -1062,6 +1091,76 @@ video_color_transform(uint32_t color)
 }
 
 
+/*
+ * Start drawing a scan line of a text mode screen.
+ *
+ * Returns 1 if this is the first scan line of a character row, in
+ * which case the caller must pass every cell of the row through
+ * text_cell(). A scan line that is not below the previous one means
+ * a new frame has started. If 'redraw' is set, all cells are drawn.
+ */
+int
+text_row(textcache_t *tc, uint32_t ma, int line, int redraw)
+{
+    if ((line > tc->line) && (ma == tc->ma)) {
+	/* Another scan line of the same row. */
+	tc->line = line;
+	return(0);
+    }
+
+    if (line <= tc->line) {
+	/* A new frame. Only our own blit may have happened since. */
+	tc->stale = (blit_count != (tc->frame + 1));
+	tc->frame = blit_count;
+	tc->row = 0;
+    } else
+	tc->row++;
+    tc->line = line;
+    tc->ma = ma;
+    tc->redraw = redraw || tc->stale || (tc->row >= TEXT_MAX_ROWS);
+    tc->dirty = 0;
+
+    return(1);
+}
+
+
+/*
+ * See if a cell has to be drawn on this scan line.
+ *
+ * On the first scan line of a row, the cell's key is compared with
+ * (and replaces) the one drawn last time, and the outcome is kept
+ * for the other scan lines of the row.
+ */
+int
+text_cell(textcache_t *tc, int col, int newrow, uint32_t key)
+{
+    uint32_t *kp;
+    int changed;
+
+    if (col >= TEXT_MAX_COLS) {
+	/* Not tracked, so always drawn. */
+	tc->dirty += newrow;
+	return(1);
+    }
+
+    if (! newrow)
+	return(tc->changed[col]);
+
+    changed = tc->redraw;
+    if (tc->row < TEXT_MAX_ROWS) {
+	kp = &tc->keys[tc->row][col];
+	if (*kp != key) {
+		*kp = key;
+		changed = 1;
+	}
+    }
+    tc->changed[col] = changed;
+    tc->dirty += changed;
+
+    return(changed);
+}
+
+
 void
 video_transform_copy(uint32_t *dst, pel_t *src, int len)
 {
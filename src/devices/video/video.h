@@ -8,7 +8,7 @@
  *
  *		Definitions for the video controller module.
  *
- * Version:	@(#)video.h	1.0.43	2021/11/04
+ * Version:	@(#)video.h	1.0.46	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -110,10 +110,72 @@ typedef struct {
 
 typedef rgb_t PALETTE[256];
 
+/*
+ * The shared frame buffer.
+ *
+ * This header is followed by two buffers of VIDFB_MAX_Y lines of
+ * 'pitch' pels each, of which 'front' holds the latest frame. To
+ * read a frame, note buf[front].seq, use the pels, and then check
+ * if buf[front].seq is still the same; if not (or if it was 0 to
+ * begin with) the blitter was updating it, and the frame should
+ * be read again.
+ */
+#define VIDFB_MAGIC	0x42464456		// 'VDFB'
+#define VIDFB_MAX_X	2048
+#define VIDFB_MAX_Y	2048
+
+typedef struct {
+    volatile uint32_t seq;		// frame in this buffer, 0 if busy
+    int		w, h;			// size of that frame
+    int		y1, y2;			// lines changed in that frame
+} vidfb_buf_t;
+
+typedef struct {
+    uint32_t	magic;			// VIDFB_MAGIC
+    uint32_t	size;			// total size, in bytes
+    uint32_t	pitch;			// pels per line
+    uint32_t	offset[2];		// start of the pels of each buffer
+    volatile uint32_t seq;		// latest frame
+    volatile uint32_t front;		// buffer holding it
+    vidfb_buf_t	buf[2];
+} vidfb_t;
+
 typedef struct {
     uint8_t	chr[32];
 } dbcs_font_t;
 
+/*
+ * Cell change tracking for the text mode renderers.
+ *
+ * For every character cell we keep a key made up of what was drawn
+ * there last time (character, attribute and the cursor and blink
+ * state.) On the first scan line of a character row the keys are
+ * compared, and only the cells that changed are drawn on that and
+ * all other scan lines of the row.
+ *
+ * The screen buffer is assumed to still hold the cells drawn for the
+ * previous frame. If anything else was blitted in between (another
+ * renderer, or a palette rebuild), the whole frame is drawn again.
+ */
+#define TEXT_MAX_COLS	256
+#define TEXT_MAX_ROWS	128
+
+#define TEXT_KEY(c,a,f)	((c) | ((a) << 8) | ((f) << 16))
+#define TEXT_CURSOR	0x01			// cursor is in this cell
+#define TEXT_BLINK	0x02			// blinking cell is off
+
+typedef struct {
+    uint32_t	ma;			// start address of current row
+    uint32_t	frame;			// blit count at start of frame
+    int		line,			// last scan line drawn
+		row,			// current row on screen
+		redraw,			// draw all cells of this row
+		stale,			// draw all cells of this frame
+		dirty;			// number of changed cells in row
+    uint8_t	changed[TEXT_MAX_COLS];
+    uint32_t	keys[TEXT_MAX_ROWS][TEXT_MAX_COLS];
+} textcache_t;
+
 
 extern int		changeframecount;
 
@@ -147,6 +209,7 @@ extern int		video_res_x,
 			video_res_y,
 			video_bpp;
 extern int		cga_palette;
+extern uint32_t		glyphmask[256][8];
 
 extern float		cpuclock;
 extern int		frames;
@@ -384,6 +447,17 @@ extern void		video_force_resize_set(uint8_t res);
 extern uint32_t		video_color_transform(uint32_t color);
 extern void		video_transform_copy(uint32_t *dst, pel_t *src, int len);
 
+extern int		text_row(textcache_t *tc, uint32_t ma, int line,
+				 int redraw);
+extern int		text_cell(textcache_t *tc, int col, int newrow,
+				  uint32_t key);
+
+extern vidfb_t		*vidfb_open(void);
+extern void		vidfb_close(void);
+extern vidfb_t		*vidfb_get(void);
+extern void		vidfb_publish(bitmap_t *scr, int x, int y,
+				      int y1, int y2, int w, int h);
+
 #ifdef __cplusplus
 }
 #endif
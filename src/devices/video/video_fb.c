@@ -0,0 +1,314 @@
+/*
+ * VARCem	Virtual ARchaeological Computer EMulator.
+ *		An emulator of (mostly) x86-based PC systems and devices,
+ *		using the ISA,EISA,VLB,MCA  and PCI system buses, roughly
+ *		spanning the era between 1981 and 1995.
+ *
+ *		This file is part of the VARCem Project.
+ *
+ *		Double-buffered frame buffer, for use by renderers such as
+ *		VNC, and (through shared memory) by external tools.
+ *
+ * Version:	@(#)video_fb.c	1.0.3	2026/10/19
+ *
+ * Author:	agent, <agent@local>
+ *
+ *		Copyright 2026 agent.
+ *
+ *		Redistribution and  use  in source  and binary forms, with
+ *		or  without modification, are permitted  provided that the
+ *		following conditions are met:
+ *
+ *		1. Redistributions of  source  code must retain the entire
+ *		   above notice, this list of conditions and the following
+ *		   disclaimer.
+ *
+ *		2. Redistributions in binary form must reproduce the above
+ *		   copyright  notice,  this list  of  conditions  and  the
+ *		   following disclaimer in  the documentation and/or other
+ *		   materials provided with the distribution.
+ *
+ *		3. Neither the  name of the copyright holder nor the names
+ *		   of  its  contributors may be used to endorse or promote
+ *		   products  derived from  this  software without specific
+ *		   prior written permission.
+ *
+ * THIS SOFTWARE  IS  PROVIDED BY THE  COPYRIGHT  HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND  ANY EXPRESS  OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE  ARE  DISCLAIMED. IN  NO  EVENT  SHALL THE COPYRIGHT
+ * HOLDER OR  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL,  EXEMPLARY,  OR  CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE  GOODS OR SERVICES;  LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON  ANY
+ * THEORY OF  LIABILITY, WHETHER IN  CONTRACT, STRICT  LIABILITY, OR  TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING  IN ANY  WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <wchar.h>
+#ifdef _WIN32
+# define WIN32_LEAN_AND_MEAN
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <unistd.h>
+#endif
+#include "../../emu.h"
+#include "../../config.h"
+#include "../../plat.h"
+#include "video.h"
+
+
+static vidfb_t		*fb = NULL;
+static mutex_t		*fb_mutex = NULL;
+static size_t		fb_size;
+static int		fb_users = 0;
+static int		fb_shm = 0;
+static char		fb_name[64];
+#ifdef _WIN32
+static HANDLE		fb_map = NULL;
+#endif
+
+
+/* Set up the buffers in (shared) memory. */
+static vidfb_t *
+fb_alloc(const char *name)
+{
+    vidfb_t *ptr = NULL;
+
+    fb_size = sizeof(vidfb_t) +
+	      (2 * VIDFB_MAX_X * VIDFB_MAX_Y * sizeof(uint32_t));
+    fb_shm = 0;
+    strncpy(fb_name, name, sizeof(fb_name) - 1);
+
+#ifdef _WIN32
+    if (*name != '\0') {
+	fb_map = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL,
+				    PAGE_READWRITE,
+				    (DWORD)((uint64_t)fb_size >> 32),
+				    (DWORD)fb_size, name);
+	if (fb_map == NULL) {
+		ERRLOG("VIDEO: unable to create shared frame buffer '%s'\n", name);
+	} else {
+		ptr = (vidfb_t *)MapViewOfFile(fb_map, FILE_MAP_ALL_ACCESS,
+					       0, 0, fb_size);
+		if (ptr == NULL) {
+			ERRLOG("VIDEO: unable to map shared frame buffer '%s'\n", name);
+			CloseHandle(fb_map);
+			fb_map = NULL;
+		} else {
+			INFO("VIDEO: frame buffer shared as '%s'\n", name);
+			fb_shm = 1;
+		}
+	}
+    }
+#else
+    if (*name != '\0') {
+	int fd;
+
+	fd = shm_open(name, O_CREAT | O_RDWR, 0600);
+	if (fd < 0) {
+		ERRLOG("VIDEO: unable to create shared frame buffer '%s'\n", name);
+	} else {
+		if (ftruncate(fd, fb_size) == 0) {
+			ptr = (vidfb_t *)mmap(NULL, fb_size,
+					      PROT_READ | PROT_WRITE,
+					      MAP_SHARED, fd, 0);
+			if (ptr == (vidfb_t *)MAP_FAILED)
+				ptr = NULL;
+		}
+		(void)close(fd);
+
+		if (ptr == NULL) {
+			ERRLOG("VIDEO: unable to map shared frame buffer '%s'\n", name);
+			(void)shm_unlink(name);
+		} else {
+			INFO("VIDEO: frame buffer shared as '%s'\n", name);
+			fb_shm = 1;
+		}
+	}
+    }
+#endif
+
+    if (ptr == NULL)
+	ptr = (vidfb_t *)mem_alloc(fb_size);
+
+    memset(ptr, 0x00, sizeof(vidfb_t));
+    ptr->magic = VIDFB_MAGIC;
+    ptr->size = (uint32_t)fb_size;
+    ptr->pitch = VIDFB_MAX_X;
+    ptr->offset[0] = sizeof(vidfb_t);
+    ptr->offset[1] = ptr->offset[0] +
+		     (VIDFB_MAX_X * VIDFB_MAX_Y * sizeof(uint32_t));
+
+    return(ptr);
+}
+
+
+static void
+fb_free(vidfb_t *ptr)
+{
+    if (fb_shm) {
+#ifdef _WIN32
+	(void)UnmapViewOfFile(ptr);
+	CloseHandle(fb_map);
+	fb_map = NULL;
+#else
+	(void)munmap(ptr, fb_size);
+	(void)shm_unlink(fb_name);
+#endif
+	return;
+    }
+
+    free(ptr);
+}
+
+
+/*
+ * Start using the frame buffer.
+ *
+ * The first user creates it, and it will then be updated with
+ * every frame the blitter processes. If a name was configured,
+ * the frame buffer is created in shared memory, so that tools
+ * outside the emulator can use it as well.
+ */
+vidfb_t *
+vidfb_open(void)
+{
+    vidfb_t *ptr;
+
+    if (fb_mutex == NULL)
+	fb_mutex = thread_create_mutex(L"VARCem.VideoFB");
+
+    thread_wait_mutex(fb_mutex);
+
+    if (fb_users++ == 0) {
+	ptr = fb_alloc(config.vidfb_name);
+
+	/* Make sure it is all set up before the blitter sees it. */
+	thread_barrier();
+	fb = ptr;
+    }
+
+    thread_release_mutex(fb_mutex);
+
+    return(fb);
+}
+
+
+/* Stop using the frame buffer, and remove it if we were the last. */
+void
+vidfb_close(void)
+{
+    vidfb_t *ptr;
+
+    if (fb_mutex == NULL) return;
+
+    thread_wait_mutex(fb_mutex);
+
+    if ((fb_users > 0) && (--fb_users == 0)) {
+	ptr = fb;
+	fb = NULL;
+	fb_free(ptr);
+    }
+
+    thread_release_mutex(fb_mutex);
+}
+
+
+/* Return the current frame buffer, if any. */
+vidfb_t *
+vidfb_get(void)
+{
+    return(fb);
+}
+
+
+/*
+ * Publish a new frame, on the blitter thread.
+ *
+ * We copy the changed lines into the buffer that is not being
+ * shown, and then flip the two. That buffer still holds the
+ * frame before the current one, so the lines changed in that
+ * frame have to be brought up to date as well. Readers never
+ * hold us up; instead, they check the sequence number of the
+ * buffer they used to see if we changed it under them.
+ */
+void
+vidfb_publish(bitmap_t *scr, int x, int y, int y1, int y2, int w, int h)
+{
+    vidfb_buf_t *front, *back;
+    uint32_t *pels, seq;
+    int from, to, yy;
+
+    if ((fb == NULL) || (y1 == y2) || (w <= 0) || (h <= 0)) return;
+
+    thread_wait_mutex(fb_mutex);
+    if (fb == NULL) {
+	thread_release_mutex(fb_mutex);
+	return;
+    }
+
+    if (w > VIDFB_MAX_X)
+	w = VIDFB_MAX_X;
+    if (h > VIDFB_MAX_Y)
+	h = VIDFB_MAX_Y;
+    if (y2 > h)
+	y2 = h;
+
+    front = &fb->buf[fb->front];
+    back = &fb->buf[fb->front ^ 1];
+    pels = (uint32_t *)((uint8_t *)fb + fb->offset[fb->front ^ 1]);
+
+    /* Work out which lines of the back buffer are out of date. */
+    from = y1;
+    to = y2;
+    if ((back->seq == 0) || (back->w != w) || (back->h != h) ||
+	(front->w != w) || (front->h != h)) {
+	from = 0;
+	to = h;
+    } else {
+	if (front->y1 < from)
+		from = front->y1;
+	if (front->y2 > to)
+		to = front->y2;
+    }
+
+    /* Mark the buffer as busy while we update it. */
+    back->seq = 0;
+    thread_barrier();
+
+    for (yy = from; yy < to; yy++) {
+	if ((y + yy) >= 0 && (y + yy) < scr->h) {
+		if (config.vid_grayscale || config.invert_display)
+			video_transform_copy(&pels[yy * VIDFB_MAX_X],
+					     &scr->line[y + yy][x], w);
+		  else
+			memcpy(&pels[yy * VIDFB_MAX_X],
+			       &scr->line[y + yy][x], w * sizeof(uint32_t));
+	}
+    }
+
+    back->w = w;
+    back->h = h;
+    back->y1 = y1;
+    back->y2 = y2;
+
+    /* Sequence number 0 means "busy", so never use that. */
+    seq = fb->seq + 1;
+    if (seq == 0)
+	seq = 1;
+
+    thread_barrier();
+    back->seq = seq;
+    fb->front ^= 1;
+    thread_barrier();
+    fb->seq = seq;
+
+    thread_release_mutex(fb_mutex);
+}
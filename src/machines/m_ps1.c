@@ -26,7 +26,7 @@
  *		Though right now two serial ports seems to be needed for it to boot without
  *		1101 error.
  *
- * Version:	@(#)m_ps1.c	1.0.35	2021/04/30
+ * Version:	@(#)m_ps1.c	1.0.37	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -215,7 +215,9 @@ snd_out(uint16_t port, uint8_t val, priv_t priv)
 static void
 snd_update(ps1snd_t *snd)
 {
-    for (; snd->pos < sound_pos_global; snd->pos++)        
+    int end = sound_get_pos();
+
+    for (; snd->pos < end; snd->pos++)        
 	snd->buffer[snd->pos] = (int8_t)(snd->dac_val ^ 0x80) * 0x20;
 }
 
@@ -43,7 +43,7 @@
  *		Type table with the main code, so the user can only select
  *		items from that list...
  *
- * Version:	@(#)m_ps1_hdc.c	1.0.15	2021/03/18
+ * Version:	@(#)m_ps1_hdc.c	1.0.16	2026/10/19
  *
  * Author:	Fred N. van Kempen, <decwiz@yahoo.com>
  *
@@ -714,7 +714,9 @@ do_format(hdc_t *dev, drive_t *drive, ccb_t *ccb)
 	case STATE_RDATA:
 		/* Perform DMA. */
 		while (dev->buf_idx < dev->buf_len) {
-			val = dma_channel_read(dev->dma);
+			val = dma_channel_read_block(dev->dma,
+					&dev->buf_ptr[dev->buf_idx],
+					dev->buf_len - dev->buf_idx);
 			if (val == DMA_NODATA) {
 				ERRLOG("HDC: CMD_FORMAT out of data (idx=%d, len=%d)!\n", dev->buf_idx, dev->buf_len);
 				dev->intstat |= ISR_EQUIP_CHECK;
@@ -722,8 +724,7 @@ do_format(hdc_t *dev, drive_t *drive, ccb_t *ccb)
 				intr = 1;
 				break;
 			}
-			dev->buf_ptr[dev->buf_idx] = (val & 0xff);
-			dev->buf_idx++;
+			dev->buf_idx += (val & ~DMA_OVER);
 		}
 		dev->state = STATE_RDONE;
 		dev->callback = HDC_TIME;
@@ -924,8 +925,9 @@ do_send:
 				if (! no_data) {
 					/* Perform DMA. */
 					while (dev->buf_idx < dev->buf_len) {
-						val = dma_channel_write(dev->dma,
-							*dev->buf_ptr++);
+						val = dma_channel_write_block(dev->dma,
+							dev->buf_ptr,
+							dev->buf_len - dev->buf_idx);
 						if (val == DMA_NODATA) {
 							ERRLOG("HDC: CMD_READ_SECTORS out of data (idx=%d, len=%d)!\n", dev->buf_idx, dev->buf_len);
 
@@ -937,7 +939,9 @@ do_send:
 							do_finish(dev);
 							return;
 						}
-						dev->buf_idx++;
+						val &= ~DMA_OVER;
+						dev->buf_ptr += val;
+						dev->buf_idx += val;
 					}
 				}
 				dev->state = STATE_SDONE;
@@ -1071,7 +1075,9 @@ do_recv:
 				if (! no_data) {
 					/* Perform DMA. */
 					while (dev->buf_idx < dev->buf_len) {
-						val = dma_channel_read(dev->dma);
+						val = dma_channel_read_block(dev->dma,
+							&dev->buf_ptr[dev->buf_idx],
+							dev->buf_len - dev->buf_idx);
 						if (val == DMA_NODATA) {
 							ERRLOG("HDC: CMD_WRITE_SECTORS out of data (idx=%d, len=%d)!\n", dev->buf_idx, dev->buf_len);
 
@@ -1083,8 +1089,7 @@ do_recv:
 							do_finish(dev);
 							return;
 						}
-						dev->buf_ptr[dev->buf_idx] = (val & 0xff);
-						dev->buf_idx++;
+						dev->buf_idx += (val & ~DMA_OVER);
 					}
 				}
 				dev->state = STATE_RDONE;
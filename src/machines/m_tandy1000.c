@@ -8,7 +8,7 @@
  *
  *		Emulation of Tandy models 1000, 1000HX and 1000SL2.
  *
- * Version:	@(#)m_tandy1000.c	1.0.27	2021/10/20
+ * Version:	@(#)m_tandy1000.c	1.0.29	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -745,7 +745,9 @@ snd_read(uint16_t port, priv_t priv)
 static void
 snd_update(t1ksnd_t *dev)
 {
-    for (; dev->pos < sound_pos_global; dev->pos++)	
+    int end = sound_get_pos();
+
+    for (; dev->pos < end; dev->pos++)	
 	dev->buffer[dev->pos] =
 		(((int8_t)(dev->dac_val ^ 0x80) * 0x20) * dev->amplitude) / 15;
 }
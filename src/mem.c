@@ -10,7 +10,7 @@
  *
  * **NOTES**	The cpu-specific MMU code should be moved to cpu/mmu.c.
  *
- * Version:	@(#)mem.c	1.0.41	2021/03/16
+ * Version:	@(#)mem.c	1.0.46	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -38,6 +38,7 @@
  *   Boston, MA 02111-1307
  *   USA.
  */
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
@@ -112,6 +113,29 @@ static int		_mem_state[0x40000];
 
 static uint8_t		ff_pccache[4] = { 0xff, 0xff, 0xff, 0xff };
 
+/*
+ * Index of all mappings, sorted by base address. Each entry also has
+ * its position in the mapping list (later entries win), and the end of
+ * the highest mapping at or below it, so that a lookup of a range only
+ * has to look at the mappings that can overlap it.
+ */
+#define MEM_MAP_INDEX_MAX	1024
+
+typedef struct {
+    mem_map_t	*map;
+    uint32_t	seq;
+    uint64_t	maxend;
+} mapidx_t;
+
+static mapidx_t		map_index[MEM_MAP_INDEX_MAX];
+static int		map_index_count;
+static uint32_t		map_seq;
+static int		map_cand[MEM_MAP_INDEX_MAX];
+
+uint64_t		mem_recalc_calls,	/* #calls to mem_map_recalc */
+			mem_recalc_changed,	/* #granules actually changed */
+			mem_recalc_flushes;	/* #TLB flushes needed */
+
 
 int
 mem_addr_is_ram(uint32_t addr)
@@ -125,6 +149,36 @@ mem_addr_is_ram(uint32_t addr)
 }
 
 
+/*
+ * Return a host pointer for a range of guest-physical memory, but
+ * only if the whole range is plain RAM within a single mapping, for
+ * both reads and writes. This lets bus-master devices move data in
+ * and out of guest memory without going through the byte handlers.
+ */
+uint8_t *
+mem_get_ram_ptr(uint32_t addr, uint32_t len)
+{
+    mem_map_t *map = read_mapping[addr >> MEM_GRANULARITY_BITS];
+    uint32_t a;
+
+    if ((len == 0) || !mem_addr_is_ram(addr) || (map->exec == NULL))
+	return(NULL);
+
+    /* The range must not run past the end of this mapping. */
+    if ((addr < map->base) || ((addr - map->base) > map->size) ||
+	(len > (map->size - (addr - map->base))))
+	return(NULL);
+
+    for (a = (addr >> MEM_GRANULARITY_BITS);
+	 a <= ((addr + len - 1) >> MEM_GRANULARITY_BITS); a++) {
+	if ((read_mapping[a] != map) || (write_mapping[a] != map))
+		return(NULL);
+    }
+
+    return(map->exec + (addr - map->base));
+}
+
+
 void
 resetreadlookup(void)
 {
@@ -217,6 +271,65 @@ flushmmucache_cr3(void)
 }
 
 
+/*
+ * Flush only those TLB entries that point to physical memory in the
+ * given range, rather than the whole lot as flushmmucache_cr3() does.
+ */
+static void
+flushmmucache_range(uint32_t start, uint32_t end)
+{
+    uint32_t phys;
+    int c;
+
+    for (c = 0; c < 256; c++) {
+	if (readlookup[c] != (int)0xffffffff) {
+		phys = (uint32_t)(readlookup2[readlookup[c]] - (uintptr_t)ram) +
+		       ((uint32_t)readlookup[c] << 12);
+		if ((phys >= (start & ~0xfff)) && (phys <= end)) {
+			readlookup2[readlookup[c]] = -1;
+			readlookup[c] = 0xffffffff;
+		}
+	}
+	if (writelookup[c] != (int)0xffffffff) {
+		if (page_lookup[writelookup[c]] != NULL)
+			phys = (uint32_t)(page_lookup[writelookup[c]] - pages) << 12;
+		else
+			phys = (uint32_t)(writelookup2[writelookup[c]] - (uintptr_t)ram) +
+			       ((uint32_t)writelookup[c] << 12);
+		if ((phys >= (start & ~0xfff)) && (phys <= end)) {
+			page_lookup[writelookup[c]] = NULL;
+			writelookup2[writelookup[c]] = -1;
+			writelookup[c] = 0xffffffff;
+		}
+	}
+    }
+}
+
+
+/*
+ * TLB entries hold host pointers into RAM, so a mapping that serves RAM
+ * from some other address (like the PS/2 split block, or the remapped
+ * top of memory) leaves entries the range flush only finds by the RAM
+ * address they point to. Flush those too, if 'exec' is such a mapping.
+ * ROM and device memory never get TLB entries, so nothing to do there.
+ */
+static void
+mem_flush_exec(const uint8_t *exec, uint32_t addr, uint32_t size)
+{
+    uintptr_t off;
+
+    if ((exec == NULL) || (ram == NULL))
+	return;
+
+    /* Compare as integers, 'exec' may not point into 'ram' at all. */
+    off = (uintptr_t)exec - (uintptr_t)ram;
+    if ((off >= (1024UL * mem_size)) || (off == addr))
+	return;
+
+    flushmmucache_range((uint32_t)off, (uint32_t)off + size - 1);
+}
+
+
 void
 mem_flush_write_page(uint32_t addr, uint32_t virt)
 {
@@ -1002,6 +1115,58 @@ mem_writeb_phys(uint32_t addr, uint8_t val)
 }
 
 
+/*
+ * Copy a block of physical memory for a bus master.
+ *
+ * Runs that fall within a directly-mapped page are copied
+ * in one go, anything else goes through the byte handlers.
+ */
+void
+mem_read_phys_block(uint32_t addr, uint8_t *buf, uint32_t len)
+{
+    uint32_t n;
+
+    while (len > 0) {
+	n = MEM_GRANULARITY_SIZE - (addr & MEM_GRANULARITY_MASK);
+	if (n > len)
+		n = len;
+
+	if (_mem_exec[addr >> MEM_GRANULARITY_BITS] != NULL) {
+		memcpy(buf, &_mem_exec[addr >> MEM_GRANULARITY_BITS][addr & MEM_GRANULARITY_MASK], n);
+		addr += n;
+		buf += n;
+		len -= n;
+	} else while (n--) {
+		*buf++ = mem_readb_phys(addr++);
+		len--;
+	}
+    }
+}
+
+
+void
+mem_write_phys_block(uint32_t addr, const uint8_t *buf, uint32_t len)
+{
+    uint32_t n;
+
+    while (len > 0) {
+	n = MEM_GRANULARITY_SIZE - (addr & MEM_GRANULARITY_MASK);
+	if (n > len)
+		n = len;
+
+	if (_mem_exec[addr >> MEM_GRANULARITY_BITS] != NULL) {
+		memcpy(&_mem_exec[addr >> MEM_GRANULARITY_BITS][addr & MEM_GRANULARITY_MASK], buf, n);
+		addr += n;
+		buf += n;
+		len -= n;
+	} else while (n--) {
+		mem_writeb_phys(addr++, *buf++);
+		len--;
+	}
+    }
+}
+
+
 uint8_t
 mem_read_ram(uint32_t addr, UNUSED(priv_t priv))
 {
@@ -1262,47 +1427,175 @@ mem_map_write_allowed(uint32_t fl, int state)
 }
 
 
+/* Recompute the highest end address for index entries from 'idx' up. */
+static void
+map_index_fixup(int idx)
+{
+    uint64_t end;
+
+    for (; idx < map_index_count; idx++) {
+	end = (uint64_t)map_index[idx].map->base + map_index[idx].map->size;
+	if ((idx > 0) && (map_index[idx - 1].maxend > end))
+		end = map_index[idx - 1].maxend;
+	map_index[idx].maxend = end;
+    }
+}
+
+
+/* Find the first index entry with a base at or above 'addr'. */
+static int
+map_index_search(uint64_t addr)
+{
+    int lo = 0, hi = map_index_count, mid;
+
+    while (lo < hi) {
+	mid = (lo + hi) / 2;
+	if ((uint64_t)map_index[mid].map->base < addr)
+		lo = mid + 1;
+	else
+		hi = mid;
+    }
+
+    return(lo);
+}
+
+
+/* Remove a mapping from the index, returning its list position. */
+static uint32_t
+map_index_del(mem_map_t *map)
+{
+    uint32_t seq = 0;
+    int i;
+
+    for (i = 0; i < map_index_count; i++) {
+	if (map_index[i].map == map)
+		break;
+    }
+    if (i == map_index_count)
+	return(0);
+
+    seq = map_index[i].seq;
+    memmove(&map_index[i], &map_index[i + 1],
+	    (map_index_count - i - 1) * sizeof(mapidx_t));
+    map_index_count--;
+    map_index_fixup(i);
+
+    return(seq);
+}
+
+
+static void
+map_index_add(mem_map_t *map, uint32_t seq)
+{
+    int i;
+
+    if (map_index_count == MEM_MAP_INDEX_MAX)
+	fatal("MEM: too many memory mappings\n");
+
+    i = map_index_search((uint64_t)map->base);
+    memmove(&map_index[i + 1], &map_index[i],
+	    (map_index_count - i) * sizeof(mapidx_t));
+    map_index[i].map = map;
+    map_index[i].seq = seq;
+    map_index_count++;
+    map_index_fixup(i);
+}
+
+
+/*
+ * Recalculate the granule tables for a range of memory.
+ *
+ * Only mappings that overlap the range are looked at, and only the
+ * granules whose mapping really changes are updated. The TLB is then
+ * flushed for just those granules, if any.
+ */
 static void
 mem_map_recalc(uint64_t base, uint64_t size)
 {
-    mem_map_t *map = base_mapping.next;
-    uint64_t c;
+    uint64_t c, end, cend, mend;
+    uint32_t lo = 0xffffffff, hi = 0;
+    mem_map_t *map, *rmap, *wmap;
+    uint8_t *exec;
+    int i, j, n = 0, t;
 
     if (! size) return;
 
-    /* Clear out old mappings. */
-    for (c = base; c < base + size; c += 0x4000) {
-	read_mapping[c >> MEM_GRANULARITY_BITS] = NULL;
-	write_mapping[c >> MEM_GRANULARITY_BITS] = NULL;
-    }
-
-    /* Walk mapping list. */
-    while (map != NULL) {
-	/*In range?*/
-	if (map->enable && (uint64_t)map->base < ((uint64_t)base + (uint64_t)size) && ((uint64_t)map->base + (uint64_t)map->size) > (uint64_t)base) {
-		uint64_t start = (map->base < base) ? map->base : base;
-		uint64_t end   = (((uint64_t)map->base + (uint64_t)map->size) < (base + size)) ? ((uint64_t)map->base + (uint64_t)map->size) : (base + size);
-		if (start < map->base)
-			start = map->base;
-
-		for (c = start; c < end; c += 0x4000) {
-			if ((map->read_b || map->read_w || map->read_l) &&
-			     mem_map_read_allowed(map->flags, _mem_state[c >> MEM_GRANULARITY_BITS])) {
-				if (map->exec)
-					_mem_exec[c >> MEM_GRANULARITY_BITS] = map->exec + (c - map->base);
-				else
-					_mem_exec[c >> MEM_GRANULARITY_BITS] = NULL;
-				read_mapping[c >> MEM_GRANULARITY_BITS] = map;
-			}
-			if ((map->write_b || map->write_w || map->write_l) &&
-			     mem_map_write_allowed(map->flags, _mem_state[c >> MEM_GRANULARITY_BITS]))
-				write_mapping[c >> MEM_GRANULARITY_BITS] = map;
+    mem_recalc_calls++;
+    end = base + size;
+
+    /* Collect the enabled mappings that overlap the range. */
+    for (i = map_index_search(end) - 1; i >= 0; i--) {
+	if (map_index[i].maxend <= base)
+		break;
+	map = map_index[i].map;
+	if (map->enable &&
+	    (((uint64_t)map->base + map->size) > base))
+		map_cand[n++] = i;
+    }
+
+    /* Sort them so the highest list position (the winner) is first. */
+    for (i = 1; i < n; i++) {
+	t = map_cand[i];
+	for (j = i; (j > 0) && (map_index[map_cand[j - 1]].seq < map_index[t].seq); j--)
+		map_cand[j] = map_cand[j - 1];
+	map_cand[j] = t;
+    }
+
+    for (c = base; c < end; c += 0x4000) {
+	cend = ((c + 0x4000) < end) ? (c + 0x4000) : end;
+	rmap = wmap = NULL;
+	exec = NULL;
+
+	for (i = 0; (i < n) && ((rmap == NULL) || (wmap == NULL)); i++) {
+		map = map_index[map_cand[i]].map;
+		mend = (uint64_t)map->base + map->size;
+		if (((uint64_t)map->base >= cend) || (mend <= c))
+			continue;
+
+		if ((rmap == NULL) &&
+		    (map->read_b || map->read_w || map->read_l) &&
+		    mem_map_read_allowed(map->flags, _mem_state[c >> MEM_GRANULARITY_BITS])) {
+			rmap = map;
+			if (map->exec)
+				exec = map->exec + (((c > map->base) ? c : map->base) - map->base);
 		}
+		if ((wmap == NULL) &&
+		    (map->write_b || map->write_w || map->write_l) &&
+		    mem_map_write_allowed(map->flags, _mem_state[c >> MEM_GRANULARITY_BITS]))
+			wmap = map;
 	}
-	map = map->next;
+
+	if ((read_mapping[c >> MEM_GRANULARITY_BITS] == rmap) &&
+	    (write_mapping[c >> MEM_GRANULARITY_BITS] == wmap) &&
+	    (_mem_exec[c >> MEM_GRANULARITY_BITS] == exec))
+		continue;
+
+	/* Entries for the old mapping may point elsewhere in RAM. */
+	mem_flush_exec(_mem_exec[c >> MEM_GRANULARITY_BITS],
+		       (uint32_t)c, (uint32_t)(cend - c));
+
+	read_mapping[c >> MEM_GRANULARITY_BITS] = rmap;
+	write_mapping[c >> MEM_GRANULARITY_BITS] = wmap;
+	_mem_exec[c >> MEM_GRANULARITY_BITS] = exec;
+
+	mem_recalc_changed++;
+	if ((uint32_t)c < lo)
+		lo = (uint32_t)c;
+	hi = (uint32_t)(cend - 1);
     }
 
-    flushmmucache_cr3();
+    if (lo <= hi) {
+	mem_recalc_flushes++;
+	flushmmucache_range(lo, hi);
+    }
+}
+
+
+void
+mem_dump_stats(void)
+{
+    INFO("MEM: %" PRIu64 " mapping recalcs, %" PRIu64 " granules changed, %" PRIu64 " TLB flushes\n",
+	 mem_recalc_calls, mem_recalc_changed, mem_recalc_flushes);
 }
 
 
@@ -1314,6 +1607,8 @@ mem_map_del(mem_map_t *map)
     /* Disable the entry. */
     mem_map_disable(map);
 
+    (void)map_index_del(map);
+
     /* Zap it from the list. */
     for (ptr = &base_mapping; ptr->next != NULL; ptr = ptr->next) {
 	if (ptr->next == map) {
@@ -1361,6 +1656,9 @@ mem_map_add(mem_map_t *map, uint32_t base, uint32_t size,
     map->dev     = NULL;
     map->next    = NULL;
 
+    (void)map_index_del(map);
+    map_index_add(map, ++map_seq);
+
     mem_map_recalc(map->base, map->size);
 }
 
@@ -1382,12 +1680,20 @@ mem_map_set_handler(mem_map_t *map,
     map->write_l = write_l;
 
     mem_map_recalc(map->base, map->size);
+
+    /* The granules still point to this mapping, but the TLB may not. */
+    if (map->size != 0) {
+	flushmmucache_range(map->base, map->base + map->size - 1);
+	mem_flush_exec(map->exec, map->base, map->size);
+    }
 }
 
 
 void
 mem_map_set_addr(mem_map_t *map, uint32_t base, uint32_t size)
 {
+    uint32_t seq;
+
     /* Remove old mapping. */
     map->enable = 0;
     mem_map_recalc(map->base, map->size);
@@ -1396,6 +1702,8 @@ mem_map_set_addr(mem_map_t *map, uint32_t base, uint32_t size)
     map->enable = 1;
     map->base = base;
     map->size = size;
+    if ((seq = map_index_del(map)) != 0)
+	map_index_add(map, seq);
 
     mem_map_recalc(map->base, map->size);
 }
@@ -1553,6 +1861,9 @@ mem_reset(void)
     memset(_mem_exec,    0x00, sizeof(_mem_exec));
 
     memset(&base_mapping, 0x00, sizeof(base_mapping));
+    map_index_count = 0;
+    map_seq = 0;
+    mem_recalc_calls = mem_recalc_changed = mem_recalc_flushes = 0;
 
     memset(_mem_state, 0x00, sizeof(_mem_state));
 
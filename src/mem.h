@@ -8,7 +8,7 @@
  *
  *		Definitions for the memory interface.
  *
- * Version:	@(#)mem.h	1.0.21	2021/03/16
+ * Version:	@(#)mem.h	1.0.23	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Sarah Walker, <tommowalker@tommowalker.co.uk>
@@ -154,6 +154,10 @@ extern page_t		*pages,
 
 extern uint32_t		get_phys_virt,get_phys_phys;
 
+extern uint64_t		mem_recalc_calls,
+			mem_recalc_changed,
+			mem_recalc_flushes;
+
 extern uint32_t		pccache;
 extern uint8_t		*pccache2;
 
@@ -231,12 +235,16 @@ extern void	mem_map_set_addr(mem_map_t *, uint32_t base, uint32_t size);
 extern void	mem_map_set_exec(mem_map_t *, uint8_t *exec);
 extern void	mem_map_disable(mem_map_t *);
 extern void	mem_map_enable(mem_map_t *);
+extern void	mem_dump_stats(void);
 
 extern void	mem_set_mem_state(uint32_t base, uint32_t size, int state);
 
 extern uint8_t	mem_readb_phys(uint32_t addr);
 extern uint16_t	mem_readw_phys(uint32_t addr);
 extern void	mem_writeb_phys(uint32_t addr, uint8_t val);
+extern void	mem_read_phys_block(uint32_t addr, uint8_t *buf, uint32_t len);
+extern void	mem_write_phys_block(uint32_t addr, const uint8_t *buf,
+					     uint32_t len);
 
 extern uint8_t	mem_read_ram(uint32_t addr, void *priv);
 extern uint16_t	mem_read_ramw(uint32_t addr, void *priv);
@@ -261,6 +269,7 @@ extern void	mem_flush_write_page(uint32_t addr, uint32_t virt);
 extern void	mem_reset_page_blocks(void);
 
 extern int	mem_addr_is_ram(uint32_t addr);
+extern uint8_t	*mem_get_ram_ptr(uint32_t addr, uint32_t len);
 
 extern void     flushmmucache(void);
 extern void     flushmmucache_cr3(void);
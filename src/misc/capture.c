@@ -0,0 +1,570 @@
+/*
+ * VARCem	Virtual ARchaeological Computer EMulator.
+ *		An emulator of (mostly) x86-based PC systems and devices,
+ *		using the ISA,EISA,VLB,MCA  and PCI system buses, roughly
+ *		spanning the era between 1981 and 1995.
+ *
+ *		This file is part of the VARCem Project.
+ *
+ *		Capture the emulated display and audio to files.
+ *
+ *		When a capture file is configured, every refresh of the
+ *		display is written to a YUV4MPEG2 (Y4M) file, in 4:4:4
+ *		format so no color detail is lost, and the main audio
+ *		mix goes into a WAV file next to it. Both are timed by
+ *		the emulated clock, so they stay in sync no matter how
+ *		fast the host is. A change of display size starts a new
+ *		video file, as Y4M cannot do that in the middle.
+ *
+ *		All the file work is done by a writer thread. Refreshes
+ *		that did not change the screen are not copied, and the
+ *		writer re-uses the last frame for them.
+ *
+ * Version:	@(#)capture.c	1.0.3	2026/10/19
+ *
+ * Author:	agent, <agent@local>
+ *
+ *		Copyright 2026 agent.
+ *
+ *		Redistribution and  use  in source  and binary forms, with
+ *		or  without modification, are permitted  provided that the
+ *		following conditions are met:
+ *
+ *		1. Redistributions of  source  code must retain the entire
+ *		   above notice, this list of conditions and the following
+ *		   disclaimer.
+ *
+ *		2. Redistributions in binary form must reproduce the above
+ *		   copyright  notice,  this list  of  conditions  and  the
+ *		   following disclaimer in  the documentation and/or other
+ *		   materials provided with the distribution.
+ *
+ *		3. Neither the  name of the copyright holder nor the names
+ *		   of  its  contributors may be used to endorse or promote
+ *		   products  derived from  this  software without specific
+ *		   prior written permission.
+ *
+ * THIS SOFTWARE  IS  PROVIDED BY THE  COPYRIGHT  HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND  ANY EXPRESS  OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE  ARE  DISCLAIMED. IN  NO  EVENT  SHALL THE COPYRIGHT
+ * HOLDER OR  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL,  EXEMPLARY,  OR  CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE  GOODS OR SERVICES;  LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON  ANY
+ * THEORY OF  LIABILITY, WHETHER IN  CONTRACT, STRICT  LIABILITY, OR  TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING  IN ANY  WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <wchar.h>
+#include "../emu.h"
+#include "../config.h"
+#include "../plat.h"
+#include "../devices/video/video.h"
+#include "../devices/sound/sound.h"
+#include "capture.h"
+
+
+#define CAP_QUEUE	8			/* frames in flight, power of 2 */
+#define CAP_AUDIO	(1024 * 1024)		/* audio ring, power of 2 */
+#define CAP_CLOCK	48000			/* capture clock, in Hz */
+
+
+/* One display refresh, as handed to the writer. */
+typedef struct {
+    uint32_t	*pix;				/* frame buffer */
+    int		size;				/* its size, in pels */
+    int		w, h;
+    int		fresh;				/* new image in pix */
+    int		count;				/* refreshes it covers */
+    uint64_t	stamp;				/* capture clock */
+} frame_t;
+
+
+/* Standard RIFF/WAVE file header. */
+#pragma pack(push,1)
+typedef struct {
+    char	riff[4];
+    uint32_t	riff_len;
+    char	wave[4];
+    char	fmt[4];
+    uint32_t	fmt_len;
+    uint16_t	format,
+		channels;
+    uint32_t	rate,
+		byte_rate;
+    uint16_t	align,
+		bits;
+    char	data[4];
+    uint32_t	data_len;
+} wav_hdr_t;
+#pragma pack(pop)
+
+
+/* Shared between the emulator and the writer thread. */
+static volatile int	cap_active = 0;
+static thread_t		*cap_tid;
+static event_t		*cap_wake;
+static frame_t		cap_frames[CAP_QUEUE];
+static volatile uint32_t cap_head,		/* written by emulator */
+			cap_tail;		/* written by writer */
+static uint8_t		*aud_buf;
+static volatile uint32_t aud_head,		/* written by emulator */
+			aud_tail;		/* written by writer */
+
+/* Used by the emulator only. */
+static uint64_t		cap_clock;
+static int		cap_force,
+			cap_missed,
+			cap_w, cap_h;
+static uint32_t		cap_drops,
+			aud_drops;
+
+/* Used by the writer only. */
+static FILE		*vid_fp,
+			*wav_fp;
+static int		seg_num,
+			seg_w, seg_h,
+			seg_hdr,
+			seg_conv;
+static uint8_t		*yuv;			/* the frame being held */
+static uint32_t		*prev;			/* its pels */
+static int		held;
+static uint64_t		held_stamp;
+static int		wav_num;
+static uint32_t		wav_len,
+			vid_frames,
+			vid_dups;
+
+
+static int
+sample_size(void)
+{
+    return(config.sound_is_float ? sizeof(float) : sizeof(int16_t));
+}
+
+
+/* Write (or re-write) the WAV header for the current length. */
+static void
+wav_header(void)
+{
+    wav_hdr_t hdr;
+
+    memcpy(hdr.riff, "RIFF", 4);
+    hdr.riff_len = sizeof(hdr) - 8 + wav_len;
+    memcpy(hdr.wave, "WAVE", 4);
+    memcpy(hdr.fmt, "fmt ", 4);
+    hdr.fmt_len = 16;
+    hdr.format = config.sound_is_float ? 3 : 1;	/* IEEE float or PCM */
+    hdr.channels = 2;
+    hdr.rate = CAP_CLOCK;
+    hdr.bits = sample_size() * 8;
+    hdr.align = hdr.channels * sample_size();
+    hdr.byte_rate = hdr.rate * hdr.align;
+    memcpy(hdr.data, "data", 4);
+    hdr.data_len = wav_len;
+
+    (void)fseek(wav_fp, 0, SEEK_SET);
+    (void)fwrite(&hdr, 1, sizeof(hdr), wav_fp);
+    (void)fseek(wav_fp, 0, SEEK_END);
+}
+
+
+/* Start a new audio file. */
+static int
+open_wav(void)
+{
+    wchar_t fn[1024];
+
+    if (wav_num++ == 0)
+	swprintf(fn, sizeof_w(fn), L"%ls.wav", config.capture_file);
+      else
+	swprintf(fn, sizeof_w(fn), L"%ls-%i.wav", config.capture_file, wav_num);
+
+    wav_fp = plat_fopen(fn, L"wb");
+    if (wav_fp == NULL) {
+	ERRLOG("CAPTURE: unable to create audio file '%ls'\n", fn);
+	return(0);
+    }
+    wav_len = 0;
+    wav_header();
+
+    INFO("CAPTURE: recording audio to '%ls'\n", fn);
+
+    return(1);
+}
+
+
+static void
+close_wav(void)
+{
+    if (wav_fp == NULL) return;
+
+    wav_header();
+    (void)fclose(wav_fp);
+    wav_fp = NULL;
+}
+
+
+/* Move whatever audio we have into the WAV file. */
+static void
+write_audio(void)
+{
+    uint32_t tail = aud_tail;
+    uint32_t len, off, n;
+
+    len = aud_head - tail;
+    thread_barrier();
+    if (len == 0) return;
+
+    /* The RIFF lengths are 32 bits, so go on in a new file when full. */
+    if ((wav_fp != NULL) &&
+	(len > (UINT32_MAX - (sizeof(wav_hdr_t) - 8) - wav_len))) {
+	close_wav();
+	(void)open_wav();
+    }
+
+    off = tail & (CAP_AUDIO - 1);
+    n = CAP_AUDIO - off;
+    if (n > len)
+	n = len;
+    if (wav_fp != NULL) {
+	(void)fwrite(&aud_buf[off], 1, n, wav_fp);
+	if (n < len)
+		(void)fwrite(aud_buf, 1, len - n, wav_fp);
+	wav_len += len;
+    }
+
+    thread_barrier();
+    aud_tail = tail + len;
+}
+
+
+/* Start a new video file, for a (new) frame size. */
+static void
+open_segment(int w, int h)
+{
+    wchar_t fn[1024];
+
+    if (seg_num++ == 0)
+	swprintf(fn, sizeof_w(fn), L"%ls.y4m", config.capture_file);
+      else
+	swprintf(fn, sizeof_w(fn), L"%ls-%i.y4m", config.capture_file, seg_num);
+
+    vid_fp = plat_fopen(fn, L"wb");
+    if (vid_fp == NULL)
+	ERRLOG("CAPTURE: unable to create video file '%ls'\n", fn);
+      else
+	INFO("CAPTURE: recording %ix%i video to '%ls'\n", w, h, fn);
+
+    free(yuv);
+    free(prev);
+    yuv = (uint8_t *)mem_alloc(w * h * 3);
+    prev = (uint32_t *)mem_alloc(w * h * sizeof(uint32_t));
+
+    seg_w = w;
+    seg_h = h;
+    seg_hdr = 0;
+    seg_conv = 0;
+    held = 0;
+}
+
+
+static void
+close_segment(void)
+{
+    if (vid_fp != NULL) {
+	(void)fclose(vid_fp);
+	vid_fp = NULL;
+    }
+}
+
+
+/*
+ * Write out the frame we are holding.
+ *
+ * We hold on to each frame until the next one comes in, so we
+ * know for how many refreshes it was shown, and (for the first
+ * one) at what rate the emulated display is refreshing, which
+ * goes into the file header.
+ */
+static void
+flush_held(int count, uint64_t stamp)
+{
+    uint64_t diff = stamp - held_stamp;
+    int i;
+
+    if (! held) return;
+
+    if (vid_fp == NULL) {
+	held = 0;
+	return;
+    }
+
+    if (! seg_hdr) {
+	if ((count > 0) && (diff > 0))
+		fprintf(vid_fp, "YUV4MPEG2 W%i H%i F%" PRIu64 ":%" PRIu64 " Ip A1:1 C444\n",
+			seg_w, seg_h, (uint64_t)count * CAP_CLOCK, diff);
+	  else
+		fprintf(vid_fp, "YUV4MPEG2 W%i H%i F60:1 Ip A1:1 C444\n",
+			seg_w, seg_h);
+	seg_hdr = 1;
+    }
+
+    for (i = 0; i < held; i++) {
+	fputs("FRAME\n", vid_fp);
+	(void)fwrite(yuv, 1, seg_w * seg_h * 3, vid_fp);
+    }
+    vid_frames += held;
+    held = 0;
+}
+
+
+/* Convert a frame to planar Y'CbCr 4:4:4 (BT.601, studio range.) */
+static void
+convert(const uint32_t *pix, int len)
+{
+    uint8_t *y = yuv;
+    uint8_t *u = y + len;
+    uint8_t *v = u + len;
+    int i, r, g, b;
+
+    for (i = 0; i < len; i++) {
+	r = (pix[i] >> 16) & 0xff;
+	g = (pix[i] >> 8) & 0xff;
+	b = pix[i] & 0xff;
+
+	y[i] = (( 66 * r + 129 * g +  25 * b + 128) >> 8) + 16;
+	u[i] = ((-38 * r -  74 * g + 112 * b + 128) >> 8) + 128;
+	v[i] = ((112 * r -  94 * g -  18 * b + 128) >> 8) + 128;
+    }
+}
+
+
+/* Process one refresh from the queue. */
+static void
+write_frame(frame_t *f)
+{
+    int len = f->w * f->h;
+
+    if (f->fresh && ((f->w != seg_w) || (f->h != seg_h) || (yuv == NULL))) {
+	flush_held(f->count, f->stamp);
+	close_segment();
+	open_segment(f->w, f->h);
+    } else
+	flush_held(f->count, f->stamp);
+
+    /* Nothing to show until we have the first image. */
+    if (yuv == NULL) return;
+
+    if (f->fresh) {
+	/* Converting is the costly part, so skip it if we can. */
+	if (!seg_conv || memcmp(prev, f->pix, len * sizeof(uint32_t))) {
+		memcpy(prev, f->pix, len * sizeof(uint32_t));
+		convert(prev, len);
+		seg_conv = 1;
+	} else
+		vid_dups++;
+    }
+
+    held = f->count;
+    held_stamp = f->stamp;
+}
+
+
+static void
+writer_thread(UNUSED(void *arg))
+{
+    frame_t *f;
+
+    for (;;) {
+	thread_wait_event(cap_wake, -1);
+	thread_reset_event(cap_wake);
+
+	while (cap_tail != cap_head) {
+		thread_barrier();
+		f = &cap_frames[cap_tail & (CAP_QUEUE - 1)];
+
+		write_frame(f);
+
+		thread_barrier();
+		cap_tail++;
+	}
+
+	write_audio();
+
+	if (! cap_active) break;
+    }
+}
+
+
+/*
+ * Called by the video core for each display refresh.
+ *
+ * This runs on the emulator thread, so all we do here is copy
+ * the screen (and only if it changed) and queue it. If the
+ * writer does not keep up, the refresh is counted with the
+ * next one, as we never want the emulation to wait for it.
+ */
+void
+capture_video(int x, int y, int y1, int y2, int w, int h)
+{
+    frame_t *f;
+    int fresh, yy;
+
+    if (! cap_active) return;
+
+    fresh = (y1 != y2) || cap_force || (w != cap_w) || (h != cap_h);
+
+    if ((cap_head - cap_tail) >= CAP_QUEUE) {
+	cap_missed++;
+	cap_drops++;
+	if (fresh)
+		cap_force = 1;
+	return;
+    }
+
+    f = &cap_frames[cap_head & (CAP_QUEUE - 1)];
+    f->fresh = fresh;
+    f->count = 1 + cap_missed;
+    f->stamp = cap_clock + sound_get_pos();
+    f->w = w;
+    f->h = h;
+
+    if (fresh) {
+	if (f->size < (w * h)) {
+		free(f->pix);
+		f->size = w * h;
+		f->pix = (uint32_t *)mem_alloc(f->size * sizeof(uint32_t));
+	}
+
+	for (yy = 0; yy < h; yy++) {
+		if ((y + yy) >= 0 && (y + yy) < screen->h)
+			memcpy(&f->pix[yy * w], &screen->line[y + yy][x], w * 4);
+		  else
+			memset(&f->pix[yy * w], 0x00, w * 4);
+	}
+
+	cap_w = w;
+	cap_h = h;
+	cap_force = 0;
+    }
+    cap_missed = 0;
+
+    /* Make sure the frame is stored before we publish it. */
+    thread_barrier();
+    cap_head++;
+
+    thread_set_event(cap_wake);
+}
+
+
+/* Called by the sound core with each block of 'len' samples of the main mix. */
+void
+capture_audio(const void *buf, int len)
+{
+    uint32_t head = aud_head;
+    uint32_t off, n;
+
+    if (! cap_active) return;
+
+    /* This is also the clock we use to time the frames. */
+    cap_clock += (len / 2);
+
+    len *= sample_size();
+    if ((uint32_t)len > (CAP_AUDIO - (head - aud_tail))) {
+	aud_drops++;
+	return;
+    }
+
+    off = head & (CAP_AUDIO - 1);
+    n = CAP_AUDIO - off;
+    if (n > (uint32_t)len)
+	n = len;
+    memcpy(&aud_buf[off], buf, n);
+    if (n < (uint32_t)len)
+	memcpy(aud_buf, (const uint8_t *)buf + n, len - n);
+
+    thread_barrier();
+    aud_head = head + len;
+
+    /* Do not let the audio wait for the next frame if it piles up. */
+    if (((head - aud_tail) < (CAP_AUDIO / 4)) &&
+	((head + len - aud_tail) >= (CAP_AUDIO / 4)))
+	thread_set_event(cap_wake);
+}
+
+
+void
+capture_init(void)
+{
+    if (config.capture_file[0] == L'\0') return;
+
+    wav_num = 0;
+    if (! open_wav())
+	return;
+
+    aud_buf = (uint8_t *)mem_alloc(CAP_AUDIO);
+    aud_head = aud_tail = 0;
+    cap_head = cap_tail = 0;
+    cap_clock = 0;
+    cap_force = 1;
+    cap_missed = 0;
+    cap_drops = aud_drops = 0;
+    vid_frames = vid_dups = 0;
+    seg_num = 0;
+
+    cap_wake = thread_create_event();
+    cap_active = 1;
+    cap_tid = thread_create(writer_thread, NULL);
+    if (cap_tid == NULL) {
+	ERRLOG("CAPTURE: unable to create writer thread!\n");
+	cap_active = 0;
+	thread_destroy_event(cap_wake);
+	(void)fclose(wav_fp);
+	wav_fp = NULL;
+	free(aud_buf);
+	return;
+    }
+}
+
+
+void
+capture_close(void)
+{
+    int i;
+
+    if (! cap_active) return;
+
+    /* Stop the writer, it will finish the queue first. */
+    cap_active = 0;
+    thread_set_event(cap_wake);
+    thread_wait(cap_tid, -1);
+    thread_destroy_event(cap_wake);
+
+    /* Write the last frame, we do not know the rate if it was the only one. */
+    flush_held(0, 0);
+    close_segment();
+
+    close_wav();
+
+    INFO("CAPTURE: %" PRIu32 " frames (%" PRIu32 " duplicates, %" PRIu32 " dropped), %" PRIu32 " bytes of audio (%" PRIu32 " blocks dropped)\n",
+	 vid_frames, vid_dups, cap_drops, wav_len, aud_drops);
+
+    for (i = 0; i < CAP_QUEUE; i++) {
+	free(cap_frames[i].pix);
+	cap_frames[i].pix = NULL;
+	cap_frames[i].size = 0;
+    }
+    free(yuv);
+    free(prev);
+    yuv = NULL;
+    prev = NULL;
+    free(aud_buf);
+    aud_buf = NULL;
+}
@@ -8,7 +8,7 @@
  *
  *		Provide centralized access to the PNG image handler.
  *
- * Version:	@(#)png.c	1.0.9	2021/03/18
+ * Version:	@(#)png.c	1.0.12	2026/10/19
  *
  * Author:	Fred N. van Kempen, <decwiz@yahoo.com>
  *
@@ -44,6 +44,7 @@
  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING  IN ANY  WAY OUT OF THE USE
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
@@ -136,6 +137,8 @@ static void		(*PNG_set_compression_method)(png_structrp png_ptr,
 						      int method);
 static void		(*PNG_set_compression_buffer_size)(png_structrp png_ptr,
 							   png_size_t size);
+static void		(*PNG_set_filter)(png_structrp png_ptr, int method,
+					  int filters);
 
 
 static const dllimp_t png_imports[] = {
@@ -164,11 +167,43 @@ static const dllimp_t png_imports[] = {
   { "png_set_compression_window_bits",	&PNG_set_compression_window_bits},
   { "png_set_compression_method",	&PNG_set_compression_method	},
   { "png_set_compression_buffer_size",	&PNG_set_compression_buffer_size},
+  { "png_set_filter",			&PNG_set_filter			},
   { NULL,				NULL				}
 };
 # endif
 
 
+#define PNG_BACKLOG	4		/* queued images before we stop compressing */
+
+#define JOB_GRAY	0
+#define JOB_RGB		1
+#define JOB_PAL		2
+
+
+/* An image waiting for the encoder thread. */
+typedef struct _job_ {
+    struct _job_ *next;
+
+    int		type,
+		flag;			/* invert or flip */
+    uint8_t	*pix;
+    int16_t	w, h;
+    uint16_t	pitch;
+    RGB_PAL	pal;
+
+    wchar_t	fn[1024];
+} job_t;
+
+
+static thread_t		*png_tid = NULL;
+static mutex_t		*png_mutex = NULL;
+static event_t		*png_wake = NULL;
+static job_t		*png_head = NULL,
+			*png_tail = NULL;
+static int		png_pending = 0;
+static volatile int	png_running = 0;
+
+
 static void
 error_handler(png_structp arg, const char *str)
 {
@@ -206,6 +241,25 @@ flush_handler(png_struct *png_ptr)
 # endif
 
 
+/* Set up the "zlib" parameters for the given compression level. */
+static void
+set_compression(png_structp png, int level)
+{
+    PNGFUNC(set_compression_level)(png, level);
+
+    /* Set other "zlib" parameters. */
+    PNGFUNC(set_compression_mem_level)(png, 8);
+    PNGFUNC(set_compression_strategy)(png, PNG_Z_DEFAULT_STRATEGY);
+    PNGFUNC(set_compression_window_bits)(png, 15);
+    PNGFUNC(set_compression_method)(png, 8);
+    PNGFUNC(set_compression_buffer_size)(png, 8192);    
+
+    /* Stored data does not get any smaller by filtering it. */
+    if (level == 0)
+	PNGFUNC(set_filter)(png, PNG_FILTER_TYPE_BASE, PNG_FILTER_NONE);
+}
+
+
 /* Prepare for use, load DLL if needed. */
 int
 png_load(void)
@@ -218,14 +272,25 @@ png_load(void)
     /* If already loaded, good! */
     if (png_handle != NULL) return(1);
 
+    /* The printers and the screenshots can both get here. */
+    if (png_mutex != NULL)
+	thread_wait_mutex(png_mutex);
+    if (png_handle != NULL) {
+	if (png_mutex != NULL)
+		thread_release_mutex(png_mutex);
+	return(1);
+    }
+
 # if USE_LIBPNG == 2
     /* Try loading the DLL. */
     png_handle = dynld_module(fn, png_imports);
     if (png_handle == NULL) {
 	swprintf(temp, sizeof_w(temp),
 		 get_string(IDS_ERR_NOLIB), "PNG", fn);
-	ui_msgbox(MBX_ERROR, temp);
 	ERRLOG("PNG: unable to load '%s'; format disabled!\n", fn);
+	if (png_mutex != NULL)
+		thread_release_mutex(png_mutex);
+	ui_msgbox(MBX_ERROR, temp);
 	return(0);
     } else
 	INFO("PNG: module '%s' loaded.\n", fn);
@@ -233,14 +298,32 @@ png_load(void)
     png_handle = (void *)1;	/* just to indicate always therse */
 # endif
 
+    if (png_mutex != NULL)
+	thread_release_mutex(png_mutex);
+
     return(1);
 }
 
 
-/* No longer needed, unload DLL if needed. */
+/* No longer needed, finish the queue and unload DLL if needed. */
 void
 png_unload(void)
 {
+    if (png_tid != NULL) {
+	png_running = 0;
+	thread_set_event(png_wake);
+	thread_wait(png_tid, -1);
+	png_tid = NULL;
+
+	thread_destroy_event(png_wake);
+	png_wake = NULL;
+    }
+
+    if (png_mutex != NULL) {
+	thread_close_mutex(png_mutex);
+	png_mutex = NULL;
+    }
+
 # if USE_LIBPNG == 2
     /* Unload the DLL if possible. */
     if (png_handle != NULL)
@@ -251,8 +334,9 @@ png_unload(void)
 
 
 /* Write the given image as an 8-bit GrayScale file. */
-int
-png_write_gray(const wchar_t *fn, int inv, uint8_t *pix, int16_t w, int16_t h)
+static int
+write_gray(const wchar_t *fn, int inv, uint8_t *pix, int16_t w, int16_t h,
+	   int level)
 {
     png_structp png = NULL;
     png_infop info = NULL;
@@ -314,14 +398,7 @@ error:
 # else
     PNGFUNC(init_io)(png, fp);
 # endif
-    PNGFUNC(set_compression_level)(png, 9);
-
-    /* Set other "zlib" parameters. */
-    PNGFUNC(set_compression_mem_level)(png, 8);
-    PNGFUNC(set_compression_strategy)(png, PNG_Z_DEFAULT_STRATEGY);
-    PNGFUNC(set_compression_window_bits)(png, 15);
-    PNGFUNC(set_compression_method)(png, 8);
-    PNGFUNC(set_compression_buffer_size)(png, 8192);    
+    set_compression(png, level);
 
     PNGFUNC(set_IHDR)(png, info, w, h, 8, PNG_COLOR_TYPE_GRAY,
 		      PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT,
@@ -361,8 +438,9 @@ error:
 
 
 /* Write the given BITMAP-format image as an 8-bit RGBA file. */
-int
-png_write_rgb(const wchar_t *fn, int flip, uint8_t *pix, int16_t w, int16_t h)
+static int
+write_rgb(const wchar_t *fn, int flip, uint8_t *pix, int16_t w, int16_t h,
+	  int level)
 {
     png_structp png = NULL;
     png_infop info = NULL;
@@ -414,14 +492,7 @@ error:
 # else
     PNGFUNC(init_io)(png, fp);
 # endif
-    PNGFUNC(set_compression_level)(png, 9);
-
-    /* Set other "zlib" parameters. */
-    PNGFUNC(set_compression_mem_level)(png, 8);
-    PNGFUNC(set_compression_strategy)(png, PNG_Z_DEFAULT_STRATEGY);
-    PNGFUNC(set_compression_window_bits)(png, 15);
-    PNGFUNC(set_compression_method)(png, 8);
-    PNGFUNC(set_compression_buffer_size)(png, 8192);    
+    set_compression(png, level);
 
     PNGFUNC(set_IHDR)(png, info, w, h, 8, PNG_COLOR_TYPE_RGB,
 		      PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT,
@@ -488,8 +559,9 @@ error:
 
 
 /* Write the given BITMAP-format image as an 8-bit color palette file. */
-int
-png_write_pal(const wchar_t *fn, uint8_t *pix, int16_t w, int16_t h, uint16_t pitch, RGB_PAL pal)
+static int
+write_pal(const wchar_t *fn, uint8_t *pix, int16_t w, int16_t h,
+	  uint16_t pitch, RGB_PAL pal, int level)
 {
     png_color palette[256];
     png_structp png = NULL;
@@ -540,14 +612,7 @@ error:
 # else
     PNGFUNC(init_io)(png, fp);
 # endif
-    PNGFUNC(set_compression_level)(png, 9);
-
-    /* Set other "zlib" parameters. */
-    PNGFUNC(set_compression_mem_level)(png, 8);
-    PNGFUNC(set_compression_strategy)(png, PNG_Z_DEFAULT_STRATEGY);
-    PNGFUNC(set_compression_window_bits)(png, 15);
-    PNGFUNC(set_compression_method)(png, 8);
-    PNGFUNC(set_compression_buffer_size)(png, 8192);    
+    set_compression(png, level);
 
     PNGFUNC(set_IHDR)(png, info, w, h, 8, PNG_COLOR_TYPE_PALETTE,
 		      PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT,
@@ -586,4 +651,301 @@ error:
 }
 
 
+int
+png_write_gray(const wchar_t *fn, int inv, uint8_t *pix, int16_t w, int16_t h)
+{
+    return(write_gray(fn, inv, pix, w, h, config.png_level));
+}
+
+
+int
+png_write_rgb(const wchar_t *fn, int flip, uint8_t *pix, int16_t w, int16_t h)
+{
+    return(write_rgb(fn, flip, pix, w, h, config.png_level));
+}
+
+
+int
+png_write_pal(const wchar_t *fn, uint8_t *pix, int16_t w, int16_t h, uint16_t pitch, RGB_PAL pal)
+{
+    return(write_pal(fn, pix, w, h, pitch, pal, config.png_level));
+}
+
+
+/*
+ * Save a queued image as a plain PGM or PPM file.
+ *
+ * The caller has long moved on by the time the encoder finds
+ * out it cannot write the PNG file, so this is the last chance
+ * to keep the image.
+ */
+static int
+write_pnm(job_t *job)
+{
+    wchar_t fn[1024];
+    wchar_t *sp;
+    uint8_t *p;
+    FILE *fp;
+    int x, y;
+
+    wcsncpy(fn, job->fn, sizeof_w(fn) - 5);
+    fn[sizeof_w(fn) - 5] = L'\0';
+    if ((sp = wcsrchr(fn, L'.')) != NULL)
+	*sp = L'\0';
+    wcscat(fn, (job->type == JOB_GRAY) ? L".pgm" : L".ppm");
+
+    fp = plat_fopen(fn, L"wb");
+    if (fp == NULL) return(0);
+
+    fprintf(fp, "P%c %d %d 255\n",
+	    (job->type == JOB_GRAY) ? '5' : '6', job->w, job->h);
+
+    for (y = 0; y < job->h; y++) {
+	switch (job->type) {
+		case JOB_GRAY:
+			p = &job->pix[y * job->w];
+			for (x = 0; x < job->w; x++)
+				fputc(job->flag ? (255 - p[x]) : p[x], fp);
+			break;
+
+		case JOB_RGB:
+			/* Bottom-up bitmaps are also stored as BGR. */
+			if (job->flag) {
+				p = &job->pix[((job->h - 1) - y) * job->w * 4];
+				for (x = 0; x < job->w; x++, p += 4) {
+					fputc(p[2], fp);
+					fputc(p[1], fp);
+					fputc(p[0], fp);
+				}
+			} else {
+				p = &job->pix[y * job->w * 4];
+				for (x = 0; x < job->w; x++, p += 4)
+					(void)fwrite(p, 1, 3, fp);
+			}
+			break;
+
+		case JOB_PAL:
+			p = &job->pix[y * job->pitch];
+			for (x = 0; x < job->w; x++) {
+				fputc(job->pal[p[x]].r, fp);
+				fputc(job->pal[p[x]].g, fp);
+				fputc(job->pal[p[x]].b, fp);
+			}
+			break;
+	}
+    }
+
+    (void)fclose(fp);
+
+    ERRLOG("PNG: unable to write %ls, saved as %ls instead\n", job->fn, fn);
+
+    return(1);
+}
+
+
+/* Write out a queued image, and then release it. */
+static void
+encode(job_t *job, int level)
+{
+    uint64_t start = plat_timer_us();
+    int ret = 0;
+
+    switch (job->type) {
+	case JOB_GRAY:
+		ret = write_gray(job->fn, job->flag, job->pix,
+				 job->w, job->h, level);
+		break;
+
+	case JOB_RGB:
+		ret = write_rgb(job->fn, job->flag, job->pix,
+				job->w, job->h, level);
+		break;
+
+	case JOB_PAL:
+		ret = write_pal(job->fn, job->pix, job->w, job->h,
+				job->pitch, job->pal, level);
+		break;
+    }
+
+    if (ret)
+	INFO("PNG: wrote %ls (%ix%i, level %i) in %" PRIu64 " ms\n",
+	     job->fn, job->w, job->h, level, (plat_timer_us() - start) / 1000);
+      else if (! write_pnm(job))
+	ERRLOG("PNG: unable to write %ls, image lost!\n", job->fn);
+
+    free(job->pix);
+    free(job);
+}
+
+
+/* Take the oldest image off the queue. */
+static job_t *
+dequeue(int *left)
+{
+    job_t *job;
+
+    thread_wait_mutex(png_mutex);
+
+    job = png_head;
+    if (job != NULL) {
+	png_head = job->next;
+	if (png_head == NULL)
+		png_tail = NULL;
+	png_pending--;
+    }
+    *left = png_pending;
+
+    thread_release_mutex(png_mutex);
+
+    return(job);
+}
+
+
+/*
+ * The encoder thread.
+ *
+ * If images come in faster than we can compress them, we
+ * store the older ones uncompressed so the queue (and the
+ * memory it holds on to) does not keep on growing.
+ */
+static void
+png_thread(UNUSED(void *arg))
+{
+    job_t *job;
+    int left;
+
+    for (;;) {
+	thread_wait_event(png_wake, -1);
+	thread_reset_event(png_wake);
+
+	while ((job = dequeue(&left)) != NULL)
+		encode(job, (left >= PNG_BACKLOG) ? 0 : config.png_level);
+
+	if (! png_running) break;
+    }
+}
+
+
+/*
+ * Start the encoder thread.
+ *
+ * This is done once, at startup, so the printers and the screenshot
+ * code never have to race each other to create it. The DLL itself is
+ * still only loaded when the first image comes in.
+ */
+void
+png_init(void)
+{
+    if (png_tid != NULL) return;
+
+    png_mutex = thread_create_mutex(L"VARCem.PNG");
+    png_wake = thread_create_event();
+    png_running = 1;
+    png_tid = thread_create(png_thread, NULL);
+    if (png_tid == NULL) {
+	ERRLOG("PNG: unable to create encoder thread!\n");
+	png_running = 0;
+	thread_destroy_event(png_wake);
+	png_wake = NULL;
+    }
+}
+
+
+/* Hand an image to the encoder thread. */
+static void
+queue(job_t *job)
+{
+    /* No thread, so we will have to do it ourselves. */
+    if (png_tid == NULL) {
+	encode(job, config.png_level);
+	return;
+    }
+
+    job->next = NULL;
+
+    thread_wait_mutex(png_mutex);
+    if (png_tail != NULL)
+	png_tail->next = job;
+      else
+	png_head = job;
+    png_tail = job;
+    png_pending++;
+    thread_release_mutex(png_mutex);
+
+    thread_set_event(png_wake);
+}
+
+
+static job_t *
+new_job(int type, const wchar_t *fn, uint8_t *pix, int16_t w, int16_t h)
+{
+    job_t *job;
+
+    job = (job_t *)mem_alloc(sizeof(job_t));
+    memset(job, 0x00, sizeof(job_t));
+    job->type = type;
+    wcsncpy(job->fn, fn, sizeof_w(job->fn) - 1);
+    job->pix = pix;
+    job->w = w;
+    job->h = h;
+
+    return(job);
+}
+
+
+/*
+ * The png_queue_xxx functions are like their png_write_xxx
+ * counterparts, but they return right away, and leave the work
+ * to the encoder thread. If they succeed, that thread owns the
+ * pixel buffer, and will free() it when done. If not (meaning
+ * PNG is not available), the buffer still belongs to the caller.
+ * Should the encoding fail later on, the image is saved as a PGM
+ * or PPM file, next to where the PNG file would have gone.
+ */
+int
+png_queue_gray(const wchar_t *fn, int inv, uint8_t *pix, int16_t w, int16_t h)
+{
+    job_t *job;
+
+    if (! png_load()) return(0);
+
+    job = new_job(JOB_GRAY, fn, pix, w, h);
+    job->flag = inv;
+    queue(job);
+
+    return(1);
+}
+
+
+int
+png_queue_rgb(const wchar_t *fn, int flip, uint8_t *pix, int16_t w, int16_t h)
+{
+    job_t *job;
+
+    if (! png_load()) return(0);
+
+    job = new_job(JOB_RGB, fn, pix, w, h);
+    job->flag = flip;
+    queue(job);
+
+    return(1);
+}
+
+
+int
+png_queue_pal(const wchar_t *fn, uint8_t *pix, int16_t w, int16_t h, uint16_t pitch, RGB_PAL pal)
+{
+    job_t *job;
+
+    if (! png_load()) return(0);
+
+    job = new_job(JOB_PAL, fn, pix, w, h);
+    job->pitch = pitch;
+    memcpy(job->pal, pal, sizeof(RGB_PAL));
+    queue(job);
+
+    return(1);
+}
+
+
 #endif	/*USE_PNG*/
@@ -8,7 +8,7 @@
  *
  *		Definitions for the centralized PNG image handler.
  *
- * Version:	@(#)png.h	1.0.4	2021/03/18
+ * Version:	@(#)png.h	1.0.6	2026/10/19
  *
  * Author:	Fred N. van Kempen, <decwiz@yahoo.com>
  *
@@ -59,6 +59,7 @@ typedef rgb_pal_t RGB_PAL[256];
 extern "C" {
 #endif
 
+extern void	png_init(void);
 extern int	png_load(void);
 extern void	png_unload(void);
 
@@ -72,6 +73,14 @@ extern int	png_write_pal(const wchar_t *fn, uint8_t *pix,
 			      int16_t w, int16_t h,
 			      uint16_t pitch, RGB_PAL pal);
 
+extern int	png_queue_gray(const wchar_t *path, int invert,
+			       uint8_t *pix, int16_t w, int16_t h);
+extern int	png_queue_rgb(const wchar_t *fn, int flip, uint8_t *pix,
+			      int16_t w, int16_t h);
+extern int	png_queue_pal(const wchar_t *fn, uint8_t *pix,
+			      int16_t w, int16_t h,
+			      uint16_t pitch, RGB_PAL pal);
+
 #ifdef __cplusplus
 }
 #endif
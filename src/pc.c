@@ -8,7 +8,7 @@
  *
  *		Main emulator module where most things are controlled.
  *
- * Version:	@(#)pc.c	1.0.85	2021/03/23
+ * Version:	@(#)pc.c	1.0.91	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -55,6 +55,10 @@
 #endif
 #include "machines/machine.h"
 #include "misc/random.h"
+#include "misc/capture.h"
+#ifdef USE_LIBPNG
+# include "misc/png.h"
+#endif
 #include "io.h"
 #include "mem.h"
 #include "rom.h"
@@ -804,8 +808,19 @@ pc_init(void)
 
     video_init();
 
+    /* Set up the shared frame buffer if one was requested. */
+    if (config.vidfb_name[0] != '\0')
+	(void)vidfb_open();
+
     sound_init();
 
+    capture_init();
+
+#ifdef USE_LIBPNG
+    /* Start the PNG encoder, used by screenshots and printers. */
+    png_init();
+#endif
+
 #if 0
     fdd_init();
 #else
@@ -846,14 +861,26 @@ pc_close(thread_t *ptr)
 	pic_dump();
     cpu_dumpregs(0);
 
+    capture_close();
+
+    if (config.vidfb_name[0] != '\0')
+	vidfb_close();
+
     video_close();
 
     device_close_all();
 
+    mem_dump_stats();
+
     network_close();
 
     sound_close();
 
+#ifdef USE_LIBPNG
+    /* Wait for any pending images to be written. */
+    png_unload();
+#endif
+
     cdrom_close();
 
 	zip_close();
@@ -1146,6 +1173,10 @@ pc_thread(void *param)
 		}
 		ui_window_title(temp);
 
+		/* Refresh the network traffic counters. */
+		if (config.network_type != NET_NONE)
+			ui_sb_tip_update(SB_NETWORK);
+
 		title_update = 0;
 	}
 
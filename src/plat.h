@@ -8,7 +8,7 @@
  *
  *		Define the various platform support functions.
  *
- * Version:	@(#)plat.h	1.0.27	2021/02/13
+ * Version:	@(#)plat.h	1.0.28	2026/10/19
  *
  * Author:	Fred N. van Kempen, <decwiz@yahoo.com>
  *
@@ -159,6 +159,7 @@ extern int	plat_dir_check(const wchar_t *path);
 extern int	plat_dir_create(const wchar_t *path);
 extern uint64_t	plat_timer_read(void);
 extern uint32_t	plat_timer_ms(void);
+extern uint64_t	plat_timer_us(void);
 extern void	plat_delay_ms(uint32_t count);
 extern void	plat_blitter(int own);
 extern void	plat_mouse_capture(int on);
@@ -214,6 +215,7 @@ extern mutex_t	*thread_create_mutex(const wchar_t *name);
 extern void	thread_close_mutex(mutex_t *arg);
 extern int	thread_wait_mutex(mutex_t *arg);
 extern int	thread_release_mutex(mutex_t *mutex);
+extern void	thread_barrier(void);
 
 #ifdef __cplusplus
 }
@@ -8,7 +8,7 @@
  *
  *		System timer module.
  *
- * Version:	@(#)timer.c	1.0.5	2019/05/17
+ * Version:	@(#)timer.c	1.0.6	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -114,6 +114,21 @@ timer_process(void)
 }
 
 
+/*
+ * Return the time that has passed since the timers were last
+ * processed. Timer callbacks run at the time they were due, so
+ * while processing them, this is always zero.
+ */
+tmrval_t
+timer_elapsed(void)
+{
+    if (latch == 0)
+	return(0);
+
+    return(latch - timer_count);
+}
+
+
 void
 timer_update_outstanding(void)
 {
@@ -8,7 +8,7 @@
  *
  *		Definitions for the system timer module.
  *
- * Version:	@(#)timer.h	1.0.6	2021/03/12
+ * Version:	@(#)timer.h	1.0.7	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -85,6 +85,7 @@ extern tmrval_t	timer_count;
 
 
 extern void	timer_process(void);
+extern tmrval_t	timer_elapsed(void);
 extern void	timer_update_outstanding(void);
 extern void	timer_reset(void);
 extern int	timer_add(void (*callback)(priv_t), priv_t priv,
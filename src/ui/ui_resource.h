@@ -12,7 +12,7 @@
  *		those are not used by the platform code. This is easier to
  *		maintain.
  *
- * Version:	@(#)ui_resource.h	1.0.25	2021/04/26
+ * Version:	@(#)ui_resource.h	1.0.27	2026/10/19
  *
  * Author:	Fred N. van Kempen, <decwiz@yahoo.com>
  *
@@ -531,6 +531,8 @@
 #define IDS_3951	3951		/* "ZIP images (*.im?)\0*.im..." */
 #define IDS_3952	3952		/* "ZIP images (*.im?)\0*.im..." */
 #define IDS_3960	3960		/* "Network (%s) */
+#define IDS_3961	3961		/* " - RX: %llu (%llu KB), TX.." */
+#define IDS_3962	3962		/* "  [%u/%u lost]" */
 #define IDS_3970	3970		/* "Sound (%s) */
 #define IDS_3980	3980		/* "MO %i (%ls): %ls" */
 #define IDS_3981	3981		/* "MO images (*.im?)\0*.im..." */
@@ -8,7 +8,7 @@
  *
  *		Common UI support functions for the Status Bar module.
  *
- * Version:	@(#)ui_stbar.c	1.0.23	2021/05/15
+ * Version:	@(#)ui_stbar.c	1.0.25	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -209,6 +209,7 @@ ui_sb_tip_update(uint8_t tag)
     cdrom_t *cdev;
     zip_drive_t *zdev;
     mo_drive_t *modev;
+    netstats_t nst;
     const wchar_t *str;
     const char *stransi;
     sbpart_t *ptr;
@@ -311,6 +312,19 @@ ui_sb_tip_update(uint8_t tag)
 	case SB_NETWORK:
 		stransi = network_card_getname(config.network_card);
 		swprintf(tip, sizeof_w(tip), get_string(IDS_3960), stransi);
+		network_get_stats(&nst);
+		swprintf(temp, sizeof_w(temp),
+			 get_string(IDS_3961),
+			 (unsigned long long)nst.rx.packets,
+			 (unsigned long long)(nst.rx.bytes >> 10),
+			 (unsigned long long)nst.tx.packets,
+			 (unsigned long long)(nst.tx.bytes >> 10));
+		wcscat(tip, temp);
+		if (nst.rx.drops || nst.tx.drops) {
+			swprintf(temp, sizeof_w(temp), get_string(IDS_3962),
+				 nst.rx.drops, nst.tx.drops);
+			wcscat(tip, temp);
+		}
 		break;
 
 	case SB_SOUND:
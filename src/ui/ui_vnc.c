@@ -10,7 +10,7 @@
  *
  * TODO:	Implement screenshots, and Audio Redirection.
  *
- * Version:	@(#)ui_vnc.c	1.0.15	2021/03/24
+ * Version:	@(#)ui_vnc.c	1.0.16	2026/10/19
  *
  * Author:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Based on raw code by RichardG, <richardg867@gmail.com>
@@ -73,9 +73,9 @@
 
 
 #define VNC_MIN_X	320
-#define VNC_MAX_X	2048
+#define VNC_MAX_X	VIDFB_MAX_X	/* we use the shared frame buffer */
 #define VNC_MIN_Y	200
-#define VNC_MAX_Y	2048
+#define VNC_MAX_Y	VIDFB_MAX_Y
 
 
 #if USE_VNC == 1
@@ -266,29 +266,25 @@ vnc_display(rfbClientPtr cl)
 }
 
 
+/*
+ * The blitter has already put the frame into the frame buffer,
+ * so all we have to do is point the server at the right half of
+ * it, and tell it which lines changed.
+ */
 static void
-vnc_blit(bitmap_t *scr, int x, int y, int y1, int y2, int w, int h)
+vnc_blit(UNUSED(bitmap_t *scr), UNUSED(int x), UNUSED(int y),
+	 int y1, int y2, UNUSED(int w), UNUSED(int h))
 {
-    uint32_t *p;
-    int yy;
+    vidfb_t *fb = vidfb_get();
 
-//INFO("VNC: blit(%i,%i, %i,%i, %i,%i)\n", x,y, y1,y2, w,h);
+    video_blit_done();
 
-    for (yy = y1; yy < y2; yy++) {
-	p = (uint32_t *)&(((uint32_t *)rfb->frameBuffer)[yy*VNC_MAX_X]);
+    if ((fb == NULL) || (y1 == y2)) return;
 
-	if ((y+yy) >= 0 && (y+yy) < VNC_MAX_Y) {
-		if (config.vid_grayscale || config.invert_display)
-			video_transform_copy(p, &scr->line[y+yy][x], w);
-		  else
-			memcpy(p, &scr->line[y+yy][x], w*4);
-	}
-    }
- 
-    video_blit_done();
+    rfb->frameBuffer = (char *)fb + fb->offset[fb->front];
 
     if (! updatingSize)
-	FUNC(MarkRectAsModified)(rfb, 0,0, allowedX,allowedY);
+	FUNC(MarkRectAsModified)(rfb, 0,y1, allowedX,y2);
 }
 
 
@@ -298,10 +294,10 @@ vnc_close(void)
     video_blit_set(NULL);
 
     if (rfb != NULL) {
-	free(rfb->frameBuffer);
-
 	FUNC(ScreenCleanup)(rfb);
 
+	vidfb_close();
+
 	rfb = NULL;
     }
 
@@ -341,6 +337,7 @@ vnc_init(int fs)
     const char *fn = PATH_VNC_DLL;
 #endif
     const char *str;
+    vidfb_t *fb;
 
     /* We do not support fullscreen, folks. */
     if (fs) {
@@ -381,7 +378,8 @@ vnc_init(int fs)
  
 	rfb = FUNC(GetScreen)(0, NULL, VNC_MAX_X, VNC_MAX_Y, 8, 3, 4);
 	rfb->desktopName = title;
-	rfb->frameBuffer = (char *)mem_alloc(VNC_MAX_X*VNC_MAX_Y*4);
+	fb = vidfb_open();
+	rfb->frameBuffer = (char *)fb + fb->offset[fb->front];
 
 	rfb->serverFormat = rpf;
 	rfb->alwaysShared = TRUE;
@@ -8,7 +8,7 @@
  *
  *		Platform main support module for Windows.
  *
- * Version:	@(#)win.c	1.0.35	2021/02/18
+ * Version:	@(#)win.c	1.0.36	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -572,6 +572,25 @@ plat_timer_ms(void)
 }
 
 
+uint64_t
+plat_timer_us(void)
+{
+    static uint64_t freq = 0;
+    LARGE_INTEGER li;
+
+    if (freq == 0) {
+	QueryPerformanceFrequency(&li);
+	freq = li.QuadPart;
+    }
+
+    /* Get the current time in microseconds. */
+    QueryPerformanceCounter(&li);
+
+    return((uint64_t)(li.QuadPart / freq) * 1000000 +
+	   ((li.QuadPart % freq) * 1000000) / freq);
+}
+
+
 void
 plat_delay_ms(uint32_t count)
 {
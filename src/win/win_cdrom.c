@@ -12,7 +12,7 @@
  *
  * FIXME:	Not yet fully working!  Getting there, though ;-)
  *
- * Version:	@(#)win_cdrom.c	1.0.17 	2019/05/17
+ * Version:	@(#)win_cdrom.c	1.0.18 	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -63,6 +63,10 @@
 #include "win.h"
 
 
+#define RA_SECTORS	32			/* read-ahead, about 0.4s */
+#define RAW_SECTOR	2352
+
+
 enum {
     CD_STOPPED = 0,
     CD_PLAYING,
@@ -92,6 +96,19 @@ typedef struct {
     uint8_t	sense[256];
     uint8_t	rcbuf[16];
     wchar_t	path[128];
+
+    /* Audio read-ahead, filled by a thread of its own. */
+    thread_t	*ra_thread;
+    event_t	*ra_wake;
+    mutex_t	*ra_mutex;
+    volatile int ra_running;
+    int		ra_gen,				/* bumped on every restart */
+		ra_error;
+    uint32_t	ra_pos,				/* next sector to read */
+		ra_end;
+    int		ra_tail,			/* oldest sector in ring */
+		ra_count;
+    uint8_t	ra_buf[RA_SECTORS][RAW_SECTOR];
 } cdrom_host_t;
 
 #define cdrom_sense_error  hdev->sense[0]
@@ -412,6 +429,15 @@ ioctl_close(cdrom_t *dev)
 
     ioctl_stop(dev);
 
+    /* Stop the read-ahead before the handle goes away. */
+    if (hdev->ra_thread != NULL) {
+	hdev->ra_running = 0;
+	thread_set_event(hdev->ra_wake);
+	thread_wait(hdev->ra_thread, -1);
+    }
+    thread_destroy_event(hdev->ra_wake);
+    thread_close_mutex(hdev->ra_mutex);
+
     hdev->disc_changed = 1;
 
     /* Unlock the media in the drive if we locked it. */
@@ -757,6 +783,82 @@ get_track_msf(cdrom_t *dev, int track)
 }
 
 
+/*
+ * Audio read-ahead thread.
+ *
+ * Reading CD-DA sectors from the host drive can take a long time
+ * (spin-up, retries), so this is not done on the emulation thread.
+ * We keep a ring of sectors ahead of the play position filled, and
+ * the audio callback only takes them from there.
+ */
+static void
+ra_thread(void *priv)
+{
+    cdrom_host_t *hdev = (cdrom_host_t *)priv;
+    uint8_t buf[RAW_SECTOR];
+    RAW_READ_INFO in;
+    uint32_t pos;
+    DWORD size;
+    int gen, ok;
+
+    while (hdev->ra_running) {
+	thread_wait_event(hdev->ra_wake, -1);
+	thread_reset_event(hdev->ra_wake);
+
+	for (;;) {
+		thread_wait_mutex(hdev->ra_mutex);
+		if (!hdev->ra_running || hdev->ra_error ||
+		    (hdev->ra_count == RA_SECTORS) ||
+		    (hdev->ra_pos >= hdev->ra_end)) {
+			thread_release_mutex(hdev->ra_mutex);
+			break;
+		}
+		pos = hdev->ra_pos;
+		gen = hdev->ra_gen;
+		thread_release_mutex(hdev->ra_mutex);
+
+		in.DiskOffset.LowPart = pos * 2048;
+		in.DiskOffset.HighPart = 0;
+		in.SectorCount = 1;
+		in.TrackMode = CDDA;
+		ok = DeviceIoControl(hdev->hIOCTL, IOCTL_CDROM_RAW_READ,
+				     &in, sizeof(in), buf, RAW_SECTOR,
+				     &size, NULL);
+
+		/* Throw the sector away if playing restarted meanwhile. */
+		thread_wait_mutex(hdev->ra_mutex);
+		if (gen == hdev->ra_gen) {
+			if (ok) {
+				memcpy(hdev->ra_buf[(hdev->ra_tail + hdev->ra_count) % RA_SECTORS], buf, RAW_SECTOR);
+				hdev->ra_count++;
+				hdev->ra_pos++;
+			} else
+				hdev->ra_error = 1;
+		}
+		thread_release_mutex(hdev->ra_mutex);
+	}
+    }
+}
+
+
+/* (Re)start the read-ahead at the current play position. */
+static void
+ra_start(cdrom_t *dev)
+{
+    cdrom_host_t *hdev = (cdrom_host_t *)dev->local;
+
+    thread_wait_mutex(hdev->ra_mutex);
+    hdev->ra_gen++;
+    hdev->ra_error = 0;
+    hdev->ra_pos = dev->seek_pos;
+    hdev->ra_end = dev->cd_end;
+    hdev->ra_tail = hdev->ra_count = 0;
+    thread_release_mutex(hdev->ra_mutex);
+
+    thread_set_event(hdev->ra_wake);
+}
+
+
 /* API: start playing audio at specified position. */
 static uint8_t
 audio_play(cdrom_t *dev, uint32_t pos, uint32_t len, int is_msf)
@@ -817,6 +919,8 @@ audio_play(cdrom_t *dev, uint32_t pos, uint32_t len, int is_msf)
 
     dev->cd_state = CD_PLAYING;
 
+    ra_start(dev);
+
     return 1;
 }
 
@@ -869,13 +973,18 @@ audio_resume(cdrom_t *dev)
 }
 
 
-/* API: callback from sound module. */
+/*
+ * API: callback from sound module.
+ *
+ * This runs on the emulation thread, so it never reads from the
+ * drive itself. If the read-ahead has fallen behind, the rest of
+ * the block is filled with silence instead.
+ */
 static int
 audio_callback(cdrom_t *dev, int16_t *bufp, int len)
 {
     cdrom_host_t *hdev = (cdrom_host_t *)dev->local;
-    RAW_READ_INFO in;
-    DWORD size;
+    int got, err;
 
     DBGLOG(1, "IOCTL: audio_callback(%i) state=%i: ",
 			dev->sound_on, dev->cd_state);
@@ -899,16 +1008,22 @@ audio_callback(cdrom_t *dev, int16_t *bufp, int len)
 
     while (dev->cd_buflen < len) {
 	if (dev->seek_pos < dev->cd_end) {
-		in.DiskOffset.LowPart = dev->seek_pos * 2048;
-		in.DiskOffset.HighPart = 0;
-		in.SectorCount = 1;
-		in.TrackMode = CDDA;		
-
-		if (! DeviceIoControl(hdev->hIOCTL, IOCTL_CDROM_RAW_READ,
-				      &in, sizeof(in),
-				      &dev->cd_buffer[dev->cd_buflen], 2352,
-				      &size, NULL)) {
-
+		got = err = 0;
+		thread_wait_mutex(hdev->ra_mutex);
+		if (hdev->ra_count > 0) {
+			memcpy(&dev->cd_buffer[dev->cd_buflen],
+			       hdev->ra_buf[hdev->ra_tail], RAW_SECTOR);
+			hdev->ra_tail = (hdev->ra_tail + 1) % RA_SECTORS;
+			hdev->ra_count--;
+			got = 1;
+		} else
+			err = hdev->ra_error;
+		thread_release_mutex(hdev->ra_mutex);
+
+		/* Let the read-ahead top up the ring. */
+		thread_set_event(hdev->ra_wake);
+
+		if (err) {
 			memset(&dev->cd_buffer[dev->cd_buflen], 0,
 			       (BUF_SIZE - dev->cd_buflen) * 2);
 			hdev->is_playing = 0;
@@ -919,8 +1034,16 @@ audio_callback(cdrom_t *dev, int16_t *bufp, int len)
 			return 0;
 		}
 
+		if (! got) {
+			memset(&dev->cd_buffer[dev->cd_buflen], 0,
+			       (len - dev->cd_buflen) * 2);
+			dev->cd_buflen = len;
+			DBGLOG(1, "read-ahead underrun\n");
+			break;
+		}
+
 		dev->seek_pos++;
-		dev->cd_buflen += (2352 / 2);
+		dev->cd_buflen += (RAW_SECTOR / 2);
 		DBGLOG(1, "dev->seek_pos = %i\n", dev->seek_pos);
 	} else {
 		memset(&dev->cd_buffer[dev->cd_buflen], 0,
@@ -1590,6 +1713,7 @@ cdrom_host_open(cdrom_t *dev, char d)
 
     /* Allocate our control block. */
     hdev = (cdrom_host_t *)mem_alloc(sizeof(cdrom_host_t));
+    memset(hdev, 0x00, sizeof(cdrom_host_t));
     swprintf(hdev->path, sizeof_w(hdev->path), L"\\\\.\\%c:", d);
     dev->local = hdev;
 
@@ -1618,6 +1742,12 @@ cdrom_host_open(cdrom_t *dev, char d)
      */
     (void)media_lock(dev, 0);
 
+    /* Start the audio read-ahead. */
+    hdev->ra_wake = thread_create_event();
+    hdev->ra_mutex = thread_create_mutex(NULL);
+    hdev->ra_running = 1;
+    hdev->ra_thread = thread_create(ra_thread, hdev);
+
     /* Looks good - attach to this cdrom instance. */
     dev->ops = &cdrom_host_ops;
     dev->reset = ioctl_reset;
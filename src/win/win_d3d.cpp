@@ -8,7 +8,7 @@
  *
  *		Rendering module for Microsoft Direct3D 9.
  *
- * Version:	@(#)win_d3d.cpp	1.0.21	2021/03/18
+ * Version:	@(#)win_d3d.cpp	1.0.22	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -695,8 +695,11 @@ d3d_screenshot(const wchar_t *fn)
     is_enabled = old;
 
 #if USE_LIBPNG
-    i = png_write_rgb(fn, 0, pixels,
+    /* Save the screenshot, using PNG. The encoder owns the pixels now. */
+    i = png_queue_rgb(fn, 0, pixels,
 		      (int16_t)desc.Width, (int16_t)desc.Height);
+    if (i)
+	pixels = NULL;
 
     /* Show error message if needed. */
     if (i == 0) {
@@ -708,8 +711,9 @@ d3d_screenshot(const wchar_t *fn)
     (void)fn;
 #endif
 
-    /* Release the linear buffer. */
-    free(pixels);
+    /* Release the linear buffer, unless the encoder has it. */
+    if (pixels != NULL)
+	free(pixels);
 }
 
 
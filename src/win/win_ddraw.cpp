@@ -8,7 +8,7 @@
  *
  *		Rendering module for Microsoft DirectDraw 9.
  *
- * Version:	@(#)win_ddraw.cpp	1.0.24	2021/03/18
+ * Version:	@(#)win_ddraw.cpp	1.0.25	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -727,11 +727,16 @@ ddraw_screenshot(const wchar_t *fn)
     wcscpy(path, fn);
 
 #ifdef USE_LIBPNG
-    /* Save the screenshot, using PNG if available. */
-    i = png_write_rgb(path, 1, pixels,
+    /*
+     * Save the screenshot, using PNG if available.
+     * If queued, the encoder owns the pixels now.
+     */
+    i = png_queue_rgb(path, 1, pixels,
 		      (int16_t)bmi.bmiHeader.biWidth,
 		      (int16_t)abs(bmi.bmiHeader.biHeight));
-    if (i == 0) {
+    if (i)
+	pixels = NULL;
+      else {
 #endif
 	/* Use BMP, so fix the file name. */
 	path[wcslen(path)-3] = L'b';
@@ -742,8 +747,9 @@ ddraw_screenshot(const wchar_t *fn)
     }
 #endif
 
-    /* Release pixel buffer. */
-    free(pixels);
+    /* Release pixel buffer, unless the encoder has it. */
+    if (pixels != NULL)
+	free(pixels);
 
     /* Show error message if needed. */
     if (i == 0) {
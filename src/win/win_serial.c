@@ -12,7 +12,7 @@
  *		Windows and UNIX systems, with support for FTDI and Prolific
  *		USB ports. Support for these has been removed.
  *
- * Version:	@(#)win_serial.c	1.0.6	2019/05/13
+ * Version:	@(#)win_serial.c	1.0.7	2026/10/19
  *
  * Author:	Fred N. van Kempen, <decwiz@yahoo.com>
  *
@@ -69,8 +69,9 @@ typedef struct {
     DCB		dcb,			/* terminal settings */
 		odcb;
     thread_t	*tid;			/* pointer to receiver thread */
-    char	buff[1024];
-    int		icnt, ihead, itail;
+    uint8_t	buff[1024];		/* must be a power of 2 */
+    volatile int ihead,			/* written by receiver thread */
+		itail;			/* written by emulator */
 } serial_t;
 
 
@@ -79,16 +80,26 @@ static void
 reader_thread(void *arg)
 {
     serial_t *dev = (serial_t *)arg;
-    uint8_t b;
-    DWORD n;
+    uint8_t b[256];
+    DWORD i, n, room;
 
     INFO("%s: thread started\n", dev->name);
 
     /* As long as the channel is open.. */
     while (dev->tid != NULL) {
-	/* Post a READ on the device. */
+	/* See how much room we have, and wait a bit if none. */
+	room = (sizeof(dev->buff) - 1) -
+	       ((dev->ihead - dev->itail) & (sizeof(dev->buff) - 1));
+	if (room == 0) {
+		Sleep(1);
+		continue;
+	}
+	if (room > sizeof(b))
+		room = sizeof(b);
+
+	/* Post a READ on the device, it returns with what it has. */
 	n = 0;
-	if (ReadFile(dev->handle, &b, (DWORD)1, &n, &dev->rov) == FALSE) {
+	if (ReadFile(dev->handle, b, room, &n, &dev->rov) == FALSE) {
 		n = GetLastError();
 		if (n != ERROR_IO_PENDING) {
 			/* Not good, we got an error. */
@@ -104,22 +115,15 @@ reader_thread(void *arg)
 		}
 	}
 
-pclog(0,"%s: got %i bytes of data\n", dev->name, n);
-	if (n == 1) {
-		/* We got data, update stuff. */
-		if (dev->icnt < sizeof(dev->buff)) {
-pclog(0,"%s: queued byte %02x (%i)\n", dev->name, b, dev->icnt+1);
-			dev->buff[dev->ihead++] = b;
-			dev->ihead &= (sizeof(dev->buff)-1);
-			dev->icnt++;
-
-			/* Do a callback to let them know. */
-			if (dev->rd_done != NULL)
-				dev->rd_done(dev->rd_arg, n);
-		} else {
-			ERRLOG("%s: RX buffer overrun!\n", dev->name);
-		}
-	}
+	/* We got data, queue it. The emulator will poll for it. */
+	for (i = 0; i < n; i++)
+		dev->buff[(dev->ihead + i) & (sizeof(dev->buff)-1)] = b[i];
+	thread_barrier();
+	dev->ihead = (dev->ihead + n) & (sizeof(dev->buff)-1);
+
+	/* Do a callback to let them know. */
+	if ((n > 0) && (dev->rd_done != NULL))
+		dev->rd_done(dev->rd_arg, n);
     }
 
     /* Error or done, clean up. */
@@ -562,7 +566,6 @@ plat_serial_write(priv_t arg, unsigned char val)
     serial_t *dev = (serial_t *)arg;
     DWORD n = 0;
 
-pclog(0,"%s: writing byte %02x\n", dev->name, val);
     if (WriteFile(dev->handle, &val, 1, &n, &dev->wov) == FALSE) {
 	n = GetLastError();
 	if (n != ERROR_IO_PENDING) {
@@ -586,23 +589,22 @@ pclog(0,"%s: writing byte %02x\n", dev->name, val);
 /*
  * API: try to read data from an open port.
  *
- * For now, we will use one byte per call.  Eventually,
- * we should go back to loading a buffer full of data,
- * just to speed things up a bit.  --FvK
+ * This takes up to 'max' bytes from what the receiver
+ * thread has queued up, and returns how many we got.
  */
 int
 plat_serial_read(priv_t arg, unsigned char *bufp, int max)
 {
     serial_t *dev = (serial_t *)arg;
-
-    if (dev->icnt == 0) return(0);
-
-    while (max-- > 0) {
-	*bufp++ = dev->buff[dev->itail++];
-pclog(0,"%s: dequeued byte %02x (%i)\n", dev->name, *(bufp-1), dev->icnt);
-	dev->itail &= (sizeof(dev->buff)-1);
-	if (--dev->icnt == 0) break;
+    int head = dev->ihead;
+    int n = 0;
+
+    thread_barrier();
+    while ((n < max) && (dev->itail != head)) {
+	*bufp++ = dev->buff[dev->itail];
+	dev->itail = (dev->itail + 1) & (sizeof(dev->buff)-1);
+	n++;
     }
 
-    return(max);
+    return(n);
 }
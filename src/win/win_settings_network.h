@@ -8,7 +8,7 @@
  *
  *		Implementation of the Settings dialog.
  *
- * Version:	@(#)win_settings_network.h	1.0.18	2021/10/22
+ * Version:	@(#)win_settings_network.h	1.0.19	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -73,6 +73,7 @@ network_recalc_combos(HWND hdlg)
 		break;
 
 	case NET_UDPLINK:
+	case NET_VSWITCH:
 		EnableWindow(h1, FALSE);
 		EnableWindow(h2, TRUE);
 		EnableWindow(h3, TRUE);
@@ -8,7 +8,7 @@
  *
  *		Implement threads and mutexes for the Win32 platform.
  *
- * Version:	@(#)win_thread.c	1.0.6	2018/10/05
+ * Version:	@(#)win_thread.c	1.0.7	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Sarah Walker, <tommowalker@tommowalker.co.uk>
@@ -186,3 +186,15 @@ thread_release_mutex(mutex_t *mutex)
 
     return(!!ReleaseMutex((HANDLE)mutex));
 }
+
+
+/*
+ * Full memory barrier, used by the lock-free (single producer,
+ * single consumer) queues to make sure the data stored in a
+ * slot is visible to the other thread before its index is.
+ */
+void
+thread_barrier(void)
+{
+    MemoryBarrier();
+}